@@ -17,6 +17,8 @@ HEADERS += src/GetFileDialog.h
 HEADERS += src/EditSimShotDialog.h
 HEADERS += src/ResultsDialog.h
 HEADERS += src/ProjectModel.h
+HEADERS += src/ProjectFile.h
+HEADERS += src/EpisodeStore.h
 HEADERS += src/Segment.h
 HEADERS += src/Series.h
 HEADERS += src/Season.h
@@ -33,6 +35,9 @@ HEADERS += src/UtteranceTreeWidget.h
 HEADERS += src/Dendogram.h
 HEADERS += src/DendogramNode.h
 HEADERS += src/DendogramWidget.h
+HEADERS += src/HacEngine.h
+HEADERS += src/SilhouetteEvaluator.h
+HEADERS += src/DistanceKernel.h
 HEADERS += src/Vertex.h
 HEADERS += src/Edge.h
 
@@ -56,10 +61,21 @@ HEADERS += src/SummarizationDialog.h
 
 HEADERS += src/MovieAnalyzer.h
 HEADERS += src/VideoFrameProcessor.h
+HEADERS += src/FrameHistoPipeline.h
+HEADERS += src/HistoCache.h
+HEADERS += src/BoundaryFrameExtractor.h
+HEADERS += src/EpisodeAnalyzer.h
+HEADERS += src/EpisodeBatchScheduler.h
 HEADERS += src/TextProcessor.h
 HEADERS += src/AudioProcessor.h
+HEADERS += src/AudioFrontEnd.h
+HEADERS += src/IVectorExtractor.h
 HEADERS += src/SocialNetProcessor.h
+HEADERS += src/SpeakerDictionary.h
+HEADERS += src/InteractionMatrix.h
+HEADERS += src/NetworkSnapshotStore.h
 HEADERS += src/Optimizer.h
+HEADERS += src/StorylineOrderer.h
 HEADERS += src/Evaluator.h
 
 HEADERS += src/VideoPlayer.h
@@ -80,6 +96,8 @@ SOURCES += src/GetFileDialog.cpp
 SOURCES += src/EditSimShotDialog.cpp
 SOURCES += src/ResultsDialog.cpp
 SOURCES += src/ProjectModel.cpp
+SOURCES += src/ProjectFile.cpp
+SOURCES += src/EpisodeStore.cpp
 SOURCES += src/Segment.cpp
 SOURCES += src/Series.cpp
 SOURCES += src/Season.cpp
@@ -96,6 +114,8 @@ SOURCES += src/UtteranceTreeWidget.cpp
 SOURCES += src/Dendogram.cpp
 SOURCES += src/DendogramNode.cpp
 SOURCES += src/DendogramWidget.cpp
+SOURCES += src/SilhouetteEvaluator.cpp
+SOURCES += src/DistanceKernel.cpp
 SOURCES += src/Vertex.cpp
 SOURCES += src/Edge.cpp
 
@@ -119,10 +139,21 @@ SOURCES += src/SummarizationDialog.cpp
 
 SOURCES += src/MovieAnalyzer.cpp
 SOURCES += src/VideoFrameProcessor.cpp
+SOURCES += src/FrameHistoPipeline.cpp
+SOURCES += src/HistoCache.cpp
+SOURCES += src/BoundaryFrameExtractor.cpp
+SOURCES += src/EpisodeAnalyzer.cpp
+SOURCES += src/EpisodeBatchScheduler.cpp
 SOURCES += src/TextProcessor.cpp
 SOURCES += src/AudioProcessor.cpp
+SOURCES += src/AudioFrontEnd.cpp
+SOURCES += src/IVectorExtractor.cpp
 SOURCES += src/SocialNetProcessor.cpp
+SOURCES += src/SpeakerDictionary.cpp
+SOURCES += src/InteractionMatrix.cpp
+SOURCES += src/NetworkSnapshotStore.cpp
 SOURCES += src/Optimizer.cpp
+SOURCES += src/StorylineOrderer.cpp
 SOURCES += src/Evaluator.cpp
 
 SOURCES += src/VideoPlayer.cpp
@@ -162,3 +193,18 @@ OBJECTS_DIR = build/.obj
 MOC_DIR = build/.moc
 RCC_DIR = build/.rcc
 UI_DIR = build/.ui
+
+# command-line driver running processing stages without user interaction:
+# qmake CONFIG+=headless
+headless {
+  TARGET = "TV Series Processing Tool CLI"
+
+  HEADERS += src/HeadlessDriver.h
+
+  SOURCES -= src/main.cpp
+  SOURCES += src/headless.cpp
+  SOURCES += src/HeadlessDriver.cpp
+
+  OBJECTS_DIR = build/.obj-headless
+  MOC_DIR = build/.moc-headless
+}
@@ -0,0 +1,171 @@
+#include <QProcess>
+#include <QStringList>
+#include <QDebug>
+
+#include <cmath>
+
+#include "AudioFrontEnd.h"
+
+using namespace arma;
+
+// 25 ms frames every 10 ms
+static const uword FrameLength = 400;
+static const uword FrameShift = 160;
+static const uword FftSize = 512;
+static const double PreEmphasis = 0.97;
+
+// frames taken into account on each side to compute deltas
+static const int DeltaWindow = 2;
+
+static double toMel(double f)
+{
+  return 2595.0 * std::log10(1.0 + f / 700.0);
+}
+
+static double fromMel(double m)
+{
+  return 700.0 * (std::pow(10.0, m / 2595.0) - 1.0);
+}
+
+/////////////////
+// constructor //
+/////////////////
+
+AudioFrontEnd::AudioFrontEnd(int nCeps, int nFilters)
+  : m_nCeps(nCeps)
+{
+  uword nBins(FftSize / 2 + 1);
+
+  m_window.set_size(FrameLength);
+  for (uword i(0); i < FrameLength; i++)
+    m_window(i) = 0.54 - 0.46 * std::cos(2 * datum::pi * i / (FrameLength - 1));
+
+  // filters equally spaced on the mel scale up to Nyquist frequency
+  vec centers(nFilters + 2);
+  double maxMel = toMel(SampleRate / 2.0);
+
+  for (int i(0); i < nFilters + 2; i++)
+    centers(i) = fromMel(maxMel * i / (nFilters + 1));
+
+  m_melBank.zeros(nFilters, nBins);
+
+  for (int i(0); i < nFilters; i++)
+    for (uword k(0); k < nBins; k++) {
+
+      double f = static_cast<double>(k) * SampleRate / FftSize;
+
+      if (f > centers(i) && f <= centers(i + 1))
+	m_melBank(i, k) = (f - centers(i)) / (centers(i + 1) - centers(i));
+      else if (f > centers(i + 1) && f < centers(i + 2))
+	m_melBank(i, k) = (centers(i + 2) - f) / (centers(i + 2) - centers(i + 1));
+    }
+
+  // DCT-II, first coefficient left aside
+  m_dct.set_size(nCeps, nFilters);
+
+  for (int i(0); i < nCeps; i++)
+    for (int j(0); j < nFilters; j++)
+      m_dct(i, j) = std::sqrt(2.0 / nFilters) * std::cos(datum::pi * (i + 1) * (j + 0.5) / nFilters);
+}
+
+////////////////////
+// public methods //
+////////////////////
+
+bool AudioFrontEnd::decode(const QString &fName, fvec &samples)
+{
+  QProcess process;
+  QStringList arguments;
+
+  // mono 16 kHz samples read from standard output: no audio file written
+  arguments << "-v" << "error" << "-i" << fName << "-map" << "0:1" << "-vn" << "-acodec" << "pcm_s16le" << "-ar" << QString::number(SampleRate) << "-ac" << "1" << "-f" << "s16le" << "-";
+
+  process.start("ffmpeg", arguments);
+
+  if (!process.waitForStarted() || !process.waitForFinished(-1) || process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+    qWarning() << "Couldn't decode audio track of" << fName << ":" << process.readAllStandardError();
+    return false;
+  }
+
+  QByteArray data = process.readAllStandardOutput();
+  const qint16 *pcm = reinterpret_cast<const qint16 *>(data.constData());
+  uword n(data.size() / sizeof(qint16));
+
+  samples.set_size(n);
+  for (uword i(0); i < n; i++)
+    samples(i) = pcm[i] / 32768.0f;
+
+  return true;
+}
+
+fmat AudioFrontEnd::computeFeatures(const fvec &samples, qint64 start, qint64 end) const
+{
+  // segment boundaries in milliseconds
+  uword first = static_cast<uword>(qMax(static_cast<qint64>(0), start)) * SampleRate / 1000;
+  uword last = qMin(static_cast<uword>(qMax(static_cast<qint64>(0), end)) * SampleRate / 1000, static_cast<uword>(samples.n_elem));
+
+  if (last <= first || last - first < FrameLength)
+    return fmat(getDim(), 0);
+
+  vec signal = conv_to<vec>::from(samples.subvec(first, last - 1));
+
+  // pre-emphasis
+  for (uword i(signal.n_elem - 1); i > 0; i--)
+    signal(i) -= PreEmphasis * signal(i - 1);
+
+  uword nFrames = (signal.n_elem - FrameLength) / FrameShift + 1;
+
+  mat frames(FrameLength, nFrames);
+  for (uword t(0); t < nFrames; t++)
+    frames.col(t) = signal.subvec(t * FrameShift, t * FrameShift + FrameLength - 1);
+
+  // log-energy of each frame
+  rowvec energy = log(clamp(sum(square(frames), 0), 1e-10, datum::inf));
+
+  // power spectrum of all frames at once, then filter bank
+  frames.each_col() %= m_window;
+  cx_mat spectrum = fft(frames, FftSize);
+  mat power = square(abs(spectrum.rows(0, FftSize / 2)));
+
+  mat C(m_nCeps + 1, nFrames);
+  C.rows(0, m_nCeps - 1) = m_dct * log(clamp(m_melBank * power, 1e-10, datum::inf));
+  C.row(m_nCeps) = energy;
+
+  mat features = join_cols(C, computeDeltas(C));
+
+  // normalization over the segment
+  vec mu = mean(features, 1);
+  vec sigma = stddev(features, 0, 1);
+  sigma.elem(find(sigma <= 0.0)).ones();
+
+  features.each_col() -= mu;
+  features.each_col() /= sigma;
+
+  return conv_to<fmat>::from(features);
+}
+
+int AudioFrontEnd::getDim() const
+{
+  return 2 * (m_nCeps + 1);
+}
+
+/////////////////////
+// private methods //
+/////////////////////
+
+mat AudioFrontEnd::computeDeltas(const mat &C) const
+{
+  int n(C.n_cols);
+  double norm(0.0);
+  mat D = zeros(C.n_rows, n);
+
+  for (int k(1); k <= DeltaWindow; k++)
+    norm += 2 * k * k;
+
+  // frames repeated beyond segment boundaries
+  for (int t(0); t < n; t++)
+    for (int k(1); k <= DeltaWindow; k++)
+      D.col(t) += k * (C.col(qMin(t + k, n - 1)) - C.col(qMax(t - k, 0)));
+
+  return D / norm;
+}
@@ -0,0 +1,36 @@
+#ifndef AUDIOFRONTEND_H
+#define AUDIOFRONTEND_H
+
+#include <QString>
+
+#include <armadillo>
+
+///////////////////////////////////////////////////////
+// acoustic features of speech segments: the audio   //
+// track of an episode is decoded once into memory,  //
+// then MFCC, log-energy and their deltas are        //
+// computed for each segment and normalized to zero  //
+// mean and unit variance                            //
+///////////////////////////////////////////////////////
+
+class AudioFrontEnd
+{
+ public:
+  static const int SampleRate = 16000;
+
+  AudioFrontEnd(int nCeps = 19, int nFilters = 24);
+
+  static bool decode(const QString &fName, arma::fvec &samples);
+  arma::fmat computeFeatures(const arma::fvec &samples, qint64 start, qint64 end) const;
+  int getDim() const;
+
+ private:
+  arma::mat computeDeltas(const arma::mat &C) const;
+
+  int m_nCeps;
+  arma::vec m_window;  // Hamming window
+  arma::mat m_melBank; // triangular filters over FFT bins
+  arma::mat m_dct;     // cepstral coefficients from filter log-energies
+};
+
+#endif
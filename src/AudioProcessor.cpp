@@ -3,54 +3,127 @@
 #include <QRegularExpression>
 #include <QMessageBox>
 #include <QMediaPlayer>
+#include <QThread>
+#include <QDir>
+#include <QEventLoop>
+#include <QProgressDialog>
 
 #include "Episode.h"
+#include "AudioFrontEnd.h"
+#include "IVectorExtractor.h"
 
 using namespace arma;
 
-AudioProcessor::AudioProcessor(QWidget *parent)
-  : QWidget(parent)
+// episodes decoded at once: each audio track is held in memory
+static const int MaxDecoders = 4;
+
+class FeatureThread: public QThread
+{
+ public:
+  FeatureThread(const AudioFrontEnd &frontEnd, const QVector<AudioProcessor::AudioJob> &jobs, QVector<fmat> &features, QVector<bool> &decoded, int first, int step)
+    : m_frontEnd(frontEnd), m_jobs(jobs), m_features(features), m_decoded(decoded), m_first(first), m_step(step) {}
+
+ protected:
+  void run() { AudioProcessor::computeEpisodeFeatures(m_frontEnd, m_jobs, m_features, m_decoded, m_first, m_step); }
+
+ private:
+  const AudioFrontEnd &m_frontEnd;
+  const QVector<AudioProcessor::AudioJob> &m_jobs;
+  QVector<fmat> &m_features;
+  QVector<bool> &m_decoded;
+  int m_first;
+  int m_step;
+};
+
+class IVectorExtractionThread: public QThread
 {
-  m_paramProcess = new QProcess;
-  m_normProcess = new QProcess;
-  m_tvProcess = new QProcess;
-  m_ivProcess = new QProcess;
-  m_genXProcess = new QProcess;
-  m_cleanDirProcess = new QProcess;
+ public:
+  IVectorExtractionThread(IVectorExtractor &extractor, const QVector<fmat> &features, mat &X)
+    : m_extractor(extractor), m_features(features), m_X(X) {}
 
-  m_convertProcess = new QProcess;
-  m_musicTrackingProcess = new QProcess;
+ protected:
+  void run() { m_X = m_extractor.extract(m_features); }
 
-  m_output = new QLabel;
-  m_output->setFixedSize(450, 75);
-  m_output->setWindowTitle(tr("Extracting i-vectors..."));
-  m_output->hide();
+ private:
+  IVectorExtractor &m_extractor;
+  const QVector<fmat> &m_features;
+  mat &m_X;
+};
 
-  connect(m_paramProcess, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(normalizeParameters(int, QProcess::ExitStatus)));
-  connect(m_normProcess, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(estimateTVMatrix(int, QProcess::ExitStatus)));
-  connect(m_tvProcess, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(genIVectors(int, QProcess::ExitStatus)));
-  connect(m_ivProcess, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(genXMatrix(int, QProcess::ExitStatus)));
-  connect(m_genXProcess, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(cleanDir(int, QProcess::ExitStatus)));
-  connect(m_cleanDirProcess, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(ivExtractionCompleted(int, QProcess::ExitStatus)));
+AudioProcessor::AudioProcessor(QWidget *parent)
+  : QWidget(parent),
+    m_interactive(true),
+    m_extractOnMismatch(true)
+{
+  m_convertProcess = new QProcess;
+  m_musicTrackingProcess = new QProcess;
 
   connect(m_convertProcess, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(extractMusicRate(int, QProcess::ExitStatus)));
   connect(m_musicTrackingProcess, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(retrieveMusicRate(int, QProcess::ExitStatus)));
 
-  connect(m_paramProcess, SIGNAL(readyReadStandardOutput()), this, SLOT(parameterizeOutput()));
-  connect(m_normProcess, SIGNAL(readyReadStandardOutput()), this, SLOT(normalizeOutput()));
-  connect(m_tvProcess, SIGNAL(readyReadStandardOutput()), this, SLOT(tvEstimateOutput()));
-  connect(m_ivProcess, SIGNAL(readyReadStandardOutput()), this, SLOT(genIVectorsOutput()));
-
   connect(m_convertProcess, SIGNAL(readyReadStandardOutput()), this, SLOT(convertOutput()));
   connect(m_musicTrackingProcess, SIGNAL(readyReadStandardOutput()), this, SLOT(musicTrackingOutput()));
 }
 
 void AudioProcessor::extractIVectors(QList<SpeechSegment *> speechSegments)
 {
-  // m_output->show();
+  QVector<fmat> features;
+
+  // nothing to do when stored i-vectors are used
+  if (!computeFeatures(speechSegments, features))
+    return;
+
+  // UBM and total variability training run on a worker thread while
+  // the GUI thread reports their progress
+  IVectorExtractor extractor;
+  IVectorExtractionThread thread(extractor, features, m_X);
+  QEventLoop loop;
+  connect(&thread, SIGNAL(finished()), &loop, SLOT(quit()));
+
+  QProgressDialog progress(tr("Extracting i-vectors..."), tr("Cancel"), 0, 0, this);
+
+  if (m_interactive) {
+    progress.setWindowModality(Qt::WindowModal);
+    connect(&extractor, SIGNAL(progressRange(int)), &progress, SLOT(setMaximum(int)));
+    connect(&extractor, SIGNAL(progress(int)), &progress, SLOT(setValue(int)));
+    connect(&progress, SIGNAL(canceled()), &extractor, SLOT(cancel()));
+  }
+
+  thread.start();
+  loop.exec();
+  thread.wait();
 
-  if (extractAudioFiles(speechSegments))
-    parameterizeSegments();
+  if (m_interactive && progress.wasCanceled()) {
+    m_X.reset();
+    emit ivExtractionDone(false);
+    return;
+  }
+
+  if (m_X.n_rows == 0) {
+    reportError(tr("I-vectors extraction"), tr("An Error occurred while extracting i-vectors"));
+    emit ivExtractionDone(false);
+    return;
+  }
+
+  // i-vectors kept for next sessions
+  QString ivDir = "spkDiarization/iv";
+  QString ivFName = ivDir + "/X_" + m_seriesName + ".dat";
+
+  if (!QDir().mkpath(ivDir) || !m_X.save(ivFName.toStdString(), raw_ascii))
+    reportError(tr("I-vectors extraction"), tr("Couldn't save i-vectors to ") + ivFName);
+
+  if (m_interactive)
+    QMessageBox::information(this, tr("I-vectors extraction"), tr("I-vectors successfully extracted"));
+  else
+    qDebug() << "I-vectors successfully extracted";
+
+  emit ivExtractionDone(true);
+}
+
+void AudioProcessor::setInteractive(bool interactive, bool extractOnMismatch)
+{
+  m_interactive = interactive;
+  m_extractOnMismatch = extractOnMismatch;
 }
 
 arma::mat AudioProcessor::getEpisodeIVectors(QList<SpeechSegment *> speechSegments)
@@ -178,128 +251,6 @@ void AudioProcessor::extractAudioFile(const QString &epFName, int frameRate)
 // slots //
 ///////////
 
-void AudioProcessor::parameterizeSegments()
-{
-  QString program;
-  QStringList arguments;
-  
-  m_output->setWindowTitle(tr("Extracting i-vectors: 2/5..."));
-
-  // parameterizing speech segments
-  program = "sh";
-  arguments << "spkDiarization/01_RUN_feature_extraction.sh";
-  m_paramProcess->start(program, arguments);
-}
-
-void AudioProcessor::normalizeParameters(int exitCode, QProcess::ExitStatus exitStatus)
-{
-  Q_UNUSED(exitCode);
-
-  QString program;
-  QStringList arguments;
-
-  if (exitStatus == QProcess::NormalExit) {
-
-    m_output->setWindowTitle(tr("Extracting i-vectors: 3/5..."));
-
-    // normalizing parameters
-    program = "sh";
-    arguments << "spkDiarization/02a_RUN_spro_front-end.sh";
-    m_normProcess->start(program, arguments);
-  }
-
-  else
-    QMessageBox::critical(this, tr("Parameterization"), tr("An Error occurred while parameterizing speech segments"));
-
-}
-
-void AudioProcessor::estimateTVMatrix(int exitCode, QProcess::ExitStatus exitStatus)
-{
-  Q_UNUSED(exitCode);
-
-  QString program;
-  QStringList arguments;
-
-  if (exitStatus == QProcess::NormalExit) {
-
-    m_output->setWindowTitle(tr("Extracting i-vectors: 4/5..."));
-
-    // estimating total variability matrix
-    program = "sh";
-    arguments << "spkDiarization/04_RUN_tv_estimation.sh";
-    m_tvProcess->start(program, arguments);
-  }
-   else
-     QMessageBox::critical(this, tr("Normalization"), tr("An Error occurred while normalizing parameters"));
-}
-
-void AudioProcessor::genIVectors(int exitCode, QProcess::ExitStatus exitStatus)
-{
-  Q_UNUSED(exitCode);
-
-  QString program;
-  QStringList arguments;
-
-  if (exitStatus == QProcess::NormalExit) {
-
-    m_output->setWindowTitle(tr("Extracting i-vectors: 5/5..."));
-
-    // extracting i-vectors
-    program = "sh";
-    arguments << "spkDiarization/05_RUN_i-vector_extraction.sh";
-    m_ivProcess->start(program, arguments);
-  }
-  else
-    QMessageBox::critical(this, tr("Total Variability matrix estimation"), tr("An Error occurred while estimating TV Matrix"));
-}
- 
-void AudioProcessor::genXMatrix(int exitCode, QProcess::ExitStatus exitStatus)
-{
-  Q_UNUSED(exitCode);
-
-  QString program;
-  QStringList arguments;
-
-  if (exitStatus == QProcess::NormalExit) {
-
-    // exporting i-vectors into readable matrix
-    program = "sh";
-    arguments << "spkDiarization/06_RUN_X_mat_generate.sh" << m_seriesName;
-    m_genXProcess->start(program, arguments);
-  }
-  else
-    QMessageBox::critical(this, tr("I-vectors extraction"), tr("An Error occurred while extracting i-vectors"));
-
-  QString ivFName = "spkDiarization/iv/X_" + m_seriesName + ".dat";
-  m_X.load(ivFName.toStdString());
-}
-
-void AudioProcessor::cleanDir(int exitCode, QProcess::ExitStatus exitStatus)
-{
-  Q_UNUSED(exitCode);
-  Q_UNUSED(exitStatus);
-
-  QString program;
-  QStringList arguments;
-
-  if (exitStatus == QProcess::NormalExit) {
-
-    // cleaning work directories
-    program = "sh";
-    arguments << "spkDiarization/00_RUN_clean_directories.sh";
-    m_cleanDirProcess->start(program, arguments);
-  }
-}
-
-void AudioProcessor::ivExtractionCompleted(int exitCode, QProcess::ExitStatus exitStatus)
-{
-  Q_UNUSED(exitCode);
-  Q_UNUSED(exitStatus);
-  
-  m_output->hide();
-  QMessageBox::information(this, tr("I-vectors extraction"), tr("I-vectors successfully extracted"));
-}
-
 void AudioProcessor::extractMusicRate(int exitCode, QProcess::ExitStatus exitStatus)
 {
   Q_UNUSED(exitCode);
@@ -315,7 +266,7 @@ void AudioProcessor::extractMusicRate(int exitCode, QProcess::ExitStatus exitSta
     m_musicTrackingProcess->start(program, m_musicTrackArgs);
   }
   else
-    QMessageBox::critical(this, tr("Audio file extraction"), tr("An Error occurred while extracting audio file"));
+    reportError(tr("Audio file extraction"), tr("An Error occurred while extracting audio file"));
 }
 
 void AudioProcessor::retrieveMusicRate(int exitCode, QProcess::ExitStatus exitStatus)
@@ -342,110 +293,13 @@ void AudioProcessor::retrieveMusicRate(int exitCode, QProcess::ExitStatus exitSt
     QFile::remove("musicTracking/output/M.dat");
     QFile::remove("musicTracking/data/wav/audioFile.wav");
 
-    QMessageBox::information(this, tr("Music tracking"), tr("Musical features successfully extracted"));
+    if (m_interactive)
+      QMessageBox::information(this, tr("Music tracking"), tr("Musical features successfully extracted"));
+    else
+      qDebug() << "Musical features successfully extracted";
   }
   else
-    QMessageBox::critical(this, tr("Musical features extraction"), tr("An Error occurred while extracting musical features"));
-}
-
-void AudioProcessor::parameterizeOutput() 
-{
-  QRegularExpression re("(\\d+)_(\\d+)_(\\d+)");
-  char buf[1024];
-  qint64 lineLength = m_paramProcess->readLine(buf, sizeof(buf));
-
-  if (lineLength != -1) {
-    QString outputText = QString::fromLocal8Bit(buf);
-    QRegularExpressionMatch match = re.match(outputText);
-    
-    if (match.hasMatch()) {
-      QString outputText = 
-	"<b>Parameterizing</b>: Season " +
-	match.captured(1) +
-	" - Episode " +
-	match.captured(2) +
-	" - Segment " +
-	match.captured(3);
-
-      m_output->setText(outputText);
-      m_output->setAlignment(Qt::AlignCenter);
-    }
-  }
-}
-
-void AudioProcessor::normalizeOutput() 
-{
-  QRegularExpression re("Writing to: (\\d+)_(\\d+)_(\\d+)");
-  char buf[1024];
-  qint64 lineLength = m_normProcess->readLine(buf, sizeof(buf));
-  if (lineLength != -1) {
-    QString outputText = QString::fromLocal8Bit(buf);
-    QRegularExpressionMatch match = re.match(outputText);
-
-    if (match.hasMatch()) {
-
-      QString outputText = 
-	"<b>Normalizing</b> parameters: Season " +
-	match.captured(1) +
-	" - Episode " +
-	match.captured(2) +
-	" - Segment " +
-	match.captured(3);
-
-      m_output->setText(outputText);
-      m_output->setAlignment(Qt::AlignCenter);
-    }
-  }
-}
-
-void AudioProcessor::tvEstimateOutput() 
-{
-  QRegularExpression re("for \\[(\\d+)_(\\d+)_(\\d+)_\\d+_\\d+\\]");
-  char buf[1024];
-  qint64 lineLength = m_normProcess->readLine(buf, sizeof(buf));
-  if (lineLength != -1) {
-    QString outputText = QString::fromLocal8Bit(buf);
-    QRegularExpressionMatch match = re.match(outputText);
-
-    if (match.hasMatch()) {
-
-      QString outputText = 
-	"<b>Total variability matrix</b> estimation...<br />Processing: Season " +
-	match.captured(1) +
-	" - Episode " +
-	match.captured(2) +
-	" - Segment " +
-	match.captured(3);
-
-      m_output->setText(outputText);
-      m_output->setAlignment(Qt::AlignCenter);
-    }
-  }
-}
-
-void AudioProcessor::genIVectorsOutput()
-{
-  QRegularExpression re("for \\[(\\d+)_(\\d+)_(\\d+)_\\d+_\\d+\\]");
-  char buf[1024];
-  qint64 lineLength = m_normProcess->readLine(buf, sizeof(buf));
-  if (lineLength != -1) {
-    QString outputText = QString::fromLocal8Bit(buf);
-    QRegularExpressionMatch match = re.match(outputText);
-
-    if (match.hasMatch()) {
-
-      QString outputText = 
-	"<b>Generating i-vectors</b>...<br />Processing: Season " +
-	match.captured(1) +
-	" - Episode " +
-	match.captured(2) +
-	" - Segment " +
-	match.captured(3);
-
-      m_output->setText(outputText);
-      m_output->setAlignment(Qt::AlignCenter);
-    }
-  }
+    reportError(tr("Musical features extraction"), tr("An Error occurred while extracting musical features"));
 }
 
 void AudioProcessor::convertOutput()
@@ -472,35 +326,20 @@ void AudioProcessor::musicTrackingOutput()
 // auxiliary methods //
 ///////////////////////
 
-bool AudioProcessor::extractAudioFiles(QList<SpeechSegment *> speechSegments)
+bool AudioProcessor::computeFeatures(QList<SpeechSegment *> speechSegments, QVector<fmat> &features)
 {
-  // creating audio files corresponding to speech segments
-  QFile lstFile("spkDiarization/data/data.lst");
-  QFile totVarFile("spkDiarization/ndx/totalvariability.ndx");
-  QFile ivExtFile("spkDiarization/ndx/ivExtractor.ndx");
-    
-  if (!lstFile.open(QIODevice::WriteOnly | QIODevice::Text))
-    return false;
-
-  if (!totVarFile.open(QIODevice::WriteOnly | QIODevice::Text))
-    return false;
-
-  if (!ivExtFile.open(QIODevice::WriteOnly | QIODevice::Text))
-    return false;
-
-  QTextStream lstOut(&lstFile);
-  QTextStream totVarOut(&totVarFile);
-  QTextStream ivExtOut(&ivExtFile);
-
   // retrieve series
   Series *series = retrieveSeries(speechSegments, m_seriesName);
 
+  if (!series)
+    return false;
+
   // retrieve audio data
-  QMap<int, QMap<int, QString> > videoFiles;
-  QMap<int, QMap<int, QStringList> > lstLines;
-  QMap<int, QMap<int, QProcess *> > aviToWaveProcesses;
+  QVector<AudioJob> jobs;
   int count(0);
-  retrieveAudioData(series, videoFiles, aviToWaveProcesses, lstLines, count);
+  m_epBound.clear();
+  m_spkIdx.clear();
+  retrieveAudioData(series, jobs, count);
 
   // load (possibly existing) matrix containing i-vectors
   QString ivFName = "spkDiarization/iv/X_" + m_seriesName + ".dat";
@@ -510,152 +349,71 @@ bool AudioProcessor::extractAudioFiles(QList<SpeechSegment *> speechSegments)
   // check if X is consistent with current data
   if (XExists) {
     int nbStoredSeg = m_X.n_rows;
-    int nbCurrSeg = 0;
-
-    QMap<int, QMap<int, QStringList> >::const_iterator it1 = lstLines.begin();
-    while (it1 != lstLines.end()) {
-
-      int seasNbr = it1.key();
-      QMap<int, QStringList>::const_iterator it2 = it1.value().begin();
-    
-      while (it2 != it1.value().end()) {
-
-	int epNbr = it2.key();
-	nbCurrSeg += lstLines[seasNbr][epNbr].size();
-			   
-	it2++;
-      }
-
-      it1++;
-    }
+    int nbCurrSeg = count;
 
     consistent = (nbStoredSeg == nbCurrSeg);
     
-    if (!consistent) {
+    if (!consistent && m_interactive) {
       int answer = QMessageBox::question(this, "Inconsistency issue", "Number of stored i-vectors (" + QString::number(nbStoredSeg) + ") is not consistent with current number of speech segments (" + QString::number(nbCurrSeg) + ").<br /><b>Extract i-vectors?</b>", QMessageBox::Yes | QMessageBox::No);
 
       if (answer == QMessageBox::No)
 	consistent = true;
     }
+
+    // answer given beforehand when nobody can be asked
+    else if (!consistent) {
+      qDebug() << "Number of stored i-vectors (" << nbStoredSeg << ") not consistent with current number of speech segments (" << nbCurrSeg << ")";
+      consistent = !m_extractOnMismatch;
+    }
   }
 
   // if stored i-vectors are consistent with current number of speech segments
   if (XExists && consistent)
     return false;
 
-  // extracting audio files
-  QString program;
-  QStringList arguments;
+  // audio tracks decoded in memory and speech segments parameterized,
+  // several episodes at once
+  AudioFrontEnd frontEnd;
+  QVector<bool> decoded(jobs.size(), false);
+  features.fill(fmat(frontEnd.getDim(), 0), count);
 
-  // generating .wav files
-  QMap<int, QMap<int, QString> >::const_iterator it1 = videoFiles.begin();
+  int nThreads = qMax(1, qMin(qMin(QThread::idealThreadCount(), MaxDecoders), jobs.size()));
+  QList<FeatureThread *> threads;
 
-  while (it1 != videoFiles.end()) {
+  for (int k(0); k < nThreads; k++) {
+    threads.push_back(new FeatureThread(frontEnd, jobs, features, decoded, k, nThreads));
+    threads.last()->start();
+  }
 
-    int seasNbr = it1.key();
-    QMap<int, QString>::const_iterator it2 = it1.value().begin();
-    
-    while (it2 != it1.value().end()) {
+  for (int k(0); k < nThreads; k++)
+    threads[k]->wait();
 
-      int epNbr = it2.key();
-      QString videoFile = it2.value();
+  qDeleteAll(threads);
 
-      QString waveFile = 
-	"spkDiarization/data/sph/" +
-	QString::number(seasNbr) + "_" +
-	QString::number(epNbr) + ".wav";
+  for (int i(0); i < jobs.size(); i++)
+    if (!decoded[i]) {
+      reportError(tr("Parameterization"), tr("An Error occurred while decoding audio track of ") + jobs[i].fName);
+      emit ivExtractionDone(false);
+      return false;
+    }
 
-      // qDebug() << seasNbr << epNbr << videoFile << waveFile;
+  return true;
+}
 
-      program = "ffmpeg";
-      arguments << "-i" << videoFile << "-map" << "0:1" << "-vn" << "-acodec" << "pcm_s16le" <<"-ar" << "16000" << "-ac" << "2" << waveFile;
-      aviToWaveProcesses[seasNbr][epNbr]->start(program, arguments);
-      aviToWaveProcesses[seasNbr][epNbr]->waitForFinished();
-      arguments.clear();
+void AudioProcessor::computeEpisodeFeatures(const AudioFrontEnd &frontEnd, const QVector<AudioJob> &jobs, QVector<fmat> &features, QVector<bool> &decoded, int first, int step)
+{
+  for (int i(first); i < jobs.size(); i += step) {
 
-      it2++;
-    }
-    it1++;
-  }
+    fvec samples;
 
-  // generating .sph files
-  it1 = videoFiles.begin();
-    
-  while (it1 != videoFiles.end()) {
+    if (!AudioFrontEnd::decode(jobs[i].fName, samples))
+      continue;
 
-    int seasNbr = it1.key();
-    QMap<int, QString>::const_iterator it2 = it1.value().begin();
-    
-    while (it2 != it1.value().end()) {
-
-      int epNbr = it2.key();
-
-      QString waveFile = 
-	"spkDiarization/data/sph/" +
-	QString::number(seasNbr) + "_" +
-	QString::number(epNbr) + ".wav";
-
-      QString sphFile =
-      "spkDiarization/data/sph/" +
-	QString::number(seasNbr) + "_" +
-	QString::number(epNbr) + ".sph";
-
-      // converting .wav audio file to .sph audio file
-      // qDebug() << seasNbr << epNbr << waveFile << sphFile;
-
-      QProcess wavToSphProcess;
-      program = "sox";
-      arguments << waveFile << sphFile;
-      wavToSphProcess.start(program, arguments);
-      wavToSphProcess.waitForFinished();
-      arguments.clear();
-      QFile::remove(waveFile);
-
-      // extraction audio files corresponding to speech segments
-      QStringList segmentsList = lstLines[seasNbr][epNbr];
-
-      // RE used to retrieve segment time boundaries
-      QRegularExpression re("\\d+_\\d+_\\d+_(\\d+)_(\\d+)");
-
-      for (int i(0); i < segmentsList.size(); i++) {
-
-	QString lstLine = segmentsList[i];
-
-	// writing out current segment in data files
-	lstOut << lstLine << endl;
-	totVarOut << lstLine << endl;
-	ivExtOut << lstLine << " " << lstLine << endl;
-
-	QRegularExpressionMatch match = re.match(lstLine);
-	
-	qreal start(-1.0);
-	qreal end(-1.0);
-	
-	if (match.hasMatch()) {
-	  start = ((match.captured(1)).toDouble()) / 1000.0;
-	  end = ((match.captured(2)).toDouble()) / 1000.0;
-	}
-
-	// extracting .sph speech segments
-	QString sphSubFile = "spkDiarization/data/sph/" + lstLine + ".sph";
-	// qDebug() << sphSubFile;
-
-	QProcess splitProcess;
-	program = "sox";
-	arguments << sphFile << sphSubFile << "trim" << QString::number(start) << "=" + QString::number(end);
-	splitProcess.start(program, arguments);
-	splitProcess.waitForFinished();
-	arguments.clear();
-      }
-
-      QFile::remove(sphFile);
+    for (int j(0); j < jobs[i].bound.size(); j++)
+      features[jobs[i].firstRow + j] = frontEnd.computeFeatures(samples, jobs[i].bound[j].first, jobs[i].bound[j].second);
 
-      it2++;
-    }
-    it1++;
+    decoded[i] = true;
   }
-  
-  return true;
 }
 
 Series * AudioProcessor::retrieveSeries(QList<SpeechSegment *> speechSegments, QString &name)
@@ -672,7 +430,7 @@ Series * AudioProcessor::retrieveSeries(QList<SpeechSegment *> speechSegments, Q
   return series;
 }
 
-void AudioProcessor::retrieveAudioData(Segment *segment, QMap<int, QMap<int, QString> > &videoFiles, QMap<int, QMap<int, QProcess *> > &aviToWaveProcesses, QMap<int, QMap<int, QStringList> > &lstLines, int &count)
+void AudioProcessor::retrieveAudioData(Segment *segment, QVector<AudioJob> &jobs, int &count)
 {
   Episode *episode;
 
@@ -681,7 +439,6 @@ void AudioProcessor::retrieveAudioData(Segment *segment, QMap<int, QMap<int, QSt
     // retrieve current episode features
     int seasNbr = episode->parent()->getNumber();
     int epNbr = episode->getNumber();
-    QString epFName = episode->getFName();
 
     // retrieve and filter speech segments
     QList<SpeechSegment *> speechSegments = episode->getSpeechSegments();
@@ -689,28 +446,22 @@ void AudioProcessor::retrieveAudioData(Segment *segment, QMap<int, QMap<int, QSt
     speechSegments = filterSpeechSegments(speechSegments);
 
     // looping over speech segments
-    QString lstLine;
+    AudioJob job;
+    job.fName = episode->getFName();
+    job.firstRow = count;
 
     for (int i(0); i < speechSegments.size(); i++) {
 
-      lstLine = 
-	QString::number(seasNbr) + "_" +
-	QString::number(epNbr) + "_" +
-	QString::number(i + 1) + "_" +
-	QString::number(speechSegments[i]->getPosition()) + "_" +
-	QString::number(speechSegments[i]->getEnd());
-
-      lstLines[seasNbr][epNbr].push_back(lstLine);
+      job.bound.push_back(QPair<qint64, qint64>(speechSegments[i]->getPosition(), speechSegments[i]->getEnd()));
 
       QString speaker = speechSegments[i]->getLabel(Segment::Manual);
       m_spkIdx[speaker].push_back(count + i);
     }
 
-    // setting video file and episode boundaries if speech segments were found
+    // setting audio track and episode boundaries if speech segments were found
     if (speechSegments.size() > 0) {
 
-      videoFiles[seasNbr][epNbr] = epFName;
-      aviToWaveProcesses[seasNbr][epNbr] = new QProcess;
+      jobs.push_back(job);
 
       m_epBound[seasNbr][epNbr] = QPair<int, int>(count,
 						  count + speechSegments.size() - 1);
@@ -720,7 +471,7 @@ void AudioProcessor::retrieveAudioData(Segment *segment, QMap<int, QMap<int, QSt
 
   else
     for (int i(0); i < segment->childCount(); i++)
-      retrieveAudioData(segment->child(i), videoFiles, aviToWaveProcesses, lstLines, count);
+      retrieveAudioData(segment->child(i), jobs, count);
 }
 
 QList<SpeechSegment *> AudioProcessor::denoiseSpeechSegments(QList<SpeechSegment *> speechSegments)
@@ -744,3 +495,11 @@ QList<SpeechSegment *> AudioProcessor::filterSpeechSegments(QList<SpeechSegment
   
   return filtered;
 }
+
+void AudioProcessor::reportError(const QString &title, const QString &text)
+{
+  if (m_interactive)
+    QMessageBox::critical(this, title, text);
+  else
+    qWarning() << title << ":" << text;
+}
@@ -4,6 +4,7 @@
 #include <QObject>
 #include <QFile>
 #include <QMap>
+#include <QVector>
 #include <QProcess>
 #include <QLabel>
 
@@ -13,6 +14,7 @@
 
 #include "Series.h"
 #include "SpeechSegment.h"
+#include "AudioFrontEnd.h"
 
 class AudioProcessor: public QWidget
 {
@@ -21,6 +23,7 @@ class AudioProcessor: public QWidget
  public:
   AudioProcessor(QWidget *parent = 0);
   void extractIVectors(QList<SpeechSegment *> speechSegments);
+  void setInteractive(bool interactive, bool extractOnMismatch = true);
   arma::mat getEpisodeIVectors(QList<SpeechSegment *> speechSegments);
   arma::mat genWMat();
   arma::mat genSigmaMat();
@@ -30,43 +33,40 @@ class AudioProcessor: public QWidget
   QList<SpeechSegment *> filterSpeechSegments(QList<SpeechSegment *> speechSegments);
 
   public slots:
-    void parameterizeSegments();
-    void normalizeParameters(int exitCode, QProcess::ExitStatus exitStatus);
-    void estimateTVMatrix(int exitCode, QProcess::ExitStatus exitStatus);
-    void genIVectors(int exitCode, QProcess::ExitStatus exitStatus);
-    void genXMatrix(int exitCode, QProcess::ExitStatus exitStatus);
-    void cleanDir(int exitCode, QProcess::ExitStatus exitStatus);
-    void ivExtractionCompleted(int exitCode, QProcess::ExitStatus exitStatus);
     void extractMusicRate(int exitCode, QProcess::ExitStatus exitStatus);  
     void retrieveMusicRate(int exitCode, QProcess::ExitStatus exitStatus);
 
-    void parameterizeOutput();
-    void normalizeOutput();
-    void tvEstimateOutput();
-    void genIVectorsOutput();
     void convertOutput();
     void musicTrackingOutput();
 
     signals:
     void musicRateRetrieved(QPair<qint64, qreal> musicRate);
+    void ivExtractionDone(bool success);
   
     private:
-    bool extractAudioFiles(QList<SpeechSegment *> speechSegments);
-    void retrieveAudioData(Segment *segment, QMap<int, QMap<int, QString> > &videoFiles, QMap<int, QMap<int, QProcess *> > &aviToWaveProcesses, QMap<int, QMap<int, QStringList> > &lstLines, int &count);
+    // speech segments of an episode, parameterized from its audio track
+    struct AudioJob {
+      QString fName;
+      int firstRow;
+      QList<QPair<qint64, qint64> > bound;
+    };
+
+    friend class FeatureThread;
+
+    bool computeFeatures(QList<SpeechSegment *> speechSegments, QVector<arma::fmat> &features);
+    static void computeEpisodeFeatures(const AudioFrontEnd &frontEnd, const QVector<AudioJob> &jobs, QVector<arma::fmat> &features, QVector<bool> &decoded, int first, int step);
+    void retrieveAudioData(Segment *segment, QVector<AudioJob> &jobs, int &count);
     Series * retrieveSeries(QList<SpeechSegment *> speechSegments, QString &name);
     void extractAudioFile(const QString &epFName, int frameRate);
+    void reportError(const QString &title, const QString &text);
 
     QString m_seriesName;
-    QProcess *m_paramProcess;
-    QProcess *m_normProcess;
-    QProcess *m_tvProcess;
-    QProcess *m_ivProcess;
-    QProcess *m_genXProcess;
-    QProcess *m_cleanDirProcess;
     QProcess *m_convertProcess;
     QProcess *m_musicTrackingProcess;
 
-    QLabel *m_output;
+    // no dialog shown when disabled
+    bool m_interactive;
+    bool m_extractOnMismatch;
 
     arma::mat m_X;
     QMap<int, QMap<int, QPair<int, int> > > m_epBound;
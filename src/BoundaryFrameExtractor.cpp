@@ -0,0 +1,79 @@
+#include <algorithm>
+
+#include "BoundaryFrameExtractor.h"
+
+using namespace cv;
+
+BoundaryFrameExtractor::BoundaryFrameExtractor(int nFrames)
+  : m_nFrames(qMax(1, nFrames)),
+    m_next(0)
+{
+}
+
+bool BoundaryFrameExtractor::open(const QString &fName, const QList<qint64> &timestamps)
+{
+  m_cap.release();
+  m_buffer.clear();
+  m_next = 0;
+
+  // frames are retrieved in a single forward pass
+  m_timestamps = timestamps;
+  std::sort(m_timestamps.begin(), m_timestamps.end());
+
+  return m_cap.open(fName.toStdString());
+}
+
+bool BoundaryFrameExtractor::next(QVector<cv::Mat> &frames)
+{
+  frames.clear();
+
+  if (m_next >= m_timestamps.size())
+    return false;
+
+  qint64 t = m_timestamps[m_next++];
+
+  // frames already decoded for previous timestamp when both overlap
+  for (int i(0); i < m_buffer.size(); i++)
+    if (m_buffer[i].first >= t && frames.size() < m_nFrames)
+      frames.push_back(m_buffer[i].second);
+
+  // decoding forward up to the needed frames
+  while (frames.size() < m_nFrames) {
+
+    qint64 position = m_cap.get(CV_CAP_PROP_POS_MSEC);
+
+    if (!m_cap.grab())
+      break;
+
+    // frame before requested timestamp: dropped without conversion
+    if (position < t)
+      continue;
+
+    Mat frame;
+    m_cap.retrieve(frame);
+
+    m_buffer.push_back(QPair<qint64, Mat>(position, frame));
+    if (m_buffer.size() > m_nFrames)
+      m_buffer.pop_front();
+
+    frames.push_back(frame);
+  }
+
+  // end of video reached: missing frames are left empty
+  bool complete(frames.size() == m_nFrames);
+
+  while (frames.size() < m_nFrames)
+    frames.push_back(Mat());
+
+  return complete;
+}
+
+qint64 BoundaryFrameExtractor::getTimestamp() const
+{
+  return m_next > 0 ? m_timestamps[m_next - 1] : -1;
+}
+
+qreal BoundaryFrameExtractor::getFrameHeight()
+{
+  return m_cap.get(CV_CAP_PROP_FRAME_HEIGHT);
+}
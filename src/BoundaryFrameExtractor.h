@@ -0,0 +1,37 @@
+#ifndef BOUNDARYFRAMEEXTRACTOR_H
+#define BOUNDARYFRAMEEXTRACTOR_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QPair>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include "opencv2/videoio.hpp"
+
+///////////////////////////////////////////////////////
+// retrieves the frames located at a sorted list of  //
+// timestamps in one forward decoding pass, frames   //
+// in between are grabbed but never converted        //
+///////////////////////////////////////////////////////
+
+class BoundaryFrameExtractor
+{
+ public:
+  BoundaryFrameExtractor(int nFrames = 1);
+
+  bool open(const QString &fName, const QList<qint64> &timestamps);
+  bool next(QVector<cv::Mat> &frames);
+  qint64 getTimestamp() const;
+  qreal getFrameHeight();
+
+ private:
+  cv::VideoCapture m_cap;
+  int m_nFrames;
+  QList<qint64> m_timestamps;
+  int m_next;
+  QList<QPair<qint64, cv::Mat> > m_buffer;
+};
+
+#endif
@@ -1,13 +1,23 @@
 #include <QDebug>
 #include <QPointF>
 #include <QLineF>
+#include <QHash>
+
+#include <algorithm>
 
 #include "Dendogram.h"
 #include "Optimizer.h"
+#include "SilhouetteEvaluator.h"
 
 using namespace std;
 using namespace arma;
 
+// ordering of merges by height
+static bool lessHeight(const QPair<qreal, DendogramNode *> &merge1, const QPair<qreal, DendogramNode *> &merge2)
+{
+  return merge1.first < merge2.first;
+}
+
 Dendogram::Dendogram()
   : m_root(nullptr),
     m_bestCutValue(0)
@@ -139,7 +149,6 @@ qreal Dendogram::getBestCutValue(DendogramNode *node)
 {
   QList<qreal> ultDists;
   QList<qreal> cutDists;
-  QList<QList<QList<int>>> partitions;
   int bestIdx(-1);
 
   // retrieving nodes ultrametric distances
@@ -153,14 +162,8 @@ qreal Dendogram::getBestCutValue(DendogramNode *node)
   if (ultDists.size() > 0)
     cutDists.push_front(ultDists[0] + 1);
 
-  // initializing list of possible partitions of the data set
-  for (int i(0); i < cutDists.size(); i++) {
-    QList<QList<int>> parti = cutTree(node, cutDists[i]);
-    partitions.push_back(parti);
-  }
-
-  if (partitions.size() > 0)
-    bestIdx = getBestPartIdxSil(partitions);
+  if (cutDists.size() > 0)
+    bestIdx = getBestPartIdxSil(node, cutDists);
   
   if (bestIdx == -1)
     return 0.0;
@@ -215,114 +218,67 @@ void Dendogram::retrieveUltDist(DendogramNode *node, QList<qreal> &ultDists)
   }
 }
 
-int Dendogram::getBestPartIdxSil(QList<QList<QList<int>>> partitions)
+int Dendogram::getBestPartIdxSil(DendogramNode *node, const QList<qreal> &cutDists)
 {
-  int n(partitions[0][0].size()); // number of instances
-  QVector<qreal> Q(n);            // quality measure for each partition
-  QVector<int> map(n);
-  QMap<int, int> mapInv;
-  QVector<int> C(n);              // cluster of each instance
-  QVector<QVector<qreal>> D(n);   // distance between each instance and each cluster
-  QVector<qreal> a(n);            // distance between an instance and its cluster
-  QVector<qreal> b(n);            // distance between an instance and the second closest cluster
-  QVector<qreal> s(n);            // measures if instance is correctly classified
+  QList<DendogramNode *> leaves;
+  QList<QPair<qreal, DendogramNode *> > merges;
+  QHash<DendogramNode *, int> clusters;
+  int n(0);                        // number of instances
+  QVector<qreal> Q(cutDists.size()); // quality measure for each partition
   int iBest(0);
   Q[iBest] = -1.0;
-  
-  // saving indices
+
+  // distances between instances of the tree
+  getClusterInstances(node, leaves);
+  n = leaves.size();
+
+  uvec idx(n);
   for (int i(0); i < n; i++) {
-    map[i]  = partitions[0][0][i];
-    mapInv[partitions[0][0][i]] = i;
+    idx(i) = leaves[i]->getLabel();
+    clusters[leaves[i]] = i;
   }
 
-  // looping over the partitions containing (2, ..., n) elements
-  for (int i(1); i < partitions.size(); i++) {
-    
-    // current partition
-    QList<QList<int>> partition = partitions[i];
-
-    // for each instance, retrieving its cluster
-    for (int j(0); j < n; j++) {
-      int k(0);
-      bool found(false);
-      while (!found && k < partition.size()) {
-	if (partition[k].contains(map[j])) {
-	  C[j] = k;
-	  found = true;
-	}
-	k++;
-      }
-    }
-    // for each instance, computing its average distance from members of each cluster
-    QVector<qreal> d(partition.size());
-
-    // looping over instances
-    for (int j(0); j < n; j++) {
-
-      // looping over clusters
-      for (int k(0); k < partition.size(); k++) {
-
-	// initializing distance between instance j and cluster k
-	d[k] = 0.0;
-	int clusterCard = partition[k].size();
- 
-	// looping over cluster instances
-	for (int l(0); l < clusterCard; l++)
-	  if (map[j] != partition[k][l]) {
-	   
-	    d[k] += m_D(map[j], partition[k][l]);
-	  }
-
-	// normalizing distance between instance j and cluster k
-	int normFac = (k == C[j]) ? clusterCard - 1 : clusterCard;
-	d[k] /= normFac;
-      }
-
-      // distance between current instance and its cluster
-      a[j] = d[C[j]];
-
-      // computing distance between current instance and second closest cluster
-      // initialization
-      int k(0);
-      while (k < partition.size() && k == C[j])
-	k++;
-      b[j] = d[k];
-
-      // retrieving closest cluster
-      for (int k(0); k < partition.size(); k++) {
-	if (k != C[j] && d[k] < b[j])
-	  b[j] = d[k];
-      }
-
-      // computing s(x_i)
-      if (partition[C[j]].size() == 1)
-	s[j] = 0;
-      else
-	s[j] = (b[j] - a[j]) / std::max(a[j], b[j]);
-    }
+  SilhouetteEvaluator evaluator(m_D.submat(idx, idx));
 
-    // looping over clusters
-    for (int k(0); k < partition.size(); k++) {
-      qreal mean = 0.0;
-
-      for (int j(0); j < partition[k].size(); j++) {
-	int idx = mapInv[partition[k][j]];
-	mean += s[idx];
-      }
-	
-      mean /= partition[k].size();
-      Q[i] += partition[k].size() * mean;
+  // merges sorted by height: sons merged before fathers
+  retrieveMerges(node, node->getUltDist(), merges);
+  std::stable_sort(merges.begin(), merges.end(), lessHeight);
+
+  // partitions containing (n, ..., 2) elements: merging clusters
+  // whose height falls below current cut value
+  int next(0);
+
+  for (int i(cutDists.size() - 1); i > 0; i--) {
+
+    while (next < merges.size() && merges[next].first <= cutDists[i]) {
+      DendogramNode *merged = merges[next].second;
+      clusters[merged] = evaluator.merge(clusters[merged->getLeftSon()], clusters[merged->getRightSon()]);
+      next++;
     }
 
-    Q[i] /= n;
+    Q[i] = evaluator.getScore();
+  }
 
+  for (int i(1); i < cutDists.size(); i++)
     if (Q[i] >= Q[iBest])
       iBest = i;
-  }
 
   return iBest;
 }
 
+void Dendogram::retrieveMerges(DendogramNode *node, qreal height, QList<QPair<qreal, DendogramNode *> > &merges)
+{
+  if (node == nullptr || node->getLabel() != -1)
+    return;
+
+  // subtree kept whole as soon as one of its ancestors is
+  height = qMin(height, node->getUltDist());
+
+  retrieveMerges(node->getLeftSon(), height, merges);
+  retrieveMerges(node->getRightSon(), height, merges);
+  merges.push_back(QPair<qreal, DendogramNode *>(height, node));
+}
+
 int Dendogram::retrieveSubsetMedoid(const QList<int> &selectedLabels)
 {
   int i(-1);
@@ -336,8 +292,10 @@ int Dendogram::retrieveSubsetMedoid(const QList<int> &selectedLabels)
   // distance submatrix
   arma::mat S = m_D.submat(I, I);
 
-  // retrieve medoid
+  // retrieve medoid: the greedy step of the heuristic solver is
+  // exact with a single center
   Optimizer optimizer;
+  optimizer.setSolverMode(Optimizer::Heuristic);
   QList<QList<int> > partition;
   QList<int> cIdx;
   qreal objValue(0.0);
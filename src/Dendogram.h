@@ -26,7 +26,8 @@ class Dendogram
   QList<QList<int>> cutTree(DendogramNode *node, qreal ultDist);
   void cutTree(DendogramNode *node, qreal ultDist, QList<DendogramNode *> &subTrees);
   void retrieveUltDist(DendogramNode *node, QList<qreal> &ultDists);
-  int getBestPartIdxSil(QList<QList<QList<int>>> partitions);
+  int getBestPartIdxSil(DendogramNode *node, const QList<qreal> &cutDists);
+  void retrieveMerges(DendogramNode *node, qreal height, QList<QPair<qreal, DendogramNode *> > &merges);
 
   void getCoordinates(QList<QPair<QLineF, QPair<int, bool> > > &coord);
   void getCoordinates(DendogramNode *node, QList<QPair<QLineF, QPair<int, bool> > > &coord, int leftMost, QPointF from);
@@ -0,0 +1,194 @@
+#include <QThread>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QDebug>
+
+#include "DistanceKernel.h"
+
+using namespace arma;
+
+// instances below which a single thread is used
+static const uword MinBlockRows = 128;
+
+class DistanceBlockThread: public QThread
+{
+ public:
+  DistanceBlockThread(const mat &Y, const mat &Z, const vec &normsY, const vec &normsZ, mat &D, uword first, uword last)
+    : m_Y(Y), m_Z(Z), m_normsY(normsY), m_normsZ(normsZ), m_D(D), m_first(first), m_last(last) {}
+
+ protected:
+  void run() { DistanceKernel::computeBlock(m_Y, m_Z, m_normsY, m_normsZ, m_D, m_first, m_last); }
+
+ private:
+  const mat &m_Y;
+  const mat &m_Z;
+  const vec &m_normsY;
+  const vec &m_normsZ;
+  mat &m_D;
+  uword m_first;
+  uword m_last;
+};
+
+////////////////////
+// public methods //
+////////////////////
+
+mat DistanceKernel::distMat(const mat &S, const mat &SigmaInv, UtteranceTree::DistType dist, int nThreads)
+{
+  switch (dist) {
+  case UtteranceTree::L2:
+    return l2DistMat(S, nThreads);
+  case UtteranceTree::Mahal:
+    return mahalDistMat(S, SigmaInv, nThreads);
+  }
+
+  return mat();
+}
+
+mat DistanceKernel::l2DistMat(const mat &S, int nThreads)
+{
+  return gramDistMat(S, S, nThreads);
+}
+
+mat DistanceKernel::mahalDistMat(const mat &S, const mat &SigmaInv, int nThreads)
+{
+  mat R;
+
+  // SigmaInv = R' * R: Mahalanobis distances are L2 distances
+  // between whitened instances S * R'
+  if (chol(R, SigmaInv)) {
+    mat Y = S * R.t();
+    return gramDistMat(Y, Y, nThreads);
+  }
+
+  // inverse covariance matrix not positive definite:
+  // (u - v) SigmaInv (u - v)' = u SigmaInv u' + v SigmaInv v' - 2 u SigmaInv v'
+  static QAtomicInt warned(0);
+
+  if (warned.testAndSetRelaxed(0, 1))
+    qWarning() << "Inverse covariance matrix not positive definite: no whitening";
+
+  return gramDistMat(S * SigmaInv, S, nThreads);
+}
+
+void DistanceKernel::benchmark(const QList<int> &sizes, int dim, int nThreads)
+{
+  QElapsedTimer timer;
+
+  // random positive definite inverse covariance matrix
+  arma_rng::set_seed(0);
+  mat A(dim, dim, fill::randn);
+  mat SigmaInv = A * A.t() / dim + eye<mat>(dim, dim);
+
+  qDebug() << "distance" << "instances" << "loop (s)" << "kernel (s)" << "speed-up" << "max. error";
+
+  for (int i(0); i < sizes.size(); i++) {
+
+    mat S(sizes[i], dim, fill::randn);
+
+    for (int j(0); j < 2; j++) {
+
+      UtteranceTree::DistType dist = (j == 0) ? UtteranceTree::L2 : UtteranceTree::Mahal;
+
+      timer.start();
+      mat D1 = loopDistMat(S, SigmaInv, dist);
+      qint64 loopTime = timer.nsecsElapsed();
+
+      timer.start();
+      mat D2 = distMat(S, SigmaInv, dist, nThreads);
+      qint64 kernelTime = timer.nsecsElapsed();
+
+      qDebug() << ((dist == UtteranceTree::L2) ? "L2" : "Mahal")
+	       << sizes[i]
+	       << QString::number(loopTime / 1e9, 'f', 3)
+	       << QString::number(kernelTime / 1e9, 'f', 3)
+	       << QString::number(loopTime / static_cast<qreal>(qMax(kernelTime, static_cast<qint64>(1))), 'f', 1)
+	       << (S.n_rows > 0 ? abs(D1 - D2).max() : 0.0);
+    }
+  }
+}
+
+/////////////////////
+// private methods //
+/////////////////////
+
+mat DistanceKernel::gramDistMat(const mat &Y, const mat &Z, int nThreads)
+{
+  uword n(Y.n_rows);
+  mat D(n, n);
+
+  // squared norms: ||y_i - z_j||^2 = y_i . z_i + y_j . z_j - 2 y_i . z_j
+  vec normsY = sum(Y % Z, 1);
+  vec normsZ = normsY;
+
+  if (nThreads <= 0)
+    nThreads = QThread::idealThreadCount();
+
+  uword nBlocks = qMax(static_cast<uword>(1), qMin(static_cast<uword>(nThreads), n / MinBlockRows));
+
+  if (nBlocks == 1) {
+    computeBlock(Y, Z, normsY, normsZ, D, 0, n);
+    return symmatu(D);
+  }
+
+  // blocks of rows of the distance matrix
+  QList<DistanceBlockThread *> threads;
+
+  for (uword i(0); i < nBlocks; i++) {
+    threads.push_back(new DistanceBlockThread(Y, Z, normsY, normsZ, D, i * n / nBlocks, (i + 1) * n / nBlocks));
+    threads.last()->start();
+  }
+
+  for (int i(0); i < threads.size(); i++) {
+    threads[i]->wait();
+    delete threads[i];
+  }
+
+  // blocks rounded independently: same value on both sides of the diagonal
+  return symmatu(D);
+}
+
+void DistanceKernel::computeBlock(const mat &Y, const mat &Z, const vec &normsY, const vec &normsZ, mat &D, uword first, uword last)
+{
+  if (first >= last)
+    return;
+
+  // Gram matrix between block instances and all instances
+  mat G = Y.rows(first, last - 1) * Z.t();
+
+  for (uword j(0); j < D.n_cols; j++)
+    for (uword i(first); i < last; i++) {
+
+      qreal d2 = normsY(i) + normsZ(j) - 2 * G(i - first, j);
+
+      // negative values only due to rounding errors
+      D(i, j) = (i == j || d2 <= 0.0) ? 0.0 : std::sqrt(d2);
+    }
+}
+
+mat DistanceKernel::loopDistMat(const mat &S, const mat &SigmaInv, UtteranceTree::DistType dist)
+{
+  mat D(S.n_rows, S.n_rows, fill::zeros);
+  mat diff;
+  qreal d(0.0);
+
+  // previous implementation: one distance at a time
+  for (uword i(0); i < S.n_rows; i++)
+    for (uword j(i+1); j < S.n_rows; j++) {
+
+      switch (dist) {
+      case UtteranceTree::L2:
+	d = norm(S.row(i) - S.row(j));
+	break;
+      case UtteranceTree::Mahal:
+	diff = S.row(i) - S.row(j);
+	d = as_scalar(sqrt(diff * SigmaInv * diff.t()));
+	break;
+      }
+
+      D(i, j) = d;
+      D(j, i) = d;
+    }
+
+  return D;
+}
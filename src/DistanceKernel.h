@@ -0,0 +1,35 @@
+#ifndef DISTANCEKERNEL_H
+#define DISTANCEKERNEL_H
+
+#include <QList>
+
+#include <armadillo>
+
+#include "UtteranceTree.h"
+
+///////////////////////////////////////////////////////
+// pairwise distances between the rows of a matrix:  //
+// instances are whitened once with the Cholesky     //
+// factor of the inverse covariance matrix, then     //
+// distances are deduced from the Gram matrix,       //
+// computed by blocks of rows in parallel            //
+///////////////////////////////////////////////////////
+
+class DistanceKernel
+{
+ public:
+  static arma::mat distMat(const arma::mat &S, const arma::mat &SigmaInv, UtteranceTree::DistType dist, int nThreads = -1);
+  static arma::mat l2DistMat(const arma::mat &S, int nThreads = -1);
+  static arma::mat mahalDistMat(const arma::mat &S, const arma::mat &SigmaInv, int nThreads = -1);
+
+  static void benchmark(const QList<int> &sizes, int dim = 100, int nThreads = -1);
+
+ private:
+  friend class DistanceBlockThread;
+
+  static arma::mat gramDistMat(const arma::mat &Y, const arma::mat &Z, int nThreads);
+  static void computeBlock(const arma::mat &Y, const arma::mat &Z, const arma::vec &normsY, const arma::vec &normsZ, arma::mat &D, arma::uword first, arma::uword last);
+  static arma::mat loopDistMat(const arma::mat &S, const arma::mat &SigmaInv, UtteranceTree::DistType dist);
+};
+
+#endif
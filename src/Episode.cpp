@@ -166,6 +166,11 @@ QString Episode::getFName() const
   return m_fName;
 }
 
+QString Episode::getName() const
+{
+  return m_name;
+}
+
 int Episode::getNumber() const
 {
   return m_number;
@@ -22,6 +22,7 @@ class Episode: public Segment
   QSize getResolution() const;
   qreal getFps() const;
   QString getFName() const;
+  QString getName() const;
   int getNumber() const;
   QList<SpeechSegment *> getSpeechSegments() const;
   
@@ -0,0 +1,467 @@
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "EpisodeAnalyzer.h"
+#include "FrameHistoPipeline.h"
+#include "HistoCache.h"
+#include "BoundaryFrameExtractor.h"
+
+using namespace cv;
+
+/////////////////////////////////
+// constructor and destructor  //
+/////////////////////////////////
+
+EpisodeAnalyzer::EpisodeAnalyzer(int nHistoWorkers, QObject *parent)
+  : QObject(parent),
+    m_nHistoWorkers(nHistoWorkers),
+    m_canceled(0)
+{
+  // metrics are set per analysis: one frame processor per episode
+  m_vFrameProcessor = new VideoFrameProcessor;
+}
+
+EpisodeAnalyzer::~EpisodeAnalyzer()
+{
+  delete m_vFrameProcessor;
+}
+
+////////////////////////////
+// image processing tasks //
+////////////////////////////
+
+bool EpisodeAnalyzer::extractShots(const QString &fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal threshold1, qreal threshold2, int nVBlock, int nHBlock, int analysisHeight)
+{
+  // decoding and histogram computation run on background threads,
+  // frames being downscaled to analysis height right after decoding
+  FrameHistoPipeline pipeline(m_vFrameProcessor, histoType, nVBins, nHBins, nSBins, nVBlock, nHBlock, analysisHeight, m_nHistoWorkers);
+
+  // histograms previously computed for the same parameters
+  HistoCache cache;
+  bool cached = cache.open(fName, histoType, nVBins, nHBins, nSBins, nVBlock, nHBlock, analysisHeight);
+
+  // local histograms of current frame
+  QVector<Mat> locHisto;
+
+  // block histograms of current and previous frames read from cache
+  Mat histos;
+  Mat prevHistos;
+
+  // distance between current and past frame
+  qreal dist;
+
+  // frames considered to detect cut
+  QList<qreal> window;
+
+  // current frame position and index
+  qint64 position(0);
+  int n(0);
+
+  // shot beginning
+  qint64 shotStart(0);
+
+  // previous frame position
+  qint64 prevPosition(0);
+
+  // normalized local copies of thresholds
+  qreal thresh1(threshold1 / 100.0);
+  qreal thresh2(threshold2 / 100.0);
+
+  // activate appropriate metrics
+  activMetrics(metrics);
+  m_shotPositions.clear();
+
+  // metrics must be set before workers start computing distances
+  if (!cached) {
+    if (!pipeline.open(fName))
+      return false;
+    cache.create(fName, histoType, nVBins, nHBins, nSBins, nVBlock, nHBlock, analysisHeight);
+  }
+  
+  // progress bar
+  emit progressRange(cached ? cache.getFrameCount() : pipeline.getFrameCount());
+
+  // consuming frame distances in frame order
+  forever {
+
+    // histograms read from cache
+    if (cached) {
+
+      if (n >= cache.getFrameCount())
+	break;
+
+      position = cache.getPosition(n);
+      histos = cache.getHistos(n);
+
+      // compute distance from previous frame for all blocks at once
+      if (prevHistos.empty())
+	dist = m_vFrameProcessor->meanDistance(QVector<qreal>(histos.rows, 0.0));
+      else
+	dist = m_vFrameProcessor->batchDistance(histos.ptr<float>(), prevHistos.ptr<float>(), histos.rows, histos.cols);
+
+      prevHistos = histos;
+    }
+
+    // histograms computed by the pipeline and saved for later use
+    else {
+
+      if (!pipeline.next(n, position, dist, locHisto))
+	break;
+
+      cache.append(position, locHisto);
+    }
+
+    // append current distance to the window
+    window.push_back(dist);
+
+    if (window.size() > 3)
+      window.pop_front();
+
+    // insert shot at current position
+    if (window.size() == 3 && window[0] <= thresh2 && window[1] >= thresh1 && window[2] <= thresh2) {
+      m_shotPositions.push_back(shotStart);
+      emit insertShot(shotStart, prevPosition);
+      shotStart = prevPosition;
+    }
+
+    // updating previous position to current
+    prevPosition = position;
+
+    // update progress bar
+    emit progress(n);
+    if (m_canceled.load())
+      return false;
+
+    n++;
+  }
+
+  if (cached)
+    position = cache.getEndPosition();
+  else {
+    position = pipeline.getEndPosition();
+    cache.commit(position);
+  }
+
+  m_shotPositions.push_back(shotStart);
+  emit insertShot(shotStart, position);
+
+  return true;
+}
+
+bool EpisodeAnalyzer::labelSimilarShots(const QString &fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal maxDist, int windowSize, const QList<qint64> &shotPositions, int nVBlock, int nHBlock, QVector<int> &shotCamera, int analysisHeight)
+{
+  // histograms possibly computed during shot extraction
+  HistoCache cache;
+  bool cached = cache.open(fName, histoType, nVBins, nHBins, nSBins, nVBlock, nHBlock, analysisHeight);
+
+  // index of last frame of previous shot
+  int prevIdx(0);
+
+  // number of shots
+  int n(shotPositions.size());
+
+  // camera label for each shot, -1 until labelled
+  shotCamera.fill(-1, n);
+
+  if (n == 0)
+    return true;
+
+  // previous and current shot frame
+  Mat prevShotFrame;
+  Mat currShotFrame;
+
+  // block histograms of previous shot last frame and current shot first frame
+  Mat prevHistos;
+  Mat currHistos;
+
+  // histograms of past shots last frames, one row per shot in a circular
+  // buffer so that the whole window is compared at once
+  Mat windowHistos;
+  int nPast(0);
+
+  // distance between first frame of current shot and last frame of past shots
+  QVector<qreal> windowDist(windowSize);
+
+  /*** for displaying purpose ***/
+  QList<Mat> frameBuffer;
+
+  // frame duration
+  // doesn't work anymore after updating Ubuntu
+  // int frameDur = 1 / m_cap.get(CV_CAP_PROP_FPS) * 1000;
+  int frameDur = 1 / 25.0 * 1000;
+
+  // frames around shot boundaries, decoded in a single pass when not cached
+  BoundaryFrameExtractor extractor(2);
+  QVector<Mat> boundFrames;
+
+  if (!cached) {
+    QList<qint64> timestamps;
+    for (int i(1); i < n; i++)
+      timestamps.push_back(shotPositions[i] - frameDur - 40);
+
+    if (!extractor.open(fName, timestamps))
+      return false;
+  }
+  
+  // distance between local histograms
+  qreal locDistance;
+  // minimum distance from current frame observed so far
+  qreal minDistance;
+  // corresponding index
+  int jMin;
+
+  // current camera label
+  int nCamera(0);
+
+  // activate appropriate metrics
+  activMetrics(metrics);
+
+  emit progressRange(n);
+
+  // normalizing max distance required to link two shots
+  maxDist /= 100.0;
+
+  // looping over shot positions
+  shotCamera[0] = nCamera;
+
+  for (int i(1); i < n; i++) {
+    
+    /****************************/
+    /* processing previous shot */
+    /****************************/
+
+    // histograms of previous shot last frame read from cache
+    if (cached) {
+      prevIdx = cache.frameIndex(shotPositions[i] - frameDur - 40);
+      prevHistos = cache.getHistos(prevIdx);
+    }
+
+    else {
+
+      // frames around shot boundary not found
+      if (!extractor.next(boundFrames))
+	return false;
+
+      m_vFrameProcessor->prepareFrame(boundFrames[0], prevShotFrame, analysisHeight);
+      m_vFrameProcessor->prepareFrame(boundFrames[1], currShotFrame, analysisHeight);
+    
+      // compute V/HS/HSV histograms of all blocks of previous shot last frame
+      m_vFrameProcessor->genBlockHistos(prevShotFrame, histoType, nHBins, nSBins, nVBins, nVBlock, nHBlock, prevHistos);
+    }
+
+    /*** for displaying purpose ***/
+    /* Mat frameCopy;
+    prevShotFrame.copyTo(frameCopy);
+    frameBuffer.push_front(frameCopy);
+    if (frameBuffer.size() == windowSize + 1)
+    frameBuffer.pop_back(); */
+
+    // saving histograms in the window, in place of the oldest shot
+    if (windowHistos.empty() && !prevHistos.empty() && windowSize > 0)
+      windowHistos = Mat::zeros(windowSize, prevHistos.total(), CV_32F);
+
+    if (!windowHistos.empty()) {
+
+      Mat row = windowHistos.row((i - 1) % windowSize);
+
+      if (prevHistos.total() == row.total())
+	prevHistos.reshape(1, 1).copyTo(row);
+      else
+	row.setTo(Scalar(0));
+
+      nPast = qMin(nPast + 1, windowSize);
+    }
+    
+    /***************************/
+    /* processing current shot */
+    /***************************/
+
+    // histograms of current shot first frame read from cache
+    if (cached) {
+      currHistos = cache.getHistos(qMin(prevIdx + 1, cache.getFrameCount() - 1));
+    }
+
+    else {
+
+      /*** for displaying purpose ***/
+      // imshow("present", currShotFrame);
+
+      // compute V/HS/HSV histograms of all blocks of current shot first frame
+      m_vFrameProcessor->genBlockHistos(currShotFrame, histoType, nHBins, nSBins, nVBins, nVBlock, nHBlock, currHistos);
+    }
+
+    // compute distances between current and all past frames histograms at once
+    int nCompared(currHistos.total() == static_cast<size_t>(windowHistos.cols) ? nPast : 0);
+
+    if (nCompared > 0)
+      m_vFrameProcessor->batchDistance(currHistos.ptr<float>(), windowHistos.ptr<float>(), windowHistos.rows, currHistos.rows, currHistos.cols, windowDist.data());
+
+    minDistance = 1.0;
+    jMin = 0;
+
+    for (int j(0); j < nCompared; j++) {
+      
+      // averaged local distances to the past shot j + 1 positions back
+      locDistance = windowDist[(i - 1 - j) % windowSize];
+
+      /*** for displaying purpose ***/
+      /* qDebug();
+      
+      for (int k(0); k < nHBlock; k++) {
+	for (int l(0); l < nVBlock; l++) {
+	  printf("%4.4f\t", 1 - distance[k * nVBlock + l]);
+	}
+	cout << endl;
+      }
+
+      qDebug();
+      qDebug() << (1 - locDistance);
+      imshow("past", frameBuffer[j]);
+      waitKey(0); */
+      
+      if (locDistance < minDistance) {
+	minDistance = locDistance;
+	jMin = j;
+      }
+    }
+
+    // similar shot retrieved among previous shots
+    if (minDistance <= maxDist) {
+      int iSim = i - (jMin + 1);
+      shotCamera[i] = shotCamera[iSim];
+    }
+
+    // no similar shot retrieved: new camera label
+    else {
+      shotCamera[i] = nCamera++;
+    }
+
+    // updating progress bar
+    emit progress(i);
+    if (m_canceled.load())
+      return false;
+  }
+      
+  return true;
+}
+
+bool EpisodeAnalyzer::faceDetectionOpenCV(const QString &fName, const QList<qint64> &shotPositions, int minHeight)
+{
+  // first frame of each shot, decoded in a single pass
+  BoundaryFrameExtractor extractor;
+  QVector<Mat> boundFrames;
+
+  if (!extractor.open(fName, shotPositions))
+    return false;
+
+  // current frame
+  Mat frame;
+
+  // frame height
+  int absMinHeight;
+
+  // current frame position and index
+  qint64 position(0);
+
+  // indicates that no more frame is available in video capture
+  bool open(true);
+  
+  // progress bar
+  emit progressRange(shotPositions.size());
+  
+  // initializing cascade classifier (needed by OpenCV face detector)
+  QString faceCascadeName = "faceDetection/model/haarcascade_frontalface_alt.xml";
+  CascadeClassifier faceCascade;
+
+  if (!faceCascade.load(faceCascadeName.toStdString()))
+    return false;
+  
+  // looping over shots
+  for (int i(0); i < shotPositions.size(); i++) {
+    
+    // retrieve frame at shot beginning
+    position = shotPositions[i];
+    open = extractor.next(boundFrames);
+    frame = boundFrames[0];
+
+    // frame found
+    if (open) {
+    
+      absMinHeight = static_cast<int>(frame.rows * minHeight / 100.0);
+      QList<QRect> frameFaces;
+      
+      frameFaces = detectFacesOpenCV(faceCascade, frame, absMinHeight);
+
+      if (frameFaces.size() > 0) {
+	emit setCurrShot(position);
+	emit appendFaces(position, frameFaces);
+      }
+    }
+    
+    // update progress bar
+    emit progress(i);
+    if (m_canceled.load())
+      return false;
+  }
+  
+  return true;
+}
+
+QList<qint64> EpisodeAnalyzer::getShotPositions() const
+{
+  return m_shotPositions;
+}
+
+///////////
+// slots //
+///////////
+
+void EpisodeAnalyzer::cancel()
+{
+  m_canceled.store(1);
+}
+
+/////////////////////
+// private methods //
+/////////////////////
+
+void EpisodeAnalyzer::activMetrics(int metrics)
+{
+  switch (metrics) {
+  case 4:
+    m_vFrameProcessor->activL1();
+    break;
+  case 5:
+    m_vFrameProcessor->activL2();
+    break;
+  case CV_COMP_CORREL:
+    m_vFrameProcessor->activCorrel();
+    break;
+  case CV_COMP_CHISQR:
+    m_vFrameProcessor->activChiSqr();
+    break;
+  case CV_COMP_INTERSECT:
+    m_vFrameProcessor->activIntersect();
+    break;
+  case CV_COMP_HELLINGER:
+    m_vFrameProcessor->activHellinger();
+    break;
+  }
+}
+
+QList<QRect> EpisodeAnalyzer::detectFacesOpenCV(cv::CascadeClassifier &faceCascade, cv::Mat &frame, int minHeight)
+{
+  QList<QRect> faces;
+  std::vector<Rect> facesRect;
+  Mat frameGray;
+
+  cvtColor(frame, frameGray, COLOR_BGR2GRAY);
+  equalizeHist(frameGray, frameGray);
+  
+  // detecting faces
+  faceCascade.detectMultiScale(frameGray, facesRect, 1.1, 2, 0 | CASCADE_SCALE_IMAGE, Size(minHeight, minHeight));
+
+  for (size_t i = 0; i < facesRect.size(); i++ )
+    faces.push_back(QRect(facesRect[i].x, facesRect[i].y, facesRect[i].width, facesRect[i].height));
+
+  return faces;
+}
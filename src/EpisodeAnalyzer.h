@@ -0,0 +1,55 @@
+#ifndef EPISODEANALYZER_H
+#define EPISODEANALYZER_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QRect>
+#include <QAtomicInt>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/objdetect/objdetect.hpp>
+
+#include "VideoFrameProcessor.h"
+
+///////////////////////////////////////////////////////
+// image processing of a single episode, free of any //
+// widget and owning its decoders: instances can run //
+// concurrently on distinct episodes                 //
+///////////////////////////////////////////////////////
+
+class EpisodeAnalyzer: public QObject
+{
+  Q_OBJECT
+
+ public:
+  EpisodeAnalyzer(int nHistoWorkers = -1, QObject *parent = 0);
+  ~EpisodeAnalyzer();
+
+  bool extractShots(const QString &fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal threshold1, qreal threshold2, int nVBlock, int nHBlock, int analysisHeight = 0);
+  bool labelSimilarShots(const QString &fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal maxDist, int windowSize, const QList<qint64> &shotPositions, int nVBlock, int nHBlock, QVector<int> &shotCamera, int analysisHeight = 0);
+  bool faceDetectionOpenCV(const QString &fName, const QList<qint64> &shotPositions, int minHeight);
+  QList<qint64> getShotPositions() const;
+
+ public slots:
+  void cancel();
+
+ signals:
+  void progressRange(int maximum);
+  void progress(int value);
+  void insertShot(qint64 position, qint64 end);
+  void setCurrShot(qint64 position);
+  void appendFaces(qint64 position, const QList<QRect> &frameFaces);
+
+ private:
+  void activMetrics(int metrics);
+  QList<QRect> detectFacesOpenCV(cv::CascadeClassifier &faceCascade, cv::Mat &frame, int minHeight);
+
+  VideoFrameProcessor *m_vFrameProcessor;
+  int m_nHistoWorkers;
+  QList<qint64> m_shotPositions;
+  QAtomicInt m_canceled;
+};
+
+#endif
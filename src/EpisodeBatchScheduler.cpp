@@ -0,0 +1,273 @@
+#include <algorithm>
+
+#include "EpisodeBatchScheduler.h"
+
+///////////////////////////////////////
+// thread running the scheduler loop //
+///////////////////////////////////////
+
+class BatchWorkerThread: public QThread
+{
+ public:
+  BatchWorkerThread(EpisodeBatchScheduler *scheduler): m_scheduler(scheduler) {}
+
+ protected:
+  void run() { m_scheduler->workLoop(); }
+
+ private:
+  EpisodeBatchScheduler *m_scheduler;
+};
+
+/////////////////////////////////
+// constructor and destructor  //
+/////////////////////////////////
+
+EpisodeBatchScheduler::EpisodeBatchScheduler(int nWorkers, QObject *parent)
+  : QObject(parent),
+    m_nWorkers(nWorkers),
+    m_stages(0),
+    m_shotHistoType(2),
+    m_shotNVBins(64),
+    m_shotNHBins(24),
+    m_shotNSBins(8),
+    m_shotMetrics(0),
+    m_threshold1(30),
+    m_threshold2(20),
+    m_shotNVBlock(5),
+    m_shotNHBlock(6),
+    m_shotHeight(0),
+    m_simHistoType(2),
+    m_simNVBins(64),
+    m_simNHBins(24),
+    m_simNSBins(8),
+    m_simMetrics(0),
+    m_maxDist(40),
+    m_windowSize(30),
+    m_simNVBlock(5),
+    m_simNHBlock(6),
+    m_simHeight(0),
+    m_minHeight(16),
+    m_next(0),
+    m_nDone(0),
+    m_nRunning(0),
+    m_canceled(false)
+{
+  // one episode per available core by default
+  if (m_nWorkers <= 0)
+    m_nWorkers = qMax(1, QThread::idealThreadCount());
+
+  // types carried by queued signals
+  qRegisterMetaType<Episode *>("Episode *");
+  qRegisterMetaType<QList<QRect> >("QList<QRect>");
+  qRegisterMetaType<QList<qint64> >("QList<qint64>");
+  qRegisterMetaType<QVector<int> >("QVector<int>");
+}
+
+EpisodeBatchScheduler::~EpisodeBatchScheduler()
+{
+  cancel();
+  wait();
+
+  for (int i(0); i < m_jobs.size(); i++)
+    delete m_jobs[i].analyzer;
+}
+
+////////////////////
+// public methods //
+////////////////////
+
+void EpisodeBatchScheduler::addEpisode(Episode *episode, const QList<qint64> &manualShots)
+{
+  Job job;
+
+  // each episode owns its decoders: histogram workers share the cores
+  // left by the other episodes processed at the same time
+  int nHistoWorkers = qMax(1, QThread::idealThreadCount() / m_nWorkers - 1);
+
+  job.episode = episode;
+  job.fName = episode->getFName();
+  job.shotPositions = manualShots;
+  job.analyzer = new EpisodeAnalyzer(nHistoWorkers);
+
+  // analyzers live in the GUI thread: signals emitted by workers are queued
+  connect(job.analyzer, SIGNAL(insertShot(qint64, qint64)), this, SLOT(forwardShot(qint64, qint64)));
+  connect(job.analyzer, SIGNAL(setCurrShot(qint64)), this, SLOT(forwardCurrShot(qint64)));
+  connect(job.analyzer, SIGNAL(appendFaces(qint64, const QList<QRect> &)), this, SLOT(forwardFaces(qint64, const QList<QRect> &)));
+
+  m_jobs.push_back(job);
+}
+
+void EpisodeBatchScheduler::setShotParams(int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal threshold1, qreal threshold2, int nVBlock, int nHBlock, int analysisHeight)
+{
+  m_shotHistoType = histoType;
+  m_shotNVBins = nVBins;
+  m_shotNHBins = nHBins;
+  m_shotNSBins = nSBins;
+  m_shotMetrics = metrics;
+  m_threshold1 = threshold1;
+  m_threshold2 = threshold2;
+  m_shotNVBlock = nVBlock;
+  m_shotNHBlock = nHBlock;
+  m_shotHeight = analysisHeight;
+}
+
+void EpisodeBatchScheduler::setSimShotParams(int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal maxDist, int windowSize, int nVBlock, int nHBlock, int analysisHeight)
+{
+  m_simHistoType = histoType;
+  m_simNVBins = nVBins;
+  m_simNHBins = nHBins;
+  m_simNSBins = nSBins;
+  m_simMetrics = metrics;
+  m_maxDist = maxDist;
+  m_windowSize = windowSize;
+  m_simNVBlock = nVBlock;
+  m_simNHBlock = nHBlock;
+  m_simHeight = analysisHeight;
+}
+
+void EpisodeBatchScheduler::setFaceParams(int minHeight)
+{
+  m_minHeight = minHeight;
+}
+
+int EpisodeBatchScheduler::getNEpisodes() const
+{
+  return m_jobs.size();
+}
+
+void EpisodeBatchScheduler::start(int stages)
+{
+  m_stages = stages;
+  m_next = 0;
+  m_nDone = 0;
+  m_canceled = false;
+
+  // no more workers than episodes
+  int nThreads = qMin(m_nWorkers, m_jobs.size());
+  m_nRunning = nThreads;
+
+  if (nThreads == 0) {
+    emit finished();
+    return;
+  }
+
+  for (int i(0); i < nThreads; i++)
+    m_threads.push_back(new BatchWorkerThread(this));
+
+  for (int i(0); i < m_threads.size(); i++)
+    m_threads[i]->start();
+}
+
+void EpisodeBatchScheduler::wait()
+{
+  for (int i(0); i < m_threads.size(); i++) {
+    m_threads[i]->wait();
+    delete m_threads[i];
+  }
+
+  m_threads.clear();
+}
+
+void EpisodeBatchScheduler::workLoop()
+{
+  forever {
+
+    m_mutex.lock();
+
+    if (m_canceled || m_next >= m_jobs.size()) {
+
+      // last worker leaving notifies the end of the batch
+      bool last = (--m_nRunning == 0);
+      m_mutex.unlock();
+
+      if (last)
+	emit finished();
+
+      return;
+    }
+
+    int k(m_next++);
+    m_mutex.unlock();
+
+    processEpisode(m_jobs[k]);
+
+    m_mutex.lock();
+    int nDone(++m_nDone);
+    m_mutex.unlock();
+
+    emit episodeDone(nDone);
+  }
+}
+
+///////////
+// slots //
+///////////
+
+void EpisodeBatchScheduler::cancel()
+{
+  m_mutex.lock();
+  m_canceled = true;
+  m_mutex.unlock();
+
+  for (int i(0); i < m_jobs.size(); i++)
+    m_jobs[i].analyzer->cancel();
+}
+
+void EpisodeBatchScheduler::forwardShot(qint64 position, qint64 end)
+{
+  emit insertShot(episodeFromAnalyzer(sender()), position, end);
+}
+
+void EpisodeBatchScheduler::forwardCurrShot(qint64 position)
+{
+  emit setCurrShot(episodeFromAnalyzer(sender()), position);
+}
+
+void EpisodeBatchScheduler::forwardFaces(qint64 position, const QList<QRect> &frameFaces)
+{
+  emit appendFaces(episodeFromAnalyzer(sender()), position, frameFaces);
+}
+
+/////////////////////
+// private methods //
+/////////////////////
+
+void EpisodeBatchScheduler::processEpisode(Job &job)
+{
+  // shots of the episode once automatic ones are merged with manual ones
+  if (m_stages & Shots) {
+
+    if (!job.analyzer->extractShots(job.fName, m_shotHistoType, m_shotNVBins, m_shotNHBins, m_shotNSBins, m_shotMetrics, m_threshold1, m_threshold2, m_shotNVBlock, m_shotNHBlock, m_shotHeight))
+      return;
+
+    QList<qint64> autoShots = job.analyzer->getShotPositions();
+
+    for (int i(0); i < autoShots.size(); i++)
+      if (!job.shotPositions.contains(autoShots[i]))
+	job.shotPositions.push_back(autoShots[i]);
+
+    std::sort(job.shotPositions.begin(), job.shotPositions.end());
+  }
+
+  if (m_stages & SimilarShots) {
+
+    QVector<int> shotCamera;
+
+    if (!job.analyzer->labelSimilarShots(job.fName, m_simHistoType, m_simNVBins, m_simNHBins, m_simNSBins, m_simMetrics, m_maxDist, m_windowSize, job.shotPositions, m_simNVBlock, m_simNHBlock, shotCamera, m_simHeight))
+      return;
+
+    emit setShotCameras(job.episode, job.shotPositions, shotCamera);
+  }
+
+  if (m_stages & Faces)
+    job.analyzer->faceDetectionOpenCV(job.fName, job.shotPositions, m_minHeight);
+}
+
+Episode * EpisodeBatchScheduler::episodeFromAnalyzer(QObject *analyzer) const
+{
+  for (int i(0); i < m_jobs.size(); i++)
+    if (m_jobs[i].analyzer == analyzer)
+      return m_jobs[i].episode;
+
+  return 0;
+}
@@ -0,0 +1,114 @@
+#ifndef EPISODEBATCHSCHEDULER_H
+#define EPISODEBATCHSCHEDULER_H
+
+#include <QObject>
+#include <QList>
+#include <QVector>
+#include <QRect>
+#include <QThread>
+#include <QMutex>
+#include <QMetaType>
+
+#include "Episode.h"
+#include "EpisodeAnalyzer.h"
+
+Q_DECLARE_METATYPE(Episode *)
+
+///////////////////////////////////////////////////////
+// runs image processing stages on several episodes  //
+// at once: a bounded pool of worker threads takes   //
+// episodes from a queue, results reach the model    //
+// through queued signals on the GUI thread          //
+///////////////////////////////////////////////////////
+
+class EpisodeBatchScheduler: public QObject
+{
+  Q_OBJECT
+
+ public:
+  enum Stage {
+    Shots = 0x1,
+    SimilarShots = 0x2,
+    Faces = 0x4
+  };
+
+  EpisodeBatchScheduler(int nWorkers = -1, QObject *parent = 0);
+  ~EpisodeBatchScheduler();
+
+  void addEpisode(Episode *episode, const QList<qint64> &manualShots);
+  void setShotParams(int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal threshold1, qreal threshold2, int nVBlock, int nHBlock, int analysisHeight = 0);
+  void setSimShotParams(int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal maxDist, int windowSize, int nVBlock, int nHBlock, int analysisHeight = 0);
+  void setFaceParams(int minHeight);
+  int getNEpisodes() const;
+
+  void start(int stages);
+  void wait();
+  void workLoop();
+
+ public slots:
+  void cancel();
+
+ signals:
+  void insertShot(Episode *episode, qint64 position, qint64 end);
+  void setCurrShot(Episode *episode, qint64 position);
+  void setShotCameras(Episode *episode, const QList<qint64> &shotPositions, const QVector<int> &shotCamera);
+  void appendFaces(Episode *episode, qint64 position, const QList<QRect> &frameFaces);
+  void episodeDone(int nDone);
+  void finished();
+
+ private slots:
+  void forwardShot(qint64 position, qint64 end);
+  void forwardCurrShot(qint64 position);
+  void forwardFaces(qint64 position, const QList<QRect> &frameFaces);
+
+ private:
+  struct Job {
+    Episode *episode;
+    QString fName;
+    QList<qint64> shotPositions;
+    EpisodeAnalyzer *analyzer;
+  };
+
+  void processEpisode(Job &job);
+  Episode * episodeFromAnalyzer(QObject *analyzer) const;
+
+  int m_nWorkers;
+  int m_stages;
+  QList<Job> m_jobs;
+  QList<QThread *> m_threads;
+
+  // shot extraction parameters
+  int m_shotHistoType;
+  int m_shotNVBins;
+  int m_shotNHBins;
+  int m_shotNSBins;
+  int m_shotMetrics;
+  qreal m_threshold1;
+  qreal m_threshold2;
+  int m_shotNVBlock;
+  int m_shotNHBlock;
+  int m_shotHeight;
+
+  // similar shot labelling parameters
+  int m_simHistoType;
+  int m_simNVBins;
+  int m_simNHBins;
+  int m_simNSBins;
+  int m_simMetrics;
+  qreal m_maxDist;
+  int m_windowSize;
+  int m_simNVBlock;
+  int m_simNHBlock;
+  int m_simHeight;
+
+  // face detection parameters
+  int m_minHeight;
+
+  QMutex m_mutex;
+  int m_next;
+  int m_nDone;
+  int m_nRunning;
+  bool m_canceled;
+};
+
+#endif
@@ -0,0 +1,324 @@
+#include <QPair>
+#include <QDebug>
+
+#include <algorithm>
+
+#include "EpisodeStore.h"
+#include "Scene.h"
+#include "Shot.h"
+#include "SpeechSegment.h"
+
+/////////////////////////////////
+// constructor and destructor  //
+/////////////////////////////////
+
+EpisodeStore::EpisodeStore()
+  : m_spillDir(0),
+    m_budget(0),
+    m_usage(0),
+    m_clock(0)
+{
+}
+
+EpisodeStore::~EpisodeStore()
+{
+  close();
+}
+
+////////////////////
+// public methods //
+////////////////////
+
+bool EpisodeStore::open(const QString &fName, Series *series, QString &projectName)
+{
+  close();
+
+  if (!m_file.open(fName))
+    return false;
+
+  m_fName = fName;
+  projectName = m_file.getProjectName();
+
+  // seasons and episodes only: contents are read when first needed
+  m_file.readSkeleton(series);
+  indexEpisodes(series);
+
+  return true;
+}
+
+bool EpisodeStore::reattach(const QString &fName, Series *series)
+{
+  // contents of unloaded episodes are now found in the saved file
+  m_file.close();
+
+  if (!m_file.open(fName)) {
+    qWarning() << "Couldn't reopen project file" << fName;
+    close();
+    return false;
+  }
+
+  m_fName = fName;
+  indexEpisodes(series);
+
+  delete m_spillDir;
+  m_spillDir = 0;
+
+  return true;
+}
+
+void EpisodeStore::close()
+{
+  m_file.close();
+  m_fName = QString();
+  m_entries.clear();
+  m_usage = 0;
+
+  delete m_spillDir;
+  m_spillDir = 0;
+}
+
+bool EpisodeStore::isOpen() const
+{
+  return m_file.isOpen();
+}
+
+QString EpisodeStore::getFName() const
+{
+  return m_fName;
+}
+
+void EpisodeStore::setMemoryBudget(qint64 budget)
+{
+  m_budget = budget;
+}
+
+qint64 EpisodeStore::getMemoryBudget() const
+{
+  return m_budget;
+}
+
+qint64 EpisodeStore::getMemoryUsage() const
+{
+  return m_usage;
+}
+
+bool EpisodeStore::isLoaded(Episode *episode) const
+{
+  QHash<Episode *, Entry>::const_iterator it = m_entries.find(episode);
+
+  // episodes created after opening are always in memory
+  return it == m_entries.end() || it->loaded;
+}
+
+int EpisodeStore::getNScenes(Episode *episode) const
+{
+  QHash<Episode *, Entry>::const_iterator it = m_entries.find(episode);
+
+  if (it == m_entries.end() || it->loaded || it->acquired)
+    return episode->childCount();
+
+  if (it->spilled) {
+    ProjectFile spill;
+    return spill.open(spillFName(*it)) ? spill.getNScenes(0) : 0;
+  }
+
+  return m_file.getNScenes(it->index);
+}
+
+void EpisodeStore::load(Episode *episode)
+{
+  QHash<Episode *, Entry>::iterator it = m_entries.find(episode);
+
+  if (it == m_entries.end())
+    return;
+
+  it->lastUse = ++m_clock;
+
+  if (it->loaded)
+    return;
+
+  // contents possibly read already for writing purposes
+  if (!it->acquired)
+    readContents(episode, *it);
+
+  it->acquired = false;
+  it->loaded = true;
+  it->size = footprint(episode);
+  m_usage += it->size;
+}
+
+void EpisodeStore::unload(Episode *episode)
+{
+  QHash<Episode *, Entry>::iterator it = m_entries.find(episode);
+
+  if (it == m_entries.end() || !it->loaded)
+    return;
+
+  if (!m_spillDir)
+    m_spillDir = new QTemporaryDir;
+
+  // current state of the episode is kept aside: it may differ from
+  // the one stored in the project file
+  if (!ProjectFile::writeEpisode(spillFName(*it), episode)) {
+    qWarning() << "Couldn't unload episode" << episode->getFName();
+    return;
+  }
+
+  clearContents(episode);
+
+  it->spilled = true;
+  it->loaded = false;
+  m_usage -= it->size;
+  it->size = 0;
+}
+
+QList<Episode *> EpisodeStore::getVictims(Episode *current) const
+{
+  QList<Episode *> victims;
+
+  if (m_budget <= 0 || m_usage <= m_budget)
+    return victims;
+
+  // loaded episodes from least to most recently used
+  QList<QPair<quint64, Episode *> > loaded;
+
+  for (QHash<Episode *, Entry>::const_iterator it = m_entries.begin(); it != m_entries.end(); it++)
+    if (it->loaded && it.key() != current)
+      loaded.push_back(QPair<quint64, Episode *>(it->lastUse, it.key()));
+
+  std::sort(loaded.begin(), loaded.end());
+
+  qint64 usage(m_usage);
+
+  for (int i(0); i < loaded.size() && usage > m_budget; i++) {
+    victims.push_back(loaded[i].second);
+    usage -= m_entries[loaded[i].second].size;
+  }
+
+  return victims;
+}
+
+void EpisodeStore::acquire(Episode *episode)
+{
+  QHash<Episode *, Entry>::iterator it = m_entries.find(episode);
+
+  if (it == m_entries.end() || it->loaded || it->acquired)
+    return;
+
+  readContents(episode, *it);
+  it->acquired = true;
+}
+
+void EpisodeStore::release(Episode *episode)
+{
+  QHash<Episode *, Entry>::iterator it = m_entries.find(episode);
+
+  if (it == m_entries.end() || !it->acquired)
+    return;
+
+  // left unchanged while acquired: nothing to keep
+  clearContents(episode);
+  it->acquired = false;
+}
+
+/////////////////////
+// private methods //
+/////////////////////
+
+void EpisodeStore::readContents(Episode *episode, const Entry &entry) const
+{
+  if (entry.spilled) {
+
+    ProjectFile spill;
+
+    if (spill.open(spillFName(entry)))
+      spill.readEpisodeContents(episode, 0);
+  }
+
+  else
+    m_file.readEpisodeContents(episode, entry.index);
+}
+
+void EpisodeStore::clearContents(Episode *episode) const
+{
+  QList<Segment *> scenes = episode->getChildren();
+  episode->clearChildren();
+  qDeleteAll(scenes);
+
+  QList<SpeechSegment *> speechSegments = episode->getSpeechSegments();
+  QList<SpeechSegment *> noSpeechSegments;
+  episode->setSpeechSegments(noSpeechSegments);
+  qDeleteAll(speechSegments);
+}
+
+void EpisodeStore::indexEpisodes(Series *series)
+{
+  QHash<Episode *, Entry> entries;
+
+  for (int i(0); i < series->childCount(); i++)
+    for (int j(0); j < series->child(i)->childCount(); j++) {
+
+      Episode *episode = dynamic_cast<Episode *>(series->child(i)->child(j));
+
+      // state of episodes already known is kept
+      Entry entry;
+
+      if (m_entries.contains(episode))
+	entry = m_entries[episode];
+
+      else {
+	entry.loaded = (m_entries.size() > 0);
+	entry.acquired = false;
+	entry.size = entry.loaded ? footprint(episode) : 0;
+	entry.lastUse = ++m_clock;
+	m_usage += entry.size;
+      }
+
+      entry.index = m_file.getEpisodeIndex(i, j);
+      entry.spilled = false;
+
+      entries.insert(episode, entry);
+    }
+
+  m_entries = entries;
+}
+
+qint64 EpisodeStore::footprint(Episode *episode) const
+{
+  // rough estimate of heap usage, containers overhead included
+  qint64 size(sizeof(Episode));
+
+  for (int i(0); i < episode->childCount(); i++) {
+
+    Segment *scene = episode->child(i);
+    size += sizeof(Scene) + 16;
+
+    for (int j(0); j < scene->childCount(); j++) {
+
+      Shot *shot = dynamic_cast<Shot *>(scene->child(j));
+      size += sizeof(Shot) + 64;
+
+      if (!shot)
+	continue;
+
+      QList<QPair<qint64, QList<Face> > > faces = shot->getFaces();
+
+      for (int k(0); k < faces.size(); k++)
+	size += 48 + faces[k].second.size() * (sizeof(Face) + 112);
+
+      size += shot->getMusicRates().size() * 32;
+    }
+  }
+
+  QList<SpeechSegment *> speechSegments = episode->getSpeechSegments();
+
+  for (int i(0); i < speechSegments.size(); i++)
+    size += sizeof(SpeechSegment) + 128 + 2 * speechSegments[i]->getText().size();
+
+  return size;
+}
+
+QString EpisodeStore::spillFName(const Entry &entry) const
+{
+  return m_spillDir->path() + "/episode_" + QString::number(entry.index) + ".tvp";
+}
@@ -0,0 +1,71 @@
+#ifndef EPISODESTORE_H
+#define EPISODESTORE_H
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QTemporaryDir>
+
+#include "ProjectFile.h"
+#include "Series.h"
+#include "Episode.h"
+
+///////////////////////////////////////////////////////
+// on-demand loading of episode contents from a      //
+// binary project file: only the series skeleton is  //
+// held in memory at first; least recently used      //
+// episodes are unloaded beyond a memory budget and  //
+// spilled to temporary files to keep their changes  //
+///////////////////////////////////////////////////////
+
+class EpisodeStore: public ProjectFile::EpisodeAccess
+{
+ public:
+  EpisodeStore();
+  ~EpisodeStore();
+
+  bool open(const QString &fName, Series *series, QString &projectName);
+  bool reattach(const QString &fName, Series *series);
+  void close();
+  bool isOpen() const;
+  QString getFName() const;
+
+  void setMemoryBudget(qint64 budget);
+  qint64 getMemoryBudget() const;
+  qint64 getMemoryUsage() const;
+
+  bool isLoaded(Episode *episode) const;
+  int getNScenes(Episode *episode) const;
+  void load(Episode *episode);
+  void unload(Episode *episode);
+  QList<Episode *> getVictims(Episode *current) const;
+
+  void acquire(Episode *episode);
+  void release(Episode *episode);
+
+ private:
+  struct Entry {
+    int index;
+    bool loaded;
+    bool spilled;
+    bool acquired;
+    qint64 size;
+    quint64 lastUse;
+  };
+
+  void readContents(Episode *episode, const Entry &entry) const;
+  void clearContents(Episode *episode) const;
+  void indexEpisodes(Series *series);
+  qint64 footprint(Episode *episode) const;
+  QString spillFName(const Entry &entry) const;
+
+  ProjectFile m_file;
+  QString m_fName;
+  QTemporaryDir *m_spillDir;
+  QHash<Episode *, Entry> m_entries;
+  qint64 m_budget;
+  qint64 m_usage;
+  quint64 m_clock;
+};
+
+#endif
@@ -0,0 +1,324 @@
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "FrameHistoPipeline.h"
+
+using namespace cv;
+
+////////////////////////////////////////
+// threads running the pipeline loops //
+////////////////////////////////////////
+
+class DecoderThread: public QThread
+{
+ public:
+  DecoderThread(FrameHistoPipeline *pipeline): m_pipeline(pipeline) {}
+
+ protected:
+  void run() { m_pipeline->decodeLoop(); }
+
+ private:
+  FrameHistoPipeline *m_pipeline;
+};
+
+class HistoWorkerThread: public QThread
+{
+ public:
+  HistoWorkerThread(FrameHistoPipeline *pipeline): m_pipeline(pipeline) {}
+
+ protected:
+  void run() { m_pipeline->workLoop(); }
+
+ private:
+  FrameHistoPipeline *m_pipeline;
+};
+
+/////////////////////////////////
+// constructor and destructor  //
+/////////////////////////////////
+
+FrameHistoPipeline::FrameHistoPipeline(VideoFrameProcessor *vFrameProcessor, int histoType, int nVBins, int nHBins, int nSBins, int nVBlock, int nHBlock, int analysisHeight, int nWorkers, int capacity)
+  : m_vFrameProcessor(vFrameProcessor),
+    m_histoType(histoType),
+    m_nVBins(nVBins),
+    m_nHBins(nHBins),
+    m_nSBins(nSBins),
+    m_nVBlock(nVBlock),
+    m_nHBlock(nHBlock),
+    m_analysisHeight(analysisHeight),
+    m_nWorkers(nWorkers),
+    m_frameCount(0),
+    m_nDecoded(0),
+    m_nClaimed(0),
+    m_nConsumed(0),
+    m_endPosition(0),
+    m_eof(false),
+    m_abort(false)
+{
+  // one worker per available core, the decoder taking the last one
+  if (m_nWorkers <= 0)
+    m_nWorkers = qMax(1, QThread::idealThreadCount() - 1);
+
+  // at least two slots are needed: current and previous frames
+  m_slots.resize(qMax(2, capacity));
+
+  for (int i(0); i < m_slots.size(); i++) {
+    m_slots[i].idx = -1;
+    m_slots[i].histoDone = false;
+    m_slots[i].distClaimed = false;
+    m_slots[i].distDone = false;
+  }
+}
+
+FrameHistoPipeline::~FrameHistoPipeline()
+{
+  stop();
+}
+
+////////////////////
+// public methods //
+////////////////////
+
+bool FrameHistoPipeline::open(const QString &fName)
+{
+  m_cap.release();
+
+  if (!m_cap.open(fName.toStdString()))
+    return false;
+
+  m_frameCount = m_cap.get(CV_CAP_PROP_FRAME_COUNT);
+
+  // starting decoder and workers
+  m_threads.push_back(new DecoderThread(this));
+
+  for (int i(0); i < m_nWorkers; i++)
+    m_threads.push_back(new HistoWorkerThread(this));
+
+  for (int i(0); i < m_threads.size(); i++)
+    m_threads[i]->start();
+
+  return true;
+}
+
+void FrameHistoPipeline::stop()
+{
+  m_mutex.lock();
+  m_abort = true;
+  m_spaceAvailable.wakeAll();
+  m_frameDecoded.wakeAll();
+  m_frameDone.wakeAll();
+  m_mutex.unlock();
+
+  for (int i(0); i < m_threads.size(); i++) {
+    m_threads[i]->wait();
+    delete m_threads[i];
+  }
+
+  m_threads.clear();
+  m_cap.release();
+}
+
+bool FrameHistoPipeline::next(int &n, qint64 &position, qreal &dist)
+{
+  QVector<Mat> locHisto;
+
+  return next(n, position, dist, locHisto);
+}
+
+bool FrameHistoPipeline::next(int &n, qint64 &position, qreal &dist, QVector<cv::Mat> &locHisto)
+{
+  QMutexLocker locker(&m_mutex);
+
+  int k(m_nConsumed);
+  Slot &slot = m_slots[k % m_slots.size()];
+
+  // waiting for distance of next frame in order
+  while (!m_abort && !(slot.idx == k && slot.distDone)) {
+    if (m_eof && k >= m_nDecoded)
+      return false;
+    m_frameDone.wait(&m_mutex);
+  }
+
+  if (m_abort)
+    return false;
+
+  n = k;
+  position = slot.position;
+  dist = slot.dist;
+
+  // histograms point to the slot buffer: valid until the following call
+  locHisto = slot.locHisto;
+
+  // previous frame is no longer needed by any worker
+  m_nConsumed++;
+  m_spaceAvailable.wakeOne();
+
+  return true;
+}
+
+int FrameHistoPipeline::getFrameCount() const
+{
+  return m_frameCount;
+}
+
+qint64 FrameHistoPipeline::getEndPosition() const
+{
+  QMutexLocker locker(&m_mutex);
+
+  return m_endPosition;
+}
+
+///////////////////
+// thread loops  //
+///////////////////
+
+void FrameHistoPipeline::decodeLoop()
+{
+  int capacity(m_slots.size());
+
+  forever {
+
+    m_mutex.lock();
+
+    // waiting for a free slot: frames from the last consumed one are kept
+    while (!m_abort && m_nDecoded - qMax(0, m_nConsumed - 1) >= capacity)
+      m_spaceAvailable.wait(&m_mutex);
+
+    if (m_abort) {
+      m_mutex.unlock();
+      return;
+    }
+
+    int k(m_nDecoded);
+    m_mutex.unlock();
+
+    // the slot is not visible to workers until published
+    Slot &slot = m_slots[k % capacity];
+
+    // retrieve position of next frame, then decode it
+    qint64 position = m_cap.get(CV_CAP_PROP_POS_MSEC) + 40;
+    bool read = m_cap.read(slot.frame);
+
+    m_mutex.lock();
+
+    if (!read) {
+      m_endPosition = position;
+      m_eof = true;
+      m_frameDecoded.wakeAll();
+      m_frameDone.wakeAll();
+      m_mutex.unlock();
+      return;
+    }
+
+    slot.idx = k;
+    slot.position = position;
+    slot.histoDone = false;
+    slot.distClaimed = false;
+    slot.distDone = false;
+    m_nDecoded++;
+
+    m_frameDecoded.wakeOne();
+    m_mutex.unlock();
+  }
+}
+
+void FrameHistoPipeline::workLoop()
+{
+  int capacity(m_slots.size());
+
+  forever {
+
+    m_mutex.lock();
+
+    // waiting for a decoded frame not yet claimed
+    while (!m_abort && m_nClaimed >= m_nDecoded && !m_eof)
+      m_frameDecoded.wait(&m_mutex);
+
+    if (m_abort || m_nClaimed >= m_nDecoded) {
+      m_mutex.unlock();
+      return;
+    }
+
+    int k(m_nClaimed++);
+    m_mutex.unlock();
+
+    Slot &slot = m_slots[k % capacity];
+    computeHisto(slot);
+
+    m_mutex.lock();
+    slot.histoDone = true;
+
+    // distance of current frame can be computed if previous histograms are ready,
+    // distance of next frame may have been waiting for current histograms
+    bool currDist = claimDistance(k);
+    bool nextDist = claimDistance(k + 1);
+    m_mutex.unlock();
+
+    if (currDist)
+      computeDistance(k);
+
+    if (nextDist)
+      computeDistance(k + 1);
+  }
+}
+
+/////////////////////
+// private methods //
+/////////////////////
+
+bool FrameHistoPipeline::histoReady(int k) const
+{
+  const Slot &slot = m_slots[k % m_slots.size()];
+
+  return slot.idx == k && slot.histoDone;
+}
+
+bool FrameHistoPipeline::claimDistance(int k)
+{
+  if (!histoReady(k) || (k > 0 && !histoReady(k - 1)))
+    return false;
+
+  Slot &slot = m_slots[k % m_slots.size()];
+
+  if (slot.distClaimed)
+    return false;
+
+  slot.distClaimed = true;
+
+  return true;
+}
+
+void FrameHistoPipeline::computeHisto(Slot &slot)
+{
+  // reduced resolution HSV frame
+  m_vFrameProcessor->prepareFrame(slot.frame, slot.scaled, m_analysisHeight);
+
+  // V/HS/HSV histograms of all frame blocks in one pass, slot buffer reused
+  m_vFrameProcessor->genBlockHistos(slot.scaled, m_histoType, m_nHBins, m_nSBins, m_nVBins, m_nVBlock, m_nHBlock, slot.histos, slot.locHisto);
+}
+
+void FrameHistoPipeline::computeDistance(int k)
+{
+  Slot &slot = m_slots[k % m_slots.size()];
+
+  qreal dist;
+
+  // first frame has no predecessor: null distances as in the serial path
+  if (k == 0)
+    dist = m_vFrameProcessor->meanDistance(QVector<qreal>(slot.histos.rows, 0.0));
+
+  else {
+    const Slot &prevSlot = m_slots[(k - 1) % m_slots.size()];
+
+    // distances of all blocks computed at once on contiguous histograms
+    if (slot.histos.size() == prevSlot.histos.size())
+      dist = m_vFrameProcessor->batchDistance(slot.histos.ptr<float>(), prevSlot.histos.ptr<float>(), slot.histos.rows, slot.histos.cols);
+    else
+      dist = m_vFrameProcessor->meanDistance(QVector<qreal>(slot.histos.rows, -1.0));
+  }
+
+  m_mutex.lock();
+  slot.dist = dist;
+  slot.distDone = true;
+  m_frameDone.wakeAll();
+  m_mutex.unlock();
+}
@@ -0,0 +1,98 @@
+#ifndef FRAMEHISTOPIPELINE_H
+#define FRAMEHISTOPIPELINE_H
+
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include "opencv2/videoio.hpp"
+
+#include "VideoFrameProcessor.h"
+
+/////////////////////////////////////////////////////////
+// multi-threaded decoding and block histogram engine: //
+// a decoder thread fills a bounded ring buffer, a     //
+// pool of workers computes block histograms and the   //
+// distance from previous frame, results are consumed  //
+// in frame order                                      //
+/////////////////////////////////////////////////////////
+
+class FrameHistoPipeline
+{
+ public:
+  FrameHistoPipeline(VideoFrameProcessor *vFrameProcessor,
+		     int histoType,
+		     int nVBins,
+		     int nHBins,
+		     int nSBins,
+		     int nVBlock,
+		     int nHBlock,
+		     int analysisHeight = 0,
+		     int nWorkers = -1,
+		     int capacity = 64);
+  ~FrameHistoPipeline();
+
+  bool open(const QString &fName);
+  void stop();
+  bool next(int &n, qint64 &position, qreal &dist);
+  bool next(int &n, qint64 &position, qreal &dist, QVector<cv::Mat> &locHisto);
+  int getFrameCount() const;
+  qint64 getEndPosition() const;
+
+  void decodeLoop();
+  void workLoop();
+
+ private:
+  struct Slot {
+    int idx;
+    qint64 position;
+    cv::Mat frame;
+    cv::Mat scaled;
+    cv::Mat histos;
+    QVector<cv::Mat> locHisto;
+    qreal dist;
+    bool histoDone;
+    bool distClaimed;
+    bool distDone;
+  };
+
+  bool histoReady(int k) const;
+  bool claimDistance(int k);
+  void computeHisto(Slot &slot);
+  void computeDistance(int k);
+
+  VideoFrameProcessor *m_vFrameProcessor;
+  cv::VideoCapture m_cap;
+
+  int m_histoType;
+  int m_nVBins;
+  int m_nHBins;
+  int m_nSBins;
+  int m_nVBlock;
+  int m_nHBlock;
+  int m_analysisHeight;
+  int m_nWorkers;
+  int m_frameCount;
+
+  QVector<Slot> m_slots;
+  QList<QThread *> m_threads;
+
+  mutable QMutex m_mutex;
+  QWaitCondition m_spaceAvailable;
+  QWaitCondition m_frameDecoded;
+  QWaitCondition m_frameDone;
+
+  int m_nDecoded;
+  int m_nClaimed;
+  int m_nConsumed;
+  qint64 m_endPosition;
+  bool m_eof;
+  bool m_abort;
+};
+
+#endif
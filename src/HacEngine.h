@@ -0,0 +1,382 @@
+#ifndef HACENGINE_H
+#define HACENGINE_H
+
+#include <QVector>
+#include <QPair>
+
+#include <armadillo>
+
+#include <cmath>
+#include <algorithm>
+
+///////////////////////////////////////////////////////
+// agglomerative hierarchical clustering: distances  //
+// are updated in place in a condensed matrix with   //
+// the Lance-Williams formula of the linkage given   //
+// as template parameter; merges are returned as a   //
+// flat table the dendograms are built from          //
+//                                                   //
+// each cluster caches its nearest neighbour: O(n^2) //
+// when few caches are invalidated by a merge, but   //
+// O(n^3) in the worst case, as each merge may send  //
+// O(n) clusters back to an O(n) search              //
+///////////////////////////////////////////////////////
+
+// merge of two clusters: leaves are numbered from 0 to n - 1,
+// cluster created by merge k is numbered n + k
+struct HacMerge {
+  int left;
+  int right;
+  double dist;
+};
+
+// Lance-Williams formulas: distance between cluster k and the
+// union of clusters 1 and 2
+
+struct MinLinkage {
+  static double update(double d1, double d2, double /*d12*/, double /*weight1*/, double /*weight2*/, double /*currWeight*/)
+  {
+    return 0.5 * d1 + 0.5 * d2 - 0.5 * std::abs(d1 - d2);
+  }
+};
+
+struct MaxLinkage {
+  static double update(double d1, double d2, double /*d12*/, double /*weight1*/, double /*weight2*/, double /*currWeight*/)
+  {
+    return 0.5 * d1 + 0.5 * d2 + 0.5 * std::abs(d1 - d2);
+  }
+};
+
+struct MeanLinkage {
+  static double update(double d1, double d2, double /*d12*/, double weight1, double weight2, double /*currWeight*/)
+  {
+    double totWeight = weight1 + weight2;
+
+    return weight1 / totWeight * d1 + weight2 / totWeight * d2;
+  }
+};
+
+struct WardLinkage {
+  static double update(double d1, double d2, double d12, double weight1, double weight2, double currWeight)
+  {
+    double totWeight = weight1 + weight2;
+    double alpha1 = (currWeight + weight1) / (currWeight + totWeight);
+    double alpha2 = (currWeight + weight2) / (currWeight + totWeight);
+    double beta = - currWeight / (currWeight + totWeight);
+
+    return alpha1 * d1 + alpha2 * d2 + beta * d12;
+  }
+};
+
+template <class Linkage>
+class HacEngine
+{
+ public:
+  // order of the current clusters, used to break ties and,
+  // under temporal constraint, to define adjacent clusters:
+  // creation order or median label of cluster instances
+  enum Ordering {
+    Creation, Median
+  };
+
+  HacEngine(Ordering ordering = Creation, bool temporalCst = false);
+
+  void run(const arma::mat &D, const arma::mat &W);
+  QVector<HacMerge> getMerges() const;
+  QVector<int> getClusters() const;
+
+ private:
+  typedef QPair<qint64, qint64> Key;
+
+  void merge(int l, int r);
+  void findNeighbour(int i);
+  void unlink(int s);
+  void link(int s);
+  bool closer(double d1, int s1, double d2, int s2) const;
+  arma::uword condensedIdx(int i, int j) const;
+
+  Ordering m_ordering;
+  bool m_temporalCst;
+  int m_n;
+
+  arma::vec m_C;                 // condensed distance matrix
+  QVector<bool> m_active;        // slots still in use
+  QVector<int> m_ids;            // cluster held in each slot
+  QVector<Key> m_keys;           // position of each cluster
+  QVector<double> m_weights;     // weight of each cluster
+  QVector<QVector<int>> m_labels; // sorted instances of each cluster
+  QVector<int> m_prev;           // clusters ordered by position
+  QVector<int> m_next;
+  int m_first;
+  QVector<int> m_nn;             // closest cluster positioned after each cluster
+  QVector<double> m_nnDist;      // distance to this cluster
+
+  QVector<HacMerge> m_merges;
+};
+
+/////////////////////////////////
+// constructor and destructor  //
+/////////////////////////////////
+
+template <class Linkage>
+HacEngine<Linkage>::HacEngine(Ordering ordering, bool temporalCst)
+  : m_ordering(ordering),
+    m_temporalCst(temporalCst),
+    m_n(0),
+    m_first(-1)
+{
+}
+
+////////////////////
+// public methods //
+////////////////////
+
+template <class Linkage>
+void HacEngine<Linkage>::run(const arma::mat &D, const arma::mat &W)
+{
+  m_n = D.n_rows;
+  m_merges.clear();
+
+  m_C.set_size(static_cast<arma::uword>(m_n) * (m_n > 0 ? m_n - 1 : 0) / 2);
+  for (int i(0); i < m_n; i++)
+    for (int j(i+1); j < m_n; j++)
+      m_C(condensedIdx(i, j)) = D(i, j);
+
+  m_active.fill(true, m_n);
+  m_ids.resize(m_n);
+  m_keys.resize(m_n);
+  m_weights.resize(m_n);
+  m_labels.resize(m_ordering == Median ? m_n : 0);
+  m_prev.resize(m_n);
+  m_next.resize(m_n);
+  m_nn.resize(m_n);
+  m_nnDist.resize(m_n);
+
+  // instances initially ordered by index
+  for (int i(0); i < m_n; i++) {
+
+    m_ids[i] = i;
+    m_weights[i] = W(i);
+
+    if (m_ordering == Median) {
+      m_labels[i] = QVector<int>(1, i);
+      m_keys[i] = Key(i, -i);
+    }
+    else
+      m_keys[i] = Key(i, 0);
+
+    m_prev[i] = i - 1;
+    m_next[i] = (i < m_n - 1) ? i + 1 : -1;
+  }
+
+  m_first = (m_n > 0) ? 0 : -1;
+
+  if (m_temporalCst) {
+
+    // closest two adjacent clusters, first ones in case of ties
+    while (true) {
+
+      int best(-1);
+      double bestDist(arma::datum::inf);
+
+      for (int s(m_first); s != -1 && m_next[s] != -1; s = m_next[s]) {
+
+	double d = m_C(condensedIdx(s, m_next[s]));
+
+	if (d < bestDist) {
+	  best = s;
+	  bestDist = d;
+	}
+      }
+
+      if (best == -1)
+	break;
+
+      merge(best, m_next[best]);
+    }
+  }
+
+  else {
+
+    for (int i(0); i < m_n; i++)
+      findNeighbour(i);
+
+    // closest two clusters, ties broken by position
+    while (true) {
+
+      int best(-1);
+
+      for (int s(0); s < m_n; s++)
+	if (m_active[s] && m_nn[s] != -1 && (best == -1 || closer(m_nnDist[s], s, m_nnDist[best], best)))
+	  best = s;
+
+      if (best == -1 || m_nnDist[best] == arma::datum::inf)
+	break;
+
+      merge(best, m_nn[best]);
+    }
+  }
+}
+
+template <class Linkage>
+QVector<HacMerge> HacEngine<Linkage>::getMerges() const
+{
+  return m_merges;
+}
+
+template <class Linkage>
+QVector<int> HacEngine<Linkage>::getClusters() const
+{
+  QVector<int> clusters;
+
+  // remaining clusters in position order
+  for (int s(m_first); s != -1; s = m_next[s])
+    clusters.push_back(m_ids[s]);
+
+  return clusters;
+}
+
+/////////////////////
+// private methods //
+/////////////////////
+
+template <class Linkage>
+void HacEngine<Linkage>::merge(int l, int r)
+{
+  double d = m_C(condensedIdx(l, r));
+
+  HacMerge newMerge = {m_ids[l], m_ids[r], d};
+  m_merges.push_back(newMerge);
+
+  // distances from the new cluster, stored in the slot of its right son
+  for (int k(0); k < m_n; k++)
+
+    if (m_active[k] && k != l && k != r) {
+
+      double newDist = Linkage::update(m_C(condensedIdx(l, k)), m_C(condensedIdx(r, k)), d, m_weights[l], m_weights[r], m_weights[k]);
+
+      if (!std::isfinite(newDist))
+	newDist = arma::datum::inf;
+
+      m_C(condensedIdx(r, k)) = newDist;
+    }
+
+  unlink(l);
+  unlink(r);
+  m_active[l] = false;
+
+  m_ids[r] = m_n + m_merges.size() - 1;
+  m_weights[r] = m_weights[l] + m_weights[r];
+
+  // newest cluster first among clusters with the same median
+  if (m_ordering == Median) {
+
+    QVector<int> labels(m_labels[l].size() + m_labels[r].size());
+    std::merge(m_labels[l].begin(), m_labels[l].end(), m_labels[r].begin(), m_labels[r].end(), labels.begin());
+    m_labels[l].clear();
+    m_labels[r] = labels;
+
+    int n(labels.size());
+    qint64 median = (n % 2 == 1) ? labels[n / 2] : (labels[n / 2 - 1] + labels[n / 2]) / 2;
+    m_keys[r] = Key(median, -m_ids[r]);
+  }
+  else
+    m_keys[r] = Key(m_ids[r], 0);
+
+  link(r);
+
+  if (m_temporalCst)
+    return;
+
+  // updating nearest neighbours: only the ones pointing to
+  // merged clusters are searched again, which may still be
+  // all remaining clusters (e.g. a chain of growing clusters)
+  findNeighbour(r);
+
+  for (int k(0); k < m_n; k++)
+
+    if (m_active[k] && k != r) {
+
+      if (m_nn[k] == l || m_nn[k] == r)
+	findNeighbour(k);
+
+      else if (m_keys[k] < m_keys[r] && (m_nn[k] == -1 || closer(m_C(condensedIdx(k, r)), r, m_nnDist[k], m_nn[k]))) {
+	m_nn[k] = r;
+	m_nnDist[k] = m_C(condensedIdx(k, r));
+      }
+    }
+}
+
+template <class Linkage>
+void HacEngine<Linkage>::findNeighbour(int i)
+{
+  m_nn[i] = -1;
+  m_nnDist[i] = arma::datum::inf;
+
+  // only clusters positioned afterwards: each pair is considered once
+  for (int j(0); j < m_n; j++)
+
+    if (m_active[j] && m_keys[i] < m_keys[j]) {
+
+      double d = m_C(condensedIdx(i, j));
+
+      if (m_nn[i] == -1 || closer(d, j, m_nnDist[i], m_nn[i])) {
+	m_nn[i] = j;
+	m_nnDist[i] = d;
+      }
+    }
+}
+
+template <class Linkage>
+void HacEngine<Linkage>::unlink(int s)
+{
+  if (m_prev[s] != -1)
+    m_next[m_prev[s]] = m_next[s];
+  else
+    m_first = m_next[s];
+
+  if (m_next[s] != -1)
+    m_prev[m_next[s]] = m_prev[s];
+}
+
+template <class Linkage>
+void HacEngine<Linkage>::link(int s)
+{
+  int prev(-1);
+  int next(m_first);
+
+  while (next != -1 && m_keys[next] < m_keys[s]) {
+    prev = next;
+    next = m_next[next];
+  }
+
+  m_prev[s] = prev;
+  m_next[s] = next;
+
+  if (prev != -1)
+    m_next[prev] = s;
+  else
+    m_first = s;
+
+  if (next != -1)
+    m_prev[next] = s;
+}
+
+template <class Linkage>
+bool HacEngine<Linkage>::closer(double d1, int s1, double d2, int s2) const
+{
+  return d1 < d2 || (d1 == d2 && m_keys[s1] < m_keys[s2]);
+}
+
+template <class Linkage>
+arma::uword HacEngine<Linkage>::condensedIdx(int i, int j) const
+{
+  if (i > j)
+    std::swap(i, j);
+
+  arma::uword u(i), v(j), n(m_n);
+
+  return u * n - u * (u + 1) / 2 + v - u - 1;
+}
+
+#endif
@@ -0,0 +1,513 @@
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonValue>
+#include <QElapsedTimer>
+#include <QDebug>
+
+#include "HeadlessDriver.h"
+#include "SpkDiarizationDialog.h"
+#include "SpkInteractDialog.h"
+#include "SummarizationDialog.h"
+#include "FaceDetectDialog.h"
+#include "UtteranceTree.h"
+#include "DistanceKernel.h"
+
+/////////////////////////////////
+// constructor and destructor  //
+/////////////////////////////////
+
+HeadlessDriver::HeadlessDriver(QObject *parent)
+  : QObject(parent),
+    m_nWorkers(-1)
+{
+  m_project = new ProjectModel(this);
+}
+
+HeadlessDriver::~HeadlessDriver()
+{
+}
+
+////////////////////
+// public methods //
+////////////////////
+
+bool HeadlessDriver::loadConfig(const QString &fName)
+{
+  QFile configFile(fName);
+
+  if (!configFile.open(QIODevice::ReadOnly)) {
+    qWarning() << "Couldn't open configuration file" << fName;
+    return false;
+  }
+
+  QJsonParseError error;
+  QJsonDocument configDoc(QJsonDocument::fromJson(configFile.readAll(), &error));
+
+  if (error.error != QJsonParseError::NoError || !configDoc.isObject()) {
+    qWarning() << "Invalid configuration file" << fName << ":" << error.errorString();
+    return false;
+  }
+
+  QJsonObject config = configDoc.object();
+
+  m_stages = config["stages"].toArray();
+  m_nWorkers = config["workers"].toInt(-1);
+  m_project->setDiarThreads(m_nWorkers);
+
+  // memory budget in MB for episodes of binary projects: unlimited by default
+  m_project->setMemoryBudget(static_cast<qint64>(config["memoryBudget"].toDouble(0) * 1024 * 1024));
+
+  // no dialog can be answered: mismatching i-vectors are extracted again
+  // unless stated otherwise
+  m_project->setInteractive(false, config["extractIVectorsOnMismatch"].toBool(true));
+
+  // p-center/p-median problems solved exactly unless stated otherwise
+  if (config["solver"].toString().toLower() == "heuristic")
+    m_project->setSolverMode(Optimizer::Heuristic, m_nWorkers);
+
+  return true;
+}
+
+bool HeadlessDriver::run(const QString &projectFName, const QString &outputFName)
+{
+  if (!m_project->load(projectFName))
+    return false;
+
+  QElapsedTimer timer;
+
+  for (int i(0); i < m_stages.size(); i++) {
+
+    QJsonObject stage = m_stages[i].toObject();
+
+    qDebug() << "Running stage" << stage["stage"].toString() << "...";
+    timer.start();
+
+    // following stages depend on previous results
+    if (!runStage(stage))
+      return false;
+
+    qDebug() << "Stage" << stage["stage"].toString() << "completed in" << QString::number(timer.elapsed() / 1000.0, 'f', 3) << "seconds";
+  }
+
+  // project files are saved with .json extension appended
+  QString baseName(outputFName);
+  if (baseName.endsWith(".json"))
+    baseName.chop(5);
+
+  return m_project->save(baseName);
+}
+
+/////////////////////
+// private methods //
+/////////////////////
+
+bool HeadlessDriver::runStage(const QJsonObject &stage)
+{
+  QString name = stage["stage"].toString();
+  QJsonObject params = stage["params"].toObject();
+
+  if (name == "shots")
+    return extractShots(params);
+
+  if (name == "similarShots")
+    return labelSimilarShots(params);
+
+  if (name == "faces")
+    return detectFaces(params);
+
+  if (name == "scenes")
+    return extractScenes(params);
+
+  if (name == "diarization")
+    return spkDiar(params);
+
+  if (name == "diarizationSweep")
+    return spkDiarSweep(params);
+
+  if (name == "interactions")
+    return spkInteract(params);
+
+  if (name == "summaries")
+    return summarization(params);
+
+  if (name == "shotBenchmark")
+    return benchmarkShotDetection(params);
+
+  if (name == "distanceBenchmark")
+    return benchmarkDistances(params);
+
+  if (name == "facilityBenchmark")
+    return benchmarkFacilityLocation(params);
+
+  if (name == "selectionBenchmark")
+    return benchmarkSelection(params);
+
+  qWarning() << "Unknown stage" << name;
+
+  return false;
+}
+
+bool HeadlessDriver::extractShots(const QJsonObject &params)
+{
+  EpisodeBatchScheduler scheduler(m_nWorkers);
+
+  qreal threshold1 = params["threshold1"].toDouble(30);
+  qreal threshold2 = params["threshold2"].toDouble(20);
+
+  scheduler.setShotParams(params["histoType"].toInt(2),
+			  params["nVBins"].toInt(64),
+			  params["nHBins"].toInt(24),
+			  params["nSBins"].toInt(8),
+			  params["metrics"].toInt(0),
+			  threshold1,
+			  threshold2,
+			  params["nVBlock"].toInt(5),
+			  params["nHBlock"].toInt(6),
+			  params["analysisHeight"].toInt(0));
+
+  if (!m_project->batchProcess(scheduler, EpisodeBatchScheduler::Shots, false))
+    return false;
+
+  // scores against manual annotations, when available
+  QList<Episode *> episodes = m_project->getEpisodes();
+
+  for (int i(0); i < episodes.size(); i++) {
+    m_project->setEpisode(episodes[i]);
+    qDebug() << episodes[i]->getFName() << "F-score:" << m_project->evaluateShotDetection(false, threshold1, threshold2);
+  }
+
+  return true;
+}
+
+bool HeadlessDriver::labelSimilarShots(const QJsonObject &params)
+{
+  EpisodeBatchScheduler scheduler(m_nWorkers);
+
+  qreal maxDist = params["maxDist"].toDouble(40);
+  int windowSize = params["windowSize"].toInt(30);
+
+  scheduler.setSimShotParams(params["histoType"].toInt(2),
+			     params["nVBins"].toInt(64),
+			     params["nHBins"].toInt(24),
+			     params["nSBins"].toInt(8),
+			     params["metrics"].toInt(0),
+			     maxDist,
+			     windowSize,
+			     params["nVBlock"].toInt(5),
+			     params["nHBlock"].toInt(6),
+			     params["analysisHeight"].toInt(0));
+
+  if (!m_project->batchProcess(scheduler, EpisodeBatchScheduler::SimilarShots, false))
+    return false;
+
+  QList<Episode *> episodes = m_project->getEpisodes();
+
+  for (int i(0); i < episodes.size(); i++) {
+    m_project->setEpisode(episodes[i]);
+    qDebug() << episodes[i]->getFName() << "F-score:" << m_project->evaluateSimShotDetection(false, maxDist, windowSize);
+  }
+
+  return true;
+}
+
+bool HeadlessDriver::detectFaces(const QJsonObject &params)
+{
+  // only OpenCV detection runs in-process: other methods rely on
+  // external tools whose results are imported afterwards
+  FaceDetectDialog::Method method = static_cast<FaceDetectDialog::Method>(enumValue(params, "method", QStringList() << "opencv" << "zhu" << "extdata", FaceDetectDialog::OpenCV));
+
+  if (method != FaceDetectDialog::OpenCV) {
+    qWarning() << "Face detection method not available in headless mode";
+    return false;
+  }
+
+  EpisodeBatchScheduler scheduler(m_nWorkers);
+  scheduler.setFaceParams(params["minHeight"].toInt(16));
+
+  return m_project->batchProcess(scheduler, EpisodeBatchScheduler::Faces, false);
+}
+
+bool HeadlessDriver::extractScenes(const QJsonObject &params)
+{
+  Segment::Source source = static_cast<Segment::Source>(enumValue(params, "source", QStringList() << "manual" << "automatic" << "both", Segment::Manual));
+
+  QList<Episode *> episodes = m_project->getEpisodes();
+
+  if (episodes.isEmpty())
+    return true;
+
+  // scenes of the whole series extracted at once, as from the GUI
+  m_project->setEpisode(episodes.first());
+  m_project->extractScenes(source, episodes.first()->getFName());
+
+  return true;
+}
+
+bool HeadlessDriver::spkDiar(const QJsonObject &params)
+{
+  UtteranceTree::DistType dist = static_cast<UtteranceTree::DistType>(enumValue(params, "dist", QStringList() << "l2" << "mahal", UtteranceTree::Mahal));
+  UtteranceTree::AgrCrit agr = static_cast<UtteranceTree::AgrCrit>(enumValue(params, "agrCrit", QStringList() << "min" << "max" << "mean" << "ward", UtteranceTree::Ward));
+  UtteranceTree::PartMeth partMeth = static_cast<UtteranceTree::PartMeth>(enumValue(params, "partMeth", QStringList() << "silhouette" << "bipartition", UtteranceTree::Silhouette));
+  bool norm = params["norm"].toBool(true);
+  bool weight = params["weight"].toBool(false);
+  bool sigma = params["sigma"].toBool(false);
+
+  QList<Episode *> episodes = m_project->getEpisodes();
+
+  for (int i(0); i < episodes.size(); i++) {
+
+    // loaded first: episodes not in memory have no speech turns yet
+    m_project->setEpisode(episodes[i]);
+
+    // episodes without speech turns are left aside
+    if (episodes[i]->getSpeechSegments().isEmpty())
+      continue;
+
+    if (!m_project->localSpkDiar(SpkDiarizationDialog::HC, dist, norm, agr, partMeth, weight, sigma))
+      return false;
+  }
+
+  return true;
+}
+
+bool HeadlessDriver::spkDiarSweep(const QJsonObject &params)
+{
+  QList<int> dists = enumValues(params, "dist", QStringList() << "l2" << "mahal");
+  QList<int> agrs = enumValues(params, "agrCrit", QStringList() << "min" << "max" << "mean" << "ward");
+  QList<int> partMeths = enumValues(params, "partMeth", QStringList() << "silhouette" << "bipartition");
+  QList<bool> norms = boolValues(params, "norm");
+  QList<bool> weights = boolValues(params, "weight");
+  QList<bool> sigmas = boolValues(params, "sigma");
+
+  // every combination of the listed values
+  QList<MovieAnalyzer::DiarConfig> configs;
+
+  for (int i(0); i < dists.size(); i++)
+    for (int j(0); j < agrs.size(); j++)
+      for (int k(0); k < partMeths.size(); k++)
+	for (int l(0); l < norms.size(); l++)
+	  for (int m(0); m < weights.size(); m++)
+	    for (int n(0); n < sigmas.size(); n++) {
+
+	      // L2 distance independent of covariance matrix
+	      if (dists[i] == UtteranceTree::L2 && n > 0)
+		continue;
+
+	      MovieAnalyzer::DiarConfig config;
+	      config.dist = static_cast<UtteranceTree::DistType>(dists[i]);
+	      config.agr = static_cast<UtteranceTree::AgrCrit>(agrs[j]);
+	      config.partMeth = static_cast<UtteranceTree::PartMeth>(partMeths[k]);
+	      config.norm = norms[l];
+	      config.weight = weights[m];
+	      config.sigma = sigmas[n];
+	      configs.push_back(config);
+	    }
+
+  QVector<QList<QPair<qreal, qreal> > > localDer(configs.size());
+  QList<Episode *> episodes = m_project->getEpisodes();
+  QElapsedTimer timer;
+
+  timer.start();
+
+  for (int i(0); i < episodes.size(); i++) {
+
+    // loaded first: episodes not in memory have no speech turns yet
+    m_project->setEpisode(episodes[i]);
+
+    // episodes without speech turns are left aside
+    if (episodes[i]->getSpeechSegments().isEmpty())
+      continue;
+
+    QVector<QList<QPair<qreal, qreal> > > episodeDer;
+
+    if (!m_project->localSpkDiarSweep(configs, episodeDer))
+      return false;
+
+    // DER over all episodes
+    for (int c(0); c < configs.size(); c++)
+      localDer[c].append(episodeDer[c]);
+  }
+
+  qDebug() << configs.size() << "configurations evaluated in" << QString::number(timer.nsecsElapsed() / 1e9, 'f', 3) << "s";
+  m_project->displaySweepTable(configs, localDer);
+
+  return true;
+}
+
+bool HeadlessDriver::spkInteract(const QJsonObject &params)
+{
+  SpkInteractDialog::InteractType type = static_cast<SpkInteractDialog::InteractType>(enumValue(params, "type", QStringList() << "ref" << "cooccurr" << "sequential", SpkInteractDialog::Sequential));
+  SpkInteractDialog::RefUnit unit = static_cast<SpkInteractDialog::RefUnit>(enumValue(params, "unit", QStringList() << "scene" << "lsu", SpkInteractDialog::Scene));
+
+  m_project->spkInteract(type, unit, params["nbDiscards"].toInt(0), params["interThresh"].toInt(5));
+
+  return true;
+}
+
+bool HeadlessDriver::summarization(const QJsonObject &params)
+{
+  SummarizationDialog::Method method = static_cast<SummarizationDialog::Method>(enumValue(params, "method", QStringList() << "content" << "style" << "both" << "random", SummarizationDialog::Both));
+  SummarizationDialog::Selection selection = static_cast<SummarizationDialog::Selection>(enumValue(params, "selection", QStringList() << "mmr" << "ratiogreedy" << "knapsack", SummarizationDialog::Mmr));
+
+  // last season by default
+  int seasonNb = params["season"].toInt(m_project->getSeasons().size() - 1);
+  int dur = params["duration"].toInt(25);
+  qreal granu = params["granularity"].toDouble(1.0);
+
+  // all reference speakers by default
+  QStringList speakers;
+  QJsonArray speakerArray = params["speakers"].toArray();
+
+  for (int i(0); i < speakerArray.size(); i++)
+    speakers.push_back(speakerArray[i].toString());
+
+  if (speakers.isEmpty())
+    speakers = m_project->retrieveRefSpeakers();
+
+  for (int i(0); i < speakers.size(); i++)
+    if (!m_project->summarization(method, seasonNb, speakers[i], dur, granu, selection))
+      return false;
+
+  return true;
+}
+
+bool HeadlessDriver::benchmarkShotDetection(const QJsonObject &params)
+{
+  QList<int> heights;
+  QJsonArray heightArray = params["analysisHeights"].toArray();
+
+  for (int i(0); i < heightArray.size(); i++)
+    heights.push_back(heightArray[i].toInt());
+
+  if (heights.isEmpty())
+    heights << 0 << 288 << 144;
+
+  QList<Episode *> episodes = m_project->getEpisodes();
+
+  for (int i(0); i < episodes.size(); i++) {
+
+    m_project->setEpisode(episodes[i]);
+
+    qDebug() << "Episode" << episodes[i]->getFName();
+    m_project->benchmarkShotDetection(episodes[i]->getFName(),
+				      heights,
+				      params["histoType"].toInt(2),
+				      params["nVBins"].toInt(64),
+				      params["nHBins"].toInt(24),
+				      params["nSBins"].toInt(8),
+				      params["metrics"].toInt(0),
+				      params["threshold1"].toDouble(30),
+				      params["threshold2"].toDouble(20),
+				      params["nVBlock"].toInt(5),
+				      params["nHBlock"].toInt(6));
+  }
+
+  return true;
+}
+
+bool HeadlessDriver::benchmarkDistances(const QJsonObject &params)
+{
+  QList<int> sizes;
+  QJsonArray sizeArray = params["sizes"].toArray();
+
+  for (int i(0); i < sizeArray.size(); i++)
+    sizes.push_back(sizeArray[i].toInt());
+
+  if (sizes.isEmpty())
+    sizes << 100 << 500 << 1000 << 2000;
+
+  DistanceKernel::benchmark(sizes, params["dim"].toInt(100), m_nWorkers);
+
+  return true;
+}
+
+bool HeadlessDriver::benchmarkFacilityLocation(const QJsonObject &params)
+{
+  QList<Episode *> episodes = m_project->getEpisodes();
+
+  for (int i(0); i < episodes.size(); i++) {
+
+    // loaded first: episodes not in memory have no speech turns yet
+    m_project->setEpisode(episodes[i]);
+
+    // episodes without speech turns are left aside
+    if (episodes[i]->getSpeechSegments().isEmpty())
+      continue;
+
+    qDebug() << "Episode" << episodes[i]->getFName();
+    m_project->benchmarkFacilityLocation(params["maxExactSize"].toInt(150));
+  }
+
+  return true;
+}
+
+bool HeadlessDriver::benchmarkSelection(const QJsonObject &params)
+{
+  QList<int> sizes;
+  QJsonArray sizeArray = params["sizes"].toArray();
+
+  for (int i(0); i < sizeArray.size(); i++)
+    sizes.push_back(sizeArray[i].toInt());
+
+  if (sizes.isEmpty())
+    sizes << 20 << 40 << 60 << 500 << 2000;
+
+  Optimizer optimizer;
+  optimizer.benchmarkSelection(sizes, params["maxExactSize"].toInt(60));
+
+  return true;
+}
+
+int HeadlessDriver::enumValue(const QJsonObject &params, const QString &key, const QStringList &names, int defValue) const
+{
+  if (!params.contains(key))
+    return defValue;
+
+  int value = names.indexOf(params[key].toString().toLower());
+
+  if (value == -1) {
+    qWarning() << "Unknown value" << params[key].toString() << "for" << key << ": default used";
+    return defValue;
+  }
+
+  return value;
+}
+
+QList<int> HeadlessDriver::enumValues(const QJsonObject &params, const QString &key, const QStringList &names) const
+{
+  QList<int> values;
+  QJsonArray array = params[key].toArray();
+
+  for (int i(0); i < array.size(); i++) {
+
+    int value = names.indexOf(array[i].toString().toLower());
+
+    if (value == -1)
+      qWarning() << "Unknown value" << array[i].toString() << "for" << key << ": ignored";
+    else if (!values.contains(value))
+      values.push_back(value);
+  }
+
+  // all values by default
+  if (values.isEmpty())
+    for (int i(0); i < names.size(); i++)
+      values.push_back(i);
+
+  return values;
+}
+
+QList<bool> HeadlessDriver::boolValues(const QJsonObject &params, const QString &key) const
+{
+  QList<bool> values;
+  QJsonArray array = params[key].toArray();
+
+  for (int i(0); i < array.size(); i++)
+    if (array[i].isBool() && !values.contains(array[i].toBool()))
+      values.push_back(array[i].toBool());
+
+  // both values by default
+  if (values.isEmpty())
+    values << false << true;
+
+  return values;
+}
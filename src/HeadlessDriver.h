@@ -0,0 +1,63 @@
+#ifndef HEADLESSDRIVER_H
+#define HEADLESSDRIVER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QJsonObject>
+#include <QJsonArray>
+
+#include "ProjectModel.h"
+
+///////////////////////////////////////////////////////
+// runs a sequence of processing stages on a project //
+// without user interaction: stages and parameters   //
+// are read from a JSON configuration file           //
+///////////////////////////////////////////////////////
+
+class HeadlessDriver: public QObject
+{
+  Q_OBJECT
+
+ public:
+  HeadlessDriver(QObject *parent = 0);
+  ~HeadlessDriver();
+
+  bool loadConfig(const QString &fName);
+  bool run(const QString &projectFName, const QString &outputFName);
+
+ private:
+  bool runStage(const QJsonObject &stage);
+
+  ///////////////////////
+  // processing stages //
+  ///////////////////////
+
+  bool extractShots(const QJsonObject &params);
+  bool labelSimilarShots(const QJsonObject &params);
+  bool detectFaces(const QJsonObject &params);
+  bool extractScenes(const QJsonObject &params);
+  bool spkDiar(const QJsonObject &params);
+  bool spkDiarSweep(const QJsonObject &params);
+  bool spkInteract(const QJsonObject &params);
+  bool summarization(const QJsonObject &params);
+
+  ////////////////
+  // benchmarks //
+  ////////////////
+
+  bool benchmarkShotDetection(const QJsonObject &params);
+  bool benchmarkDistances(const QJsonObject &params);
+  bool benchmarkFacilityLocation(const QJsonObject &params);
+  bool benchmarkSelection(const QJsonObject &params);
+
+  int enumValue(const QJsonObject &params, const QString &key, const QStringList &names, int defValue) const;
+  QList<int> enumValues(const QJsonObject &params, const QString &key, const QStringList &names) const;
+  QList<bool> boolValues(const QJsonObject &params, const QString &key) const;
+
+  ProjectModel *m_project;
+  QJsonArray m_stages;
+  int m_nWorkers;
+};
+
+#endif
@@ -0,0 +1,315 @@
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDir>
+#include <QCryptographicHash>
+
+#include <cstring>
+#include <algorithm>
+
+#include "HistoCache.h"
+
+using namespace cv;
+
+static const char histoCacheMagic[8] = { 'T', 'V', 'H', 'I', 'S', 'T', 'O', '\0' };
+static const qint32 histoCacheVersion = 1;
+
+// directory of cache files, relative to working directory by default
+static QString histoCacheDir("histoCache");
+
+/////////////////////////////////
+// constructor and destructor  //
+/////////////////////////////////
+
+HistoCache::HistoCache()
+  : m_data(0),
+    m_histo(0),
+    m_positions(0),
+    m_writing(false)
+{
+  memset(&m_header, 0, sizeof(Header));
+}
+
+HistoCache::~HistoCache()
+{
+  if (m_writing)
+    discard();
+  else
+    close();
+}
+
+QString HistoCache::cacheFName(const QString &fName, int histoType, int nVBins, int nHBins, int nSBins, int nVBlock, int nHBlock, int analysisHeight)
+{
+  QFileInfo fileInfo(fName);
+
+  // episodes of distinct seasons may share the same base name
+  QByteArray pathHash = QCryptographicHash::hash(fileInfo.absoluteFilePath().toUtf8(), QCryptographicHash::Md5).toHex().left(8);
+
+  return histoCacheDir + "/" +
+    fileInfo.completeBaseName() + "_" +
+    QString::fromLatin1(pathHash) + "_" +
+    QString::number(histoType) + "_" +
+    QString::number(nHBins) + "x" +
+    QString::number(nSBins) + "x" +
+    QString::number(nVBins) + "_" +
+    QString::number(nVBlock) + "x" +
+    QString::number(nHBlock) +
+    (analysisHeight > 0 ? "_h" + QString::number(analysisHeight) : QString()) + ".hist";
+}
+
+QString HistoCache::getCacheDir()
+{
+  return histoCacheDir;
+}
+
+void HistoCache::setCacheDir(const QString &dir)
+{
+  histoCacheDir = dir;
+}
+
+/////////////
+// reading //
+/////////////
+
+bool HistoCache::open(const QString &fName, int histoType, int nVBins, int nHBins, int nSBins, int nVBlock, int nHBlock, int analysisHeight)
+{
+  close();
+
+  m_file.setFileName(cacheFName(fName, histoType, nVBins, nHBins, nSBins, nVBlock, nHBlock, analysisHeight));
+
+  if (!m_file.open(QIODevice::ReadOnly))
+    return false;
+
+  if (m_file.size() < static_cast<qint64>(sizeof(Header))) {
+    close();
+    return false;
+  }
+
+  m_data = m_file.map(0, m_file.size());
+
+  if (!m_data) {
+    close();
+    return false;
+  }
+
+  // cache may have been computed for another video or other parameters
+  Header stored;
+  memcpy(&stored, m_data, sizeof(Header));
+  initHeader(fName, histoType, nVBins, nHBins, nSBins, nVBlock, nHBlock, analysisHeight);
+
+  qint64 histoBytes = stored.nFrames * stored.nBlocks * stored.nBins * sizeof(float);
+  qint64 posOffset = sizeof(Header) + ((histoBytes + 7) / 8) * 8;
+
+  if (memcmp(stored.magic, histoCacheMagic, sizeof(histoCacheMagic)) != 0 ||
+      stored.version != m_header.version ||
+      stored.histoType != m_header.histoType ||
+      stored.nVBins != m_header.nVBins ||
+      stored.nHBins != m_header.nHBins ||
+      stored.nSBins != m_header.nSBins ||
+      stored.nVBlock != m_header.nVBlock ||
+      stored.nHBlock != m_header.nHBlock ||
+      stored.analysisHeight != m_header.analysisHeight ||
+      stored.videoSize != m_header.videoSize ||
+      stored.videoMTime != m_header.videoMTime ||
+      m_file.size() != posOffset + stored.nFrames * static_cast<qint64>(sizeof(qint64))) {
+    close();
+    return false;
+  }
+
+  m_header = stored;
+  m_histo = reinterpret_cast<const float *>(m_data + sizeof(Header));
+  m_positions = reinterpret_cast<const qint64 *>(m_data + posOffset);
+
+  return true;
+}
+
+void HistoCache::close()
+{
+  if (m_data)
+    m_file.unmap(m_data);
+
+  m_file.close();
+  m_data = 0;
+  m_histo = 0;
+  m_positions = 0;
+  memset(&m_header, 0, sizeof(Header));
+}
+
+bool HistoCache::isOpen() const
+{
+  return m_data != 0;
+}
+
+int HistoCache::getFrameCount() const
+{
+  return isOpen() ? static_cast<int>(m_header.nFrames) : 0;
+}
+
+int HistoCache::getNBlocks() const
+{
+  return m_header.nBlocks;
+}
+
+qint64 HistoCache::getPosition(int k) const
+{
+  return m_positions[k];
+}
+
+qint64 HistoCache::getEndPosition() const
+{
+  return m_header.endPosition;
+}
+
+int HistoCache::frameIndex(qint64 msec) const
+{
+  // first frame displayed at or after given time, as when seeking the capture
+  const qint64 *first = m_positions;
+  const qint64 *last = m_positions + m_header.nFrames;
+  int k = std::lower_bound(first, last, msec + 40) - first;
+
+  return qBound(0, k, getFrameCount() - 1);
+}
+
+QVector<cv::Mat> HistoCache::getLocHisto(int k) const
+{
+  QVector<Mat> locHisto(m_header.nBlocks);
+  const float *data = frameData(k);
+
+  // headers pointing to mapped memory: no copy
+  for (int i(0); i < m_header.nBlocks; i++)
+    locHisto[i] = Mat(1, m_header.nBins, CV_32F, const_cast<float *>(data + i * m_header.nBins));
+
+  return locHisto;
+}
+
+cv::Mat HistoCache::getHistos(int k) const
+{
+  // one row per block, pointing to mapped memory
+  return Mat(m_header.nBlocks, m_header.nBins, CV_32F, const_cast<float *>(frameData(k)));
+}
+
+/////////////
+// writing //
+/////////////
+
+bool HistoCache::create(const QString &fName, int histoType, int nVBins, int nHBins, int nSBins, int nVBlock, int nHBlock, int analysisHeight)
+{
+  close();
+
+  m_fName = cacheFName(fName, histoType, nVBins, nHBins, nSBins, nVBlock, nHBlock, analysisHeight);
+  QDir().mkpath(QFileInfo(m_fName).path());
+
+  m_file.setFileName(m_fName + ".tmp");
+
+  if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return false;
+
+  initHeader(fName, histoType, nVBins, nHBins, nSBins, nVBlock, nHBlock, analysisHeight);
+  m_writtenPos.clear();
+  m_writing = true;
+
+  // header is rewritten once number of frames is known
+  return m_file.write(reinterpret_cast<const char *>(&m_header), sizeof(Header)) == sizeof(Header);
+}
+
+bool HistoCache::append(qint64 position, const QVector<cv::Mat> &locHisto)
+{
+  if (!m_writing || locHisto.isEmpty())
+    return false;
+
+  // block and bin numbers are set by first frame
+  if (m_writtenPos.isEmpty()) {
+    m_header.nBlocks = locHisto.size();
+    m_header.nBins = static_cast<qint32>(locHisto[0].total());
+  }
+
+  if (locHisto.size() != m_header.nBlocks)
+    return false;
+
+  for (int i(0); i < locHisto.size(); i++) {
+
+    Mat histo;
+
+    if (locHisto[i].type() == CV_32F && locHisto[i].isContinuous())
+      histo = locHisto[i];
+    else
+      locHisto[i].convertTo(histo, CV_32F);
+
+    qint64 nBytes = m_header.nBins * sizeof(float);
+    if (static_cast<qint64>(histo.total()) != m_header.nBins ||
+	m_file.write(reinterpret_cast<const char *>(histo.ptr<float>()), nBytes) != nBytes)
+      return false;
+  }
+
+  m_writtenPos.push_back(position);
+
+  return true;
+}
+
+bool HistoCache::commit(qint64 endPosition)
+{
+  if (!m_writing)
+    return false;
+
+  m_header.nFrames = m_writtenPos.size();
+  m_header.endPosition = endPosition;
+
+  // aligning frame positions on 8 bytes
+  qint64 histoBytes = m_file.pos() - sizeof(Header);
+  QByteArray padding(((histoBytes + 7) / 8) * 8 - histoBytes, '\0');
+  m_file.write(padding);
+
+  qint64 posBytes = m_writtenPos.size() * sizeof(qint64);
+  bool written =
+    m_file.write(reinterpret_cast<const char *>(m_writtenPos.constData()), posBytes) == posBytes &&
+    m_file.seek(0) &&
+    m_file.write(reinterpret_cast<const char *>(&m_header), sizeof(Header)) == sizeof(Header);
+
+  m_file.close();
+  m_writing = false;
+  m_writtenPos.clear();
+
+  if (!written) {
+    QFile::remove(m_fName + ".tmp");
+    return false;
+  }
+
+  QFile::remove(m_fName);
+
+  return QFile::rename(m_fName + ".tmp", m_fName);
+}
+
+void HistoCache::discard()
+{
+  m_file.close();
+  m_writing = false;
+  m_writtenPos.clear();
+
+  QFile::remove(m_fName + ".tmp");
+}
+
+/////////////////////
+// private methods //
+/////////////////////
+
+void HistoCache::initHeader(const QString &fName, int histoType, int nVBins, int nHBins, int nSBins, int nVBlock, int nHBlock, int analysisHeight)
+{
+  QFileInfo videoInfo(fName);
+
+  memset(&m_header, 0, sizeof(Header));
+  memcpy(m_header.magic, histoCacheMagic, sizeof(histoCacheMagic));
+  m_header.version = histoCacheVersion;
+  m_header.histoType = histoType;
+  m_header.nVBins = nVBins;
+  m_header.nHBins = nHBins;
+  m_header.nSBins = nSBins;
+  m_header.nVBlock = nVBlock;
+  m_header.nHBlock = nHBlock;
+  m_header.analysisHeight = analysisHeight;
+  m_header.videoSize = videoInfo.size();
+  m_header.videoMTime = videoInfo.lastModified().toMSecsSinceEpoch();
+}
+
+const float * HistoCache::frameData(int k) const
+{
+  return m_histo + static_cast<qint64>(k) * m_header.nBlocks * m_header.nBins;
+}
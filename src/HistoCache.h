@@ -0,0 +1,76 @@
+#ifndef HISTOCACHE_H
+#define HISTOCACHE_H
+
+#include <QString>
+#include <QVector>
+#include <QFile>
+
+#include <opencv2/core/core.hpp>
+
+///////////////////////////////////////////////////////
+// on-disk store of per-frame block histograms,      //
+// keyed by episode file and histogram parameters,   //
+// read through a memory mapping                     //
+///////////////////////////////////////////////////////
+
+class HistoCache
+{
+ public:
+  HistoCache();
+  ~HistoCache();
+
+  static QString cacheFName(const QString &fName, int histoType, int nVBins, int nHBins, int nSBins, int nVBlock, int nHBlock, int analysisHeight = 0);
+  static QString getCacheDir();
+  static void setCacheDir(const QString &dir);
+
+  // reading
+  bool open(const QString &fName, int histoType, int nVBins, int nHBins, int nSBins, int nVBlock, int nHBlock, int analysisHeight = 0);
+  void close();
+  bool isOpen() const;
+  int getFrameCount() const;
+  int getNBlocks() const;
+  qint64 getPosition(int k) const;
+  qint64 getEndPosition() const;
+  int frameIndex(qint64 msec) const;
+  QVector<cv::Mat> getLocHisto(int k) const;
+  cv::Mat getHistos(int k) const;
+
+  // writing
+  bool create(const QString &fName, int histoType, int nVBins, int nHBins, int nSBins, int nVBlock, int nHBlock, int analysisHeight = 0);
+  bool append(qint64 position, const QVector<cv::Mat> &locHisto);
+  bool commit(qint64 endPosition);
+  void discard();
+
+ private:
+  struct Header {
+    char magic[8];
+    qint32 version;
+    qint32 histoType;
+    qint32 nVBins;
+    qint32 nHBins;
+    qint32 nSBins;
+    qint32 nVBlock;
+    qint32 nHBlock;
+    qint32 nBlocks;
+    qint32 nBins;
+    qint32 analysisHeight;
+    qint64 nFrames;
+    qint64 videoSize;
+    qint64 videoMTime;
+    qint64 endPosition;
+  };
+
+  void initHeader(const QString &fName, int histoType, int nVBins, int nHBins, int nSBins, int nVBlock, int nHBlock, int analysisHeight);
+  const float * frameData(int k) const;
+
+  QFile m_file;
+  QString m_fName;
+  Header m_header;
+  uchar *m_data;
+  const float *m_histo;
+  const qint64 *m_positions;
+  QVector<qint64> m_writtenPos;
+  bool m_writing;
+};
+
+#endif
@@ -0,0 +1,355 @@
+#include <QThread>
+#include <QDebug>
+
+#include <cmath>
+
+#include "IVectorExtractor.h"
+
+using namespace arma;
+
+// frames used to train the UBM, taken at regular intervals
+static const uword MaxUbmFrames = 100000;
+
+// segments gathered into a single matrix product
+static const int BlockSize = 256;
+
+// blocks split into a fixed number of partial sums, whatever the number
+// of threads, so that accumulators are always summed in the same order
+static const int MaxPartialSums = 16;
+
+class IVectorThread: public QThread
+{
+ public:
+  IVectorThread(IVectorExtractor *extractor, const QVector<fmat> &features, bool stats, mat *A, mat *C, mat *W, int first, int last)
+    : m_extractor(extractor), m_features(features), m_stats(stats), m_A(A), m_C(C), m_W(W), m_first(first), m_last(last) {}
+
+ protected:
+  void run()
+  {
+    if (m_stats)
+      m_extractor->computeStats(m_features, m_first, m_last);
+    else
+      m_extractor->processPartialSums(m_features.size(), m_first, m_last, m_A, m_C, m_W);
+  }
+
+ private:
+  IVectorExtractor *m_extractor;
+  const QVector<fmat> &m_features;
+  bool m_stats;
+  mat *m_A;
+  mat *m_C;
+  mat *m_W;
+  int m_first;
+  int m_last;
+};
+
+/////////////////
+// constructor //
+/////////////////
+
+IVectorExtractor::IVectorExtractor(int nComponents, int rank, int nIter, int nThreads, QObject *parent)
+  : QObject(parent),
+    m_nComponents(nComponents),
+    m_rank(rank),
+    m_nIter(nIter),
+    m_nThreads((nThreads <= 0) ? QThread::idealThreadCount() : nThreads),
+    m_dim(0),
+    m_canceled(0)
+{
+}
+
+////////////////////
+// public methods //
+////////////////////
+
+mat IVectorExtractor::extract(const QVector<fmat> &features)
+{
+  mat X;
+  int n(features.size());
+
+  if (n == 0)
+    return X;
+
+  m_dim = features[0].n_rows;
+
+  // UBM, statistics, EM iterations and final extraction
+  emit progressRange(m_nIter + 3);
+  emit progress(0);
+
+  if (!trainUbm(features))
+    return X;
+
+  emit progress(1);
+  if (m_canceled.load())
+    return X;
+
+  // Baum-Welch statistics
+  m_N.zeros(m_nComponents, n);
+  m_F.zeros(m_nComponents * m_dim, n);
+  runThreads(features, true, 0, 0, 0);
+
+  emit progress(2);
+  if (m_canceled.load())
+    return X;
+
+  // same initial matrix from one run to another
+  arma_rng::set_seed(0);
+  m_T = 0.1 * randn<mat>(m_nComponents * m_dim, m_rank);
+  computeTtT();
+
+  for (int i(0); i < m_nIter; i++) {
+
+    mat A = zeros(m_rank * m_rank, m_nComponents);
+    mat C = zeros(m_nComponents * m_dim, m_rank);
+
+    runThreads(features, false, &A, &C, 0);
+    updateTV(A, C);
+
+    qDebug() << "Total variability matrix: iteration" << i + 1 << "/" << m_nIter;
+
+    emit progress(i + 3);
+    if (m_canceled.load())
+      return X;
+  }
+
+  // i-vectors from the final matrix
+  mat W(m_rank, n);
+  runThreads(features, false, 0, 0, &W);
+  fillEmptySegments(W);
+
+  X = W.t();
+
+  emit progress(m_nIter + 3);
+
+  return X;
+}
+
+///////////
+// slots //
+///////////
+
+void IVectorExtractor::cancel()
+{
+  m_canceled = 1;
+}
+
+/////////////////////
+// private methods //
+/////////////////////
+
+bool IVectorExtractor::trainUbm(const QVector<fmat> &features)
+{
+  uword total(0);
+
+  for (int i(0); i < features.size(); i++)
+    total += features[i].n_cols;
+
+  if (total < static_cast<uword>(m_nComponents)) {
+    qWarning() << "Not enough speech frames to train the UBM:" << total;
+    return false;
+  }
+
+  uword step = (total > MaxUbmFrames) ? total / MaxUbmFrames : 1;
+  mat data(m_dim, (total + step - 1) / step);
+  uword t(0);
+
+  for (int i(0); i < features.size(); i++)
+    for (uword j(0); j < features[i].n_cols; j++, t++)
+      if (t % step == 0)
+	data.col(t / step) = conv_to<vec>::from(features[i].col(j));
+
+  arma_rng::set_seed(0);
+  gmm_diag ubm;
+
+  if (!ubm.learn(data, m_nComponents, maha_dist, random_subset, 10, 20, 1e-6, false)) {
+    qWarning() << "Couldn't train the UBM";
+    return false;
+  }
+
+  mat vars = ubm.dcovs;
+  m_means = ubm.means;
+  m_sigmas = sqrt(vars);
+
+  // log-likelihoods of all frames given by two matrix products
+  m_precA = trans(-0.5 / vars);
+  m_precB = trans(m_means / vars);
+  m_logConst = trans(log(ubm.hefts) - 0.5 * (m_dim * std::log(2 * datum::pi) + sum(log(vars), 0) + sum(square(m_means) / vars, 0)));
+
+  return true;
+}
+
+void IVectorExtractor::computeStats(const QVector<fmat> &features, int first, int last)
+{
+  for (int u(first); u < last; u++) {
+
+    if (features[u].n_cols == 0)
+      continue;
+
+    mat X = conv_to<mat>::from(features[u]);
+
+    // posteriors of UBM components
+    mat G = m_precA * square(X) + m_precB * X;
+    G.each_col() += m_logConst;
+    G.each_row() -= max(G, 0);
+    G = exp(G);
+    G.each_row() /= sum(G, 0);
+
+    vec N = sum(G, 1);
+
+    // centered and whitened first-order statistics
+    mat F = X * G.t();
+    F -= m_means.each_row() % N.t();
+    F /= m_sigmas;
+
+    m_N.col(u) = N;
+    m_F.col(u) = conv_to<fvec>::from(vectorise(F));
+  }
+}
+
+void IVectorExtractor::processPartialSums(int n, int first, int last, mat *A, mat *C, mat *W) const
+{
+  int nBlocks = (n + BlockSize - 1) / BlockSize;
+  int nPartials = qMin(MaxPartialSums, nBlocks);
+
+  // segments of each partial sum start on a block boundary
+  for (int p(first); p < last; p++)
+    processBlock(p * nBlocks / nPartials * BlockSize,
+		 qMin(n, (p + 1) * nBlocks / nPartials * BlockSize),
+		 A ? &A[p] : 0,
+		 C ? &C[p] : 0,
+		 W);
+}
+
+void IVectorExtractor::processBlock(int first, int last, mat *A, mat *C, mat *W) const
+{
+  int R(m_rank);
+
+  for (int b(first); b < last; b += BlockSize) {
+
+    int e = qMin(b + BlockSize, last) - 1;
+
+    mat F = conv_to<mat>::from(m_F.cols(b, e));
+    mat N = m_N.cols(b, e);
+    mat TtF = m_T.t() * F;
+
+    // precision matrices of all segments of the block
+    mat L = m_TtT * N;
+    mat M(R * R, N.n_cols);
+    mat Wb(R, N.n_cols);
+
+    for (uword u(0); u < N.n_cols; u++) {
+
+      mat Lu = reshape(L.col(u), R, R);
+      Lu.diag() += 1.0;
+
+      mat LInv;
+      if (!inv_sympd(LInv, symmatu(Lu)))
+	LInv = pinv(Lu);
+
+      vec w = LInv * TtF.col(u);
+      Wb.col(u) = w;
+
+      if (A)
+	M.col(u) = vectorise(LInv + w * w.t());
+    }
+
+    // accumulators of the M-step
+    if (A) {
+      *A += M * N.t();
+      *C += F * Wb.t();
+    }
+
+    if (W)
+      W->cols(b, e) = Wb;
+  }
+}
+
+void IVectorExtractor::runThreads(const QVector<fmat> &features, bool stats, mat *A, mat *C, mat *W)
+{
+  int n(features.size());
+  int nPartials = qMin(MaxPartialSums, (n + BlockSize - 1) / BlockSize);
+  int nThreads = qMax(1, qMin(m_nThreads, nPartials));
+
+  QList<IVectorThread *> threads;
+  QVector<mat> partialA(nPartials);
+  QVector<mat> partialC(nPartials);
+
+  for (int p(0); p < nPartials; p++) {
+
+    if (A)
+      partialA[p].zeros(A->n_rows, A->n_cols);
+
+    if (C)
+      partialC[p].zeros(C->n_rows, C->n_cols);
+  }
+
+  // statistics split by segments, M-step accumulators by partial sums
+  for (int k(0); k < nThreads; k++) {
+
+    int first = stats ? k * n / nThreads : k * nPartials / nThreads;
+    int last = stats ? (k + 1) * n / nThreads : (k + 1) * nPartials / nThreads;
+
+    threads.push_back(new IVectorThread(this, features, stats, A ? partialA.data() : 0, C ? partialC.data() : 0, W, first, last));
+    threads.last()->start();
+  }
+
+  for (int k(0); k < nThreads; k++)
+    threads[k]->wait();
+
+  // partial sums merged in order: same model whatever the number of threads
+  for (int p(0); p < nPartials; p++) {
+
+    if (A)
+      *A += partialA[p];
+
+    if (C)
+      *C += partialC[p];
+  }
+
+  qDeleteAll(threads);
+}
+
+void IVectorExtractor::updateTV(const mat &A, const mat &C)
+{
+  int R(m_rank);
+
+  for (int c(0); c < m_nComponents; c++) {
+
+    mat Ac = reshape(A.col(c), R, R);
+    uword first = c * m_dim;
+    uword last = first + m_dim - 1;
+
+    // T_c = C_c A_c^-1 with A_c symmetric
+    m_T.rows(first, last) = trans(solve(symmatu(Ac), trans(C.rows(first, last))));
+  }
+
+  computeTtT();
+}
+
+void IVectorExtractor::computeTtT()
+{
+  m_TtT.set_size(m_rank * m_rank, m_nComponents);
+
+  for (int c(0); c < m_nComponents; c++) {
+    mat Tc = m_T.rows(c * m_dim, (c + 1) * m_dim - 1);
+    m_TtT.col(c) = vectorise(Tc.t() * Tc);
+  }
+}
+
+void IVectorExtractor::fillEmptySegments(mat &W) const
+{
+  // segments without any frame get a null i-vector, which cannot be
+  // length-normalized: the mean i-vector of other segments is used instead
+  uvec empty = find(sum(m_N, 0) == 0);
+
+  if (empty.n_elem == 0 || empty.n_elem == W.n_cols)
+    return;
+
+  uvec full = find(sum(m_N, 0) > 0);
+  vec mu = mean(W.cols(full), 1);
+
+  for (uword i(0); i < empty.n_elem; i++)
+    W.col(empty(i)) = mu;
+
+  qWarning() << empty.n_elem << "speech segments without any frame: mean i-vector used";
+}
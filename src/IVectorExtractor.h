@@ -0,0 +1,67 @@
+#ifndef IVECTOREXTRACTOR_H
+#define IVECTOREXTRACTOR_H
+
+#include <QObject>
+#include <QVector>
+#include <QAtomicInt>
+
+#include <armadillo>
+
+///////////////////////////////////////////////////////
+// total variability modelling of speech segments: a //
+// diagonal UBM is trained on the features of all    //
+// segments, Baum-Welch statistics are gathered for  //
+// each segment, then the total variability matrix   //
+// is estimated by EM and i-vectors are extracted;   //
+// segments are processed by blocks in parallel      //
+///////////////////////////////////////////////////////
+
+class IVectorExtractor: public QObject
+{
+  Q_OBJECT
+
+ public:
+  IVectorExtractor(int nComponents = 128, int rank = 100, int nIter = 5, int nThreads = -1, QObject *parent = 0);
+
+  arma::mat extract(const QVector<arma::fmat> &features);
+
+ public slots:
+  void cancel();
+
+ signals:
+  void progressRange(int maximum);
+  void progress(int value);
+
+ private:
+  friend class IVectorThread;
+
+  bool trainUbm(const QVector<arma::fmat> &features);
+  void computeStats(const QVector<arma::fmat> &features, int first, int last);
+  void processPartialSums(int n, int first, int last, arma::mat *A, arma::mat *C, arma::mat *W) const;
+  void processBlock(int first, int last, arma::mat *A, arma::mat *C, arma::mat *W) const;
+  void runThreads(const QVector<arma::fmat> &features, bool stats, arma::mat *A, arma::mat *C, arma::mat *W);
+  void updateTV(const arma::mat &A, const arma::mat &C);
+  void computeTtT();
+  void fillEmptySegments(arma::mat &W) const;
+
+  int m_nComponents;
+  int m_rank;
+  int m_nIter;
+  int m_nThreads;
+  int m_dim;
+
+  arma::mat m_means;      // UBM means, one column per component
+  arma::mat m_sigmas;     // UBM standard deviations
+  arma::mat m_precA;      // -0.5 / sigma^2, one row per component
+  arma::mat m_precB;      // mu / sigma^2
+  arma::vec m_logConst;   // log-weight and normalization term
+
+  arma::mat m_N;          // zero-order statistics, one column per segment
+  arma::fmat m_F;         // whitened first-order statistics
+  arma::mat m_T;          // total variability matrix
+  arma::mat m_TtT;        // vectorized T_c' T_c, one column per component
+
+  QAtomicInt m_canceled;
+};
+
+#endif
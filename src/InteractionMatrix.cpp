@@ -0,0 +1,312 @@
+#include <QtMath>
+#include <QStringList>
+#include <QSet>
+
+#include <algorithm>
+
+#include "InteractionMatrix.h"
+
+// ordering of triplets by row, then by column
+class TripletOrder
+{
+ public:
+  TripletOrder(const QVector<int> &rows, const QVector<int> &cols)
+    : m_rows(rows), m_cols(cols) {}
+
+  bool operator()(int i, int j) const
+  {
+    if (m_rows[i] != m_rows[j])
+      return m_rows[i] < m_rows[j];
+
+    return m_cols[i] < m_cols[j];
+  }
+
+ private:
+  const QVector<int> &m_rows;
+  const QVector<int> &m_cols;
+};
+
+/////////////////
+// constructor //
+/////////////////
+
+InteractionMatrix::InteractionMatrix()
+{
+  m_rowPtr.push_back(0);
+}
+
+////////////////////
+// public methods //
+////////////////////
+
+void InteractionMatrix::add(int fSpk, int sSpk, qreal weight)
+{
+  m_cooRows.push_back(fSpk);
+  m_cooCols.push_back(sSpk);
+  m_cooValues.push_back(weight);
+}
+
+void InteractionMatrix::compress(int nSpeakers)
+{
+  int nRows = qMax(nSpeakers, getNRows());
+
+  // entries already compressed come first
+  QVector<int> rows;
+  QVector<int> cols = m_colIdx;
+  QVector<qreal> values = m_values;
+
+  for (int i(0); i < getNRows(); i++)
+    for (int k(m_rowPtr[i]); k < m_rowPtr[i + 1]; k++)
+      rows.push_back(i);
+
+  rows += m_cooRows;
+  cols += m_cooCols;
+  values += m_cooValues;
+
+  for (int k(0); k < m_cooRows.size(); k++)
+    nRows = qMax(nRows, m_cooRows[k] + 1);
+
+  // stable sort: duplicates summed up in insertion order
+  QVector<int> order(rows.size());
+  for (int k(0); k < order.size(); k++)
+    order[k] = k;
+
+  std::stable_sort(order.begin(), order.end(), TripletOrder(rows, cols));
+
+  m_rowPtr.fill(0, nRows + 1);
+  m_colIdx.clear();
+  m_values.clear();
+
+  int k(0);
+
+  while (k < order.size()) {
+
+    int r = rows[order[k]];
+    int c = cols[order[k]];
+    qreal w(0.0);
+
+    while (k < order.size() && rows[order[k]] == r && cols[order[k]] == c)
+      w += values[order[k++]];
+
+    m_colIdx.push_back(c);
+    m_values.push_back(w);
+    m_rowPtr[r + 1]++;
+  }
+
+  for (int i(0); i < nRows; i++)
+    m_rowPtr[i + 1] += m_rowPtr[i];
+
+  m_cooRows.clear();
+  m_cooCols.clear();
+  m_cooValues.clear();
+}
+
+bool InteractionMatrix::isEmpty() const
+{
+  return m_colIdx.isEmpty() && m_cooRows.isEmpty();
+}
+
+int InteractionMatrix::getNRows() const
+{
+  return m_rowPtr.size() - 1;
+}
+
+int InteractionMatrix::getNnz() const
+{
+  return m_colIdx.size();
+}
+
+qreal InteractionMatrix::value(int fSpk, int sSpk) const
+{
+  if (fSpk < 0 || fSpk >= getNRows())
+    return 0.0;
+
+  QVector<int>::const_iterator first = m_colIdx.constBegin() + m_rowPtr[fSpk];
+  QVector<int>::const_iterator last = m_colIdx.constBegin() + m_rowPtr[fSpk + 1];
+  QVector<int>::const_iterator it = std::lower_bound(first, last, sSpk);
+
+  if (it == last || *it != sSpk)
+    return 0.0;
+
+  return m_values[it - m_colIdx.constBegin()];
+}
+
+qreal InteractionMatrix::squaredNorm() const
+{
+  qreal l(0.0);
+
+  for (int k(0); k < m_values.size(); k++)
+    l += qPow(m_values[k], 2);
+
+  return l;
+}
+
+qreal InteractionMatrix::dot(const InteractionMatrix &other) const
+{
+  qreal scalProd(0.0);
+  int nRows = qMin(getNRows(), other.getNRows());
+
+  // entries present in both matrices, rows merged on column index
+  for (int i(0); i < nRows; i++) {
+
+    int k(m_rowPtr[i]);
+    int l(other.m_rowPtr[i]);
+
+    while (k < m_rowPtr[i + 1] && l < other.m_rowPtr[i + 1]) {
+
+      if (m_colIdx[k] < other.m_colIdx[l])
+	k++;
+      else if (m_colIdx[k] > other.m_colIdx[l])
+	l++;
+      else
+	scalProd += other.m_values[l++] * m_values[k++];
+    }
+  }
+
+  return scalProd;
+}
+
+qreal InteractionMatrix::normalizedDist(const InteractionMatrix &other, qreal norm, qreal otherNorm) const
+{
+  if (norm == 0.0 || otherNorm == 0.0)
+    return 0.0;
+
+  // entries shared by both matrices are counted twice
+  qreal dist = squaredDiff(other, norm, otherNorm, 0.0);
+  dist = other.squaredDiff(*this, otherNorm, norm, dist);
+
+  return qSqrt(dist);
+}
+
+const QVector<int> & InteractionMatrix::getRowPtr() const
+{
+  return m_rowPtr;
+}
+
+const QVector<int> & InteractionMatrix::getColIdx() const
+{
+  return m_colIdx;
+}
+
+const QVector<qreal> & InteractionMatrix::getValues() const
+{
+  return m_values;
+}
+
+qint64 InteractionMatrix::pairKey(int fSpk, int sSpk)
+{
+  return (static_cast<qint64>(fSpk) << 32) | static_cast<quint32>(sSpk);
+}
+
+InteractionMatrix InteractionMatrix::fromMap(const QMap<QString, QMap<QString, qreal> > &net, SpeakerDictionary &speakers)
+{
+  InteractionMatrix M;
+
+  QMap<QString, QMap<QString, qreal> >::const_iterator it1 = net.begin();
+
+  while (it1 != net.end()) {
+
+    int fSpk = speakers.intern(it1.key());
+    QMap<QString, qreal>::const_iterator it2 = it1.value().begin();
+
+    while (it2 != it1.value().end()) {
+      M.add(fSpk, speakers.intern(it2.key()), it2.value());
+      it2++;
+    }
+
+    it1++;
+  }
+
+  M.compress(speakers.size());
+
+  return M;
+}
+
+QVector<InteractionMatrix> InteractionMatrix::fromMaps(const QVector<QMap<QString, QMap<QString, qreal> > > &nets, SpeakerDictionary &speakers)
+{
+  QVector<InteractionMatrix> matrices(nets.size());
+
+  // speakers numbered in name order when not already known
+  if (speakers.size() == 0) {
+
+    QSet<QString> names;
+
+    for (int i(0); i < nets.size(); i++) {
+
+      QMap<QString, QMap<QString, qreal> >::const_iterator it1 = nets[i].begin();
+
+      while (it1 != nets[i].end()) {
+
+	names.insert(it1.key());
+
+	QMap<QString, qreal>::const_iterator it2 = it1.value().begin();
+	while (it2 != it1.value().end()) {
+	  names.insert(it2.key());
+	  it2++;
+	}
+
+	it1++;
+      }
+    }
+
+    speakers = SpeakerDictionary(names.toList());
+  }
+
+  for (int i(0); i < nets.size(); i++)
+    matrices[i] = fromMap(nets[i], speakers);
+
+  return matrices;
+}
+
+QMap<QString, QMap<QString, qreal> > InteractionMatrix::toMap(const SpeakerDictionary &speakers) const
+{
+  QMap<QString, QMap<QString, qreal> > net;
+  QVector<int> rowOrder = speakers.getOrder();
+
+  for (int i(0); i < rowOrder.size(); i++) {
+
+    int r = rowOrder[i];
+
+    if (r >= getNRows() || m_rowPtr[r] == m_rowPtr[r + 1])
+      continue;
+
+    // name order matches id order: entries appended at the end
+    QMap<QString, qreal> interlocs;
+
+    if (speakers.isSorted())
+      for (int k(m_rowPtr[r]); k < m_rowPtr[r + 1]; k++)
+	interlocs.insert(interlocs.constEnd(), speakers.getName(m_colIdx[k]), m_values[k]);
+    else
+      for (int k(m_rowPtr[r]); k < m_rowPtr[r + 1]; k++)
+	interlocs.insert(speakers.getName(m_colIdx[k]), m_values[k]);
+
+    net.insert(net.constEnd(), speakers.getName(r), interlocs);
+  }
+
+  return net;
+}
+
+/////////////////////
+// private methods //
+/////////////////////
+
+qreal InteractionMatrix::squaredDiff(const InteractionMatrix &other, qreal norm, qreal otherNorm, qreal dist) const
+{
+  for (int i(0); i < getNRows(); i++) {
+
+    int l = (i < other.getNRows()) ? other.m_rowPtr[i] : 0;
+    int lEnd = (i < other.getNRows()) ? other.m_rowPtr[i + 1] : 0;
+
+    for (int k(m_rowPtr[i]); k < m_rowPtr[i + 1]; k++) {
+
+      while (l < lEnd && other.m_colIdx[l] < m_colIdx[k])
+	l++;
+
+      qreal w = (l < lEnd && other.m_colIdx[l] == m_colIdx[k]) ? other.m_values[l] : 0.0;
+
+      dist += qPow(m_values[k] / norm - w / otherNorm, 2);
+    }
+  }
+
+  return dist;
+}
@@ -0,0 +1,57 @@
+#ifndef INTERACTIONMATRIX_H
+#define INTERACTIONMATRIX_H
+
+#include <QString>
+#include <QVector>
+#include <QMap>
+
+#include "SpeakerDictionary.h"
+
+///////////////////////////////////////////////////////
+// sparse interaction network between speaker ids:   //
+// weights are first gathered as (row, column,       //
+// value) triplets, then compressed into rows sorted //
+// by column, duplicate entries being summed up in   //
+// insertion order                                   //
+///////////////////////////////////////////////////////
+
+class InteractionMatrix
+{
+ public:
+  InteractionMatrix();
+
+  void add(int fSpk, int sSpk, qreal weight);
+  void compress(int nSpeakers = -1);
+
+  bool isEmpty() const;
+  int getNRows() const;
+  int getNnz() const;
+  qreal value(int fSpk, int sSpk) const;
+  qreal squaredNorm() const;
+  qreal dot(const InteractionMatrix &other) const;
+  qreal normalizedDist(const InteractionMatrix &other, qreal norm, qreal otherNorm) const;
+
+  const QVector<int> & getRowPtr() const;
+  const QVector<int> & getColIdx() const;
+  const QVector<qreal> & getValues() const;
+
+  static qint64 pairKey(int fSpk, int sSpk);
+  static InteractionMatrix fromMap(const QMap<QString, QMap<QString, qreal> > &net, SpeakerDictionary &speakers);
+  static QVector<InteractionMatrix> fromMaps(const QVector<QMap<QString, QMap<QString, qreal> > > &nets, SpeakerDictionary &speakers);
+  QMap<QString, QMap<QString, qreal> > toMap(const SpeakerDictionary &speakers) const;
+
+ private:
+  qreal squaredDiff(const InteractionMatrix &other, qreal norm, qreal otherNorm, qreal dist) const;
+
+  // triplets not compressed yet
+  QVector<int> m_cooRows;
+  QVector<int> m_cooCols;
+  QVector<qreal> m_cooValues;
+
+  // compressed rows
+  QVector<int> m_rowPtr;
+  QVector<int> m_colIdx;
+  QVector<qreal> m_values;
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include <QDialog>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QVideoFrame>
 
 #include "MainWindow.h"
@@ -65,6 +66,8 @@ MainWindow::MainWindow(QWidget *parent): QMainWindow(parent)
   connect(m_coClusterAct, SIGNAL(triggered()), this, SLOT(coClustering()));
   connect(m_summAct, SIGNAL(triggered()), this, SLOT(summarization()));
   connect(m_chartAct, SIGNAL(triggered()), this, SLOT(viewNarrChart()));
+  connect(m_batchAct, SIGNAL(triggered()), this, SLOT(batchProcess()));
+  connect(m_heurSolverAct, SIGNAL(triggered(bool)), this, SLOT(heuristicSolver(bool)));
 
   // enabling/disabling actions
   m_proOpen = false;
@@ -203,7 +206,7 @@ bool MainWindow::newProject()
  
 bool MainWindow::openProject()
 {
-  QString fName = QFileDialog::getOpenFileName(this, tr("Open File"), QString(), tr("Project (*.json)"));
+  QString fName = QFileDialog::getOpenFileName(this, tr("Open File"), QString(), tr("Project (*.json *.tvp)"));
   // QString fName = QFileDialog::getOpenFileName(this, tr("Open File"), QString(), tr("Project (*.dat)"));
 
   if (!fName.isEmpty() && m_project->load(fName)) {
@@ -231,9 +234,15 @@ bool MainWindow::saveProject()
     m_project->initShotAnnot(false);
   }
 
+  QString filter;
   QString fName = QFileDialog::getSaveFileName(this, tr("Save File"),
 					       ("./projects/" + m_project->getName()),
-					       tr("Project (*.json)"));
+					       tr("Project (*.json);;Binary project (*.tvp)"),
+					       &filter);
+
+  // binary format selected by extension
+  if (filter.contains("*.tvp") && !fName.endsWith(".tvp"))
+    fName += ".tvp";
 
   // QString fName = QFileDialog::getSaveFileName(this, tr("Save File"),
   // ("./projects/" + m_project->getName()),
@@ -442,6 +451,84 @@ bool MainWindow::extractScenes()
   return false;
 }
 
+bool MainWindow::batchProcess()
+{
+  QStringList stages;
+  stages << tr("Shot extraction") << tr("Shot similarity detection") << tr("Face detection");
+
+  bool ok;
+  QString stage = QInputDialog::getItem(this, tr("Batch processing"), tr("Stage applied to every episode:"), stages, 0, false, &ok);
+
+  if (!ok)
+    return false;
+
+  EpisodeBatchScheduler scheduler;
+  int stageFlag;
+
+  // same parameter dialogs as the single-episode actions
+  if (stage == stages[0]) {
+
+    CompareImageDialog dialog(tr("Shot extraction"), 64, 24, 8, 30, 20, tr("<b>High threshold:</b>"), tr("<b>Low threshold:</b>"), this);
+
+    if (dialog.exec() != QDialog::Accepted)
+      return false;
+
+    scheduler.setShotParams(dialog.getHistoType(),
+			    dialog.getNVBins(),
+			    dialog.getNHBins(),
+			    dialog.getNSBins(),
+			    dialog.getMetrics(),
+			    dialog.getThreshold1(),
+			    dialog.getThreshold2(),
+			    dialog.getNVBlock(),
+			    dialog.getNHBlock());
+    stageFlag = EpisodeBatchScheduler::Shots;
+  }
+  else if (stage == stages[1]) {
+
+    CompareImageDialog dialog(tr("Shot Similarity Detection..."), 64, 24, 8, 40, 30, tr("<b>Max distance:</b>"), tr("<b>Window size:</b>"), this);
+
+    if (dialog.exec() != QDialog::Accepted)
+      return false;
+
+    scheduler.setSimShotParams(dialog.getHistoType(),
+			       dialog.getNVBins(),
+			       dialog.getNHBins(),
+			       dialog.getNSBins(),
+			       dialog.getMetrics(),
+			       dialog.getThreshold1(),
+			       dialog.getThreshold2(),
+			       dialog.getNVBlock(),
+			       dialog.getNHBlock());
+    stageFlag = EpisodeBatchScheduler::SimilarShots;
+  }
+  else {
+
+    FaceDetectDialog dialog(tr("Face Detection"), this);
+
+    if (dialog.exec() != QDialog::Accepted)
+      return false;
+
+    // only the OpenCV detector runs in the batch workers
+    scheduler.setFaceParams(dialog.getMinHeight());
+    stageFlag = EpisodeBatchScheduler::Faces;
+  }
+
+  m_project->batchProcess(scheduler, stageFlag);
+
+  selectShotLevel();
+  m_proModified = true;
+  updateActions();
+
+  return true;
+}
+
+void MainWindow::heuristicSolver(bool checked)
+{
+  // greedy solvers instead of CPLEX for large instances
+  m_project->setSolverMode(checked ? Optimizer::Heuristic : Optimizer::Exact, -1);
+}
+
 bool MainWindow::spkDiar()
 {
   SpkDiarizationDialog::Method method;
@@ -756,7 +843,8 @@ bool MainWindow::summarization()
 				    dialog.getSeasonNb(),
 				    dialog.getSpeaker(),
 				    dialog.getDur(),
-				    dialog.getGranu());
+				    dialog.getGranu(),
+				    dialog.getSelection());
   }
 
   return false;
@@ -857,6 +945,9 @@ void MainWindow::createActions()
   m_faceDetectAct = new QAction(tr("&Face Detection..."), this);
   m_exportShotBoundAct = new QAction(tr("Export shot boundaries..."), this);
   m_summAct = new QAction(tr("Su&mmarization..."), this);
+  m_batchAct = new QAction(tr("&Batch Processing..."), this);
+  m_heurSolverAct = new QAction(tr("&Heuristic solver"), this);
+  m_heurSolverAct->setCheckable(true);
 
   // set icon actions
   m_proOpenProAct->setIcon(style()->standardIcon(QStyle::SP_DialogOpenButton));
@@ -924,8 +1015,10 @@ void MainWindow::createMenus()
   toolsMenu->addAction(m_autSceneAct);
   toolsMenu->addAction(m_faceDetectAct);
   toolsMenu->addAction(m_exportShotBoundAct);
+  toolsMenu->addAction(m_batchAct);
   toolsMenu->addSeparator();
   toolsMenu->addAction(m_summAct);
+  toolsMenu->addAction(m_heurSolverAct);
 }
 
 ///////////////////////////////
@@ -967,6 +1060,8 @@ void MainWindow::updateActions()
   m_manSceneAct->setEnabled(m_proOpen);
   m_summAct->setEnabled(m_proOpen);
   m_chartAct->setEnabled(m_proOpen);
+  m_batchAct->setEnabled(m_proOpen);
+  m_heurSolverAct->setEnabled(m_proOpen);
 }
 
 void MainWindow::selectDefaultLevel()
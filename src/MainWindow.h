@@ -36,6 +36,8 @@ class MainWindow: public QMainWindow
     bool detectSimShots();
     bool extractScenes();
     bool spkDiar();
+    bool batchProcess();
+    void heuristicSolver(bool checked);
     bool spkInteract();
     bool musicTracking();
     bool coClustering();
@@ -113,6 +115,8 @@ class MainWindow: public QMainWindow
   QAction *m_faceDetectAct;
   QAction *m_summAct;
   QAction *m_chartAct;
+  QAction *m_batchAct;
+  QAction *m_heurSolverAct;
 
   QActionGroup *m_granularityGroup;
  
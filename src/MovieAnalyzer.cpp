@@ -5,6 +5,7 @@
 #include <QFileDialog>
 #include <QRegularExpression>
 #include <QElapsedTimer>
+#include <QThread>
 
 #include <qmath.h>
 
@@ -18,12 +19,65 @@
 #include "ProjectModel.h"
 #include "SpkInteractDialog.h"
 #include "UtteranceTree.h"
+#include "HistoCache.h"
+#include "BoundaryFrameExtractor.h"
+#include "EpisodeAnalyzer.h"
+#include "DistanceKernel.h"
 
 using namespace cv;
 using namespace std;
 
+class LsuDiarThread: public QThread
+{
+ public:
+  LsuDiarThread(MovieAnalyzer *analyzer, const arma::mat &X, const arma::mat &CovInv, UtteranceTree::DistType dist, UtteranceTree::AgrCrit agr, UtteranceTree::PartMeth partMeth, bool weight, const QList<SpeechSegment *> &speechSegments, const QList<QList<SpeechSegment *> > &lsuSpeechSegments, QVector<QList<QList<int> > > &partitions, QVector<QPair<qreal, qreal> > &lsuDer, int first, int step)
+    : m_analyzer(analyzer), m_X(X), m_CovInv(CovInv), m_dist(dist), m_agr(agr), m_partMeth(partMeth), m_weight(weight), m_speechSegments(speechSegments), m_lsuSpeechSegments(lsuSpeechSegments), m_partitions(partitions), m_lsuDer(lsuDer), m_first(first), m_step(step) {}
+
+ protected:
+  void run() { m_analyzer->diarizeLsus(m_X, m_CovInv, m_dist, m_agr, m_partMeth, m_weight, m_speechSegments, m_lsuSpeechSegments, m_partitions, m_lsuDer, m_first, m_step); }
+
+ private:
+  MovieAnalyzer *m_analyzer;
+  const arma::mat &m_X;
+  const arma::mat &m_CovInv;
+  UtteranceTree::DistType m_dist;
+  UtteranceTree::AgrCrit m_agr;
+  UtteranceTree::PartMeth m_partMeth;
+  bool m_weight;
+  const QList<SpeechSegment *> &m_speechSegments;
+  const QList<QList<SpeechSegment *> > &m_lsuSpeechSegments;
+  QVector<QList<QList<int> > > &m_partitions;
+  QVector<QPair<qreal, qreal> > &m_lsuDer;
+  int m_first;
+  int m_step;
+};
+
+class DiarSweepThread: public QThread
+{
+ public:
+  DiarSweepThread(MovieAnalyzer *analyzer, MovieAnalyzer::SweepData &data, bool distances, int first, int step)
+    : m_analyzer(analyzer), m_data(data), m_distances(distances), m_first(first), m_step(step) {}
+
+ protected:
+  void run()
+  {
+    if (m_distances)
+      m_analyzer->computeSweepDistances(m_data, m_first, m_step);
+    else
+      m_analyzer->evalSweepConfigs(m_data, m_first, m_step);
+  }
+
+ private:
+  MovieAnalyzer *m_analyzer;
+  MovieAnalyzer::SweepData &m_data;
+  bool m_distances;
+  int m_first;
+  int m_step;
+};
+
 MovieAnalyzer::MovieAnalyzer(QWidget *parent)
-  : QWidget(parent)
+  : QWidget(parent),
+    m_nDiarThreads(-1)
 {
   m_vFrameProcessor = new VideoFrameProcessor;
   m_textProcessor = new TextProcessor;
@@ -52,6 +106,21 @@ QList<SpeechSegment *> MovieAnalyzer::filterSpeechSegments(QList<SpeechSegment *
   return m_audioProcessor->filterSpeechSegments(speechSegments);
 }
 
+void MovieAnalyzer::setInteractive(bool interactive, bool extractOnMismatch)
+{
+  m_audioProcessor->setInteractive(interactive, extractOnMismatch);
+}
+
+void MovieAnalyzer::setSolverMode(Optimizer::SolverMode solverMode, int nThreads)
+{
+  m_optimizer->setSolverMode(solverMode, nThreads);
+}
+
+void MovieAnalyzer::setDiarThreads(int nThreads)
+{
+  m_nDiarThreads = nThreads;
+}
+
 QSize MovieAnalyzer::getResolution(const QString &fName)
 {
   m_cap.release();
@@ -73,9 +142,6 @@ qreal MovieAnalyzer::getFps(const QString &fName)
 
 bool MovieAnalyzer::setShotCorrMatrix(arma::mat &D, const QString &fName, QList<Shot *> shots, int nV, int nH)
 {
-  m_cap.release();
-  m_cap.open(fName.toStdString());
-
   // number of vertical and horizontal blocks
   int nVBlock(nV);
   int nHBlock(nH);
@@ -85,14 +151,17 @@ bool MovieAnalyzer::setShotCorrMatrix(arma::mat &D, const QString &fName, QList<
   int nSBins(8);
   int nVBins(64);
 
+  // histograms possibly computed during shot extraction
+  HistoCache cache;
+  bool cached = cache.open(fName, 2, nVBins, nHBins, nSBins, nVBlock, nHBlock);
+
+  // index of last frame of previous shot
+  int prevIdx(0);
+
   // previous and current shot frame
   Mat prevShotFrame;
   Mat currShotFrame;
 
-  // subimages of current and past frames
-  QVector<Mat> prevBlocks;
-  QVector<Mat> currBlocks;
-
   // local histogram of each frame block
   QVector<Mat> locHisto(nVBlock * nHBlock);
 
@@ -106,6 +175,19 @@ bool MovieAnalyzer::setShotCorrMatrix(arma::mat &D, const QString &fName, QList<
   // doesn't work anymore after updating Ubuntu
   // int frameDur = 1 / m_cap.get(CV_CAP_PROP_FPS) * 1000;
   int frameDur = 1 / 25.0 * 1000;
+
+  // frames around shot boundaries, decoded in a single pass when not cached
+  BoundaryFrameExtractor extractor(2);
+  QVector<Mat> boundFrames;
+
+  if (!cached) {
+    QList<qint64> timestamps;
+    for (int i(1); i < shots.size(); i++)
+      timestamps.push_back(shots[i]->getPosition() - frameDur - 40);
+
+    if (!extractor.open(fName, timestamps))
+      return false;
+  }
   
   // distance between local histograms
   qreal locDistance;
@@ -120,21 +202,26 @@ bool MovieAnalyzer::setShotCorrMatrix(arma::mat &D, const QString &fName, QList<
     // processing previous shot //
     //////////////////////////////
 
-    m_cap.set(CV_CAP_PROP_POS_MSEC, shots[i]->getPosition() - frameDur - 40);
-    m_cap >> prevShotFrame;
-    
-    // retrieving previous shot frame blocks
-    prevBlocks = m_vFrameProcessor->splitImage(prevShotFrame, nVBlock, nHBlock);
+    // histograms of previous shot last frame read from cache
+    if (cached) {
+      prevIdx = cache.frameIndex(shots[i]->getPosition() - frameDur - 40);
+      locHisto = cache.getLocHisto(prevIdx);
+    }
 
-    // resizing local histograms vector if necessary
-    if (prevBlocks.size() != nVBlock * nHBlock)
-      locHisto.resize(prevBlocks.size());
+    else {
 
-    // looping over previous shot frame blocks
-    for (int j(0); j < prevBlocks.size(); j++)
+      // frames around shot boundary not found
+      if (!extractor.next(boundFrames))
+	return false;
 
-      // compute V/HS/HSV histogram for each block of previous shot last frame
-      locHisto[j] = m_vFrameProcessor->genHsvHisto(prevBlocks[j], nHBins, nSBins, nVBins);
+      m_vFrameProcessor->prepareFrame(boundFrames[0], prevShotFrame, 0);
+      m_vFrameProcessor->prepareFrame(boundFrames[1], currShotFrame, 0);
+    
+      // compute HSV histograms of all blocks of previous shot last frame
+      Mat prevHistos;
+      locHisto.clear();
+      m_vFrameProcessor->genBlockHistos(prevShotFrame, 2, nHBins, nSBins, nVBins, nVBlock, nHBlock, prevHistos, locHisto);
+    }
     
     // saving list of corresponding histograms
     locHistoBuffer.push_front(locHisto);
@@ -143,22 +230,20 @@ bool MovieAnalyzer::setShotCorrMatrix(arma::mat &D, const QString &fName, QList<
     // processing current shot //
     /////////////////////////////
 
-    m_cap >> currShotFrame;
-
-    // retrieving current shot frame blocks
-    currBlocks = m_vFrameProcessor->splitImage(currShotFrame, nVBlock, nHBlock);
-
-    // resizing local histograms vector if necessary
-    if (currBlocks.size() != nVBlock * nHBlock) {
-      locHisto.resize(currBlocks.size());
-      distance.resize(currBlocks.size());
+    // histograms of current shot first frame read from cache
+    if (cached) {
+      locHisto = cache.getLocHisto(qMin(prevIdx + 1, cache.getFrameCount() - 1));
+      distance.resize(locHisto.size());
     }
 
-    // looping over current shot frame blocks
-    for (int j(0); j < currBlocks.size(); j++)
+    else {
 
-      // compute  V/HS/HSV histogram for each block of current shot last frame
-      locHisto[j] = m_vFrameProcessor->genHsvHisto(currBlocks[j], nHBins, nSBins, nVBins);
+      // compute HSV histograms of all blocks of current shot first frame
+      Mat currHistos;
+      locHisto.clear();
+      m_vFrameProcessor->genBlockHistos(currShotFrame, 2, nHBins, nSBins, nVBins, nVBlock, nHBlock, currHistos, locHisto);
+      distance.resize(locHisto.size());
+    }
 
     for (int j(0); j < locHistoBuffer.size(); j++) {
       
@@ -181,468 +266,92 @@ bool MovieAnalyzer::setShotCorrMatrix(arma::mat &D, const QString &fName, QList<
   return true;
 }
 
-bool MovieAnalyzer::extractShots(const QString &fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal threshold1, qreal threshold2, int nVBlock, int nHBlock, bool viewProgress)
+bool MovieAnalyzer::extractShots(const QString &fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal threshold1, qreal threshold2, int nVBlock, int nHBlock, bool viewProgress, int analysisHeight)
 {
-  m_cap.release();
-  m_cap.open(fName.toStdString());
+  EpisodeAnalyzer analyzer;
 
-  // current frame
-  Mat frame;
-
-  // subimages of current frame
-  QVector<Mat> blocks(nVBlock * nHBlock);
-
-  // corresponding local histograms
-  QVector<Mat> locHisto(nVBlock * nHBlock);
+  connect(&analyzer, SIGNAL(insertShot(qint64, qint64)), this, SIGNAL(insertShot(qint64, qint64)));
 
-  // distances between current and previous local histograms
-  QVector<qreal> distance(nVBlock * nHBlock);
-
-  // distance between current and past frame
-  qreal dist;
-
-  // frames considered to detect cut
-  QList<qreal> window;
-
-  // current frame position and index
-  qint64 position(0);
-  int n(0);
-
-  // shot beginning
-  qint64 shotStart(0);
-
-  // previous frame position
-  qint64 prevPosition(0);
-
-  // indicates that no more frame is available in video capture
-  bool open(true);
-
-  // normalized local copies of thresholds
-  qreal thresh1(threshold1 / 100.0);
-  qreal thresh2(threshold2 / 100.0);
-
-  // activate appropriate metrics
-  switch (metrics) {
-  case 4:
-    m_vFrameProcessor->activL1();
-    break;
-  case 5:
-    m_vFrameProcessor->activL2();
-    break;
-  case CV_COMP_CORREL:
-    m_vFrameProcessor->activCorrel();
-    break;
-  case CV_COMP_CHISQR:
-    m_vFrameProcessor->activChiSqr();
-    break;
-  case CV_COMP_INTERSECT:
-    m_vFrameProcessor->activIntersect();
-    break;
-  case CV_COMP_HELLINGER:
-    m_vFrameProcessor->activHellinger();
-    break;
-  }
-  
   // progress bar
-  QProgressDialog progress(tr("Extracting shots..."), tr("Cancel"), 0, m_cap.get(CV_CAP_PROP_FRAME_COUNT), this);
+  QProgressDialog progress(tr("Extracting shots..."), tr("Cancel"), 0, 0, this);
+
   if (viewProgress) {
     progress.setWindowModality(Qt::WindowModal);
+    connect(&analyzer, SIGNAL(progressRange(int)), &progress, SLOT(setMaximum(int)));
+    connect(&analyzer, SIGNAL(progress(int)), &progress, SLOT(setValue(int)));
+    connect(&progress, SIGNAL(canceled()), &analyzer, SLOT(cancel()));
   }
 
-  // beginning of first shot
-  shotStart = m_cap.get(CV_CAP_PROP_POS_MSEC);
-  
-  while (open) {
-
-    // retrieve index and position of next frame
-    n = m_cap.get(CV_CAP_PROP_POS_FRAMES);
-    position = m_cap.get(CV_CAP_PROP_POS_MSEC) + 40;
-    
-    open = m_cap.read(frame);
-
-    // convert to HSV
-    cvtColor(frame, frame, CV_BGR2HSV);
-    
-    if (open) {
-
-      // retrieving previous shot frame blocks
-      blocks = m_vFrameProcessor->splitImage(frame, nVBlock, nHBlock);
-
-      // looping over frame blocks
-      for (int i(0); i < blocks.size(); i++) {
-
-	// compute  V/HS/HSV histogram for each frame block
-	switch (histoType) {
-	case 0:
-	  locHisto[i] = m_vFrameProcessor->genVHisto(blocks[i], nVBins);
-	  break;
-	case 1:
-	  locHisto[i] = m_vFrameProcessor->genHsHisto(blocks[i], nHBins, nSBins);
-	  break;
-	case 2:
-	  locHisto[i] = m_vFrameProcessor->genHsvHisto(blocks[i], nHBins, nSBins, nVBins);
-	  break;
-	}
-
-	// compute distance from previous frame for each block
-	if (!m_prevLocHisto.isEmpty())
-	  distance[i] = m_vFrameProcessor->distanceFromPrev(locHisto[i], m_prevLocHisto[i]);
-      }
-     
-      dist = meanDistance(distance);
-      
-      /*** for displaying purpose ***/
-      /*
-      qDebug();
-      for (int i(0); i < nHBlock; i++) {
-	for (int j(0); j < nVBlock; j++) {
-	  printf("%4.4f\t", 1 - distance[i * nVBlock + j]);
-	}
-	cout << endl;
-      }
-
-      qDebug();
-      qDebug() << (1 - dist);
-      */
-
-      // append current distance to the window
-      window.push_back(dist);
-
-      if (window.size() > 3)
-	window.pop_front();
-
-      // insert shot at current position
-      if (window[0] <= thresh2 && window[1] >= thresh1 && window[2] <= thresh2) {
-	emit insertShot(shotStart, prevPosition);
-	shotStart = prevPosition;
-      }
-
-      // updating previous local histograms to current ones
-      m_prevLocHisto.resize(blocks.size());
-      m_prevLocHisto = locHisto;
-
-      // updating previous position to current
-      prevPosition = position;
-    }
-
-    // update progress bar
-    if (viewProgress) {
-      progress.setValue(n);
-      if (progress.wasCanceled())
-	return false;
-    }
-  }
-
-  emit insertShot(shotStart, position);
-
-  return true;
+  return analyzer.extractShots(fName, histoType, nVBins, nHBins, nSBins, metrics, threshold1, threshold2, nVBlock, nHBlock, analysisHeight);
 }
 
-bool MovieAnalyzer::labelSimilarShots(QString fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal maxDist, int windowSize, QList<Shot *> shots, int nVBlock, int nHBlock, bool viewProgress)
+bool MovieAnalyzer::labelSimilarShots(QString fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal maxDist, int windowSize, QList<Shot *> shots, int nVBlock, int nHBlock, bool viewProgress, int analysisHeight)
 {
-  m_cap.release();
-  m_cap.open(fName.toStdString());
-
-  // number of shots
-  int n(shots.size());
-
-  // previous and current shot frame
-  Mat prevShotFrame;
-  Mat currShotFrame;
-
-  // subimages of current and past frames
-  QVector<Mat> prevBlocks;
-  QVector<Mat> currBlocks;
-
-  // local histogram of each frame block
-  QVector<Mat> locHisto(nVBlock * nHBlock);
-
-  // accumulator of previous lists of local histograms
-  QList<QVector<Mat> > locHistoBuffer;
-
-  // distance between first frame of current shot and last frame of past shot
-  QVector<qreal> distance(nVBlock * nHBlock);
-
-  /*** for displaying purpose ***/
-  QList<Mat> frameBuffer;
+  EpisodeAnalyzer analyzer;
+  QList<qint64> shotPositions;
+  QVector<int> shotCamera;
 
-  // frame duration
-  // doesn't work anymore after updating Ubuntu
-  // int frameDur = 1 / m_cap.get(CV_CAP_PROP_FPS) * 1000;
-  int frameDur = 1 / 25.0 * 1000;
-  
-  // distance between local histograms
-  qreal locDistance;
-  // minimum distance from current frame observed so far
-  qreal minDistance;
-  // corresponding index
-  int jMin;
-
-  // current camera label
-  int nCamera(0);
-  
-  // camera label for each shot
-  QVector<int> shotCamera(n);
-
-  // activate appropriate metrics
-  switch (metrics) {
-  case 4:
-    m_vFrameProcessor->activL1();
-    break;
-  case 5:
-    m_vFrameProcessor->activL2();
-    break;
-  case CV_COMP_CORREL:
-    m_vFrameProcessor->activCorrel();
-    break;
-  case CV_COMP_CHISQR:
-    m_vFrameProcessor->activChiSqr();
-    break;
-  case CV_COMP_INTERSECT:
-    m_vFrameProcessor->activIntersect();
-    break;
-  case CV_COMP_HELLINGER:
-    m_vFrameProcessor->activHellinger();
-    break;
-  }
+  for (int i(0); i < shots.size(); i++)
+    shotPositions.push_back(shots[i]->getPosition());
 
   // progress bar
-  QProgressDialog progress(tr("Retrieving similar shots..."), tr("Cancel"), 0, n, this);
-  int count(0);
+  QProgressDialog progress(tr("Retrieving similar shots..."), tr("Cancel"), 0, 0, this);
 
-  if (viewProgress)
+  if (viewProgress) {
     progress.setWindowModality(Qt::WindowModal);
+    connect(&analyzer, SIGNAL(progressRange(int)), &progress, SLOT(setMaximum(int)));
+    connect(&analyzer, SIGNAL(progress(int)), &progress, SLOT(setValue(int)));
+    connect(&progress, SIGNAL(canceled()), &analyzer, SLOT(cancel()));
+  }
 
-  // normalizing max distance required to link two shots
-  maxDist /= 100.0;
-
-  // looping over shot positions
-  shotCamera[0] = nCamera;
-  shots[0]->setCamera(shotCamera[0], Segment::Automatic);
-
-  for (int i(1); i < n; i++) {
-    
-    /****************************/
-    /* processing previous shot */
-    /****************************/
-
-    m_cap.set(CV_CAP_PROP_POS_MSEC, shots[i]->getPosition() - frameDur - 40);
-    m_cap >> prevShotFrame;
-    
-    // retrieving previous shot frame blocks
-    prevBlocks = m_vFrameProcessor->splitImage(prevShotFrame, nVBlock, nHBlock);
-
-    // resizing local histograms vector if necessary
-    if (prevBlocks.size() != nVBlock * nHBlock)
-      locHisto.resize(prevBlocks.size());
-
-    // looping over previous shot frame blocks
-    for (int j(0); j < prevBlocks.size(); j++)
-
-      // compute  V/HS/HSV histogram for each block of previous shot last frame
-      switch (histoType) {
-      case 0:
-	locHisto[j] = m_vFrameProcessor->genVHisto(prevBlocks[j], nVBins);
-	break;
-      case 1:
-	locHisto[j] = m_vFrameProcessor->genHsHisto(prevBlocks[j], nHBins, nSBins);
-	break;
-      case 2:
-	locHisto[j] = m_vFrameProcessor->genHsvHisto(prevBlocks[j], nHBins, nSBins, nVBins);
-       break;
-      }
-
-    /*** for displaying purpose ***/
-    /* Mat frameCopy;
-    prevShotFrame.copyTo(frameCopy);
-    frameBuffer.push_front(frameCopy);
-    if (frameBuffer.size() == windowSize + 1)
-    frameBuffer.pop_back(); */
-
-    // saving list of corresponding histograms
-    locHistoBuffer.push_front(locHisto);
-
-    // update buffer boundaries
-    if (locHistoBuffer.size() == windowSize + 1)
-      locHistoBuffer.pop_back();
-    
-    /***************************/
-    /* processing current shot */
-    /***************************/
-
-    m_cap >> currShotFrame;
-
-    /*** for displaying purpose ***/
-    // imshow("present", currShotFrame);
-
-    // retrieving current shot frame blocks
-    currBlocks = m_vFrameProcessor->splitImage(currShotFrame, nVBlock, nHBlock);
-
-    // resizing local histograms vector if necessary
-    if (currBlocks.size() != nVBlock * nHBlock) {
-      locHisto.resize(currBlocks.size());
-      distance.resize(currBlocks.size());
-    }
-
-    // looping over current shot frame blocks
-    for (int j(0); j < currBlocks.size(); j++)
-
-      // compute  V/HS/HSV histogram for each block of current shot last frame
-      switch (histoType) {
-      case 0:
-	locHisto[j] = m_vFrameProcessor->genVHisto(currBlocks[j], nVBins);
-	break;
-      case 1:
-	locHisto[j] = m_vFrameProcessor->genHsHisto(currBlocks[j], nHBins, nSBins);
-	break;
-      case 2:
-	locHisto[j] = m_vFrameProcessor->genHsvHisto(currBlocks[j], nHBins, nSBins, nVBins);
-       break;
-      }
-
-    // compute distance between current and past frame local histograms
-    minDistance = 1.0;
-    jMin = 0;
-
-    for (int j(0); j < locHistoBuffer.size(); j++) {
-      
-      // retrieving past list of local histograms
-      QVector<Mat> prevLocHisto = locHistoBuffer[j];
-
-      // looping over list of local histograms and computing local distances
-      for (int k(0); k < prevLocHisto.size(); k++)
-	distance[k] = m_vFrameProcessor->distanceFromPrev(locHisto[k], prevLocHisto[k]);
-
-      // averaging local distances
-      locDistance = meanDistance(distance);
-
-      /*** for displaying purpose ***/
-      /* qDebug();
-      
-      for (int k(0); k < nHBlock; k++) {
-	for (int l(0); l < nVBlock; l++) {
-	  printf("%4.4f\t", 1 - distance[k * nVBlock + l]);
-	}
-	cout << endl;
-      }
-
-      qDebug();
-      qDebug() << (1 - locDistance);
-      imshow("past", frameBuffer[j]);
-      waitKey(0); */
-      
-      if (locDistance < minDistance) {
-	minDistance = locDistance;
-	jMin = j;
-      }
-    }
+  bool done = analyzer.labelSimilarShots(fName, histoType, nVBins, nHBins, nSBins, metrics, maxDist, windowSize, shotPositions, nVBlock, nHBlock, shotCamera, analysisHeight);
 
-    // similar shot retrieved among previous shots
-    if (minDistance <= maxDist) {
-      int iSim = i - (jMin + 1);
-      shotCamera[i] = shotCamera[iSim];
+  // shots labelled before cancelation keep their label
+  for (int i(0); i < shotCamera.size(); i++)
+    if (shotCamera[i] != -1)
       shots[i]->setCamera(shotCamera[i], Segment::Automatic);
-    }
 
-    // no similar shot retrieved: new camera label
-    else {
-      shotCamera[i] = nCamera++;
-      shots[i]->setCamera(shotCamera[i], Segment::Automatic);
-    }
-
-    // updating progress bar
-    if (viewProgress) {
-      progress.setValue(++count);
-      if (progress.wasCanceled())
-	return false;
-    }
-  }
-      
-  return true;
+  return done;
 }
 
 bool MovieAnalyzer::faceDetectionOpenCV(QList<Shot *> shots, const QString &fName, int minHeight)
 {
-  m_cap.release();
-  m_cap.open(fName.toStdString());
+  EpisodeAnalyzer analyzer;
+  QList<qint64> shotPositions;
 
-  // current frame
-  Mat frame;
+  for (int i(0); i < shots.size(); i++)
+    shotPositions.push_back(shots[i]->getPosition());
 
-  // frame height
-  int absMinHeight;
+  connect(&analyzer, SIGNAL(setCurrShot(qint64)), this, SIGNAL(setCurrShot(qint64)));
+  connect(&analyzer, SIGNAL(appendFaces(qint64, const QList<QRect> &)), this, SIGNAL(appendFaces(qint64, const QList<QRect> &)));
 
-  // current frame position and index
-  qint64 position(0);
-
-  // indicates that no more frame is available in video capture
-  bool open(true);
-  
   // progress bar
-  QProgressDialog progress(tr("Detecting faces..."), tr("Cancel"), 0, shots.size(), this);
+  QProgressDialog progress(tr("Detecting faces..."), tr("Cancel"), 0, 0, this);
   progress.setWindowModality(Qt::WindowModal);
-  
-  // initializing cascade classifier (needed by OpenCV face detector)
-  QString faceCascadeName = "faceDetection/model/haarcascade_frontalface_alt.xml";
-  CascadeClassifier faceCascade;
 
-  if (!faceCascade.load(faceCascadeName.toStdString()))
-    return false;
-  
-  // looping over shots
-  for (int i(0); i < shots.size(); i++) {
-    
-    // set video capture at shot beginning
-    position = shots[i]->getPosition();
-    m_cap.set(CV_CAP_PROP_POS_MSEC, position);
-
-    open = m_cap.read(frame);
-
-    // frame found
-    if (open) {
-    
-      absMinHeight = static_cast<int>(frame.rows * minHeight / 100.0);
-      QList<QRect> frameFaces;
-      
-      frameFaces = detectFacesOpenCV(faceCascade, frame, absMinHeight);
+  connect(&analyzer, SIGNAL(progressRange(int)), &progress, SLOT(setMaximum(int)));
+  connect(&analyzer, SIGNAL(progress(int)), &progress, SLOT(setValue(int)));
+  connect(&progress, SIGNAL(canceled()), &analyzer, SLOT(cancel()));
 
-      if (frameFaces.size() > 0) {
-	emit setCurrShot(position);
-	emit appendFaces(position, frameFaces);
-      }
-    }
-    
-    // update progress bar
-    progress.setValue(i);
-    if (progress.wasCanceled())
-      return false;
-  }
-  
-  return true;
+  return analyzer.faceDetectionOpenCV(fName, shotPositions, minHeight);
 }
 
-QList<QRect> MovieAnalyzer::detectFacesOpenCV(cv::CascadeClassifier &faceCascade, cv::Mat &frame, int minHeight)
+void MovieAnalyzer::faceDetectionZhu(QList<Shot *> shots, const QString &fName, int minHeight)
 {
-  QList<QRect> faces;
-  std::vector<Rect> facesRect;
-  Mat frameGray;
+  // number of shots to process
+  // int nShots(shots.size());
+  int nShots(qMin(21, shots.size()));
 
-  cvtColor(frame, frameGray, COLOR_BGR2GRAY);
-  equalizeHist(frameGray, frameGray);
-  
-  // detecting faces
-  faceCascade.detectMultiScale(frameGray, facesRect, 1.1, 2, 0 | CASCADE_SCALE_IMAGE, Size(minHeight, minHeight));
+  // first frame of each shot, decoded in a single pass
+  BoundaryFrameExtractor extractor;
+  QVector<Mat> boundFrames;
+  QList<qint64> timestamps;
 
-  for (size_t i = 0; i < facesRect.size(); i++ )
-    faces.push_back(QRect(facesRect[i].x, facesRect[i].y, facesRect[i].width, facesRect[i].height));
-
-  return faces;
-}
+  for (int i(0); i < nShots; i++)
+    timestamps.push_back(shots[i]->getPosition());
 
-void MovieAnalyzer::faceDetectionZhu(QList<Shot *> shots, const QString &fName, int minHeight)
-{
-  m_cap.release();
-  m_cap.open(fName.toStdString());
+  if (!extractor.open(fName, timestamps))
+    return;
 
   // current frame
   Mat frame;
@@ -662,7 +371,7 @@ void MovieAnalyzer::faceDetectionZhu(QList<Shot *> shots, const QString &fName,
   ////////////////////////
   
   // computing and writing out scaling factor
-  qreal scaleFac = 80.0 / (minHeight * m_cap.get(CV_CAP_PROP_FRAME_HEIGHT) / 100.0);
+  qreal scaleFac = 80.0 / (minHeight * extractor.getFrameHeight() / 100.0);
   QFile scaleFile("faceDetection/tmp/scaleFactor.csv");
 
   if (!scaleFile.open(QIODevice::WriteOnly | QIODevice::Text))
@@ -672,14 +381,12 @@ void MovieAnalyzer::faceDetectionZhu(QList<Shot *> shots, const QString &fName,
   scaleOut << scaleFac << endl;
 
   // looping over shots
-  // for (int i(0); i < shots.size(); i++) {
-  for (int i(0); i < 21; i++) {
+  for (int i(0); i < nShots; i++) {
     
-    // set video capture at shot beginning
+    // retrieve frame at shot beginning
     position = shots[i]->getPosition();
-    m_cap.set(CV_CAP_PROP_POS_MSEC, position);
-
-    open = m_cap.read(frame);
+    open = extractor.next(boundFrames);
+    frame = boundFrames[0];
 
     // frame found
     if (open) {
@@ -733,39 +440,143 @@ void MovieAnalyzer::musicRateRetrieved(QPair<qint64, qreal> musicRate)
   emit insertMusicRate(musicRate);
 }
 
-bool MovieAnalyzer::localSpkDiarHC(UtteranceTree::DistType dist, bool norm, UtteranceTree::AgrCrit agr, UtteranceTree::PartMeth partMeth, bool weight, bool sigma, QList<SpeechSegment *> speechSegments, QList<QList<SpeechSegment *> > lsuSpeechSegments)
-{
-  arma::mat X;
-  arma::mat Sigma;
-  arma::mat W;
-  arma::mat CovInv;
+bool MovieAnalyzer::localSpkDiarHC(UtteranceTree::DistType dist, bool norm, UtteranceTree::AgrCrit agr, UtteranceTree::PartMeth partMeth, bool weight, bool sigma, QList<SpeechSegment *> speechSegments, QList<QList<SpeechSegment *> > lsuSpeechSegments)
+{
+  arma::mat X;
+  arma::mat Sigma;
+  arma::mat W;
+  arma::mat CovInv;
+
+  m_audioProcessor->extractIVectors(speechSegments);
+  X = m_audioProcessor->getEpisodeIVectors(speechSegments);
+  Sigma = m_audioProcessor->genSigmaMat();
+  W = m_audioProcessor->genWMat();
+
+  int nLsus(lsuSpeechSegments.size());
+  QVector<QList<QList<int> > > partitions(nLsus); // partition of each pattern
+  QVector<QPair<qreal, qreal> > lsuDer(nLsus);     // DER of each pattern
+  QList<QPair<qreal, qreal> > localDer;           // DER for each pattern
+
+  // setting covariance matrix
+  if (sigma)
+    CovInv = pinv(Sigma);
+  else
+    CovInv = pinv(W);
+
+  // normalize utterance vectors if necessary
+  if (norm)
+    normalize(X, CovInv, dist);
+
+  // patterns processed in parallel, each thread with its own tree
+  int nThreads = (m_nDiarThreads <= 0) ? QThread::idealThreadCount() : m_nDiarThreads;
+  nThreads = qMax(1, qMin(nThreads, nLsus));
+
+  QList<LsuDiarThread *> threads;
+
+  for (int k(0); k < nThreads; k++) {
+    threads.push_back(new LsuDiarThread(this, X, CovInv, dist, agr, partMeth, weight, speechSegments, lsuSpeechSegments, partitions, lsuDer, k, nThreads));
+    threads.last()->start();
+  }
+
+  for (int k(0); k < nThreads; k++)
+    threads[k]->wait();
+
+  qDeleteAll(threads);
+
+  // patterns merged in order: same labels and DER as with a single thread
+  for (int i(0); i < nLsus; i++)
+    if (lsuSpeechSegments[i].size() > 1) {
+      setHypSpeakers(partitions[i], speechSegments, "LSU" + QString::number(i));
+      localDer.push_back(lsuDer[i]);
+    }
+
+  // retrieving single-show Diarization Error Rate
+  m_localDer = QString::number((retrieveSSDer(localDer)), 'g', 4);
+  qDebug() << "Single-show DER:" << m_localDer << "%";
+
+  return true;
+}
+
+int MovieAnalyzer::sweepDistIdx(const DiarConfig &config)
+{
+  // L2 distance independent of covariance matrix
+  if (config.dist == UtteranceTree::L2)
+    return config.norm ? 1 : 0;
+
+  return 2 + (config.norm ? 2 : 0) + (config.sigma ? 1 : 0);
+}
+
+void MovieAnalyzer::computeSweepDistances(SweepData &data, int first, int step)
+{
+  for (int i(first); i < data.lsuIdx.size(); i += step) {
+
+    const arma::uvec &V = data.lsuIdx.at(i);
+
+    if (V.n_elem > 1)
+      for (int k(0); k < data.D.size(); k++)
+	if (data.used.at(k)) {
+
+	  // several threads already running: single-threaded kernel
+	  arma::mat D = DistanceKernel::distMat(data.X.at(k).rows(V), data.CovInv.at(k), data.dist.at(k), 1);
+	  D.diag().fill(arma::datum::inf);
+
+	  data.D[k][i] = D;
+	}
+  }
+}
+
+void MovieAnalyzer::evalSweepConfigs(SweepData &data, int first, int step)
+{
+  UtteranceTree tree;
+
+  for (int c(first); c < data.configs.size(); c += step) {
+
+    const DiarConfig &config = data.configs.at(c);
+    int k = sweepDistIdx(config);
+    QList<QPair<qreal, qreal> > localDer;
+
+    tree.setDist(config.dist);
+    tree.setAgr(config.agr);
+    tree.setPartMeth(config.partMeth);
+
+    for (int i(0); i < data.lsuIdx.size(); i++) {
+
+      const arma::uvec &V = data.lsuIdx.at(i);
+
+      if (V.n_elem > 1) {
+
+	// tree built from cached distances
+	tree.setTree(data.D.at(k).at(i), data.W.at(config.weight ? 1 : 0).at(i));
+
+	QList<QList<int> > partition(tree.getPartition());
+
+	for (int l(0); l < partition.size(); l++)
+	  for (int j(0); j < partition[l].size(); j++)
+	    partition[l][j] = V(partition[l][j]);
+
+	// speaker labels left unchanged
+	localDer.push_back(computeSpkError(partition, data.speechSegments, "LSU" + QString::number(i), false));
+      }
+    }
 
-  m_audioProcessor->extractIVectors(speechSegments);
-  X = m_audioProcessor->getEpisodeIVectors(speechSegments);
-  Sigma = m_audioProcessor->genSigmaMat();
-  W = m_audioProcessor->genWMat();
+    data.localDer[c] = localDer;
+  }
+}
 
-  UtteranceTree tree;                   // dendogram corresponding to local clustering  
-  QString pattLabel;                    // pattern label
-  QList<QPair<qreal, qreal> > localDer; // DER for each pattern
+void MovieAnalyzer::diarizeLsus(const arma::mat &X, const arma::mat &CovInv, UtteranceTree::DistType dist, UtteranceTree::AgrCrit agr, UtteranceTree::PartMeth partMeth, bool weight, const QList<SpeechSegment *> &speechSegments, const QList<QList<SpeechSegment *> > &lsuSpeechSegments, QVector<QList<QList<int> > > &partitions, QVector<QPair<qreal, qreal> > &lsuDer, int first, int step)
+{
+  UtteranceTree tree;                   // dendogram corresponding to local clustering
 
   // parameterizing tree
   tree.setDist(dist);
   tree.setAgr(agr);
   tree.setPartMeth(partMeth);
 
-  // setting covariance matrix
-  if (sigma)
-    CovInv = pinv(Sigma);
-  else
-    CovInv = pinv(W);
+  // patterns already spread over threads
+  tree.setDistThreads(1);
 
-  // normalize utterance vectors if necessary
-  if (norm)
-    normalize(X, CovInv, dist);
-  
-  // looping over shot patterns for labelling purpose
-  for (int i(0); i < lsuSpeechSegments.size(); i++) {
+  // one pattern out of step: sizes of consecutive patterns often alike
+  for (int i(first); i < lsuSpeechSegments.size(); i += step) {
 
     // number of instances
     int m = lsuSpeechSegments[i].size();
@@ -802,24 +613,149 @@ bool MovieAnalyzer::localSpkDiarHC(UtteranceTree::DistType dist, bool norm, Utte
       // retrieving optimal partition
       QList<QList<int> > partition(tree.getPartition());
 
-      for (int i(0); i < partition.size(); i++)
-	for (int j(0); j < partition[i].size(); j++)
-	  partition[i][j] = V(0, partition[i][j]);
+      for (int k(0); k < partition.size(); k++)
+	for (int j(0); j < partition[k].size(); j++)
+	  partition[k][j] = V(0, partition[k][j]);
+
+      // labels are set afterwards, while merging patterns
+      QString pattLabel = "LSU" + QString::number(i);
+      lsuDer[i] = computeSpkError(partition, speechSegments, pattLabel, false);
+      partitions[i] = partition;
+    }
+  }
+}
+
+bool MovieAnalyzer::localSpkDiarSweep(const QList<DiarConfig> &configs, QList<SpeechSegment *> speechSegments, QList<QList<SpeechSegment *> > lsuSpeechSegments, QVector<QList<QPair<qreal, qreal> > > &localDer)
+{
+  SweepData data;
+  int nLsus(lsuSpeechSegments.size());
+  int nDist(6);
+
+  // i-vectors and inverse covariance matrices computed once for all
+  // configurations
+  m_audioProcessor->extractIVectors(speechSegments);
+  arma::mat X = m_audioProcessor->getEpisodeIVectors(speechSegments);
+  arma::mat WInv = pinv(m_audioProcessor->genWMat());
+  arma::mat SigmaInv = pinv(m_audioProcessor->genSigmaMat());
+
+  data.configs = configs;
+  data.speechSegments = speechSegments;
+  data.localDer.resize(configs.size());
+
+  // distances: L2 with and without normalization, Mahalanobis
+  // with and without normalization, based on W or Sigma matrix
+  data.X.resize(nDist);
+  data.CovInv.resize(nDist);
+  data.dist.resize(nDist);
+  data.used.fill(false, nDist);
+  data.D.resize(nDist);
+
+  for (int c(0); c < configs.size(); c++)
+    data.used[sweepDistIdx(configs[c])] = true;
+
+  for (int k(0); k < nDist; k++) {
+
+    bool norm = (k < 2) ? (k == 1) : ((k - 2) / 2 == 1);
+    bool sigma = (k >= 2 && (k - 2) % 2 == 1);
+
+    data.dist[k] = (k < 2) ? UtteranceTree::L2 : UtteranceTree::Mahal;
+    data.CovInv[k] = sigma ? SigmaInv : WInv;
+
+    if (data.used[k]) {
 
-      pattLabel = "LSU" + QString::number(i);
+      data.X[k] = X;
 
-      QPair<qreal, qreal> res(computeSpkError(partition, speechSegments, pattLabel));
-      localDer.push_back(res);
+      if (norm)
+	normalize(data.X[k], data.CovInv[k], data.dist[k]);
+
+      data.D[k].resize(nLsus);
     }
   }
 
-  // retrieving single-show Diarization Error Rate
-  m_localDer = QString::number((retrieveSSDer(localDer)), 'g', 4);
-  qDebug() << "Single-show DER:" << m_localDer << "%";
+  // utterances of each LSU and their weights
+  data.lsuIdx.resize(nLsus);
+  data.W.resize(2);
+  data.W[0].resize(nLsus);
+  data.W[1].resize(nLsus);
+
+  for (int i(0); i < nLsus; i++) {
+
+    int m = lsuSpeechSegments[i].size();
+
+    if (m > 1) {
+
+      arma::uvec V(m);
+      arma::mat W(1, m);
+
+      for (int j(0); j < m; j++) {
+	V(j) = speechSegments.indexOf(lsuSpeechSegments[i][j]);
+	W(0, j) = (lsuSpeechSegments[i][j]->getEnd() - lsuSpeechSegments[i][j]->getPosition()) / 1000.0;
+      }
+
+      data.lsuIdx[i] = V;
+      data.W[0][i] = arma::mat(1, m, arma::fill::ones) / m;
+      data.W[1][i] = W / arma::accu(W);
+    }
+  }
+
+  // distance matrices of the LSUs first, then configurations, both
+  // processed in parallel
+  int nThreads = (m_nDiarThreads <= 0) ? QThread::idealThreadCount() : m_nDiarThreads;
+
+  for (int phase(0); phase < 2; phase++) {
+
+    int nTasks = (phase == 0) ? nLsus : configs.size();
+    int nPhaseThreads = qMax(1, qMin(nThreads, nTasks));
+
+    QList<DiarSweepThread *> threads;
+
+    for (int k(0); k < nPhaseThreads; k++) {
+      threads.push_back(new DiarSweepThread(this, data, phase == 0, k, nPhaseThreads));
+      threads.last()->start();
+    }
+
+    for (int k(0); k < nPhaseThreads; k++)
+      threads[k]->wait();
+
+    qDeleteAll(threads);
+  }
+
+  localDer = data.localDer;
 
   return true;
 }
 
+void MovieAnalyzer::displaySweepTable(const QList<DiarConfig> &configs, const QVector<QList<QPair<qreal, qreal> > > &localDer)
+{
+  QStringList distNames = QStringList() << "l2" << "mahal";
+  QStringList agrNames = QStringList() << "min" << "max" << "mean" << "ward";
+  QStringList partNames = QStringList() << "silhouette" << "bipartition";
+  int iBest(-1);
+  qreal bestDer(0.0);
+
+  qDebug() << "dist" << "agrCrit" << "partMeth" << "norm" << "weight" << "sigma" << "DER (%)";
+
+  for (int c(0); c < configs.size(); c++) {
+
+    QList<QPair<qreal, qreal> > der(localDer[c]);
+    qreal ssDer = retrieveSSDer(der);
+
+    qDebug() << distNames[configs[c].dist] << agrNames[configs[c].agr] << partNames[configs[c].partMeth]
+	     << configs[c].norm << configs[c].weight << configs[c].sigma
+	     << QString::number(ssDer, 'f', 2);
+
+    if (iBest == -1 || ssDer < bestDer) {
+      iBest = c;
+      bestDer = ssDer;
+    }
+  }
+
+  if (iBest != -1)
+    qDebug() << "Best configuration:" << distNames[configs[iBest].dist] << agrNames[configs[iBest].agr] << partNames[configs[iBest].partMeth]
+	     << configs[iBest].norm << configs[iBest].weight << configs[iBest].sigma
+	     << "DER:" << QString::number(bestDer, 'f', 2) << "%";
+}
+
 bool MovieAnalyzer::globalSpkDiar(const QString &baseName, QList<QPair<qint64, qint64> > &subBound, QList<QString> &refLbl)
 {
   Q_UNUSED(baseName);
@@ -1096,7 +1032,7 @@ void MovieAnalyzer::musicTracking(const QString &epFName, int frameRate, int mtW
   m_audioProcessor->trackMusic(epFName, frameRate, mtWindowSize, mtHopSize, chromaStaticFrameSize, chromaDynamicFrameSize);
 }
 
-void MovieAnalyzer::summarization(SummarizationDialog::Method method, int seasonNb, const QString &speaker, int dur, qreal granu, QList<QList<SpeechSegment *> > sceneSpeechSegments, QList<QList<Shot *> > lsuShots, QList<QList<SpeechSegment *> > lsuSpeechSegments)
+void MovieAnalyzer::summarization(SummarizationDialog::Method method, int seasonNb, const QString &speaker, int dur, qreal granu, QList<QList<SpeechSegment *> > sceneSpeechSegments, QList<QList<Shot *> > lsuShots, QList<QList<SpeechSegment *> > lsuSpeechSegments, SummarizationDialog::Selection selection)
 {
   QElapsedTimer timer;
   timer.start();
@@ -1127,15 +1063,15 @@ void MovieAnalyzer::summarization(SummarizationDialog::Method method, int season
     switch (method) {
       
     case SummarizationDialog::Content:
-      segments = fullSpeakerSummary(sceneSpeechSegments, lsuShots, lsuSpeechSegments, sceneCovering, speaker, lsuDuration, FS, dur, 0.0, steps, sceneMapping);
+      segments = fullSpeakerSummary(sceneSpeechSegments, lsuShots, lsuSpeechSegments, sceneCovering, speaker, lsuDuration, FS, dur, 0.0, steps, sceneMapping, selection);
       break;
 
     case SummarizationDialog::Style:
-      segments = styleSpeakerSummary(sceneSpeechSegments, lsuShots, lsuSpeechSegments, sceneCovering.size() * dur, lsuDuration, FS, sceneMapping, speaker);
+      segments = styleSpeakerSummary(sceneSpeechSegments, lsuShots, lsuSpeechSegments, sceneCovering.size() * dur, lsuDuration, FS, sceneMapping, speaker, selection);
       break;
 
     case SummarizationDialog::Both:
-      segments = fullSpeakerSummary(sceneSpeechSegments, lsuShots, lsuSpeechSegments, sceneCovering, speaker, lsuDuration, FS, dur, 4.0, steps, sceneMapping);
+      segments = fullSpeakerSummary(sceneSpeechSegments, lsuShots, lsuSpeechSegments, sceneCovering, speaker, lsuDuration, FS, dur, 4.0, steps, sceneMapping, selection);
       break;
 
     case SummarizationDialog::Random:
@@ -1244,7 +1180,7 @@ qreal MovieAnalyzer::getTotalSceneDuration(const QString &speaker, QList<QList<S
   return totDuration;
 }
 
-QList<QPair<Episode *, QPair<qint64, qint64> > > MovieAnalyzer::styleSpeakerSummary(QList<QList<SpeechSegment *> > sceneSpeechSegments, QList<QList<Shot *> > lsuShots, QList<QList<SpeechSegment *> > lsuSpeechSegments, int dur, const QList<qreal> &lsuDuration, const arma::mat &FS, const QMap<int, int> &sceneMapping, const QString &speaker)
+QList<QPair<Episode *, QPair<qint64, qint64> > > MovieAnalyzer::styleSpeakerSummary(QList<QList<SpeechSegment *> > sceneSpeechSegments, QList<QList<Shot *> > lsuShots, QList<QList<SpeechSegment *> > lsuSpeechSegments, int dur, const QList<qreal> &lsuDuration, const arma::mat &FS, const QMap<int, int> &sceneMapping, const QString &speaker, SummarizationDialog::Selection selection)
 {
   QList<int> spkSceneSelected;
   QList<QPair<Episode *, QPair<qint64, qint64> > > summary;
@@ -1285,7 +1221,7 @@ QList<QPair<Episode *, QPair<qint64, qint64> > > MovieAnalyzer::styleSpeakerSumm
 
   // select most expressive LSUs
   QList<int> selected;
-  m_optimizer->mmr(P, W, FS, SD, dur, selected);
+  selectLsus(selection, P, W, FS, SD, dur, selected);
 
   // build summary
   for (int i(0); i < selected.size(); i++) {
@@ -1383,7 +1319,7 @@ QList<QPair<Episode *, QPair<qint64, qint64> > > MovieAnalyzer::randomSpeakerSum
   return summary;
 }
 
-QList<QPair<Episode *, QPair<qint64, qint64> > > MovieAnalyzer::fullSpeakerSummary(QList<QList<SpeechSegment *> > sceneSpeechSegments, QList<QList<Shot *> > lsuShots, QList<QList<SpeechSegment *> > lsuSpeechSegments, const QList<QPair<QMap<QString, qreal>, QList<int> > > &sceneCovering, const QString &speaker, const QList<qreal> &lsuDuration, const arma::mat &FS, int dur, qreal styleWeight, QList<int> &steps, const QMap<int, int> &sceneMapping)
+QList<QPair<Episode *, QPair<qint64, qint64> > > MovieAnalyzer::fullSpeakerSummary(QList<QList<SpeechSegment *> > sceneSpeechSegments, QList<QList<Shot *> > lsuShots, QList<QList<SpeechSegment *> > lsuSpeechSegments, const QList<QPair<QMap<QString, qreal>, QList<int> > > &sceneCovering, const QString &speaker, const QList<qreal> &lsuDuration, const arma::mat &FS, int dur, qreal styleWeight, QList<int> &steps, const QMap<int, int> &sceneMapping, SummarizationDialog::Selection selection)
 {
   QList<int> allSelected;
   QList<int> allCandidate;
@@ -1463,7 +1399,7 @@ QList<QPair<Episode *, QPair<qint64, qint64> > > MovieAnalyzer::fullSpeakerSumma
     qreal lambda(0.05);
     // qreal optValue = m_optimizer->knapsack(P, W, CFS, lambda * CSD, dur, selected);
     selected.clear();
-    qreal heurValue = m_optimizer->mmr(P, W, CFS, lambda * CSD, dur, selected);
+    qreal heurValue = selectLsus(selection, P, W, CFS, lambda * CSD, dur, selected);
     // qDebug() << endl << "***" << optValue << heurValue << (heurValue / optValue) * 100.0 << "***" << endl;
     // qDebug() << selected;
 
@@ -1524,6 +1460,19 @@ QList<QPair<Episode *, QPair<qint64, qint64> > > MovieAnalyzer::fullSpeakerSumma
   return summary;
 }
 
+qreal MovieAnalyzer::selectLsus(SummarizationDialog::Selection selection, const arma::vec &P, const arma::vec &W, const arma::mat &FR, const arma::mat &SD, qreal dur, QList<int> &selected)
+{
+  switch (selection) {
+  case SummarizationDialog::RatioGreedy:
+    return m_optimizer->ratioGreedy(P, W, FR, SD, dur, selected);
+  case SummarizationDialog::Knapsack:
+    return m_optimizer->knapsack(P, W, FR, SD, dur, selected);
+  case SummarizationDialog::Mmr:
+  default:
+    return m_optimizer->mmr(P, W, FR, SD, dur, selected);
+  }
+}
+
 qreal MovieAnalyzer::getAvgDuration(const QList<int> &lsus, const QList<qreal> &lsuDuration)
 {
   qreal dur(0.0);
@@ -1595,9 +1544,17 @@ arma::mat MovieAnalyzer::computeLsuSocialSimMat(const QVector<QMap<QString, QMap
   arma::mat S;
   S.eye(lsuInteractions.size(), lsuInteractions.size());
 
-  for (int i(0); i < lsuInteractions.size() - 1; i++)
-    for (int j(i+1); j < lsuInteractions.size(); j++) {
-      S(i, j) = getLsuSocialSim(lsuInteractions[i], lsuInteractions[j]);
+  // LSUs converted once, then compared on speaker ids
+  SpeakerDictionary speakers;
+  QVector<InteractionMatrix> lsuMat = InteractionMatrix::fromMaps(lsuInteractions, speakers);
+  QVector<qreal> norm(lsuMat.size());
+
+  for (int i(0); i < lsuMat.size(); i++)
+    norm[i] = qSqrt(lsuMat[i].squaredNorm());
+
+  for (int i(0); i < lsuMat.size() - 1; i++)
+    for (int j(i+1); j < lsuMat.size(); j++) {
+      S(i, j) = getLsuSocialSim(lsuMat[i], lsuMat[j], norm[i], norm[j]);
       S(j, i) = S(i, j);
     }
 
@@ -1606,57 +1563,20 @@ arma::mat MovieAnalyzer::computeLsuSocialSimMat(const QVector<QMap<QString, QMap
 
 qreal MovieAnalyzer::getLsuSocialSim(const QMap<QString, QMap<QString, qreal> > &lsu1, const QMap<QString, QMap<QString, qreal> > &lsu2)
 {
-  qreal scalProd(0.0);
-  qreal l1(0.0);
-  qreal l2(0.0);
-
-  // compute first vector length
-  QMap<QString, QMap<QString, qreal> >::const_iterator it1 = lsu1.begin();
-
-  while (it1 != lsu1.end()) {
-
-    QMap<QString, qreal> interlocs = it1.value();
-    QMap<QString, qreal>::const_iterator it2 = interlocs.begin();
-
-    while (it2 != interlocs.end()) {
-
-      qreal w = it2.value();
-      l1 += qPow(w, 2);
-      
-      it2++;
-    }
-
-    it1++;
-  }
-
-  // compute scalar product and second vector length
-  it1 = lsu2.begin();
-
-  while (it1 != lsu2.end()) {
-
-    QString fSpeaker = it1.key();
-    QMap<QString, qreal> interlocs = it1.value();
-    
-    QMap<QString, qreal>::const_iterator it2 = interlocs.begin();
-
-    while (it2 != interlocs.end()) {
-	
-      QString sSpeaker = it2.key();
-      qreal w = it2.value();
-      
-      scalProd += (w * lsu1[fSpeaker][sSpeaker]);
-      l2 += qPow(w, 2);
+  SpeakerDictionary speakers;
+  QVector<InteractionMatrix> lsuMat = InteractionMatrix::fromMaps({lsu1, lsu2}, speakers);
 
-      it2++;
-    }
+  return getLsuSocialSim(lsuMat[0], lsuMat[1], qSqrt(lsuMat[0].squaredNorm()), qSqrt(lsuMat[1].squaredNorm()));
+}
 
-    it1++;
-  }
+qreal MovieAnalyzer::getLsuSocialSim(const InteractionMatrix &lsu1, const InteractionMatrix &lsu2, qreal l1, qreal l2)
+{
+  qreal scalProd = lsu1.dot(lsu2);
 
   if (l1 == 0.0 || l2 == 0.0)
     return scalProd;
 
-  return scalProd / (qSqrt(l1) * qSqrt(l2));
+  return scalProd / (l1 * l2);
 }
 
 arma::mat MovieAnalyzer::computeLsuSocialDistMat(const QVector<QMap<QString, QMap<QString, qreal> > > &lsuInteractions)
@@ -1664,9 +1584,17 @@ arma::mat MovieAnalyzer::computeLsuSocialDistMat(const QVector<QMap<QString, QMa
   arma::mat D;
   D.zeros(lsuInteractions.size(), lsuInteractions.size());
 
-  for (int i(0); i < lsuInteractions.size() - 1; i++)
-    for (int j(i+1); j < lsuInteractions.size(); j++) {
-      D(i, j) = getLsuSocialDist(lsuInteractions[i], lsuInteractions[j]);
+  // LSUs converted once, then compared on speaker ids
+  SpeakerDictionary speakers;
+  QVector<InteractionMatrix> lsuMat = InteractionMatrix::fromMaps(lsuInteractions, speakers);
+  QVector<qreal> norm(lsuMat.size());
+
+  for (int i(0); i < lsuMat.size(); i++)
+    norm[i] = qSqrt(lsuMat[i].squaredNorm());
+
+  for (int i(0); i < lsuMat.size() - 1; i++)
+    for (int j(i+1); j < lsuMat.size(); j++) {
+      D(i, j) = lsuMat[i].normalizedDist(lsuMat[j], norm[i], norm[j]);
       D(j, i) = D(i, j);
     }
 
@@ -1675,100 +1603,10 @@ arma::mat MovieAnalyzer::computeLsuSocialDistMat(const QVector<QMap<QString, QMa
 
 qreal MovieAnalyzer::getLsuSocialDist(const QMap<QString, QMap<QString, qreal> > &lsu1, const QMap<QString, QMap<QString, qreal> > &lsu2)
 {
-  qreal dist(0.0);
-  qreal l1(0.0);
-  qreal l2(0.0);
-
-  // compute first vector length
-  QMap<QString, QMap<QString, qreal> >::const_iterator it1 = lsu1.begin();
-
-  while (it1 != lsu1.end()) {
-
-    QMap<QString, qreal> interlocs = it1.value();
-    QMap<QString, qreal>::const_iterator it2 = interlocs.begin();
-
-    while (it2 != interlocs.end()) {
-
-      qreal w = it2.value();
-      l1 += qPow(w, 2);
-      
-      it2++;
-    }
-
-    it1++;
-  }
-
-  // compute second vector length
-  it1 = lsu2.begin();
-
-  while (it1 != lsu2.end()) {
-
-    QMap<QString, qreal> interlocs = it1.value();
-    QMap<QString, qreal>::const_iterator it2 = interlocs.begin();
-
-    while (it2 != interlocs.end()) {
-
-      qreal w = it2.value();
-      l2 += qPow(w, 2);
-      
-      it2++;
-    }
-
-    it1++;
-  }
-
-  l1 = qSqrt(l1);
-  l2 = qSqrt(l2);
-
-  if (l1 == 0.0 || l2 == 0.0)
-    return 0.0;
-
-  // compute euclidean distance between LSUs
-  it1 = lsu1.begin();
-
-  while (it1 != lsu1.end()) {
-
-    QString fSpeaker = it1.key();
-    QMap<QString, qreal> interlocs = it1.value();
-    
-    QMap<QString, qreal>::const_iterator it2 = interlocs.begin();
-
-    while (it2 != interlocs.end()) {
-	
-      QString sSpeaker = it2.key();
-      qreal w = it2.value();
-      
-      dist += qPow(w / l1 - lsu2[fSpeaker][sSpeaker] / l2, 2);
-
-      it2++;
-    }
-
-    it1++;
-  }
-
-  it1 = lsu2.begin();
-
-  while (it1 != lsu2.end()) {
-
-    QString fSpeaker = it1.key();
-    QMap<QString, qreal> interlocs = it1.value();
-    
-    QMap<QString, qreal>::const_iterator it2 = interlocs.begin();
-
-    while (it2 != interlocs.end()) {
-	
-      QString sSpeaker = it2.key();
-      qreal w = it2.value();
-      
-      dist += qPow(w / l2 - lsu1[fSpeaker][sSpeaker] / l1, 2);
-
-      it2++;
-    }
-
-    it1++;
-  }
+  SpeakerDictionary speakers;
+  QVector<InteractionMatrix> lsuMat = InteractionMatrix::fromMaps({lsu1, lsu2}, speakers);
 
-  return qSqrt(dist);
+  return lsuMat[0].normalizedDist(lsuMat[1], qSqrt(lsuMat[0].squaredNorm()), qSqrt(lsuMat[1].squaredNorm()));
 }
 
 qreal MovieAnalyzer::getLsuSocialRelevance(const QMap<QString, QMap<QString, qreal> > &lsuInteractions, const QString &speaker, const QMap<QString, qreal> &socialState)
@@ -2170,74 +2008,47 @@ QPair<arma::mat, QList<QPair<QString, QString> > > MovieAnalyzer::vectorize(cons
   arma::mat M;
   QList<QPair<QString, QString> > mapping;
 
-  // mapping
-  for (int i(0); i < inter.size(); i++) {
+  // speaker ids follow name order: same mapping order as when iterating maps
+  SpeakerDictionary speakers;
+  QVector<InteractionMatrix> interMat = InteractionMatrix::fromMaps(inter.toVector(), speakers);
+  QHash<qint64, int> pairIdx;
+  QVector<QVector<int> > rowIdx(interMat.size());
 
-    QMap<QString, QMap<QString, qreal> >::const_iterator it1 = inter[i].begin();
+  // mapping
+  for (int j(0); j < interMat.size(); j++) {
 
-    while (it1 != inter[i].end()) {
+    const QVector<int> &rowPtr = interMat[j].getRowPtr();
+    const QVector<int> &colIdx = interMat[j].getColIdx();
 
-      QString fSpeaker = it1.key();
-      QMap<QString, qreal> interlocs = it1.value();
+    for (int fSpk(0); fSpk < interMat[j].getNRows(); fSpk++)
+      for (int k(rowPtr[fSpk]); k < rowPtr[fSpk + 1]; k++) {
 
-      QMap<QString, qreal>::const_iterator it2 = interlocs.begin();
+	int sSpk = colIdx[k];
+	bool swap = !directed && sSpk < fSpk;
+	int first = swap ? sSpk : fSpk;
+	int second = swap ? fSpk : sSpk;
 
-      while (it2 != interlocs.end()) {
-      
-	QString sSpeaker = it2.key();
+	qint64 key = InteractionMatrix::pairKey(first, second);
+	QHash<qint64, int>::const_iterator it = pairIdx.constFind(key);
 
-	QPair<QString, QString> inter(fSpeaker, sSpeaker);
-	
-	if (!directed) {
-	  inter.first = (fSpeaker <= sSpeaker) ? fSpeaker : sSpeaker;
-	  inter.second = (fSpeaker > sSpeaker) ? fSpeaker : sSpeaker;
+	if (it == pairIdx.constEnd()) {
+	  it = pairIdx.insert(key, mapping.size());
+	  mapping.push_back(QPair<QString, QString>(speakers.getName(first), speakers.getName(second)));
 	}
-	
-	if (!mapping.contains(inter))
-	  mapping.push_back(inter);
 
-	it2++;
+	rowIdx[j].push_back(it.value());
       }
-
-      it1++;
-    }
   }
 
   // populate matrix of vectorized interactions
   M.zeros(mapping.size(), inter.size());
 
-  for (int j(0); j < inter.size(); j++) {
-
-    QMap<QString, QMap<QString, qreal> >::const_iterator it1 = inter[j].begin();
-
-    while (it1 != inter[j].end()) {
-
-      QString fSpeaker = it1.key();
-      QMap<QString, qreal> interlocs = it1.value();
-
-      QMap<QString, qreal>::const_iterator it2 = interlocs.begin();
-
-      while (it2 != interlocs.end()) {
-      
-	QString sSpeaker = it2.key();
-	qreal weight = it2.value();
-
-	QPair<QString, QString> inter(fSpeaker, sSpeaker);
-
-	if (!directed) {
-	  inter.first = (fSpeaker <= sSpeaker) ? fSpeaker : sSpeaker;
-	  inter.second = (fSpeaker > sSpeaker) ? fSpeaker : sSpeaker;
-	}
+  for (int j(0); j < interMat.size(); j++) {
 
-	int i = mapping.indexOf(inter);
+    const QVector<qreal> &values = interMat[j].getValues();
 
-	M(i, j) += weight;
-	
-	it2++;
-      }
-
-      it1++;
-    }
+    for (int k(0); k < values.size(); k++)
+      M(rowIdx[j][k], j) += values[k];
   }
 
   return QPair<arma::mat, QList<QPair<QString, QString> > >(M, mapping);
@@ -2399,6 +2210,65 @@ bool MovieAnalyzer::coClustering(const QString &fName, QList<Shot *> shots, QLis
   return true;
 }
 
+void MovieAnalyzer::benchmarkFacilityLocation(QList<SpeechSegment *> speechSegments, QList<QList<SpeechSegment *> > lsuSpeechSegments, int maxExactSize)
+{
+  QElapsedTimer timer;
+  Optimizer::SolverMode solverMode = m_optimizer->getSolverMode();
+  int nThreads = m_optimizer->getNThreads();
+
+  m_audioProcessor->extractIVectors(speechSegments);
+  arma::mat X = m_audioProcessor->getEpisodeIVectors(speechSegments);
+  arma::mat Sigma = m_audioProcessor->genSigmaMat();
+
+  qDebug() << "LSU" << "utterances" << "p" << "problem" << "exact" << "time (s)" << "heuristic" << "time (s)" << "gap (%)";
+
+  // looping over LSUs containing at least two speech segments
+  for (int i(0); i < lsuSpeechSegments.size(); i++) {
+
+    int n(lsuSpeechSegments[i].size());
+
+    if (n < 2)
+      continue;
+
+    // utterances clustered into as many clusters as reference speakers
+    arma::mat D = retrieveUtterMatDist(X, Sigma, UtteranceTree::L2, lsuSpeechSegments[i], speechSegments);
+    int p = getNbRefSpeakers(lsuSpeechSegments[i]);
+
+    for (int j(0); j < 2; j++) {
+
+      QList<QList<int> > partition;
+      QList<int> cIdx;
+      qreal exactObj(-1.0);
+      qint64 exactTime(-1);
+
+      // exact models left aside for large LSUs
+      if (n <= maxExactSize) {
+	m_optimizer->setSolverMode(Optimizer::Exact, nThreads);
+	timer.start();
+	exactObj = (j == 0) ? m_optimizer->pMedian(p, D, partition, cIdx) : m_optimizer->pCenter(p, D, partition, cIdx);
+	exactTime = timer.nsecsElapsed();
+      }
+
+      partition.clear();
+      cIdx.clear();
+
+      m_optimizer->setSolverMode(Optimizer::Heuristic, nThreads);
+      timer.start();
+      qreal heurObj = (j == 0) ? m_optimizer->pMedian(p, D, partition, cIdx) : m_optimizer->pCenter(p, D, partition, cIdx);
+      qint64 heurTime = timer.nsecsElapsed();
+
+      qDebug() << i << n << p << ((j == 0) ? "p-median" : "p-center")
+	       << (exactTime >= 0 ? QString::number(exactObj, 'f', 4) : QString("-"))
+	       << (exactTime >= 0 ? QString::number(exactTime / 1e9, 'f', 3) : QString("-"))
+	       << QString::number(heurObj, 'f', 4)
+	       << QString::number(heurTime / 1e9, 'f', 3)
+	       << (exactTime >= 0 && exactObj > 0.0 ? QString::number((heurObj - exactObj) / exactObj * 100.0, 'f', 2) : QString("-"));
+    }
+  }
+
+  m_optimizer->setSolverMode(solverMode, nThreads);
+}
+
 int MovieAnalyzer::getNbRefShotClusters(QList<Shot *> shots)
 {
   QList<QString> refLabels;
@@ -2824,12 +2694,7 @@ void MovieAnalyzer::extractLSUs_aux(int first, int last, const arma::umat &Y, qi
 
 qreal MovieAnalyzer::meanDistance(const QVector<qreal> &distance)
 {
-  qreal sum(0.0);
-
-  for (int i(0); i < distance.size(); i++)
-    sum += abs(1 - distance[i]);
-
-  return 1 - sum / distance.size();
+  return m_vFrameProcessor->meanDistance(distance);
 }
 
 
@@ -2952,17 +2817,7 @@ qreal MovieAnalyzer::retrieveDer(QString fName)
 
 arma::mat MovieAnalyzer::computeDistMat(const arma::mat &S, const arma::mat &SigmaInv, UtteranceTree::DistType dist)
 {
-  arma::mat D(S.n_rows, S.n_rows, arma::fill::zeros);
-  qreal d;
-
-  for (arma::uword i(0); i < S.n_rows; i++)
-    for (arma::uword j(i); j < S.n_rows; j++) {
-      d = computeDistance(S.row(i), S.row(j), SigmaInv, dist);
-      D(i, j) = d;
-      D(j, i) = d;
-    }
-  
-  return D;
+  return DistanceKernel::distMat(S, SigmaInv, dist);
 }
 
 qreal MovieAnalyzer::computeDistance(const arma::mat &U, const arma::mat &V, const arma::mat &SigmaInv, UtteranceTree::DistType dist)
@@ -3001,7 +2856,7 @@ arma::mat MovieAnalyzer::retrieveUtterMatDist(arma::mat X, arma::mat CovInv, Utt
   return computeDistMat(S, CovInv, dist);
 }
 
-QPair<qreal, qreal> MovieAnalyzer::computeSpkError(QList<QList<int> > &partition, QList<SpeechSegment *> speechSegments, QString pattLabel)
+QPair<qreal, qreal> MovieAnalyzer::computeSpkError(QList<QList<int> > &partition, const QList<SpeechSegment *> &speechSegments, QString pattLabel, bool labelling)
 {
   QList<QString> refList;                    // reference speakers
   QList<QString> hypList;                    // hypothesized speakers
@@ -3040,11 +2895,12 @@ QPair<qreal, qreal> MovieAnalyzer::computeSpkError(QList<QList<int> > &partition
       
       // updating ditribution of hypothesized speakers over reference ones
       dist[refSpk][hypSpk] += uttDur;
-
-      speechSegments[uttIdx]->setLabel(hypSpk, Segment::Automatic);
     }
   }
 
+  if (labelling)
+    setHypSpeakers(partition, speechSegments, pattLabel);
+
   // retrieve optimal mapping between reference and hypothesized partitions
   optMap = m_optimizer->optimalMatching(refList, hypList, dist);
 
@@ -3057,8 +2913,11 @@ QPair<qreal, qreal> MovieAnalyzer::computeSpkError(QList<QList<int> > &partition
       // reference speaker
       QString refSpk = speechSegments[uttIdx]->getLabel(Segment::Manual);
 
-      // hypothesized speaker
-      QString hypSpk = speechSegments[uttIdx]->getLabel(Segment::Automatic);
+      // hypothesized speaker: labels possibly not set yet
+      QString spkPrefix = "";
+      if (pattLabel != "")
+	spkPrefix = pattLabel + "_";
+      QString hypSpk = spkPrefix + "S" + QString::number(i);
 
       // utterance boundaries
       qreal uttStart = speechSegments[uttIdx]->getPosition() / 1000.0;
@@ -3080,6 +2939,17 @@ QPair<qreal, qreal> MovieAnalyzer::computeSpkError(QList<QList<int> > &partition
   return res;
 }
 
+void MovieAnalyzer::setHypSpeakers(const QList<QList<int> > &partition, const QList<SpeechSegment *> &speechSegments, const QString &pattLabel)
+{
+  QString spkPrefix = "";
+  if (pattLabel != "")
+    spkPrefix = pattLabel + "_";
+
+  for (int i(0); i < partition.size(); i++)
+    for (int j(0); j < partition[i].size(); j++)
+      speechSegments[partition[i][j]]->setLabel(spkPrefix + "S" + QString::number(i), Segment::Automatic);
+}
+
  qreal MovieAnalyzer::retrieveSSDer(QList<QPair<qreal, qreal> > &localDer)
 {
   qreal totDuration(0.0);
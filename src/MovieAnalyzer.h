@@ -17,6 +17,7 @@
 #include "TextProcessor.h"
 #include "AudioProcessor.h"
 #include "SocialNetProcessor.h"
+#include "InteractionMatrix.h"
 #include "Optimizer.h"
 #include "Segment.h"
 #include "Episode.h"
@@ -33,6 +34,16 @@ class MovieAnalyzer: public QWidget
   Q_OBJECT
 
  public:
+  // local speaker diarization settings evaluated by parameter sweeps
+  struct DiarConfig {
+    UtteranceTree::DistType dist;
+    UtteranceTree::AgrCrit agr;
+    UtteranceTree::PartMeth partMeth;
+    bool norm;
+    bool weight;
+    bool sigma;
+  };
+
   MovieAnalyzer(QWidget *parent = 0);
   ~MovieAnalyzer();
 
@@ -52,8 +63,9 @@ class MovieAnalyzer: public QWidget
 		    qreal threshold2 = 20,
 		    int nVBlock = 5,
 		    int nHBlock = 6,
-		    bool viewProgress = true);
-  bool labelSimilarShots(QString fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal maxDist, int windowSize, QList<Shot *> shots, int nVBlock, int nHBlock, bool viewProgress);
+		    bool viewProgress = true,
+		    int analysisHeight = 0);
+  bool labelSimilarShots(QString fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal maxDist, int windowSize, QList<Shot *> shots, int nVBlock, int nHBlock, bool viewProgress, int analysisHeight = 0);
   bool faceDetectionOpenCV(QList<Shot *> shots, const QString &fName, int minHeight);
   void faceDetectionZhu(QList<Shot *> shots, const QString &fName, int minHeight);
 
@@ -62,6 +74,8 @@ class MovieAnalyzer: public QWidget
   ////////////////////////////
 
   bool localSpkDiarHC(UtteranceTree::DistType dist, bool norm, UtteranceTree::AgrCrit agr, UtteranceTree::PartMeth partMeth, bool weight, bool sigma, QList<SpeechSegment *> speechSegments, QList<QList<SpeechSegment *> > lsuSpeechSegments);
+  bool localSpkDiarSweep(const QList<DiarConfig> &configs, QList<SpeechSegment *> speechSegments, QList<QList<SpeechSegment *> > lsuSpeechSegments, QVector<QList<QPair<qreal, qreal> > > &localDer);
+  void displaySweepTable(const QList<DiarConfig> &configs, const QVector<QList<QPair<qreal, qreal> > > &localDer);
   bool globalSpkDiar(const QString &baseName, QList<QPair<qint64, qint64> > &subBound, QList<QString> &refLbl);
   void setCoOccurrInteract(QList<QList<SpeechSegment *> > unitSpeechSegments, int nbDiscards);
   void setSequentialInteract(QList<QList<SpeechSegment *> > unitSpeechSegments, int nbDiscards, int interThresh, const QVector<bool> &rules);
@@ -72,21 +86,23 @@ class MovieAnalyzer: public QWidget
   //////////////////////////////////////////////
 
   bool coClustering(const QString &fName, QList<Shot *> shots, QList<QList<Shot *> > lsuShots, QList<SpeechSegment *> speechSegments, QList<QList<SpeechSegment *> > lsuSpeechSegments);
+  void benchmarkFacilityLocation(QList<SpeechSegment *> speechSegments, QList<QList<SpeechSegment *> > lsuSpeechSegments, int maxExactSize = 150);
   bool extractScenes(QString fName, const QList<QString> &shotLabels, const QList<qint64> &shotPositions, const QList<QString> &utterLabels, const QList<QPair<qint64, qint64> > &utterBound);
 
   //////////////////////
   // high-level tasks //
   //////////////////////
 
-  void summarization(SummarizationDialog::Method method, int seasonNb, const QString &speaker, int dur, qreal granu, QList<QList<SpeechSegment *> > sceneSpeechSegments, QList<QList<Shot *> > lsuShots, QList<QList<SpeechSegment *> > lsuSpeechSegments);
+  void summarization(SummarizationDialog::Method method, int seasonNb, const QString &speaker, int dur, qreal granu, QList<QList<SpeechSegment *> > sceneSpeechSegments, QList<QList<Shot *> > lsuShots, QList<QList<SpeechSegment *> > lsuSpeechSegments, SummarizationDialog::Selection selection = SummarizationDialog::Mmr);
 
   void exportToFile(const QList<QPair<Episode *, QPair<qint64, qint64> > > summary, QString speaker, int seasNbr, SummarizationDialog::Method method, const QList<int> &steps);
 
-  QList<QPair<Episode *, QPair<qint64, qint64> > > styleSpeakerSummary(QList<QList<SpeechSegment *> > sceneSpeechSegments, QList<QList<Shot *> > lsuShots, QList<QList<SpeechSegment *> > lsuSpeechSegments, int dur, const QList<qreal> &lsuDuration, const arma::mat &FS, const QMap<int, int> &sceneMapping, const QString &speaker);
+  QList<QPair<Episode *, QPair<qint64, qint64> > > styleSpeakerSummary(QList<QList<SpeechSegment *> > sceneSpeechSegments, QList<QList<Shot *> > lsuShots, QList<QList<SpeechSegment *> > lsuSpeechSegments, int dur, const QList<qreal> &lsuDuration, const arma::mat &FS, const QMap<int, int> &sceneMapping, const QString &speaker, SummarizationDialog::Selection selection);
 
   QList<QPair<Episode *, QPair<qint64, qint64> > > randomSpeakerSummary(QList<QList<Shot *> > lsuShots, QList<QList<SpeechSegment *> > lsuSpeechSegments, int dur, const QList<qreal> &lsuDuration, const arma::mat &FS);
 
-  QList<QPair<Episode *, QPair<qint64, qint64> > > fullSpeakerSummary(QList<QList<SpeechSegment *> > sceneSpeechSegments, QList<QList<Shot *> > lsuShots, QList<QList<SpeechSegment *> > lsuSpeechSegments, const QList<QPair<QMap<QString, qreal>, QList<int> > > &sceneCovering, const QString &speaker, const QList<qreal> &lsuDuration, const arma::mat &FS, int dur, qreal styleWeight, QList<int> &steps, const QMap<int, int> &sceneMapping);
+  QList<QPair<Episode *, QPair<qint64, qint64> > > fullSpeakerSummary(QList<QList<SpeechSegment *> > sceneSpeechSegments, QList<QList<Shot *> > lsuShots, QList<QList<SpeechSegment *> > lsuSpeechSegments, const QList<QPair<QMap<QString, qreal>, QList<int> > > &sceneCovering, const QString &speaker, const QList<qreal> &lsuDuration, const arma::mat &FS, int dur, qreal styleWeight, QList<int> &steps, const QMap<int, int> &sceneMapping, SummarizationDialog::Selection selection);
+  qreal selectLsus(SummarizationDialog::Selection selection, const arma::vec &P, const arma::vec &W, const arma::mat &FR, const arma::mat &SD, qreal dur, QList<int> &selected);
 
   qreal getAvgDuration(const QList<int> &lsus, const QList<qreal> &lsuDuration);
 
@@ -107,6 +123,7 @@ class MovieAnalyzer: public QWidget
   
   arma::mat computeLsuSocialSimMat(const QVector<QMap<QString, QMap<QString, qreal> > > &lsuInteractions);
   qreal getLsuSocialSim(const QMap<QString, QMap<QString, qreal> > &lsu1, const QMap<QString, QMap<QString, qreal> > &lsu2);
+  qreal getLsuSocialSim(const InteractionMatrix &lsu1, const InteractionMatrix &lsu2, qreal l1, qreal l2);
   arma::mat computeLsuSocialDistMat(const QVector<QMap<QString, QMap<QString, qreal> > > &lsuInteractions);
   qreal getLsuSocialDist(const QMap<QString, QMap<QString, qreal> > &lsu1, const QMap<QString, QMap<QString, qreal> > &lsu2);
   
@@ -144,6 +161,14 @@ class MovieAnalyzer: public QWidget
   QList<SpeechSegment *> denoiseSpeechSegments(QList<SpeechSegment *> speechSegments);
   QList<SpeechSegment *> filterSpeechSegments(QList<SpeechSegment *> speechSegments);
 
+  //////////////////////
+  // user interaction //
+  //////////////////////
+
+  void setInteractive(bool interactive, bool extractOnMismatch = true);
+  void setSolverMode(Optimizer::SolverMode solverMode, int nThreads = 1);
+  void setDiarThreads(int nThreads);
+
   public slots:
     void setSpeakerPartition(QList<QList<int>> partition);
     void playSpeakers(QList<int> speakers);
@@ -177,6 +202,23 @@ class MovieAnalyzer: public QWidget
   void getSnapshots(const QVector<QMap<QString, QMap<QString, qreal> > > &snapshots);
 
  private:
+  // inputs shared by the configurations of a diarization sweep
+  struct SweepData {
+    QList<DiarConfig> configs;
+    QList<SpeechSegment *> speechSegments;
+    QVector<arma::uvec> lsuIdx;                     // utterances of each LSU
+    QVector<arma::mat> X;                           // utterance vectors for each distance
+    QVector<arma::mat> CovInv;                      // inverse covariance for each distance
+    QVector<UtteranceTree::DistType> dist;
+    QVector<bool> used;                             // distances needed by configurations
+    QVector<QVector<arma::mat> > D;                 // distance matrices for each distance and LSU
+    QVector<QVector<arma::mat> > W;                 // utterance weights with and without durations
+    QVector<QList<QPair<qreal, qreal> > > localDer; // DER for each configuration and LSU
+  };
+
+  friend class LsuDiarThread;
+  friend class DiarSweepThread;
+
   qreal meanDistance(const QVector<qreal> &distance);
 
   void normalize(arma::mat &E, const arma::mat &CovInv, UtteranceTree::DistType dist);
@@ -188,7 +230,12 @@ DistType dist);
   qreal computeDistance(const arma::mat &U, const arma::mat &V, const arma::mat &SigmaInv, UtteranceTree::DistType dist);
 
   arma::mat retrieveUtterMatDist(arma::mat X, arma::mat CovInv, UtteranceTree::DistType dist, QList<SpeechSegment *> lsuSpeechSegments, QList<SpeechSegment *> speechSegments);
-  QPair<qreal, qreal> computeSpkError(QList<QList<int> > &partition, QList<SpeechSegment *> speechSegments, QString pattLabel);
+  QPair<qreal, qreal> computeSpkError(QList<QList<int> > &partition, const QList<SpeechSegment *> &speechSegments, QString pattLabel, bool labelling = true);
+  void setHypSpeakers(const QList<QList<int> > &partition, const QList<SpeechSegment *> &speechSegments, const QString &pattLabel);
+  static int sweepDistIdx(const DiarConfig &config);
+  void computeSweepDistances(SweepData &data, int first, int step);
+  void evalSweepConfigs(SweepData &data, int first, int step);
+  void diarizeLsus(const arma::mat &X, const arma::mat &CovInv, UtteranceTree::DistType dist, UtteranceTree::AgrCrit agr, UtteranceTree::PartMeth partMeth, bool weight, const QList<SpeechSegment *> &speechSegments, const QList<QList<SpeechSegment *> > &lsuSpeechSegments, QVector<QList<QList<int> > > &partitions, QVector<QPair<qreal, qreal> > &lsuDer, int first, int step);
   qreal retrieveSSDer(QList<QPair<qreal, qreal> > &localDer);
   bool setShotCorrMatrix(arma::mat &D, const QString &fName, QList<Shot *> shots, int nV, int nH);
   QList<QPair<int, int> > extractLSUs(const arma::umat &Y, bool rec, qint64 minDur, qint64 maxDur, QList<Shot *> shots);
@@ -203,7 +250,6 @@ DistType dist);
   int getNbRefShotClusters(QList<Shot *> shots);
   int getNbRefSpeakers(QList<SpeechSegment *> speechSegments);
 
-  QList<QRect> detectFacesOpenCV(cv::CascadeClassifier &faceCascade, cv::Mat &frame, int minHeight);
   QList<QRect> detectFacesZhu(qint64 position, cv::Mat &frame, int minHeight);
 
   bool sameSurroundSpeaker(int i, QList<QList<SpeechSegment *> > speechSegments);
@@ -218,7 +264,6 @@ DistType dist);
   AudioProcessor *m_audioProcessor;
   SocialNetProcessor *m_socialNetProcessor;
   Optimizer *m_optimizer;
-  QVector<cv::Mat> m_prevLocHisto;
   cv::Mat m_prevGlobHisto;
   QProcess *m_faceDetectProcess;
 
@@ -226,6 +271,7 @@ DistType dist);
   QList<QString> m_speakers;
   QList<QPair<qint64, qint64> > m_subBound;
   QString m_localDer;
+  int m_nDiarThreads;
 };
 
 #endif
@@ -19,6 +19,7 @@ NarrChartMonitor::NarrChartMonitor(QWidget *parent)
 
   QCheckBox *displayLines = new QCheckBox(tr("Display lines"));
   QCheckBox *displayArcs = new QCheckBox(tr("Display arcs"));
+  QCheckBox *exactOrdering = new QCheckBox(tr("Exact ordering"));
   m_controls = new PlayerControls(false);
   m_timer = new QTimer(this);
 
@@ -26,12 +27,14 @@ NarrChartMonitor::NarrChartMonitor(QWidget *parent)
   layout->addWidget(m_scrollArea, 0, 0, 1, 10);
   layout->addWidget(displayLines, 1, 0);
   layout->addWidget(displayArcs, 1, 1);
-  layout->addWidget(m_controls, 1, 2);
+  layout->addWidget(exactOrdering, 1, 2);
+  layout->addWidget(m_controls, 1, 3);
 
   setLayout(layout);
 
   connect(displayLines, SIGNAL(clicked(bool)), m_narrChartWidget, SLOT(displayLines(bool)));
   connect(displayArcs, SIGNAL(clicked(bool)), m_narrChartWidget, SLOT(displayArcs(bool)));
+  connect(exactOrdering, SIGNAL(clicked(bool)), this, SLOT(setExactOrdering(bool)));
 
   connect(m_controls, SIGNAL(play()), this, SLOT(play()));
   connect(m_controls, SIGNAL(pause()), this, SLOT(pause()));
@@ -66,6 +69,18 @@ void NarrChartMonitor::viewNarrChart(QList<QList<SpeechSegment *> > sceneSpeechS
   show();
 }
 
+void NarrChartMonitor::setExactOrdering(bool exact)
+{
+  m_socialNetProcessor->setStorylineOrdering(exact);
+
+  // chart already displayed: storylines ordered again
+  if (m_currScene != -1) {
+    m_socialNetProcessor->setNarrChart();
+    m_narrChartWidget->setNarrChart(m_socialNetProcessor->getNarrChart());
+    m_narrChartWidget->update();
+  }
+}
+
 void NarrChartMonitor::grabSnapshots(const QVector<QMap<QString, QMap<QString, qreal> > > &snapshots)
 {
   m_narrChartWidget->setSnapshots(snapshots);
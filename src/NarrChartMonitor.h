@@ -24,6 +24,7 @@ void pause();
 void stop();
 void setPlaybackRate(qreal rate);
 void updateNarrChartWidget();
+void setExactOrdering(bool exact);
 
     signals:
 
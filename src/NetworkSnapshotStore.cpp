@@ -0,0 +1,241 @@
+#include "NetworkSnapshotStore.h"
+
+//////////////////
+// constructors //
+//////////////////
+
+NetworkSnapshotStore::NetworkSnapshotStore(int checkpointStep)
+  : m_checkpointStep(qMax(1, checkpointStep))
+{
+  m_updatePtr.push_back(0);
+  m_emptyRowPtr.push_back(0);
+}
+
+NetworkSnapshotStore::NetworkSnapshotStore(const SpeakerDictionary &speakers, int checkpointStep)
+  : m_checkpointStep(qMax(1, checkpointStep)),
+    m_speakers(speakers)
+{
+  m_updatePtr.push_back(0);
+  m_emptyRowPtr.push_back(0);
+}
+
+////////////////////
+// public methods //
+////////////////////
+
+void NetworkSnapshotStore::clear(int n)
+{
+  m_speakers = SpeakerDictionary();
+  m_updates.clear();
+  m_updatePtr.clear();
+  m_updatePtr.push_back(0);
+  m_emptyRows.clear();
+  m_emptyRowPtr.clear();
+  m_emptyRowPtr.push_back(0);
+  m_checkpoints.clear();
+  m_last = InteractionMatrix();
+
+  // empty snapshots
+  for (int i(0); i < n; i++)
+    append(InteractionMatrix());
+}
+
+void NetworkSnapshotStore::append(const QMap<QString, QMap<QString, qreal> > &snapshot)
+{
+  InteractionMatrix M = InteractionMatrix::fromMap(snapshot, m_speakers);
+
+  // speakers without interlocutor have no entry in the matrix
+  QMap<QString, QMap<QString, qreal> >::const_iterator it = snapshot.begin();
+
+  while (it != snapshot.end()) {
+    if (it.value().isEmpty())
+      m_emptyRows.push_back(m_speakers.getId(it.key()));
+    it++;
+  }
+
+  append(M);
+}
+
+void NetworkSnapshotStore::append(const InteractionMatrix &snapshot)
+{
+  const QVector<int> &prevPtr = m_last.getRowPtr();
+  const QVector<int> &prevIdx = m_last.getColIdx();
+  const QVector<qreal> &prevValues = m_last.getValues();
+
+  const QVector<int> &rowPtr = snapshot.getRowPtr();
+  const QVector<int> &colIdx = snapshot.getColIdx();
+  const QVector<qreal> &values = snapshot.getValues();
+
+  int nRows = qMax(m_last.getNRows(), snapshot.getNRows());
+
+  // edges added, modified or removed since previous snapshot
+  for (int i(0); i < nRows; i++) {
+
+    int k = (i < m_last.getNRows()) ? prevPtr[i] : 0;
+    int kEnd = (i < m_last.getNRows()) ? prevPtr[i + 1] : 0;
+    int l = (i < snapshot.getNRows()) ? rowPtr[i] : 0;
+    int lEnd = (i < snapshot.getNRows()) ? rowPtr[i + 1] : 0;
+
+    while (k < kEnd || l < lEnd) {
+
+      EdgeUpdate update;
+      update.fSpk = i;
+      update.removed = false;
+
+      if (l == lEnd || (k < kEnd && prevIdx[k] < colIdx[l])) {
+	update.sSpk = prevIdx[k++];
+	update.weight = 0.0;
+	update.removed = true;
+      }
+      else if (k == kEnd || colIdx[l] < prevIdx[k]) {
+	update.sSpk = colIdx[l];
+	update.weight = values[l++];
+      }
+      else {
+	update.sSpk = colIdx[l];
+	update.weight = values[l++];
+
+	if (prevValues[k++] == update.weight)
+	  continue;
+      }
+
+      m_updates.push_back(update);
+    }
+  }
+
+  if (size() % m_checkpointStep == 0)
+    m_checkpoints.push_back(snapshot);
+
+  m_updatePtr.push_back(m_updates.size());
+  m_emptyRowPtr.push_back(m_emptyRows.size());
+  m_last = snapshot;
+}
+
+int NetworkSnapshotStore::size() const
+{
+  return m_updatePtr.size() - 1;
+}
+
+bool NetworkSnapshotStore::isEmpty() const
+{
+  return size() == 0;
+}
+
+int NetworkSnapshotStore::getNUpdates() const
+{
+  return m_updates.size();
+}
+
+QMap<QString, QMap<QString, qreal> > NetworkSnapshotStore::at(int i) const
+{
+  int c = i / m_checkpointStep;
+  QMap<QString, QMap<QString, qreal> > snapshot = m_checkpoints[c].toMap(m_speakers);
+  addEmptyRows(snapshot, c * m_checkpointStep);
+
+  for (int j(c * m_checkpointStep + 1); j <= i; j++)
+    applyUpdates(snapshot, j);
+
+  return snapshot;
+}
+
+QMap<QString, QMap<QString, qreal> > NetworkSnapshotStore::operator[](int i) const
+{
+  return at(i);
+}
+
+QMap<QString, QMap<QString, qreal> > NetworkSnapshotStore::first() const
+{
+  return at(0);
+}
+
+QVector<QMap<QString, QMap<QString, qreal> > > NetworkSnapshotStore::toVector() const
+{
+  QVector<QMap<QString, QMap<QString, qreal> > > snapshots(size());
+  Cursor cursor(this);
+
+  for (int i(0); i < size(); i++) {
+    cursor.seek(i);
+    snapshots[i] = cursor.getSnapshot();
+  }
+
+  return snapshots;
+}
+
+/////////////////////
+// private methods //
+/////////////////////
+
+void NetworkSnapshotStore::applyUpdates(QMap<QString, QMap<QString, qreal> > &snapshot, int i) const
+{
+  for (int k(m_updatePtr[i]); k < m_updatePtr[i + 1]; k++) {
+
+    const EdgeUpdate &update = m_updates[k];
+    QString fSpeaker = m_speakers.getName(update.fSpk);
+    QString sSpeaker = m_speakers.getName(update.sSpk);
+
+    if (update.removed) {
+
+      QMap<QString, QMap<QString, qreal> >::iterator it = snapshot.find(fSpeaker);
+      it.value().remove(sSpeaker);
+
+      if (it.value().isEmpty())
+	snapshot.erase(it);
+    }
+
+    else
+      snapshot[fSpeaker][sSpeaker] = update.weight;
+  }
+
+  // speakers left without interlocutor in previous snapshot only
+  for (int k(m_emptyRowPtr[i - 1]); k < m_emptyRowPtr[i]; k++) {
+
+    QMap<QString, QMap<QString, qreal> >::iterator it = snapshot.find(m_speakers.getName(m_emptyRows[k]));
+
+    if (it != snapshot.end() && it.value().isEmpty())
+      snapshot.erase(it);
+  }
+
+  addEmptyRows(snapshot, i);
+}
+
+void NetworkSnapshotStore::addEmptyRows(QMap<QString, QMap<QString, qreal> > &snapshot, int i) const
+{
+  for (int k(m_emptyRowPtr[i]); k < m_emptyRowPtr[i + 1]; k++)
+    snapshot[m_speakers.getName(m_emptyRows[k])];
+}
+
+////////////
+// cursor //
+////////////
+
+NetworkSnapshotStore::Cursor::Cursor(const NetworkSnapshotStore *store)
+  : m_store(store),
+    m_pos(-1)
+{
+}
+
+void NetworkSnapshotStore::Cursor::seek(int i)
+{
+  int c = i / m_store->m_checkpointStep;
+  int fromCheckpoint = i - c * m_store->m_checkpointStep;
+
+  // restart from closest checkpoint when moving backward or far ahead
+  if (m_pos < 0 || i < m_pos || i - m_pos > fromCheckpoint) {
+    m_snapshot = m_store->m_checkpoints[c].toMap(m_store->m_speakers);
+    m_pos = c * m_store->m_checkpointStep;
+    m_store->addEmptyRows(m_snapshot, m_pos);
+  }
+
+  while (m_pos < i)
+    m_store->applyUpdates(m_snapshot, ++m_pos);
+}
+
+int NetworkSnapshotStore::Cursor::getPosition() const
+{
+  return m_pos;
+}
+
+const QMap<QString, QMap<QString, qreal> > & NetworkSnapshotStore::Cursor::getSnapshot() const
+{
+  return m_snapshot;
+}
@@ -0,0 +1,83 @@
+#ifndef NETWORKSNAPSHOTSTORE_H
+#define NETWORKSNAPSHOTSTORE_H
+
+#include <QString>
+#include <QVector>
+#include <QMap>
+
+#include "SpeakerDictionary.h"
+#include "InteractionMatrix.h"
+
+///////////////////////////////////////////////////////
+// sequence of network snapshots stored as edge      //
+// updates from one snapshot to the next, with a     //
+// full snapshot kept every few scenes: a snapshot   //
+// is rebuilt from the closest checkpoint before it, //
+// while a cursor moves from one snapshot to the     //
+// next by applying a single set of updates          //
+///////////////////////////////////////////////////////
+
+class NetworkSnapshotStore
+{
+ public:
+  class Cursor
+  {
+   public:
+    Cursor(const NetworkSnapshotStore *store);
+
+    void seek(int i);
+    int getPosition() const;
+    const QMap<QString, QMap<QString, qreal> > & getSnapshot() const;
+
+   private:
+    const NetworkSnapshotStore *m_store;
+    int m_pos;
+    QMap<QString, QMap<QString, qreal> > m_snapshot;
+  };
+
+  NetworkSnapshotStore(int checkpointStep = 32);
+  NetworkSnapshotStore(const SpeakerDictionary &speakers, int checkpointStep = 32);
+
+  void clear(int n = 0);
+  void append(const QMap<QString, QMap<QString, qreal> > &snapshot);
+  void append(const InteractionMatrix &snapshot); // compressed, on store speaker ids
+
+  int size() const;
+  bool isEmpty() const;
+  int getNUpdates() const;
+  QMap<QString, QMap<QString, qreal> > at(int i) const;
+  QMap<QString, QMap<QString, qreal> > operator[](int i) const;
+  QMap<QString, QMap<QString, qreal> > first() const;
+  QVector<QMap<QString, QMap<QString, qreal> > > toVector() const;
+
+ private:
+  struct EdgeUpdate
+  {
+    int fSpk;
+    int sSpk;
+    qreal weight;
+    bool removed;
+  };
+
+  void applyUpdates(QMap<QString, QMap<QString, qreal> > &snapshot, int i) const;
+  void addEmptyRows(QMap<QString, QMap<QString, qreal> > &snapshot, int i) const;
+
+  int m_checkpointStep;
+  SpeakerDictionary m_speakers;
+
+  // updates leading from snapshot i-1 to snapshot i
+  QVector<EdgeUpdate> m_updates;
+  QVector<int> m_updatePtr;
+
+  // speakers of snapshot i without any interlocutor
+  QVector<int> m_emptyRows;
+  QVector<int> m_emptyRowPtr;
+
+  // full snapshots every m_checkpointStep scenes
+  QVector<InteractionMatrix> m_checkpoints;
+
+  // last snapshot appended, updates being computed against it
+  InteractionMatrix m_last;
+};
+
+#endif
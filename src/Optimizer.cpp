@@ -1,182 +1,113 @@
 #include <time.h>
 #include <stdlib.h>
 
+#include <algorithm>
+#include <queue>
+
+#include <QThread>
+#include <QElapsedTimer>
+
 #include "Optimizer.h"
 
 using namespace std;
 using namespace arma;
 
 #include "DendogramNode.h"
+#include "HacEngine.h"
+
+// minimum number of candidate nodes evaluated by each thread
+static const int MinBlockNodes = 128;
+
+// minimum decrease of the p-median objective for a swap to be applied
+static const double SwapEpsilon = 1e-10;
+
+class SwapEvalThread: public QThread
+{
+ public:
+  SwapEvalThread(const mat &D, const QVector<int> &centers, const QVector<bool> &isCenter, const QVector<int> &c1, const vec &d1, const vec &d2, int first, int last)
+    : m_D(D), m_centers(centers), m_isCenter(isCenter), m_c1(c1), m_d1(d1), m_d2(d2), m_first(first), m_last(last) {}
+
+  Optimizer::Swap getBest() const { return m_best; }
+
+ protected:
+  void run() { Optimizer::evalSwaps(m_D, m_centers, m_isCenter, m_c1, m_d1, m_d2, m_first, m_last, m_best); }
+
+ private:
+  const mat &m_D;
+  const QVector<int> &m_centers;
+  const QVector<bool> &m_isCenter;
+  const QVector<int> &m_c1;
+  const vec &m_d1;
+  const vec &m_d2;
+  int m_first;
+  int m_last;
+  Optimizer::Swap m_best;
+};
 
 Optimizer::Optimizer(QWidget *parent)
-  : QWidget(parent)
+  : QWidget(parent),
+    m_solverMode(Exact),
+    m_nThreads(1),
+    m_storylineOrderer(0),
+    m_orderingTimeLimit(1.0)
 {
 }
 
-Dendogram * Optimizer::hierarchicalClustering(arma::mat D, bool temporalCst)
+Optimizer::~Optimizer()
 {
-  Dendogram *dendo = new Dendogram;
-  dendo->setDistMat(D);
-
-  qreal d(0.0);         // minimum distance in distance matrix
-  mat N;                // updated distance from new cluster
-  mat M;                // updated distance from new cluster
-  uword toMerge1(0);
-  uword toMerge2(0);    // indices of the closest two instances
-  uword iMin, iMax;     // min and max indices of the instances to merge
-
-  // set diagonal to +Inf
-  for (uword i(0); i < D.n_rows; i++)
-    D(i, i) = datum::inf;
+  delete m_storylineOrderer;
+}
 
-  // stop condition
-  umat F = arma::find(D != datum::inf);
+void Optimizer::setSolverMode(SolverMode solverMode, int nThreads)
+{
+  m_solverMode = solverMode;
+  m_nThreads = (nThreads <= 0) ? QThread::idealThreadCount() : nThreads;
+}
 
-  // initializing list of clusters
-  QList<DendogramNode *> clusters;
-  for (uword i(0); i < D.n_rows; i++)
-    clusters.push_back(new DendogramNode(0.0, 1.0, i));
-  
-  while (!F.is_empty()) {
-
-    // retrieving indices of the closest two instances
-    if (temporalCst) {
-      d = datum::inf;
-      for (uword i(0); i < D.n_rows - 1; i++)
-	if (D(i, i + 1) < d) {
-	  toMerge1 = i;
-	  toMerge2 = i + 1;
-	  d = arma::as_scalar(D(i, i + 1));
-	}
-    }
-    else
-      d = D.min(toMerge1, toMerge2);
+Optimizer::SolverMode Optimizer::getSolverMode() const
+{
+  return m_solverMode;
+}
 
-    // ordering the indices of instances to merge for deleting purpose
-    if (toMerge1 < toMerge2) {
-      iMin = toMerge1;
-      iMax = toMerge2;
-    }
-    else {
-      iMin = toMerge2;
-      iMax = toMerge1;
-    }
+int Optimizer::getNThreads() const
+{
+  return m_nThreads;
+}
 
-    // creation of the new cluster
-    DendogramNode *newCluster = new DendogramNode(d, 0.0, -1, clusters[iMin], clusters[iMax]);
-  
-    // re-estimating distances from cluster of agregated instances
-    N = updateDistances(clusters, clusters[iMin], clusters[iMax], iMin, iMax, D, Ward);
-  
-    // updating list of clusters
-    clusters.removeAt(iMax);
-    clusters.removeAt(iMin);
+void Optimizer::setOrderingTimeLimit(qreal timeLimit)
+{
+  m_orderingTimeLimit = timeLimit;
 
-    // compute median values for current clusters
-    QList<int> clusterMedians = computeClusterMedians(clusters);
+  if (m_storylineOrderer)
+    m_storylineOrderer->setTimeLimit(timeLimit);
+}
 
-    // compute median value for new cluster
-    QList<DendogramNode *> newClusterAsList = {newCluster};
-    QList<int> newClusterMedian = computeClusterMedians(newClusterAsList);
+Dendogram * Optimizer::hierarchicalClustering(arma::mat D, bool temporalCst)
+{
+  Dendogram *dendo = new Dendogram;
+  dendo->setDistMat(D);
 
-    // index of insertion of new cluster
-    int iInsert(0);
-    while (iInsert < clusterMedians.size() && newClusterMedian.first() > clusterMedians[iInsert])
-      iInsert++;
+  // Ward criterion, clusters ordered by median instance
+  HacEngine<WardLinkage> hac(HacEngine<WardLinkage>::Median, temporalCst);
+  hac.run(D, ones<mat>(D.n_rows, 1));
 
-    // qDebug() << clusterMedians << "*" << newClusterMedian << "*" << iInsert;
+  QVector<HacMerge> merges = hac.getMerges();
+  QVector<int> clusters = hac.getClusters();
 
-    clusters.insert(iInsert, newCluster);
+  // building tree from merge table
+  QVector<DendogramNode *> nodes;
+  for (uword i(0); i < D.n_rows; i++)
+    nodes.push_back(new DendogramNode(0.0, 1.0, i));
 
-    // qDebug();
-    // cout << D;
-      
-    // qDebug() << "(" << iMin << "," << iMax << ")";
-    // displayClusters(clusters);
-    // qDebug();
-
-    // updating distance matrix
-    D.shed_row(iMax);
-    D.shed_col(iMax);
-    D.shed_row(iMin);
-    D.shed_col(iMin);
-    D.insert_cols(iInsert, N);
-    mat T;
-    T << datum::inf;
-    N.insert_rows(iInsert, T);
-    D.insert_rows(iInsert, N.t());
-
-    // updating flag
-    F = arma::find(D != datum::inf);
-  }
+  for (int i(0); i < merges.size(); i++)
+    nodes.push_back(new DendogramNode(merges[i].dist, 0.0, -1, nodes[merges[i].left], nodes[merges[i].right]));
   
-  dendo->setRoot(clusters.first());
+  dendo->setRoot(nodes[clusters.first()]);
   dendo->setBestCutValue();
 
   return dendo;
 }
 
-arma::vec Optimizer::updateDistances(QList<DendogramNode *> clusters, DendogramNode *merged1, DendogramNode *merged2, uword iMin, uword iMax, const mat &D, AgrCrit agr)
-{
-  // updated distances from new cluster
-  mat N;
-  N.zeros(clusters.size());
-
-  // weights of merged clusters and new cluster
-  qreal weight1(computeWeight(merged1));
-  qreal weight2(computeWeight(merged2));
-  qreal totWeight = weight1 + weight2;
-
-  // weight of current cluster
-  qreal currWeight;
-
-  // coefficients of Lance-Wiliams formula
-  qreal alpha1(0.0), alpha2(0.0), beta(0.0), gamma(0.0);
-
-  // initializing coefficients in case of min/max/mean criteria
-  switch (agr) {
-  case Min:
-    alpha2 = alpha1 = 1.0 / 2.0;
-    gamma = - 1.0 / 2.0;
-    break;
-  case Max:
-    alpha2 = alpha1 = 1.0 / 2.0;
-    gamma = 1.0 / 2.0;
-    break;
-  case Mean:
-    alpha1 = weight1 / totWeight;
-    alpha2 = weight2 / totWeight;
-    break;
-  case Ward:
-    break;
-  }
-  
-  // looping over clusters
-  for (uword i(0); i < static_cast<uword>(clusters.size()); i++)
-
-    if (i != iMin && i != iMax) {
-
-      // initializing coefficients in case of ward criterion
-      if (agr == Ward) {
-	currWeight = computeWeight(clusters[i]);
-	alpha1 = (currWeight + weight1) / (currWeight + totWeight);
-	alpha2 = (currWeight + weight2) / (currWeight + totWeight);
-	beta = - currWeight / (currWeight + totWeight);
-      }
-     
-      N(i) = alpha1 * D(iMin, i) + alpha2 * D(iMax, i) + beta * D(iMin, iMax) + gamma * qAbs(D(iMin, i) - D(iMax, i));
-
-      if (!is_finite(N.row(i)))
-	N(i) = datum::inf;
-    }
-
-  // removing rows corresponding to clustered instances
-  N.shed_row(iMax);
-  N.shed_row(iMin);
-
-  return N;
-}
-
 qreal Optimizer::computeWeight(DendogramNode *node)
 {
   if (node == nullptr)
@@ -197,26 +128,6 @@ void Optimizer::displayClusters(QList<DendogramNode *> clusters)
   }
 }
 
-QList<int> Optimizer::computeClusterMedians(QList<DendogramNode *> clusters)
-{
-  QList<int> means;
-
-  for (int i(0); i < clusters.size(); i++) {
-    
-    QList<DendogramNode *> instances;
-    getClusterInstances(clusters[i], instances);
-    
-    arma::uvec U(instances.size());
-    
-    for (int j(0); j < instances.size(); j++)
-      U(j) = instances[j]->getLabel();
-
-    means.push_back(median(U));
-  }
-
-  return means;
-}
-
 void Optimizer::getClusterInstances(DendogramNode *node, QList<DendogramNode *> &instances)
 {
   if (node != nullptr) {
@@ -425,6 +336,9 @@ QMap<QString, QString> Optimizer::optimalMatching(QList<QString> &nodeLabels_1,
 
 int Optimizer::setCovering(arma::umat &A, QList<QList<int> > &partition, QList<int> &cIdx)
 {
+  if (m_solverMode == Heuristic)
+    return setCovering_greedy(A, partition, cIdx);
+
   int n(A.n_rows);                  // number of variables
   int nCenters(0);
 
@@ -515,6 +429,9 @@ int Optimizer::setCovering(arma::umat &A, QList<QList<int> > &partition, QList<i
 
 qreal Optimizer::pCenter(int p, arma::mat &D, QList<QList<int> > &partition, QList<int> &cIdx)
 {
+  if (m_solverMode == Heuristic)
+    return pCenter_heur(p, D, partition, cIdx);
+
   int n(D.n_rows);                  // number of nodes
   qreal covDist(-1.0);
 
@@ -718,6 +635,9 @@ qreal Optimizer::pCenterOptP(arma::mat &D, QList<QList<int> > &partition, QList<
 
 qreal Optimizer::pMedian(int p, arma::mat &D, QList<QList<int> > &partition, QList<int> &cIdx)
 {
+  if (m_solverMode == Heuristic)
+    return pMedian_heur(p, D, partition, cIdx);
+
   int n(D.n_rows);                     // number of instances
   IloNum objValue(-1.0);               // objective value
   IloEnv env;
@@ -845,6 +765,221 @@ qreal Optimizer::pMedian(int p, arma::mat &D, QList<QList<int> > &partition, QLi
   return objValue / n;
 }
 
+int Optimizer::setCovering_greedy(const arma::umat &A, QList<QList<int> > &partition, QList<int> &cIdx, int maxCenters)
+{
+  int n(A.n_rows);                  // number of demand nodes
+  int m(A.n_cols);                  // number of supply nodes
+  int nCovered(0);
+  QList<int> centers;
+  QVector<bool> covered(n, false);
+
+  // number of uncovered demand nodes covered by each supply node
+  QVector<int> count(m, 0);
+  for (int j(0); j < m; j++)
+    count[j] = arma::accu(A.col(j));
+
+  while (nCovered < n) {
+
+    // supply node covering the most uncovered demand nodes,
+    // first one in case of ties
+    int best(0);
+    for (int j(1); j < m; j++)
+      if (count[j] > count[best])
+	best = j;
+
+    // remaining demand nodes cannot be covered
+    if (m == 0 || count[best] == 0)
+      return -1;
+
+    centers.push_back(best);
+
+    // too many centers: no need to go further
+    if (maxCenters >= 0 && centers.size() > maxCenters)
+      return centers.size();
+
+    for (int i(0); i < n; i++)
+      if (A(i, best) && !covered[i]) {
+	covered[i] = true;
+	nCovered++;
+
+	for (int j(0); j < m; j++)
+	  if (A(i, j))
+	    count[j]--;
+      }
+  }
+
+  // centers listed by index as with the exact model
+  std::sort(centers.begin(), centers.end());
+
+  for (int i(0); i < centers.size(); i++) {
+
+    cIdx.push_back(centers[i]);
+    arma::uvec idx = arma::find(A.col(centers[i]));
+    QList<int> part;
+    for (arma::uword j(0); j < idx.n_elem; j++)
+      part.push_back(idx(j));
+
+    partition.push_back(part);
+  }
+
+  return centers.size();
+}
+
+qreal Optimizer::pCenter_heur(int p, const arma::mat &D, QList<QList<int> > &partition, QList<int> &cIdx)
+{
+  int n(D.n_rows);                  // number of nodes
+
+  partition.clear();
+  cIdx.clear();
+
+  if (n == 0 || p <= 0)
+    return -1.0;
+
+  p = qMin(p, n);
+
+  // candidate coverage distances, sorted
+  arma::vec radii = arma::unique(arma::vectorise(D));
+  radii = radii.elem(arma::find_finite(radii));
+
+  QList<QList<int> > cover;
+  QList<int> centers;
+
+  if (radii.n_elem > 0) {
+
+    // smallest coverage distance for which the greedy covering needs
+    // at most p centers: the largest one is normally covered by a
+    // single center
+    arma::uword lBound(0);
+    arma::uword uBound(radii.n_elem - 1);
+
+    arma::umat A = D <= radii(uBound);
+    setCovering_greedy(A, cover, centers, p);
+
+    while (lBound < uBound) {
+
+      arma::uword mid = (lBound + uBound) / 2;
+      QList<QList<int> > currCover;
+      QList<int> currCenters;
+
+      A = D <= radii(mid);
+      int currP = setCovering_greedy(A, currCover, currCenters, p);
+
+      if (currP >= 0 && currP <= p) {
+	uBound = mid;
+	centers = currCenters;
+      }
+      else
+	lBound = mid + 1;
+    }
+  }
+
+  // less than p centers: farthest nodes from current centers are
+  // added, which does not increase the coverage distance
+  arma::vec dist(n);
+  dist.fill(arma::datum::inf);
+  QVector<bool> isCenter(n, false);
+
+  for (int i(0); i < centers.size(); i++) {
+    isCenter[centers[i]] = true;
+    for (int j(0); j < n; j++)
+      dist(j) = qMin(dist(j), D(j, centers[i]));
+  }
+
+  while (centers.size() < p) {
+
+    int farthest(-1);
+    for (int j(0); j < n; j++)
+      if (!isCenter[j] && (farthest == -1 || dist(j) > dist(farthest)))
+	farthest = j;
+
+    centers.push_back(farthest);
+    isCenter[farthest] = true;
+
+    for (int j(0); j < n; j++)
+      dist(j) = qMin(dist(j), D(j, farthest));
+  }
+
+  // each node allocated to its nearest center
+  cIdx = centers;
+  assignNearest(D, cIdx, partition, dist);
+
+  return dist.max();
+}
+
+qreal Optimizer::pMedian_heur(int p, const arma::mat &D, QList<QList<int> > &partition, QList<int> &cIdx)
+{
+  int n(D.n_rows);                  // number of nodes
+
+  partition.clear();
+  cIdx.clear();
+
+  if (n == 0 || p <= 0)
+    return -1.0;
+
+  p = qMin(p, n);
+
+  QVector<int> centers;
+  QVector<bool> isCenter(n, false);
+  arma::vec d1(n);
+  d1.fill(arma::datum::inf);
+
+  // greedy initialization: the center added at each step is the one
+  // that decreases the most the sum of distances to nearest centers
+  for (int k(0); k < p; k++) {
+
+    int best(-1);
+    double bestCost(arma::datum::inf);
+
+    for (int j(0); j < n; j++)
+
+      if (!isCenter[j]) {
+
+	const double *col = D.colptr(j);
+	double cost(0.0);
+
+	for (int i(0); i < n; i++)
+	  cost += qMin(d1(i), col[i]);
+
+	if (best == -1 || cost < bestCost) {
+	  best = j;
+	  bestCost = cost;
+	}
+      }
+
+    centers.push_back(best);
+    isCenter[best] = true;
+
+    for (int i(0); i < n; i++)
+      d1(i) = qMin(d1(i), D(i, best));
+  }
+
+  // interchange: the best swap between a center and another node is
+  // applied until none decreases the sum of distances
+  QVector<int> c1;
+  arma::vec d2;
+  nearestCenters(D, centers, c1, d1, d2);
+
+  while (true) {
+
+    Swap swap = findBestSwap(D, centers, isCenter, c1, d1, d2);
+
+    if (swap.in == -1 || !(swap.delta < -SwapEpsilon))
+      break;
+
+    centers[centers.indexOf(swap.out)] = swap.in;
+    isCenter[swap.out] = false;
+    isCenter[swap.in] = true;
+
+    nearestCenters(D, centers, c1, d1, d2);
+  }
+
+  // each node allocated to its nearest center
+  cIdx = centers.toList();
+  assignNearest(D, cIdx, partition, d1);
+
+  return arma::accu(d1) / n;
+}
+
 qreal Optimizer::coClusterOptMatch(int p, arma::mat D, QList<QList<int> > &shotPartition, QList<int> &shotCIdx, arma::mat A, int pp, arma::mat DP, QList<QList<int> > &utterPartition, QList<int> &utterCIdx, QMap<int, QList<int> > &mapping, qreal lambda)
 {
   int n(A.n_rows);                  // number of shots
@@ -1400,111 +1535,37 @@ qreal Optimizer::orderStorylines(QVector<int> &pos, const arma::mat &A, const QV
   // number of nodes (speakers)
   int n = A.n_rows;
 
-  // maximum x coordinate
-  int max(n - 1);
-
-  // optimal value
-  qreal objValue(-1.0);
-
-  // permutation to return
-  pos.resize(n);
+  // previous permutation used as a MIP start
+  QVector<QVector<int> > startPos;
 
-  IloEnv env;
-
-  try {
-    IloModel model(env);
-      
-    // var x[i]: rank assigned to i-th speaker
-    IloIntVarArray x(env);
+  if (prevPos.size() == n)
     for (int i(0); i < n; i++)
-      x.add(IloIntVar(env, 0, max));
+      startPos.push_back(QVector<int>(1, prevPos[i]));
 
-    // coefficient a[i][j]: weight of edge linking node i and node j
-    IloArray<IloNumArray> a(env);
-    for (int i(0); i < n; i++) {
-      IloNumArray tmp(env);
-      for (int j(0); j < n; j++) {
-	tmp.add(A(i, j));
-      }
-      a.add(tmp);
-    }
+  QVector<QVector<int> > snapshotPos;
+  qreal objValue = getStorylineOrderer()->order(snapshotPos, A, QVector<QVector<int> >(), startPos, 0.0);
 
-    // d[i][j] = |x[i] - x[j]|: additional variables used to linearize objective
-    IloArray<IloIntVarArray> d(env);
-    for (int i(0); i < n; i++) {
-      IloIntVarArray tmp(env);
-      for (int j(0); j < n; j++)
-	tmp.add(IloIntVar(env, 0, max));
-      d.add(tmp);
-    }
+  // permutation to return
+  pos.resize(n);
+  for (int i(0); i < n; i++)
+    pos[i] = snapshotPos[i][0];
 
-    // objective function
-    IloExpr obj(env);
-    
-    for (int i(0); i < n; i++)
-      for (int j(0); j < n; j++)
-	obj += a[i][j] * d[i][j];
+  // time limit reached: barycenter ordering kept if better
+  if (!m_storylineOrderer->isOptimal()) {
 
-    model.add(IloMinimize(env, obj));
+    QVector<int> baryPos = barycenterOrdering(A, prevPos);
 
-    // linearization constraints
     for (int i(0); i < n; i++)
-      for (int j(0); j < n; j++) {
-	IloConstraint c1(d[i][j] >= x[i] - x[j]);
-	IloConstraint c2(d[i][j] >= x[j] - x[i]);
-	model.add(c1);
-	model.add(c2);
-      }
-    
-    // all different constraints
-    for (int i(0); i < n - 1; i++)
-      for (int j(i+1); j < n; j++) {
-	IloConstraint c3(x[i] != x[j]);
-	model.add(c3);
-      }
+      snapshotPos[i][0] = baryPos[i];
 
-    // solve model
-    IloCplex cplex(model);
+    qreal baryValue = storylineCost(snapshotPos, A, 0.0);
 
-    // no output in terminal
-    // cplex.setOut(env.getNullStream());
-
-    // solve model
-    if (!cplex.solve()) {
-      env.error() << "Failed to optimize LP." << endl;
-      throw(-1);
-    }
-
-    // solution features
-    env.out() << "Solution status = " << cplex.getStatus() << endl;
-    env.out() << "Solution value = " << cplex.getObjValue() << endl;
-    objValue = cplex.getObjValue();
-
-    // retrieve distances
-    for (int i(0); i < n; i++) {
-      IloNumArray dVals(env);
-      cplex.getValues(dVals, d[i]);
-      // cout << dVals << endl;
+    if (objValue < 0.0 || baryValue < objValue) {
+      pos = baryPos;
+      objValue = baryValue;
     }
-
-    // retrieve optimal solution
-    IloNumArray xVals(env);
-    cplex.getValues(xVals, x);
-
-    for (int i(0); i < n; i++)
-      pos[i] = xVals[i];
   }
 
-  catch (IloException &e) {
-    cerr << "Concert exception caught: " << e << endl;
-  }
-    
-  catch (...) {
-    cerr << "Unknown exception caught: " << endl;
-  }
-
-  env.end();
-
   return objValue;
 }
 
@@ -1514,167 +1575,36 @@ qreal Optimizer::orderStorylines_global(QVector<QVector<int> > &pos, const arma:
   int n = W.n_rows;
 
   // number of snapshots
-  int T = W.n_cols / n;
+  int T = (n > 0) ? W.n_cols / n : 0;
 
-  // maximum x coordinate
-  int max(n - 1);
+  // ranks in prevPos are fixed; previous solution used as a MIP start
+  qreal objValue = getStorylineOrderer()->order(pos, W, prevPos, QVector<QVector<int> >(), alpha);
 
-  // optimal value
-  qreal objValue(-1.0);
+  if (objValue >= 0.0 || n == 0)
+    return objValue;
 
-  // sequence of permutation to return
-  pos.resize(n);
-  for (int i(0); i < n; i++)
-    pos[i] = QVector<int>(T, -1);
-
-  IloEnv env;
-
-  try {
-    IloModel model(env);
-      
-    // var x[i][t]: rank assigned to i-th speaker at scene t
-    IloArray<IloIntVarArray> x(env);
-    for (int i(0); i < n; i++) {
-      IloIntVarArray tmp(env);
-      for (int t(0); t < T; t++)
-	tmp.add(IloIntVar(env, 0, max));
-      x.add(tmp);
-    }
-
-    // coefficient a[i][j][t]: weight of edge linking node i and node j at scene t
-    IloArray<IloArray<IloNumArray> > a(env);
-    for (int i(0); i < n; i++) {
-      IloArray<IloNumArray> tmp1(env);
-      for (int j(0); j < n; j++) {
-	IloNumArray tmp2(env);
-	for (int t(0); t < T; t++) {
-	  arma::mat A = W.submat(0, t * n, n - 1, (t + 1) * n - 1);
-	  tmp2.add(A(i, j));
-	}
-	tmp1.add(tmp2);
-      }
-      a.add(tmp1);
-    }
-
-    // d[i][j][t] = |x[i][t] - x[j][t]|: additional variables used to linearize objective
-    IloArray<IloArray<IloIntVarArray> > d(env);
-    for (int i(0); i < n; i++) {
-      IloArray<IloIntVarArray> tmp1(env);
-      for (int j(0); j < n; j++) {
-	IloIntVarArray tmp2(env);
-	for (int t(0); t < T; t++)
-	  tmp2.add(IloIntVar(env, 0, max));
-	tmp1.add(tmp2);
-      }
-      d.add(tmp1);
-    }
+  // no solution within time limit: snapshots ordered one after the
+  // other with the barycenter heuristic, unless ranks are all fixed
+  QVector<int> currPos;
 
-    // u[i][t] = |x[i][t] - x[i][t+1]|: additional variables used to linearize objective
-    IloArray<IloIntVarArray> u(env);
-    for (int i(0); i < n; i++) {
-      IloIntVarArray tmp(env);
-      for (int t(0); t < T - 1; t++)
-	tmp.add(IloIntVar(env, 0, max));
-      u.add(tmp);
-    }
-
-    // objective function
-    IloExpr obj1(env);
-    for (int i(0); i < n; i++)
-      for (int j(0); j < n; j++)
-	for (int t(0); t < T; t++)
-	  obj1 += a[i][j][t] * d[i][j][t];
+  for (int t(0); t < T; t++) {
 
-    IloExpr obj2(env);
-    for (int i(0); i < n; i++)
-      for (int t(0); t < T - 1; t++)
-	obj2 += u[i][t];
+    QVector<int> fixedPos;
 
-    IloExpr obj = (1.0 - alpha) * obj1 + alpha * obj2;
-    model.add(IloMinimize(env, obj));
+    for (int i(0); i < prevPos.size() && i < n; i++)
+      if (t < prevPos[i].size())
+	fixedPos.push_back(prevPos[i][t]);
 
-    // linearization constraints
-    for (int i(0); i < n; i++)
-      for (int j(0); j < n; j++)
-	for (int t(0); t < T; t++) {
-	  IloConstraint c1(d[i][j][t] >= x[i][t] - x[j][t]);
-	  IloConstraint c2(d[i][j][t] >= x[j][t] - x[i][t]);
-	  model.add(c1);
-	  model.add(c2);
-	}
+    if (fixedPos.size() == n)
+      currPos = fixedPos;
+    else
+      currPos = barycenterOrdering(W.cols(t * n, (t + 1) * n - 1), currPos);
 
     for (int i(0); i < n; i++)
-      for (int t(0); t < T - 1; t++) {
-	IloConstraint c3(u[i][t] >= x[i][t] - x[i][t+1]);
-	IloConstraint c4(u[i][t] >= x[i][t+1] - x[i][t]);
-	model.add(c3);
-	model.add(c4);
-      }
-    
-    // all different at scene t constraints
-    for (int t(0); t < T; t++)
-      for (int i(0); i < n - 1; i++)
-	for (int j(i+1); j < n; j++) {
-	  IloConstraint c5(x[i][t] != x[j][t]);
-	  model.add(c5);
-	}
-
-    // set x[i][t] variables
-    for (int i(0); i < prevPos.size(); i++)
-      for (int t(0); t < prevPos[i].size(); t++) {
-	IloConstraint c6(x[i][t] == prevPos[i][t]);
-	model.add(c6);
-      }
-
-    // solve model
-    IloCplex cplex(model);
-
-    // no output in terminal
-    // cplex.setOut(env.getNullStream());
-
-    // solve model
-    if (!cplex.solve()) {
-      env.error() << "Failed to optimize LP." << endl;
-      throw(-1);
-    }
-
-    // solution features
-    env.out() << "Solution status = " << cplex.getStatus() << endl;
-    env.out() << "Solution value = " << cplex.getObjValue() << endl;
-    objValue = cplex.getObjValue();
-    
-    // retrieve distances
-    /*
-    for (int i(0); i < n; i++) {
-      for (int j(0); j < n; j++) {
-	IloNumArray dVals(env);
-	cplex.getValues(dVals, d[i][j]);
-	for (int t(0); t < T; t++)
-	  qDebug() << i << j << t << ":" << dVals[t] << endl;
-      }
-    }
-    */
-
-    // retrieve optimal solution
-    for (int i(0); i < n; i++) {
-      IloNumArray xVals(env);
-      cplex.getValues(xVals, x[i]);
-      for (int t(0); t < T; t++)
-	pos[i][t] = xVals[t];
-    } 
-  }
-
-  catch (IloException &e) {
-    cerr << "Concert exception caught: " << e << endl;
-  }
-    
-  catch (...) {
-    cerr << "Unknown exception caught: " << endl;
+      pos[i][t] = currPos[i];
   }
 
-  env.end();
-
-  return objValue;
+  return storylineCost(pos, W, alpha);
 }
 
 qreal Optimizer::knapsack(const arma::vec &PV, const arma::vec &WV, const arma::mat &FR, const arma::mat &SD, qreal W, QList<int> &selected)
@@ -1998,6 +1928,192 @@ qreal Optimizer::mmr(arma::vec PV, const arma::vec &WV, const arma::mat &FR, con
   return objValue;
 }
 
+qreal Optimizer::ratioGreedy(const arma::vec &PV, const arma::vec &WV, const arma::mat &FR, const arma::mat &SR, qreal W, QList<int> &selected)
+{
+  int n(PV.n_rows);                  // number of elements
+  qreal capacity(W);
+
+  // marginal gain of element k: PV(k) + SR(k, k) + sum of SR(k, j) + SR(j, k)
+  // over selected elements j
+  QVector<qreal> gains(n);
+  QVector<int> nAccounted(n, 0);     // selected elements accounted for in gains
+
+  for (int k(0); k < n; k++)
+    gains[k] = PV(k) + SR(k, k);
+
+  // gains only decrease with non-positive pairwise terms: once
+  // computed, they are upper bounds of later gains and are only
+  // updated when reaching the top of the queue; with positive terms,
+  // as the dissimilarity rewards of summaries, stale gains are not
+  // bounds any more and all of them are updated after each selection
+  arma::mat pairTerms = SR + SR.t();
+  pairTerms.diag().zeros();
+  bool lazy = (n == 0 || pairTerms.max() <= 0.0);
+
+  // elements ordered by (gain / weight) ratio, first ones in case of ties
+  std::priority_queue<QPair<qreal, int> > queue;
+
+  for (int k(0); k < n; k++)
+    queue.push(QPair<qreal, int>(gains[k] / WV(k), -k));
+
+  while (!queue.empty()) {
+
+    int k = -queue.top().second;
+    queue.pop();
+
+    // elements not feasible any more never become feasible again:
+    // capacity decreases and overlaps accumulate
+    if (!isFeasible(k, selected, WV, FR, W))
+      continue;
+
+    if (nAccounted[k] < selected.size()) {
+
+      for (int j(nAccounted[k]); j < selected.size(); j++)
+	gains[k] += SR(k, selected[j]) + SR(selected[j], k);
+
+      nAccounted[k] = selected.size();
+      queue.push(QPair<qreal, int>(gains[k] / WV(k), -k));
+      continue;
+    }
+
+    // no more improvement
+    if (gains[k] <= 0.0)
+      break;
+
+    selected.push_back(k);
+    W -= WV(k);
+
+    // otherwise all gains are updated before the next selection
+    if (!lazy) {
+
+      std::priority_queue<QPair<qreal, int> > updated;
+
+      while (!queue.empty()) {
+
+	int l = -queue.top().second;
+	queue.pop();
+
+	for (int j(nAccounted[l]); j < selected.size(); j++)
+	  gains[l] += SR(l, selected[j]) + SR(selected[j], l);
+
+	nAccounted[l] = selected.size();
+	updated.push(QPair<qreal, int>(gains[l] / WV(l), -l));
+      }
+
+      queue = updated;
+    }
+  }
+
+  // single best element kept instead if better, as usual with
+  // budgeted greedy selection
+  qreal objValue = selectionValue(selected, PV, SR);
+  int best(-1);
+
+  for (int k(0); k < n; k++)
+    if (WV(k) <= capacity && PV(k) + SR(k, k) > objValue && (best == -1 || PV(k) + SR(k, k) > PV(best) + SR(best, best)))
+      best = k;
+
+  if (best != -1) {
+    selected.clear();
+    selected.push_back(best);
+    objValue = PV(best) + SR(best, best);
+  }
+
+  std::sort(selected.begin(), selected.end());
+
+  return objValue;
+}
+
+qreal Optimizer::selectionValue(const QList<int> &selected, const arma::vec &PV, const arma::mat &SR) const
+{
+  qreal value(0.0);
+
+  // same objective as the exact model
+  for (int i(0); i < selected.size(); i++) {
+
+    value += PV(selected[i]);
+
+    for (int j(0); j < selected.size(); j++)
+      value += SR(selected[i], selected[j]);
+  }
+
+  return value;
+}
+
+void Optimizer::benchmarkSelection(const QList<int> &sizes, int maxExactSize)
+{
+  QElapsedTimer timer;
+  arma::arma_rng::set_seed(0);
+
+  qDebug() << "elements" << "pairwise" << "exact" << "time (s)" << "ratio greedy" << "time (s)" << "ratio" << "mmr" << "time (s)" << "ratio";
+
+  for (int i(0); i < sizes.size(); i++) {
+
+    int n(sizes[i]);
+
+    // random costs, durations from 5 to 60 seconds and budget of
+    // a tenth of the total duration
+    arma::vec PV(n, arma::fill::randu);
+    arma::vec WV = 5.0 + 55.0 * arma::randu<arma::vec>(n);
+    qreal W = 0.1 * arma::accu(WV);
+
+    // overlaps between some successive elements
+    arma::mat FR(n, n, arma::fill::zeros);
+    for (int k(0); k < n - 1; k++)
+      if (arma::as_scalar(arma::randu<arma::vec>(1)) < 0.2) {
+	FR(k, k + 1) = 1.0;
+	FR(k + 1, k) = 1.0;
+      }
+
+    // pairwise terms: dissimilarity reward as in summaries, then
+    // redundancy penalty
+    arma::mat X(n, 10, arma::fill::randu);
+    arma::mat G = X * X.t();
+    arma::vec norms = G.diag();
+    arma::mat SD = arma::sqrt(arma::clamp(arma::repmat(norms, 1, n) + arma::repmat(norms.t(), n, 1) - 2.0 * G, 0.0, arma::datum::inf));
+    SD /= SD.max();
+
+    for (int j(0); j < 2; j++) {
+
+      arma::mat SR = (j == 0) ? 0.05 * SD : -0.05 * (1.0 - SD);
+      SR.diag().zeros();
+
+      QList<int> exactSel;
+      qint64 exactTime(-1);
+      qreal exactValue(-1.0);
+
+      if (n <= maxExactSize) {
+	timer.start();
+	knapsack(PV, WV, FR, SR, W, exactSel);
+	exactTime = timer.nsecsElapsed();
+	exactValue = selectionValue(exactSel, PV, SR);
+      }
+
+      QList<int> ratioSel;
+      timer.start();
+      ratioGreedy(PV, WV, FR, SR, W, ratioSel);
+      qint64 ratioTime = timer.nsecsElapsed();
+      qreal ratioValue = selectionValue(ratioSel, PV, SR);
+
+      QList<int> mmrSel;
+      timer.start();
+      mmr(PV, WV, FR, SR, W, mmrSel);
+      qint64 mmrTime = timer.nsecsElapsed();
+      qreal mmrValue = selectionValue(mmrSel, PV, SR);
+
+      qDebug() << n << ((j == 0) ? "dissimilarity" : "redundancy")
+	       << (exactTime >= 0 ? QString::number(exactValue, 'f', 4) : QString("-"))
+	       << (exactTime >= 0 ? QString::number(exactTime / 1e9, 'f', 3) : QString("-"))
+	       << QString::number(ratioValue, 'f', 4)
+	       << QString::number(ratioTime / 1e9, 'f', 3)
+	       << (exactValue > 0.0 ? QString::number(ratioValue / exactValue, 'f', 3) : QString("-"))
+	       << QString::number(mmrValue, 'f', 4)
+	       << QString::number(mmrTime / 1e9, 'f', 3)
+	       << (exactValue > 0.0 ? QString::number(mmrValue / exactValue, 'f', 3) : QString("-"));
+    }
+  }
+}
+
 void Optimizer::randomSelection(const arma::vec &WV, const arma::mat &FR, qreal W, QList<int> &selected)
 {
   // initialite random number generator
@@ -2121,3 +2237,188 @@ QVector<int> Optimizer::barycenterOrdering(const QStringList &speakers, const QM
   
   return pos;
 }
+
+void Optimizer::nearestCenters(const arma::mat &D, const QVector<int> &centers, QVector<int> &c1, arma::vec &d1, arma::vec &d2)
+{
+  int n(D.n_rows);
+
+  c1.fill(-1, n);
+  d1.set_size(n);
+  d1.fill(arma::datum::inf);
+  d2.set_size(n);
+  d2.fill(arma::datum::inf);
+
+  // nearest center and distances to the two nearest centers
+  for (int k(0); k < centers.size(); k++) {
+
+    const double *col = D.colptr(centers[k]);
+
+    for (int i(0); i < n; i++) {
+
+      if (c1[i] == -1 || col[i] < d1(i)) {
+	d2(i) = d1(i);
+	d1(i) = col[i];
+	c1[i] = centers[k];
+      }
+
+      else if (col[i] < d2(i))
+	d2(i) = col[i];
+    }
+  }
+}
+
+void Optimizer::evalSwaps(const arma::mat &D, const QVector<int> &centers, const QVector<bool> &isCenter, const QVector<int> &c1, const arma::vec &d1, const arma::vec &d2, int first, int last, Swap &best)
+{
+  int n(D.n_rows);
+
+  best.in = -1;
+  best.out = -1;
+  best.delta = arma::datum::inf;
+
+  // loss incurred by removing each center
+  arma::vec loss(n, arma::fill::zeros);
+
+  for (int j(first); j < last; j++) {
+
+    if (isCenter[j])
+      continue;
+
+    const double *col = D.colptr(j);
+    double gain(0.0);
+
+    for (int k(0); k < centers.size(); k++)
+      loss(centers[k]) = 0.0;
+
+    // nodes closer to the candidate move to it whatever center is
+    // removed; other ones only move if their nearest center is removed
+    for (int i(0); i < n; i++) {
+
+      if (col[i] < d1(i))
+	gain += d1(i) - col[i];
+      else
+	loss(c1[i]) += qMin(col[i], d2(i)) - d1(i);
+    }
+
+    for (int k(0); k < centers.size(); k++) {
+
+      double delta = loss(centers[k]) - gain;
+
+      if (best.in == -1 || delta < best.delta) {
+	best.in = j;
+	best.out = centers[k];
+	best.delta = delta;
+      }
+    }
+  }
+}
+
+Optimizer::Swap Optimizer::findBestSwap(const arma::mat &D, const QVector<int> &centers, const QVector<bool> &isCenter, const QVector<int> &c1, const arma::vec &d1, const arma::vec &d2)
+{
+  int n(D.n_rows);
+  int nThreads = qMax(1, qMin(m_nThreads, n / MinBlockNodes));
+  Swap best;
+
+  if (nThreads == 1) {
+    evalSwaps(D, centers, isCenter, c1, d1, d2, 0, n, best);
+    return best;
+  }
+
+  // blocks of candidate nodes evaluated in parallel
+  QList<SwapEvalThread *> threads;
+
+  for (int k(0); k < nThreads; k++) {
+    threads.push_back(new SwapEvalThread(D, centers, isCenter, c1, d1, d2, k * n / nThreads, (k + 1) * n / nThreads));
+    threads.last()->start();
+  }
+
+  // blocks are compared in order: same swap as with a single thread
+  best.in = -1;
+
+  for (int k(0); k < nThreads; k++) {
+
+    threads[k]->wait();
+    Swap blockBest = threads[k]->getBest();
+
+    if (blockBest.in != -1 && (best.in == -1 || blockBest.delta < best.delta))
+      best = blockBest;
+  }
+
+  qDeleteAll(threads);
+
+  return best;
+}
+
+void Optimizer::assignNearest(const arma::mat &D, QList<int> &cIdx, QList<QList<int> > &partition, arma::vec &dist)
+{
+  int n(D.n_rows);
+
+  // centers listed by index as with the exact models
+  std::sort(cIdx.begin(), cIdx.end());
+
+  partition.clear();
+  for (int k(0); k < cIdx.size(); k++)
+    partition.push_back(QList<int>());
+
+  dist.set_size(n);
+
+  // first center in case of ties
+  for (int i(0); i < n; i++) {
+
+    int best(-1);
+
+    for (int k(0); k < cIdx.size(); k++)
+      if (best == -1 || D(i, cIdx[k]) < dist(i)) {
+	best = k;
+	dist(i) = D(i, cIdx[k]);
+      }
+
+    partition[best].push_back(i);
+  }
+}
+
+StorylineOrderer * Optimizer::getStorylineOrderer()
+{
+  // model kept alive across successive orderings
+  if (!m_storylineOrderer) {
+    m_storylineOrderer = new StorylineOrderer;
+    m_storylineOrderer->setTimeLimit(m_orderingTimeLimit);
+  }
+
+  return m_storylineOrderer;
+}
+
+QVector<int> Optimizer::barycenterOrdering(const arma::mat &A, const QVector<int> &initPos)
+{
+  QStringList speakers;
+  QMap<QString, QMap<QString, qreal> > neighbors;
+
+  // speakers labelled by index
+  for (arma::uword i(0); i < A.n_rows; i++)
+    speakers.push_back(QString::number(i));
+
+  for (arma::uword i(0); i < A.n_rows; i++)
+    for (arma::uword j(0); j < A.n_cols; j++)
+      neighbors[speakers[i]][speakers[j]] = A(i, j);
+
+  return barycenterOrdering(speakers, neighbors, initPos);
+}
+
+qreal Optimizer::storylineCost(const QVector<QVector<int> > &pos, const arma::mat &W, qreal alpha) const
+{
+  int n = W.n_rows;
+  int T = (n > 0) ? W.n_cols / n : 0;
+  qreal crossCost(0.0);
+  qreal moveCost(0.0);
+
+  // same objective as the exact model
+  for (int t(0); t < T; t++)
+    for (int i(0); i < n; i++)
+      for (int j(0); j < n; j++)
+	crossCost += W(i, t * n + j) * qAbs(pos[i][t] - pos[j][t]);
+
+  for (int i(0); i < n; i++)
+    for (int t(0); t < T - 1; t++)
+      moveCost += qAbs(pos[i][t] - pos[i][t+1]);
+
+  return (1.0 - alpha) * crossCost + alpha * moveCost;
+}
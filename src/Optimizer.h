@@ -7,6 +7,7 @@
 #include <armadillo>
 
 #include "Dendogram.h"
+#include "StorylineOrderer.h"
 
 #include <QDebug>
 
@@ -19,13 +20,23 @@ class Optimizer: public QWidget
     Min, Max, Mean, Ward
   };
 
+  // p-center/p-median problems: exact CPLEX models or native
+  // heuristics, near-optimal and much faster on large instances
+  enum SolverMode {
+    Exact, Heuristic
+  };
+
   Optimizer(QWidget *parent = 0);
+  ~Optimizer();
+
+  void setSolverMode(SolverMode solverMode, int nThreads = 1);
+  SolverMode getSolverMode() const;
+  int getNThreads() const;
+  void setOrderingTimeLimit(qreal timeLimit);
 
   Dendogram * hierarchicalClustering(arma::mat D, bool temporalCst = false);
-  arma::vec updateDistances(QList<DendogramNode *> clusters, DendogramNode *merged1, DendogramNode *merged2, arma::uword iMin, arma::uword iMax, const arma::mat &D, AgrCrit agr);
   qreal computeWeight(DendogramNode *node);
   void displayClusters(QList<DendogramNode *> clusters);
-  QList<int> computeClusterMedians(QList<DendogramNode *> clusters);
   void getClusterInstances(DendogramNode *node, QList<DendogramNode *> &instances);
 
   qreal optimalMatching_bis(const arma::mat &A, QVector<int> &matching);
@@ -39,6 +50,10 @@ class Optimizer: public QWidget
 
  qreal pMedian(int p, arma::mat &D, QList<QList<int> > &partition, QList<int> &cIdx);
 
+ int setCovering_greedy(const arma::umat &A, QList<QList<int> > &partition, QList<int> &cIdx, int maxCenters = -1);
+ qreal pCenter_heur(int p, const arma::mat &D, QList<QList<int> > &partition, QList<int> &cIdx);
+ qreal pMedian_heur(int p, const arma::mat &D, QList<QList<int> > &partition, QList<int> &cIdx);
+
  qreal coClusterOptMatch(int p, arma::mat D, QList<QList<int> > &shotPartition, QList<int> &shotCIdx, arma::mat A, int pp, arma::mat DP, QList<QList<int> > &utterPartition, QList<int> &utterCIdx, QMap<int, QList<int> > &mapping, qreal lambda);
  qreal coClusterOptMatch_iter(int p, arma::mat D, QList<QList<int> > &shotPartition, QList<int> &shotCIdx, arma::mat A, int pp, arma::mat DP, QList<QList<int> > &utterPartition, QList<int> &utterCIdx, QMap<int, QList<int> > &mapping, qreal alpha);
 
@@ -49,6 +64,9 @@ class Optimizer: public QWidget
  qreal knapsack(const arma::vec &PV, const arma::vec &WV, const arma::mat &FR, const arma::mat &SR, qreal W, QList<int> &selected);
  qreal facilityLocation(const arma::vec &PV, const arma::vec &WV, const arma::mat &FR, const arma::mat &SR, qreal W, QList<int> &selected);
  qreal mmr(arma::vec PV, const arma::vec &WV, const arma::mat &FR, const arma::mat &SR, qreal W, QList<int> &selected);
+ qreal ratioGreedy(const arma::vec &PV, const arma::vec &WV, const arma::mat &FR, const arma::mat &SR, qreal W, QList<int> &selected);
+ qreal selectionValue(const QList<int> &selected, const arma::vec &PV, const arma::mat &SR) const;
+ void benchmarkSelection(const QList<int> &sizes, int maxExactSize = 60);
  void randomSelection(const arma::vec &WV, const arma::mat &FR, qreal W, QList<int> &selected);
  bool isFeasible(int idx, const QList<int> &selected, const arma::vec &WV, const arma::mat &FR, qreal W);
  QVector<QPair<qreal, int> > getRatios(const arma::vec &R);
@@ -58,6 +76,29 @@ class Optimizer: public QWidget
     signals:
       
     private:
+  // exchange of a center for a non-center node and resulting
+  // variation of the p-median objective
+  struct Swap {
+    int in;
+    int out;
+    double delta;
+  };
+
+  friend class SwapEvalThread;
+
+  static void nearestCenters(const arma::mat &D, const QVector<int> &centers, QVector<int> &c1, arma::vec &d1, arma::vec &d2);
+  static void evalSwaps(const arma::mat &D, const QVector<int> &centers, const QVector<bool> &isCenter, const QVector<int> &c1, const arma::vec &d1, const arma::vec &d2, int first, int last, Swap &best);
+  Swap findBestSwap(const arma::mat &D, const QVector<int> &centers, const QVector<bool> &isCenter, const QVector<int> &c1, const arma::vec &d1, const arma::vec &d2);
+  static void assignNearest(const arma::mat &D, QList<int> &cIdx, QList<QList<int> > &partition, arma::vec &dist);
+
+  StorylineOrderer * getStorylineOrderer();
+  QVector<int> barycenterOrdering(const arma::mat &A, const QVector<int> &initPos);
+  qreal storylineCost(const QVector<QVector<int> > &pos, const arma::mat &W, qreal alpha) const;
+
+  SolverMode m_solverMode;
+  int m_nThreads;
+  StorylineOrderer *m_storylineOrderer;
+  qreal m_orderingTimeLimit;
 };
 
 #endif
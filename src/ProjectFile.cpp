@@ -0,0 +1,700 @@
+#include <QVector>
+#include <QStringList>
+#include <QDebug>
+
+#include <cstring>
+
+#include "ProjectFile.h"
+#include "Face.h"
+
+// file signature
+static const char projectMagic[8] = {'T', 'V', 'S', 'P', 'R', 'O', 'J', '\0'};
+
+// tables start on 8-byte boundaries so that records can be read in place
+static quint64 align8(quint64 offset)
+{
+  return (offset + 7) & ~static_cast<quint64>(7);
+}
+
+// records [first, first + n) exist in a table of count records
+static bool inRange(quint64 first, quint64 n, quint64 count)
+{
+  return first <= count && n <= count - first;
+}
+
+/////////////////////////////////////////////////
+// table builder used when writing the project //
+/////////////////////////////////////////////////
+
+class ProjectFile::Writer
+{
+ public:
+  Writer(EpisodeAccess *access = 0)
+    : m_tables(NTables),
+      m_access(access)
+  {
+    // first string is the empty one
+    quint32 offset(0);
+    m_tables[StringOffsets].append(reinterpret_cast<const char *>(&offset), sizeof(offset));
+    intern(QString());
+  }
+
+  quint32 count(Table table) const
+  {
+    return m_tables[table].size() / recordSize(table);
+  }
+
+  template <typename T> quint32 append(Table table, const T &record)
+  {
+    quint32 idx(count(table));
+    m_tables[table].append(reinterpret_cast<const char *>(&record), sizeof(T));
+
+    return idx;
+  }
+
+  // slots filled once children records are known
+  template <typename T> quint32 reserve(Table table, int n)
+  {
+    quint32 first(count(table));
+    m_tables[table].append(QByteArray(n * sizeof(T), '\0'));
+
+    return first;
+  }
+
+  template <typename T> void set(Table table, quint32 idx, const T &record)
+  {
+    std::memcpy(m_tables[table].data() + idx * sizeof(T), &record, sizeof(T));
+  }
+
+  quint32 intern(const QString &str)
+  {
+    QHash<QString, quint32>::const_iterator it = m_strings.find(str);
+
+    if (it != m_strings.end())
+      return it.value();
+
+    quint32 idx(count(StringOffsets) - 1);
+    m_strings.insert(str, idx);
+
+    m_tables[StringData].append(str.toUtf8());
+    quint32 end(m_tables[StringData].size());
+    append(StringOffsets, end);
+
+    return idx;
+  }
+
+  void writeSeason(Season *season, quint32 idx);
+  void writeEpisode(Episode *episode, quint32 idx);
+  void writeScene(Scene *scene, quint32 idx);
+  void writeShot(Shot *shot, quint32 idx);
+  bool save(const QString &fName, const Header &header) const;
+
+ private:
+  QVector<QByteArray> m_tables;
+  QHash<QString, quint32> m_strings;
+  EpisodeAccess *m_access;
+};
+
+// children of given type only: video frames inserted during manual
+// annotation are not part of the project
+template <typename T> static QList<T *> typedChildren(Segment *segment)
+{
+  QList<T *> children;
+
+  for (int i(0); i < segment->childCount(); i++) {
+    T *child = dynamic_cast<T *>(segment->child(i));
+    if (child)
+      children.push_back(child);
+  }
+
+  return children;
+}
+
+void ProjectFile::Writer::writeSeason(Season *season, quint32 idx)
+{
+  QList<Episode *> episodes = typedChildren<Episode>(season);
+
+  SeasonRecord record = SeasonRecord();
+  record.position = season->getPosition();
+  record.source = season->getSource();
+  record.number = season->getNumber();
+  record.firstEpisode = reserve<EpisodeRecord>(Episodes, episodes.size());
+  record.nEpisodes = episodes.size();
+
+  for (int i(0); i < episodes.size(); i++) {
+
+    if (m_access)
+      m_access->acquire(episodes[i]);
+
+    writeEpisode(episodes[i], record.firstEpisode + i);
+
+    if (m_access)
+      m_access->release(episodes[i]);
+  }
+
+  set(Seasons, idx, record);
+}
+
+void ProjectFile::Writer::writeEpisode(Episode *episode, quint32 idx)
+{
+  QList<Scene *> scenes = typedChildren<Scene>(episode);
+  QList<SpeechSegment *> speechSegments = episode->getSpeechSegments();
+
+  EpisodeRecord record = EpisodeRecord();
+  record.position = episode->getPosition();
+  record.fps = episode->getFps();
+  record.source = episode->getSource();
+  record.number = episode->getNumber();
+  record.name = intern(episode->getName());
+  record.fName = intern(episode->getFName());
+  record.width = episode->getResolution().width();
+  record.height = episode->getResolution().height();
+  record.firstScene = reserve<SceneRecord>(Scenes, scenes.size());
+  record.nScenes = scenes.size();
+
+  for (int i(0); i < scenes.size(); i++)
+    writeScene(scenes[i], record.firstScene + i);
+
+  record.firstSpeechSegment = count(SpeechSegments);
+  record.nSpeechSegments = speechSegments.size();
+
+  for (int i(0); i < speechSegments.size(); i++) {
+
+    SpeechSegmentRecord segRecord = SpeechSegmentRecord();
+    segRecord.start = speechSegments[i]->getPosition();
+    segRecord.end = speechSegments[i]->getEnd();
+    segRecord.text = intern(speechSegments[i]->getText());
+
+    // speaker labels
+    QVector<QString> speakers = speechSegments[i]->getSpeakers();
+    segRecord.firstSpeaker = count(StringRefs);
+    segRecord.nSpeakers = speakers.size();
+
+    for (int j(0); j < speakers.size(); j++)
+      append(StringRefs, intern(speakers[j]));
+
+    // interlocutors for each source
+    QVector<QStringList> interLocs = speechSegments[i]->getInterLocs();
+    segRecord.firstInterLoc = count(InterLocs);
+    segRecord.nInterLocs = interLocs.size();
+
+    for (int j(0); j < interLocs.size(); j++) {
+
+      InterLocRecord interLocRecord;
+      interLocRecord.firstRef = count(StringRefs);
+      interLocRecord.nRefs = interLocs[j].size();
+
+      for (int k(0); k < interLocs[j].size(); k++)
+	append(StringRefs, intern(interLocs[j][k]));
+
+      append(InterLocs, interLocRecord);
+    }
+
+    append(SpeechSegments, segRecord);
+  }
+
+  set(Episodes, idx, record);
+}
+
+void ProjectFile::Writer::writeScene(Scene *scene, quint32 idx)
+{
+  QList<Shot *> shots = typedChildren<Shot>(scene);
+
+  SceneRecord record = SceneRecord();
+  record.position = scene->getPosition();
+  record.source = scene->getSource();
+  record.firstShot = reserve<ShotRecord>(Shots, shots.size());
+  record.nShots = shots.size();
+
+  for (int i(0); i < shots.size(); i++)
+    writeShot(shots[i], record.firstShot + i);
+
+  set(Scenes, idx, record);
+}
+
+void ProjectFile::Writer::writeShot(Shot *shot, quint32 idx)
+{
+  QList<QPair<qint64, QList<Face> > > faces = shot->getFaces();
+  QList<QPair<qint64, qreal> > musicRates = shot->getMusicRates();
+
+  ShotRecord record = ShotRecord();
+  record.position = shot->getPosition();
+  record.end = shot->getEnd();
+  record.source = shot->getSource();
+  record.transition = shot->getTransitionType();
+  record.camera[Segment::Manual] = shot->getCamera(Segment::Manual);
+  record.camera[Segment::Automatic] = shot->getCamera(Segment::Automatic);
+
+  // faces detected on each frame
+  record.firstFaceFrame = count(FaceFrames);
+  record.nFaceFrames = faces.size();
+
+  for (int i(0); i < faces.size(); i++) {
+
+    FaceFrameRecord frameRecord;
+    frameRecord.position = faces[i].first;
+    frameRecord.firstFace = count(Faces);
+    frameRecord.nFaces = faces[i].second.size();
+
+    for (int j(0); j < faces[i].second.size(); j++) {
+
+      const Face &face = faces[i].second[j];
+      QList<QPoint> landmarks = face.getLandmarks();
+
+      FaceRecord faceRecord = FaceRecord();
+      faceRecord.bbox[0] = face.getBbox().x();
+      faceRecord.bbox[1] = face.getBbox().y();
+      faceRecord.bbox[2] = face.getBbox().width();
+      faceRecord.bbox[3] = face.getBbox().height();
+      faceRecord.id = face.getId();
+      faceRecord.name = intern(face.getName());
+      faceRecord.nLandmarks = qMin(landmarks.size(), 5);
+
+      for (int k(0); k < faceRecord.nLandmarks; k++) {
+	faceRecord.landmarks[2 * k] = landmarks[k].x();
+	faceRecord.landmarks[2 * k + 1] = landmarks[k].y();
+      }
+
+      append(Faces, faceRecord);
+    }
+
+    append(FaceFrames, frameRecord);
+  }
+
+  // musical features
+  record.firstMusicRate = count(MusicRates);
+  record.nMusicRates = musicRates.size();
+
+  for (int i(0); i < musicRates.size(); i++) {
+    MusicRateRecord rateRecord;
+    rateRecord.position = musicRates[i].first;
+    rateRecord.value = musicRates[i].second;
+    append(MusicRates, rateRecord);
+  }
+
+  set(Shots, idx, record);
+}
+
+bool ProjectFile::Writer::save(const QString &fName, const Header &header) const
+{
+  QFile file(fName);
+
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    qWarning() << "Couldn't save file" << fName;
+    return false;
+  }
+
+  // table directory following header
+  QVector<TableEntry> entries(NTables);
+  quint64 offset = align8(sizeof(Header) + NTables * sizeof(TableEntry));
+
+  for (int i(0); i < NTables; i++) {
+    entries[i].recordSize = recordSize(static_cast<Table>(i));
+    entries[i].reserved = 0;
+    entries[i].offset = offset;
+    entries[i].count = m_tables[i].size() / entries[i].recordSize;
+    offset = align8(offset + m_tables[i].size());
+  }
+
+  file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+  file.write(reinterpret_cast<const char *>(entries.constData()), NTables * sizeof(TableEntry));
+
+  for (int i(0); i < NTables; i++) {
+    file.write(QByteArray(entries[i].offset - file.pos(), '\0'));
+    file.write(m_tables[i]);
+  }
+
+  file.write(QByteArray(offset - file.pos(), '\0'));
+
+  return file.error() == QFile::NoError;
+}
+
+/////////////////////////////////
+// constructor and destructor  //
+/////////////////////////////////
+
+ProjectFile::ProjectFile()
+  : m_data(0),
+    m_size(0),
+    m_header(0),
+    m_tables(0)
+{
+}
+
+ProjectFile::~ProjectFile()
+{
+  close();
+}
+
+////////////////////
+// public methods //
+////////////////////
+
+bool ProjectFile::isProjectFile(const QString &fName)
+{
+  QFile file(fName);
+
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+
+  QByteArray magic = file.read(sizeof(projectMagic));
+
+  return magic.size() == sizeof(projectMagic) && std::memcmp(magic.constData(), projectMagic, sizeof(projectMagic)) == 0;
+}
+
+bool ProjectFile::write(const QString &fName, const QString &projectName, Series *series, EpisodeAccess *access)
+{
+  Writer writer(access);
+
+  QList<Season *> seasons = typedChildren<Season>(series);
+  quint32 first = writer.reserve<SeasonRecord>(Seasons, seasons.size());
+
+  for (int i(0); i < seasons.size(); i++)
+    writer.writeSeason(seasons[i], first + i);
+
+  Header header = Header();
+  std::memcpy(header.magic, projectMagic, sizeof(projectMagic));
+  header.version = Version;
+  header.nTables = NTables;
+  header.projectName = writer.intern(projectName);
+  header.seriesName = writer.intern(series->getName());
+  header.seriesPosition = series->getPosition();
+  header.seriesSource = series->getSource();
+
+  return writer.save(fName, header);
+}
+
+bool ProjectFile::writeEpisode(const QString &fName, Episode *episode)
+{
+  Writer writer;
+
+  // single episode record, without any season
+  writer.reserve<EpisodeRecord>(Episodes, 1);
+  writer.writeEpisode(episode, 0);
+
+  Header header = Header();
+  std::memcpy(header.magic, projectMagic, sizeof(projectMagic));
+  header.version = Version;
+  header.nTables = NTables;
+
+  return writer.save(fName, header);
+}
+
+bool ProjectFile::open(const QString &fName)
+{
+  close();
+
+  m_file.setFileName(fName);
+
+  if (!m_file.open(QIODevice::ReadOnly)) {
+    qWarning() << "Couldn't open file" << fName;
+    return false;
+  }
+
+  m_size = m_file.size();
+  quint64 dirEnd = sizeof(Header) + NTables * sizeof(TableEntry);
+
+  if (static_cast<quint64>(m_size) < dirEnd || !(m_data = m_file.map(0, m_size))) {
+    qWarning() << "Invalid project file" << fName;
+    close();
+    return false;
+  }
+
+  m_header = reinterpret_cast<const Header *>(m_data);
+  m_tables = reinterpret_cast<const TableEntry *>(m_data + sizeof(Header));
+
+  if (std::memcmp(m_header->magic, projectMagic, sizeof(projectMagic)) != 0 ||
+      m_header->version != Version ||
+      m_header->nTables != NTables) {
+    qWarning() << "Unsupported project file" << fName << "(version" << m_header->version << ")";
+    close();
+    return false;
+  }
+
+  // tables must lie within the file and match current record layouts
+  for (int i(0); i < NTables; i++)
+    if (m_tables[i].recordSize != recordSize(static_cast<Table>(i)) ||
+	m_tables[i].offset % 8 != 0 ||
+	m_tables[i].offset > static_cast<quint64>(m_size) ||
+	m_tables[i].count > (m_size - m_tables[i].offset) / m_tables[i].recordSize) {
+      qWarning() << "Corrupted project file" << fName;
+      close();
+      return false;
+    }
+
+  // records must only refer to existing ones
+  if (!checkRecords()) {
+    qWarning() << "Corrupted project file" << fName;
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+void ProjectFile::close()
+{
+  if (m_data)
+    m_file.unmap(const_cast<uchar *>(m_data));
+
+  m_file.close();
+
+  m_data = 0;
+  m_size = 0;
+  m_header = 0;
+  m_tables = 0;
+}
+
+bool ProjectFile::isOpen() const
+{
+  return m_data != 0;
+}
+
+QString ProjectFile::getProjectName() const
+{
+  return string(m_header->projectName);
+}
+
+void ProjectFile::readSeries(Series *series) const
+{
+  readSkeleton(series);
+
+  for (int i(0); i < series->childCount(); i++)
+    for (int j(0); j < series->child(i)->childCount(); j++)
+      readEpisodeContents(dynamic_cast<Episode *>(series->child(i)->child(j)), getEpisodeIndex(i, j));
+}
+
+void ProjectFile::readSkeleton(Series *series) const
+{
+  const SeasonRecord *seasons = records<SeasonRecord>(Seasons);
+  const EpisodeRecord *episodes = records<EpisodeRecord>(Episodes);
+
+  series->clearChildren();
+  series->setName(string(m_header->seriesName));
+  series->setPosition(m_header->seriesPosition);
+  series->setSource(static_cast<Segment::Source>(m_header->seriesSource));
+
+  for (quint64 i(0); i < m_tables[Seasons].count; i++) {
+
+    const SeasonRecord &seasRecord = seasons[i];
+    Season *season = new Season(seasRecord.number, series, seasRecord.position, static_cast<Segment::Source>(seasRecord.source));
+
+    for (quint32 j(seasRecord.firstEpisode); j < seasRecord.firstEpisode + seasRecord.nEpisodes; j++) {
+
+      const EpisodeRecord &epRecord = episodes[j];
+      Episode *episode = new Episode(epRecord.number, string(epRecord.fName), season, string(epRecord.name), epRecord.position, static_cast<Segment::Source>(epRecord.source));
+      episode->setResolution(QSize(epRecord.width, epRecord.height));
+      episode->setFps(epRecord.fps);
+
+      season->appendChild(episode);
+    }
+
+    series->appendChild(season);
+  }
+}
+
+void ProjectFile::readEpisodeContents(Episode *episode, int iEpisode) const
+{
+  const EpisodeRecord &epRecord = records<EpisodeRecord>(Episodes)[iEpisode];
+  const SceneRecord *scenes = records<SceneRecord>(Scenes);
+  const ShotRecord *shots = records<ShotRecord>(Shots);
+  const FaceFrameRecord *faceFrames = records<FaceFrameRecord>(FaceFrames);
+  const FaceRecord *faces = records<FaceRecord>(Faces);
+  const MusicRateRecord *musicRates = records<MusicRateRecord>(MusicRates);
+  const SpeechSegmentRecord *speechSegments = records<SpeechSegmentRecord>(SpeechSegments);
+  const InterLocRecord *interLocs = records<InterLocRecord>(InterLocs);
+
+  // scenes and shots
+  for (quint32 i(epRecord.firstScene); i < epRecord.firstScene + epRecord.nScenes; i++) {
+
+    Scene *scene = new Scene(scenes[i].position, episode, static_cast<Segment::Source>(scenes[i].source));
+
+    for (quint32 j(scenes[i].firstShot); j < scenes[i].firstShot + scenes[i].nShots; j++) {
+
+      const ShotRecord &shotRecord = shots[j];
+      Shot *shot = new Shot(shotRecord.position, static_cast<Shot::TransitionType>(shotRecord.transition), scene, static_cast<Segment::Source>(shotRecord.source));
+      shot->setEnd(shotRecord.end);
+      shot->setCamera(shotRecord.camera[Segment::Manual], Segment::Manual);
+      shot->setCamera(shotRecord.camera[Segment::Automatic], Segment::Automatic);
+
+      for (quint32 k(shotRecord.firstFaceFrame); k < shotRecord.firstFaceFrame + shotRecord.nFaceFrames; k++) {
+
+	QList<Face> frameFaces;
+
+	for (quint32 l(faceFrames[k].firstFace); l < faceFrames[k].firstFace + faceFrames[k].nFaces; l++) {
+
+	  const FaceRecord &face = faces[l];
+	  QList<QPoint> landmarks;
+
+	  for (int m(0); m < face.nLandmarks; m++)
+	    landmarks.push_back(QPoint(face.landmarks[2 * m], face.landmarks[2 * m + 1]));
+
+	  frameFaces.push_back(Face(QRect(face.bbox[0], face.bbox[1], face.bbox[2], face.bbox[3]), landmarks, face.id, string(face.name)));
+	}
+
+	shot->appendFaces(faceFrames[k].position, frameFaces);
+      }
+
+      for (quint32 k(shotRecord.firstMusicRate); k < shotRecord.firstMusicRate + shotRecord.nMusicRates; k++)
+	shot->appendMusicRate(QPair<qint64, qreal>(musicRates[k].position, musicRates[k].value));
+
+      scene->appendChild(shot);
+    }
+
+    episode->appendChild(scene);
+  }
+
+  // speech segments
+  QList<SpeechSegment *> episodeSegments;
+
+  for (quint32 i(epRecord.firstSpeechSegment); i < epRecord.firstSpeechSegment + epRecord.nSpeechSegments; i++) {
+
+    const SpeechSegmentRecord &segRecord = speechSegments[i];
+
+    QVector<QString> speakers = stringList(segRecord.firstSpeaker, segRecord.nSpeakers).toVector();
+
+    QVector<QStringList> interLoc;
+    for (quint32 j(segRecord.firstInterLoc); j < segRecord.firstInterLoc + segRecord.nInterLocs; j++)
+      interLoc.push_back(stringList(interLocs[j].firstRef, interLocs[j].nRefs));
+
+    episodeSegments.push_back(new SpeechSegment(segRecord.start,
+						segRecord.end,
+						string(segRecord.text),
+						speakers,
+						interLoc,
+						episode));
+  }
+
+  episode->setSpeechSegments(episodeSegments);
+}
+
+int ProjectFile::getNEpisodes() const
+{
+  return m_tables[Episodes].count;
+}
+
+int ProjectFile::getEpisodeIndex(int iSeason, int iEpisode) const
+{
+  return records<SeasonRecord>(Seasons)[iSeason].firstEpisode + iEpisode;
+}
+
+int ProjectFile::getNScenes(int iEpisode) const
+{
+  return records<EpisodeRecord>(Episodes)[iEpisode].nScenes;
+}
+
+/////////////////////
+// private methods //
+/////////////////////
+
+bool ProjectFile::checkRecords() const
+{
+  const SeasonRecord *seasons = records<SeasonRecord>(Seasons);
+  const EpisodeRecord *episodes = records<EpisodeRecord>(Episodes);
+  const SceneRecord *scenes = records<SceneRecord>(Scenes);
+  const ShotRecord *shots = records<ShotRecord>(Shots);
+  const FaceFrameRecord *faceFrames = records<FaceFrameRecord>(FaceFrames);
+  const FaceRecord *faces = records<FaceRecord>(Faces);
+  const SpeechSegmentRecord *speechSegments = records<SpeechSegmentRecord>(SpeechSegments);
+  const InterLocRecord *interLocs = records<InterLocRecord>(InterLocs);
+  const quint32 *offsets = records<quint32>(StringOffsets);
+
+  for (quint64 i(0); i < m_tables[Seasons].count; i++)
+    if (!inRange(seasons[i].firstEpisode, seasons[i].nEpisodes, m_tables[Episodes].count))
+      return false;
+
+  for (quint64 i(0); i < m_tables[Episodes].count; i++)
+    if (!inRange(episodes[i].firstScene, episodes[i].nScenes, m_tables[Scenes].count) ||
+	!inRange(episodes[i].firstSpeechSegment, episodes[i].nSpeechSegments, m_tables[SpeechSegments].count))
+      return false;
+
+  for (quint64 i(0); i < m_tables[Scenes].count; i++)
+    if (!inRange(scenes[i].firstShot, scenes[i].nShots, m_tables[Shots].count))
+      return false;
+
+  for (quint64 i(0); i < m_tables[Shots].count; i++)
+    if (!inRange(shots[i].firstFaceFrame, shots[i].nFaceFrames, m_tables[FaceFrames].count) ||
+	!inRange(shots[i].firstMusicRate, shots[i].nMusicRates, m_tables[MusicRates].count))
+      return false;
+
+  for (quint64 i(0); i < m_tables[FaceFrames].count; i++)
+    if (!inRange(faceFrames[i].firstFace, faceFrames[i].nFaces, m_tables[Faces].count))
+      return false;
+
+  for (quint64 i(0); i < m_tables[Faces].count; i++)
+    if (faces[i].nLandmarks < 0 || faces[i].nLandmarks > 5)
+      return false;
+
+  for (quint64 i(0); i < m_tables[SpeechSegments].count; i++)
+    if (!inRange(speechSegments[i].firstSpeaker, speechSegments[i].nSpeakers, m_tables[StringRefs].count) ||
+	!inRange(speechSegments[i].firstInterLoc, speechSegments[i].nInterLocs, m_tables[InterLocs].count))
+      return false;
+
+  for (quint64 i(0); i < m_tables[InterLocs].count; i++)
+    if (!inRange(interLocs[i].firstRef, interLocs[i].nRefs, m_tables[StringRefs].count))
+      return false;
+
+  // string bounds increasing and within string data
+  for (quint64 i(0); i < m_tables[StringOffsets].count; i++)
+    if (offsets[i] > m_tables[StringData].count || (i > 0 && offsets[i] < offsets[i - 1]))
+      return false;
+
+  return true;
+}
+
+quint32 ProjectFile::recordSize(Table table)
+{
+  switch (table) {
+  case Seasons:
+    return sizeof(SeasonRecord);
+  case Episodes:
+    return sizeof(EpisodeRecord);
+  case Scenes:
+    return sizeof(SceneRecord);
+  case Shots:
+    return sizeof(ShotRecord);
+  case FaceFrames:
+    return sizeof(FaceFrameRecord);
+  case Faces:
+    return sizeof(FaceRecord);
+  case MusicRates:
+    return sizeof(MusicRateRecord);
+  case SpeechSegments:
+    return sizeof(SpeechSegmentRecord);
+  case InterLocs:
+    return sizeof(InterLocRecord);
+  case StringRefs:
+  case StringOffsets:
+    return sizeof(quint32);
+  case StringData:
+  default:
+    return 1;
+  }
+}
+
+template <typename T> const T * ProjectFile::records(Table table) const
+{
+  return reinterpret_cast<const T *>(m_data + m_tables[table].offset);
+}
+
+QString ProjectFile::string(quint32 idx) const
+{
+  const quint32 *offsets = records<quint32>(StringOffsets);
+  const char *data = records<char>(StringData);
+
+  if (idx + 1 >= m_tables[StringOffsets].count)
+    return QString();
+
+  return QString::fromUtf8(data + offsets[idx], offsets[idx + 1] - offsets[idx]);
+}
+
+QStringList ProjectFile::stringList(quint32 first, quint32 n) const
+{
+  const quint32 *refs = records<quint32>(StringRefs);
+  QStringList strings;
+
+  for (quint32 i(first); i < first + n; i++)
+    strings.push_back(string(refs[i]));
+
+  return strings;
+}
@@ -0,0 +1,186 @@
+#ifndef PROJECTFILE_H
+#define PROJECTFILE_H
+
+#include <QString>
+#include <QFile>
+#include <QHash>
+#include <QByteArray>
+
+#include "Series.h"
+#include "Season.h"
+#include "Episode.h"
+#include "Scene.h"
+#include "Shot.h"
+#include "SpeechSegment.h"
+
+///////////////////////////////////////////////////////
+// binary project file: the segment tree is stored   //
+// as flat tables of fixed-size records, read        //
+// straight from the memory-mapped file; strings     //
+// are pooled and referred to by index               //
+///////////////////////////////////////////////////////
+
+class ProjectFile
+{
+ public:
+  // current format version: files with another version are rejected
+  static const quint32 Version = 1;
+
+  // access to episode contents not held in memory while writing
+  class EpisodeAccess
+  {
+   public:
+    virtual ~EpisodeAccess() {}
+    virtual void acquire(Episode *episode) = 0;
+    virtual void release(Episode *episode) = 0;
+  };
+
+  ProjectFile();
+  ~ProjectFile();
+
+  static bool isProjectFile(const QString &fName);
+  static bool write(const QString &fName, const QString &projectName, Series *series, EpisodeAccess *access = 0);
+  static bool writeEpisode(const QString &fName, Episode *episode);
+
+  bool open(const QString &fName);
+  void close();
+  bool isOpen() const;
+
+  QString getProjectName() const;
+  void readSeries(Series *series) const;
+  void readSkeleton(Series *series) const;
+  void readEpisodeContents(Episode *episode, int iEpisode) const;
+  int getNEpisodes() const;
+  int getEpisodeIndex(int iSeason, int iEpisode) const;
+  int getNScenes(int iEpisode) const;
+
+ private:
+  enum Table {
+    Seasons,
+    Episodes,
+    Scenes,
+    Shots,
+    FaceFrames,
+    Faces,
+    MusicRates,
+    SpeechSegments,
+    InterLocs,
+    StringRefs,
+    StringOffsets,
+    StringData,
+    NTables
+  };
+
+  struct Header {
+    char magic[8];
+    quint32 version;
+    quint32 nTables;
+    quint32 projectName;
+    quint32 seriesName;
+    qint64 seriesPosition;
+    qint32 seriesSource;
+    quint32 reserved;
+  };
+
+  struct TableEntry {
+    quint32 recordSize;
+    quint32 reserved;
+    quint64 offset;
+    quint64 count;
+  };
+
+  struct SeasonRecord {
+    qint64 position;
+    qint32 source;
+    qint32 number;
+    quint32 firstEpisode;
+    quint32 nEpisodes;
+  };
+
+  struct EpisodeRecord {
+    qint64 position;
+    double fps;
+    qint32 source;
+    qint32 number;
+    quint32 name;
+    quint32 fName;
+    qint32 width;
+    qint32 height;
+    quint32 firstScene;
+    quint32 nScenes;
+    quint32 firstSpeechSegment;
+    quint32 nSpeechSegments;
+  };
+
+  struct SceneRecord {
+    qint64 position;
+    qint32 source;
+    quint32 firstShot;
+    quint32 nShots;
+    quint32 reserved;
+  };
+
+  struct ShotRecord {
+    qint64 position;
+    qint64 end;
+    qint32 source;
+    qint32 transition;
+    qint32 camera[2];
+    quint32 firstFaceFrame;
+    quint32 nFaceFrames;
+    quint32 firstMusicRate;
+    quint32 nMusicRates;
+  };
+
+  struct FaceFrameRecord {
+    qint64 position;
+    quint32 firstFace;
+    quint32 nFaces;
+  };
+
+  struct FaceRecord {
+    qint32 bbox[4];
+    qint32 id;
+    quint32 name;
+    qint32 nLandmarks;
+    qint32 landmarks[10];
+    quint32 reserved;
+  };
+
+  struct MusicRateRecord {
+    qint64 position;
+    double value;
+  };
+
+  struct SpeechSegmentRecord {
+    qint64 start;
+    qint64 end;
+    quint32 text;
+    quint32 firstSpeaker;
+    quint32 nSpeakers;
+    quint32 firstInterLoc;
+    quint32 nInterLocs;
+    quint32 reserved;
+  };
+
+  struct InterLocRecord {
+    quint32 firstRef;
+    quint32 nRefs;
+  };
+
+  class Writer;
+
+  bool checkRecords() const;
+  static quint32 recordSize(Table table);
+  template <typename T> const T * records(Table table) const;
+  QString string(quint32 idx) const;
+  QStringList stringList(quint32 first, quint32 n) const;
+
+  QFile m_file;
+  const uchar *m_data;
+  qint64 m_size;
+  const Header *m_header;
+  const TableEntry *m_tables;
+};
+
+#endif
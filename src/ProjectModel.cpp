@@ -10,6 +10,11 @@
 #include <QDir>
 #include <QProcess>
 #include <QtMath>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QEventLoop>
+#include <QCoreApplication>
+#include <QSet>
 
 #include <opencv2/imgproc/imgproc.hpp>
 
@@ -17,6 +22,9 @@
 #include "Season.h"
 #include "Scene.h"
 #include "ResultsDialog.h"
+#include "HistoCache.h"
+#include "ProjectFile.h"
+#include "InteractionMatrix.h"
 
 using namespace std;
 using namespace arma;
@@ -29,7 +37,9 @@ using namespace cv;
 ProjectModel::ProjectModel(QObject *parent)
   : QAbstractItemModel(parent),
     m_name(QString()),
-    m_baseName(QString())
+    m_baseName(QString()),
+    m_episode(0),
+    m_interactive(true)
 {
   m_series = new Series;
   m_movieAnalyzer = new MovieAnalyzer;
@@ -59,6 +69,32 @@ ProjectModel::~ProjectModel()
 
 bool ProjectModel::save(const QString &fName)
 {
+  // binary format selected by extension
+  if (fName.endsWith(".tvp")) {
+
+    // unloaded episodes are read back while writing
+    if (fName != m_episodeStore.getFName())
+      return ProjectFile::write(fName, m_name, m_series, &m_episodeStore);
+
+    // project file still mapped: replaced once fully written
+    QString tmpFName = fName + ".tmp";
+
+    if (!ProjectFile::write(tmpFName, m_name, m_series, &m_episodeStore))
+      return false;
+
+    QFile::remove(fName);
+
+    if (!QFile::rename(tmpFName, fName)) {
+      qWarning("Couldn't replace project file.");
+      return false;
+    }
+
+    return m_episodeStore.reattach(fName, m_series);
+  }
+
+  // whole series needed in memory for JSON serialization
+  loadAllEpisodes();
+
   QFile saveFile(fName + ".json");
   // QFile saveFile(fName + ".dat");
 
@@ -83,6 +119,24 @@ bool ProjectModel::save(const QString &fName)
 
 bool ProjectModel::load(const QString &fName)
 {
+  // binary files recognized by their header
+  if (ProjectFile::isProjectFile(fName)) {
+
+    // episode contents read on demand
+    if (!m_episodeStore.open(fName, m_series, m_name))
+      return false;
+
+    // first episode loaded so that tree depth is known
+    QList<Episode *> episodes = getEpisodes();
+
+    if (!episodes.isEmpty())
+      loadEpisode(episodes.first());
+
+    return true;
+  }
+
+  m_episodeStore.close();
+
   QFile loadFile(fName);
 
   if (!loadFile.open(QIODevice::ReadOnly)) {
@@ -260,6 +314,56 @@ int ProjectModel::getDepth() const
   return m_series->getHeight();
 }
 
+void ProjectModel::loadEpisode(Episode *episode)
+{
+  if (m_episodeStore.isLoaded(episode))
+    return;
+
+  int nScenes = m_episodeStore.getNScenes(episode);
+
+  if (nScenes > 0)
+    beginInsertRows(indexFromSegment(episode), 0, nScenes - 1);
+
+  m_episodeStore.load(episode);
+
+  if (nScenes > 0)
+    endInsertRows();
+}
+
+// series-wide tasks (i-vectors, interactions, networks, scenes, batch
+// processing, summaries) read every episode and keep pointers to their
+// segments: they still load the whole series, the memory budget only
+// bounding memory once their results are released
+void ProjectModel::loadAllEpisodes()
+{
+  if (!m_episodeStore.isOpen())
+    return;
+
+  QList<Episode *> episodes = getEpisodes();
+
+  for (int i(0); i < episodes.size(); i++)
+    loadEpisode(episodes[i]);
+}
+
+void ProjectModel::evictEpisodes()
+{
+  // least recently used episodes unloaded beyond memory budget
+  QList<Episode *> victims = m_episodeStore.getVictims(m_episode);
+
+  for (int i(0); i < victims.size(); i++) {
+
+    int nScenes = victims[i]->childCount();
+
+    if (nScenes > 0)
+      beginRemoveRows(indexFromSegment(victims[i]), 0, nScenes - 1);
+
+    m_episodeStore.unload(victims[i]);
+
+    if (nScenes > 0)
+      endRemoveRows();
+  }
+}
+
 ///////////////
 // modifiers //
 ///////////////
@@ -576,6 +680,9 @@ bool ProjectModel::insertSubtitles(const QString &subFName)
 
 void ProjectModel::getDiarData()
 {
+  // i-vectors retrieved over the speech segments of the whole series
+  loadAllEpisodes();
+
   QList<SpeechSegment *> speechSegments;
   retrieveSpeechSegments(m_episode, speechSegments);
 
@@ -584,6 +691,9 @@ void ProjectModel::getDiarData()
 
 bool ProjectModel::localSpkDiar(SpkDiarizationDialog::Method method, UtteranceTree::DistType dist, bool norm, UtteranceTree::AgrCrit agr, UtteranceTree::PartMeth partMeth, bool weight, bool sigma)
 {
+  // i-vectors retrieved over the speech segments of the whole series
+  loadAllEpisodes();
+
   QList<SpeechSegment *> speechSegments;
   retrieveSpeechSegments(m_episode, speechSegments);
   speechSegments = m_movieAnalyzer->denoiseSpeechSegments(speechSegments);
@@ -601,6 +711,24 @@ bool ProjectModel::localSpkDiar(SpkDiarizationDialog::Method method, UtteranceTr
   return true;
 }
 
+bool ProjectModel::localSpkDiarSweep(const QList<MovieAnalyzer::DiarConfig> &configs, QVector<QList<QPair<qreal, qreal> > > &localDer)
+{
+  // i-vectors retrieved over the speech segments of the whole series
+  loadAllEpisodes();
+
+  QList<SpeechSegment *> speechSegments;
+  retrieveSpeechSegments(m_episode, speechSegments);
+  speechSegments = m_movieAnalyzer->denoiseSpeechSegments(speechSegments);
+  speechSegments = m_movieAnalyzer->filterSpeechSegments(speechSegments);
+
+  return m_movieAnalyzer->localSpkDiarSweep(configs, speechSegments, m_lsuSpeechSegments, localDer);
+}
+
+void ProjectModel::displaySweepTable(const QList<MovieAnalyzer::DiarConfig> &configs, const QVector<QList<QPair<qreal, qreal> > > &localDer)
+{
+  m_movieAnalyzer->displaySweepTable(configs, localDer);
+}
+
 bool ProjectModel::globalSpkDiar()
 {
   m_movieAnalyzer->globalSpkDiar(m_baseName, m_subBound, m_subRefLbl);
@@ -610,6 +738,9 @@ bool ProjectModel::globalSpkDiar()
 
 void ProjectModel::spkInteract(SpkInteractDialog::InteractType type, SpkInteractDialog::RefUnit unit, int nbDiscards, int interThresh)
 {
+  // interactions computed over the whole series
+  loadAllEpisodes();
+
   // episodes
 
   //////////////////
@@ -836,7 +967,7 @@ void ProjectModel::spkInteract(SpkInteractDialog::InteractType type, SpkInteract
     conversNets.push_back(getUttOrientedNet(unitSpeechSegments, type));
 
     // compute and possibly display evaluation results
-    QPair<QVector<qreal>, QVector<qreal> > results = evaluateSpkInteract(unitSpeechSegments, true, type, conversNets);
+    QPair<QVector<qreal>, QVector<qreal> > results = evaluateSpkInteract(unitSpeechSegments, m_interactive, type, conversNets);
 
     // S.insert_rows(i, arma::mat(results.first.toStdVector()).t());
     // U.insert_rows(i, arma::mat(results.second.toStdVector()).t());
@@ -1250,12 +1381,14 @@ QPair<QVector<qreal>, QVector<qreal> > ProjectModel::evaluateSpkInteract(QList<Q
 
 QMap<QString, QMap<QString, qreal> > ProjectModel::getSpkOrientedNet(QList<QList<SpeechSegment *> > unitSpeechSegments, SpkInteractDialog::InteractType type)
 {
-  QMap<QString, QMap<QString, qreal> > spkOrientedNet;
+  SpeakerDictionary speakers;
+  InteractionMatrix spkOrientedNet;
 
   // loop over units
   for (int i(0); i < unitSpeechSegments.size(); i++) {
 
-    QMap<QString, QStringList> spkInterloc;
+    // interactions already counted in current unit
+    QSet<qint64> unitInter;
 
     for (int j(0); j < unitSpeechSegments[i].size(); j++) {
 	
@@ -1266,23 +1399,33 @@ QMap<QString, QMap<QString, qreal> > ProjectModel::getSpkOrientedNet(QList<QList
       QStringList interLoc = unitSpeechSegments[i][j]->getInterLocs(type);
      
       if (!interLoc.isEmpty()) {
+
+	int fSpk = speakers.intern(currSpeaker);
+
 	// loop over interlocutors
 	for (int k(0); k < interLoc.size(); k++) {
-	  if (!spkInterloc[currSpeaker].contains(interLoc[k])) {
-	    spkInterloc[currSpeaker].push_back(interLoc[k]);
-	    spkOrientedNet[currSpeaker][interLoc[k]]++;
+
+	  int sSpk = speakers.intern(interLoc[k]);
+	  qint64 key = InteractionMatrix::pairKey(fSpk, sSpk);
+
+	  if (!unitInter.contains(key)) {
+	    unitInter.insert(key);
+	    spkOrientedNet.add(fSpk, sSpk, 1.0);
 	  }
 	}
       }
     }
   }
 
-  return spkOrientedNet;
+  spkOrientedNet.compress(speakers.size());
+
+  return spkOrientedNet.toMap(speakers);
 }
 
 QMap<QString, QMap<QString, qreal> > ProjectModel::getUttOrientedNet(QList<QList<SpeechSegment *> > unitSpeechSegments, SpkInteractDialog::InteractType type, bool nbWeight)
 {
-  QMap<QString, QMap<QString, qreal> > uttOrientedNet;
+  SpeakerDictionary speakers;
+  InteractionMatrix uttOrientedNet;
 
   // loop over units
   for (int i(0); i < unitSpeechSegments.size(); i++)
@@ -1293,18 +1436,22 @@ QMap<QString, QMap<QString, qreal> > ProjectModel::getUttOrientedNet(QList<QList
       
       if (!interLoc.isEmpty()) {
 
-	// update interactions
+	int fSpk = speakers.intern(currSpk);
+
+	// update interactions, summed up when compressing
 	for (int k(0); k < interLoc.size(); k++)
 	  if (nbWeight)
-	    uttOrientedNet[currSpk][interLoc[k]] += 1.0 / interLoc.size();
+	    uttOrientedNet.add(fSpk, speakers.intern(interLoc[k]), 1.0 / interLoc.size());
 	  else {
 	    qreal duration = (unitSpeechSegments[i][j]->getEnd() - unitSpeechSegments[i][j]->getPosition()) / 1000.0;
-	    uttOrientedNet[currSpk][interLoc[k]] += duration / interLoc.size();
+	    uttOrientedNet.add(fSpk, speakers.intern(interLoc[k]), duration / interLoc.size());
 	  }
       }
     }
 
-  return uttOrientedNet;
+  uttOrientedNet.compress(speakers.size());
+
+  return uttOrientedNet.toMap(speakers);
 }
 
 void ProjectModel::processErrorCases(QList<QList<SpeechSegment *> > unitSpeechSegments, const QMap<QString, QMap<QString, qreal> > &hypInter, const QMap<QString, QMap<QString, qreal> > &refInter) const
@@ -1397,6 +1544,9 @@ void ProjectModel::musicTracking(int frameRate, int mtWindowSize, int mtHopSize,
 
 bool ProjectModel::coClustering(const QString &fName)
 {
+  // i-vectors retrieved over the speech segments of the whole series
+  loadAllEpisodes();
+
   QList<Shot *> shots;
   retrieveShots(m_episode, shots);
 
@@ -1410,8 +1560,23 @@ bool ProjectModel::coClustering(const QString &fName)
   return true;
 }
 
-bool ProjectModel::summarization(SummarizationDialog::Method method, int seasonNb, const QString &speaker, int dur, qreal granu)
+void ProjectModel::benchmarkFacilityLocation(int maxExactSize)
+{
+  // i-vectors retrieved over the speech segments of the whole series
+  loadAllEpisodes();
+
+  QList<SpeechSegment *> speechSegments;
+  retrieveSpeechSegments(m_episode, speechSegments);
+  speechSegments = m_movieAnalyzer->denoiseSpeechSegments(speechSegments);
+  speechSegments = m_movieAnalyzer->filterSpeechSegments(speechSegments);
+
+  m_movieAnalyzer->benchmarkFacilityLocation(speechSegments, m_lsuSpeechSegments, maxExactSize);
+}
+
+bool ProjectModel::summarization(SummarizationDialog::Method method, int seasonNb, const QString &speaker, int dur, qreal granu, SummarizationDialog::Selection selection)
 {
+  loadAllEpisodes();
+
   // retrieve scene speech segments for network building
   QList<QList<SpeechSegment *> > sceneSpeechSegments;
   m_scenes.clear();
@@ -1427,7 +1592,7 @@ bool ProjectModel::summarization(SummarizationDialog::Method method, int seasonN
   
   retrieveLsuContents(m_series, lsuShots, lsuSpeechSegments, minDur, maxDur);
 
-  m_movieAnalyzer->summarization(method, seasonNb, speaker, dur, granu, sceneSpeechSegments, lsuShots, lsuSpeechSegments);
+  m_movieAnalyzer->summarization(method, seasonNb, speaker, dur, granu, sceneSpeechSegments, lsuShots, lsuSpeechSegments, selection);
 
   return true;
 }
@@ -1438,33 +1603,94 @@ void ProjectModel::showNarrChart(bool checked)
   QList<QList<SpeechSegment *> > sceneSpeechSegments;
   m_scenes.clear();
 
-  if (checked)
+  if (checked) {
+    loadAllEpisodes();
     retrieveSpeakersNet_aux(m_series, sceneSpeechSegments, m_scenes);
+  }
 
   emit viewNarrChart(sceneSpeechSegments);
 }
 
-void ProjectModel::extractShots(QString fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal threshold1, qreal threshold2, int nVBlock, int nHBlock)
+void ProjectModel::extractShots(QString fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal threshold1, qreal threshold2, int nVBlock, int nHBlock, int analysisHeight)
+{
+  removeAutoShots(m_episode);
+
+  m_movieAnalyzer->extractShots(fName, histoType, nVBins, nHBins, nSBins, metrics, threshold1, threshold2, nVBlock, nHBlock, m_interactive, analysisHeight);
+  evaluateShotDetection(m_interactive, threshold1, threshold2);
+}
+
+void ProjectModel::benchmarkShotDetection(QString fName, const QList<int> &analysisHeights, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal threshold1, qreal threshold2, int nVBlock, int nHBlock)
 {
+  QElapsedTimer timer;
+  qint64 refTime(-1);
+
+  // histograms computed from scratch in a temporary cache, user cache
+  // files being left untouched
+  QTemporaryDir cacheDir;
+  QString userCacheDir = HistoCache::getCacheDir();
+
+  if (!cacheDir.isValid()) {
+    qWarning() << "Couldn't create temporary histogram cache directory";
+    return;
+  }
+
+  HistoCache::setCacheDir(cacheDir.path());
+
+  // automatic shots restored once benchmark is over
+  QList<QPair<qint64, qint64> > autoShots;
+  QList<Shot *> shots;
+  retrieveShots(m_episode, shots);
+
+  for (int i(0); i < shots.size(); i++)
+    if (shots[i]->getSource() != Segment::Manual)
+      autoShots.push_back(QPair<qint64, qint64>(shots[i]->getPosition(), shots[i]->getEnd()));
+
+  qDebug() << "height" << "time (s)" << "speed-up" << "F-score";
+
+  for (int i(0); i < analysisHeights.size(); i++) {
+
+    removeAutoShots(m_episode);
+
+    timer.start();
+    m_movieAnalyzer->extractShots(fName, histoType, nVBins, nHBins, nSBins, metrics, threshold1, threshold2, nVBlock, nHBlock, false, analysisHeights[i]);
+    qint64 elapsed = timer.elapsed();
+
+    // speed-up relative to first configuration
+    if (refTime < 0)
+      refTime = elapsed;
+
+    qreal fScore = evaluateShotDetection(false, threshold1, threshold2);
+
+    qDebug() << (analysisHeights[i] > 0 ? QString::number(analysisHeights[i]) : QString("full"))
+	     << QString::number(elapsed / 1000.0, 'f', 3)
+	     << QString::number(refTime / static_cast<qreal>(qMax(elapsed, static_cast<qint64>(1))), 'f', 2)
+	     << QString::number(fScore, 'f', 4);
+  }
+
+  HistoCache::setCacheDir(userCacheDir);
+
   removeAutoShots(m_episode);
 
-  m_movieAnalyzer->extractShots(fName, histoType, nVBins, nHBins, nSBins, metrics, threshold1, threshold2, nVBlock, nHBlock);
-  evaluateShotDetection(true, threshold1, threshold2);
+  for (int i(0); i < autoShots.size(); i++)
+    insertShotAuto(m_episode, autoShots[i].first, autoShots[i].second);
 }
 
-void ProjectModel::labelSimilarShots(QString fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal maxDist, int windowSize, int nVBlock, int nHBlock)
+void ProjectModel::labelSimilarShots(QString fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal maxDist, int windowSize, int nVBlock, int nHBlock, int analysisHeight)
 {
   resetAutoCameraLabels(m_episode);
 
   QList<Shot *> shots;
   retrieveShots(m_episode, shots);
   
-  m_movieAnalyzer->labelSimilarShots(fName, histoType, nVBins, nHBins, nSBins, metrics, maxDist, windowSize, shots, nVBlock, nHBlock, true);
-  evaluateSimShotDetection(true, maxDist, windowSize);
+  m_movieAnalyzer->labelSimilarShots(fName, histoType, nVBins, nHBins, nSBins, metrics, maxDist, windowSize, shots, nVBlock, nHBlock, m_interactive, analysisHeight);
+  evaluateSimShotDetection(m_interactive, maxDist, windowSize);
 }
 
 void ProjectModel::extractScenes(Segment::Source vSrc, const QString &fName)
 {
+  // shot labels and positions retrieved over the whole series
+  loadAllEpisodes();
+
   /***********************/
   /* retrieve audio data */
   /***********************/
@@ -1520,7 +1746,7 @@ void ProjectModel::extractScenes(Segment::Source vSrc, const QString &fName)
   /* evaluation */
   /**************/
 
-  evaluateSceneDetection(true);
+  evaluateSceneDetection(m_interactive);
 }
 
 void ProjectModel::faceDetection(const QString &fName, FaceDetectDialog::Method method, int minHeight)
@@ -1540,6 +1766,68 @@ void ProjectModel::faceDetection(const QString &fName, FaceDetectDialog::Method
   }
 }
 
+bool ProjectModel::batchProcess(int stages, int nWorkers, bool viewProgress)
+{
+  EpisodeBatchScheduler scheduler(nWorkers);
+
+  return batchProcess(scheduler, stages, viewProgress);
+}
+
+bool ProjectModel::batchProcess(EpisodeBatchScheduler &scheduler, int stages, bool viewProgress)
+{
+  QList<Episode *> episodes;
+  initEpisodes_aux(m_series, episodes);
+
+  // workers need every episode in memory
+  loadAllEpisodes();
+
+  // previous automatic results are cleared before workers start
+  for (int i(0); i < episodes.size(); i++) {
+
+    if (stages & EpisodeBatchScheduler::Shots)
+      removeAutoShots(episodes[i]);
+
+    if (stages & EpisodeBatchScheduler::SimilarShots)
+      resetAutoCameraLabels(episodes[i]);
+
+    if (stages & EpisodeBatchScheduler::Faces)
+      resetShotFaces(episodes[i]);
+
+    QList<qint64> shotPositions;
+    retrieveShotPositions(episodes[i], shotPositions);
+    scheduler.addEpisode(episodes[i], shotPositions);
+  }
+
+  // results merged on the GUI thread as workers produce them
+  connect(&scheduler, SIGNAL(insertShot(Episode *, qint64, qint64)), this, SLOT(insertShotAuto(Episode *, qint64, qint64)));
+  connect(&scheduler, SIGNAL(setCurrShot(Episode *, qint64)), this, SLOT(setCurrShot(Episode *, qint64)));
+  connect(&scheduler, SIGNAL(setShotCameras(Episode *, const QList<qint64> &, const QVector<int> &)), this, SLOT(setShotCameras(Episode *, const QList<qint64> &, const QVector<int> &)));
+  connect(&scheduler, SIGNAL(appendFaces(Episode *, qint64, const QList<QRect> &)), this, SLOT(appendFaces(Episode *, qint64, const QList<QRect> &)));
+
+  // event loop running until the last episode is processed, queued since
+  // finished() is emitted by start() itself when no episode is queued
+  QEventLoop loop;
+  connect(&scheduler, SIGNAL(finished()), &loop, SLOT(quit()), Qt::QueuedConnection);
+
+  QProgressDialog progress(tr("Processing episodes..."), tr("Cancel"), 0, episodes.size());
+
+  if (viewProgress) {
+    progress.setWindowModality(Qt::ApplicationModal);
+    connect(&scheduler, SIGNAL(episodeDone(int)), &progress, SLOT(setValue(int)));
+    connect(&progress, SIGNAL(canceled()), &scheduler, SLOT(cancel()));
+  }
+
+  scheduler.start(stages);
+  loop.exec();
+  scheduler.wait();
+
+  // results still queued are merged before returning
+  QCoreApplication::sendPostedEvents(this);
+  evictEpisodes();
+
+  return !(viewProgress && progress.wasCanceled());
+}
+
 void ProjectModel::externFaceDetection(const QString &fName)
 {
   resetShotFaces(m_episode);
@@ -1939,6 +2227,33 @@ QString ProjectModel::getSeriesName() const
   return m_series->getName();
 }
 
+void ProjectModel::setInteractive(bool interactive, bool extractOnMismatch)
+{
+  m_interactive = interactive;
+  m_movieAnalyzer->setInteractive(interactive, extractOnMismatch);
+}
+
+void ProjectModel::setMemoryBudget(qint64 budget)
+{
+  m_episodeStore.setMemoryBudget(budget);
+  evictEpisodes();
+}
+
+void ProjectModel::setSolverMode(Optimizer::SolverMode solverMode, int nThreads)
+{
+  m_movieAnalyzer->setSolverMode(solverMode, nThreads);
+}
+
+void ProjectModel::setDiarThreads(int nThreads)
+{
+  m_movieAnalyzer->setDiarThreads(nThreads);
+}
+
+qint64 ProjectModel::getMemoryUsage() const
+{
+  return m_episodeStore.getMemoryUsage();
+}
+
 ///////////
 // slots //
 ///////////
@@ -1971,6 +2286,9 @@ void ProjectModel::playSegments(QList<QPair<Episode *, QPair<qint64, qint64> > >
 void ProjectModel::setEpisode(Episode *currEpisode)
 {
   m_episode = currEpisode;
+  loadEpisode(m_episode);
+  evictEpisodes();
+
   setLsuContents(Segment::Manual);
   emit resetSegmentView();
   emit resetSpkDiarMonitor();
@@ -2125,10 +2443,15 @@ void ProjectModel::removeVideoFrames(Segment *segment)
 }
 
 void ProjectModel::insertShotAuto(qint64 position, qint64 end)
+{
+  insertShotAuto(m_episode, position, end);
+}
+
+void ProjectModel::insertShotAuto(Episode *episode, qint64 position, qint64 end)
 {
   // retrieve insertion scene
-  int i = m_episode->childIndexFromPosition(position);
-  Segment *scene = m_episode->child(i);
+  int i = episode->childIndexFromPosition(position);
+  Segment *scene = episode->child(i);
 
   // retrieve index closest shot to position
   int iCloseShot = scene->childIndexFromPosition(position);
@@ -2154,7 +2477,10 @@ void ProjectModel::insertShotAuto(qint64 position, qint64 end)
   
   emit resetSegmentView();
   emit setDepthView(getDepth());
-  emit positionChanged(position);
+
+  // other episodes may be processed in batch
+  if (episode == m_episode)
+    emit positionChanged(position);
 }
 
 void ProjectModel::appendFaces(qint64 position, const QList<QRect> &faces)
@@ -2162,6 +2488,32 @@ void ProjectModel::appendFaces(qint64 position, const QList<QRect> &faces)
   m_currShot->appendFaces(position, faces);
 }
 
+void ProjectModel::appendFaces(Episode *episode, qint64 position, const QList<QRect> &faces)
+{
+  Shot *shot = shotFromPosition(episode, position);
+
+  if (shot)
+    shot->appendFaces(position, faces);
+}
+
+void ProjectModel::setShotCameras(Episode *episode, const QList<qint64> &shotPositions, const QVector<int> &shotCamera)
+{
+  QList<Shot *> shots;
+  retrieveShots(episode, shots);
+
+  // both shot lists are sorted by position
+  int j(0);
+
+  for (int i(0); i < shots.size(); i++) {
+
+    while (j < shotPositions.size() && shotPositions[j] < shots[i]->getPosition())
+      j++;
+
+    if (j < shotPositions.size() && shotPositions[j] == shots[i]->getPosition() && shotCamera[j] != -1)
+      shots[i]->setCamera(shotCamera[j], Segment::Automatic);
+  }
+}
+
 void ProjectModel::insertScene(qint64 position, Segment::Source source)
 {
   int i(-1);
@@ -2322,6 +2674,8 @@ void ProjectModel::processSegmentation(bool autoChecked, bool refChecked, bool a
 
 QStringList ProjectModel::retrieveRefSpeakers()
 {
+  loadAllEpisodes();
+
   QMap<QString, qreal> refSpeakers;
   QMap<qreal, QString> invRefSpeakers;
   QStringList speakers;
@@ -2343,6 +2697,9 @@ QStringList ProjectModel::retrieveRefSpeakers()
   for (int i(0); i < speakers.size(); i++)
     revSpeakers.push_front(speakers[i]);
 
+  // only names kept: memory budget applies again
+  evictEpisodes();
+
   return revSpeakers;
 }
 
@@ -2367,6 +2724,8 @@ void ProjectModel::retrieveRefSpeakers_aux(Segment *segment, QMap<QString, qreal
  
 void ProjectModel::retrieveSpeakersNet(Segment *segment)
 {
+  loadAllEpisodes();
+
   QList<QList<SpeechSegment *> > sceneSpeechSegments;
   m_scenes.clear();
 
@@ -2600,9 +2959,26 @@ void ProjectModel::setCurrSpeechSeg(qint64 position)
 }
 
 void ProjectModel::setCurrShot(qint64 position)
+{
+  Shot *shot = shotFromPosition(m_episode, position);
+
+  // possibly update current shot
+  if (m_currShot != shot)
+    m_currShot = shot;
+}
+
+void ProjectModel::setCurrShot(Episode *episode, qint64 position)
+{
+  // batch workers report shots of every episode: only the displayed
+  // one owns the current shot
+  if (episode == m_episode)
+    setCurrShot(position);
+}
+
+Shot * ProjectModel::shotFromPosition(Episode *episode, qint64 position)
 {
   QList<Shot *> shots;
-  retrieveShots(m_episode, shots);
+  retrieveShots(episode, shots);
   bool found(false);
   int iSup(shots.size()-1);
   int iInf(0);
@@ -2618,9 +2994,7 @@ void ProjectModel::setCurrShot(qint64 position)
       iInf = iMed + 1;
   }
 
-  // possibly update current shot
-  if (m_currShot != shots[iMed])
-    m_currShot = shots[iMed];
+  return iMed != -1 ? shots[iMed] : 0;
 }
 
 void ProjectModel::getCurrFaces(qint64 position)
@@ -2704,6 +3078,15 @@ void ProjectModel::retrieveShots(Segment *segment, QList<Shot *> &shots)
     retrieveShots(segment->child(i), shots);
 }
 
+QList<Episode *> ProjectModel::getEpisodes()
+{
+  QList<Episode *> episodes;
+
+  initEpisodes_aux(m_series, episodes);
+
+  return episodes;
+}
+
 QStringList ProjectModel::getSeasons()
 {
   QStringList seasons;
@@ -2726,10 +3109,15 @@ void ProjectModel::getSeasons_aux(Segment *segment, QStringList &seasons)
 
 QList<QStringList> ProjectModel::getSeasonSpeakers()
 {
+  loadAllEpisodes();
+
   QList<QStringList> seasonSpeakers;
 
   getSeasonSpeakers_aux(m_series, seasonSpeakers);
 
+  // only names kept: memory budget applies again
+  evictEpisodes();
+
   return seasonSpeakers;
 }
 
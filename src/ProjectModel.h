@@ -15,6 +15,8 @@
 #include "SpeechSegment.h"
 #include "VideoFrame.h"
 #include "MovieAnalyzer.h"
+#include "EpisodeBatchScheduler.h"
+#include "EpisodeStore.h"
 #include "SpkDiarizationDialog.h"
 #include "FaceDetectDialog.h"
 #include "SpkInteractDialog.h"
@@ -62,6 +64,7 @@ class ProjectModel: public QAbstractItemModel
   
   void retrieveShots(Segment *segment, QList<Shot *> &shots);
   QStringList getSeasons();
+  QList<Episode *> getEpisodes();
   void getSeasons_aux(Segment *segment, QStringList &seasons);
   QStringList retrieveRefSpeakers();
   QList<QStringList> getSeasonSpeakers();
@@ -71,13 +74,16 @@ class ProjectModel: public QAbstractItemModel
   // image processing //
   //////////////////////
 
-  void extractShots(QString fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal threshold1, qreal threshold2, int nVBlock, int nHBlock);
+  void extractShots(QString fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal threshold1, qreal threshold2, int nVBlock, int nHBlock, int analysisHeight = 0);
   qreal evaluateShotDetection(bool displayResults, qreal thresh1, qreal thresh2) const;
-  void labelSimilarShots(QString fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal maxDist, int windowSize, int nVBlock, int nHBlock);
+  void benchmarkShotDetection(QString fName, const QList<int> &analysisHeights, int histoType = 2, int nVBins = 64, int nHBins = 24, int nSBins = 8, int metrics = 0, qreal threshold1 = 30, qreal threshold2 = 20, int nVBlock = 5, int nHBlock = 6);
+  void labelSimilarShots(QString fName, int histoType, int nVBins, int nHBins, int nSBins, int metrics, qreal maxDist, int windowSize, int nVBlock, int nHBlock, int analysisHeight = 0);
   qreal evaluateSimShotDetection(bool displayResults, qreal thresh1, qreal thresh2) const;
   void extractScenes(Segment::Source vSrc, const QString &fName);
   qreal evaluateSceneDetection(bool displayResults) const;
   void faceDetection(const QString &fName, FaceDetectDialog::Method method, int minHeight);
+  bool batchProcess(int stages, int nWorkers = -1, bool viewProgress = true);
+  bool batchProcess(EpisodeBatchScheduler &scheduler, int stages, bool viewProgress = true);
 
   //////////////////////
   // audio processing //
@@ -85,6 +91,8 @@ class ProjectModel: public QAbstractItemModel
 
   void getDiarData();
   bool localSpkDiar(SpkDiarizationDialog::Method method, UtteranceTree::DistType dist, bool norm, UtteranceTree::AgrCrit agr, UtteranceTree::PartMeth partMeth, bool weight, bool sigma);
+  bool localSpkDiarSweep(const QList<MovieAnalyzer::DiarConfig> &configs, QVector<QList<QPair<qreal, qreal> > > &localDer);
+  void displaySweepTable(const QList<MovieAnalyzer::DiarConfig> &configs, const QVector<QList<QPair<qreal, qreal> > > &localDer);
   bool globalSpkDiar();
   void spkInteract(SpkInteractDialog::InteractType type, SpkInteractDialog::RefUnit unit, int nbDiscards, int interThresh);
   QPair<QVector<qreal>, QVector<qreal> > evaluateSpkInteract(QList<QList<SpeechSegment *> > unitSpeechSegments, bool displayResults, SpkInteractDialog::InteractType type, const QList<QMap<QString, QMap<QString, qreal> > > &conversNets);
@@ -97,12 +105,13 @@ class ProjectModel: public QAbstractItemModel
   ////////////////////////////
   
   bool coClustering(const QString &fName);
+  void benchmarkFacilityLocation(int maxExactSize = 150);
 
   //////////////////////
   // high-level tasks //
   //////////////////////
 
-  bool summarization(SummarizationDialog::Method method, int seasonNb, const QString &speaker, int dur, qreal granu);
+  bool summarization(SummarizationDialog::Method method, int seasonNb, const QString &speaker, int dur, qreal granu, SummarizationDialog::Selection selection = SummarizationDialog::Mmr);
   void showNarrChart(bool checked);
 
   ///////////////
@@ -112,6 +121,11 @@ class ProjectModel: public QAbstractItemModel
   QString getName() const;
   QString getBaseName() const;
   QString getSeriesName() const;
+  void setInteractive(bool interactive, bool extractOnMismatch = true);
+  void setMemoryBudget(qint64 budget);
+  void setSolverMode(Optimizer::SolverMode solverMode, int nThreads = 1);
+  void setDiarThreads(int nThreads);
+  qint64 getMemoryUsage() const;
 
   public slots:
 
@@ -142,6 +156,7 @@ class ProjectModel: public QAbstractItemModel
     void retrieveSceneNetworks(Segment *segment, QList<QMap<QString, QMap<QString, qreal> > > &networks);
     void setCurrSpeechSeg(qint64 position);
     void setCurrShot(qint64 position);
+    void setCurrShot(Episode *episode, qint64 position);
     void getCurrFaces(qint64 position);
     void getCurrLSU(qint64 position);
 
@@ -150,7 +165,10 @@ class ProjectModel: public QAbstractItemModel
     //////////////////////
 
     void insertShotAuto(qint64 position, qint64 end);
+    void insertShotAuto(Episode *episode, qint64 position, qint64 end);
     void appendFaces(qint64 position, const QList<QRect> &faces);
+    void appendFaces(Episode *episode, qint64 position, const QList<QRect> &faces);
+    void setShotCameras(Episode *episode, const QList<qint64> &shotPositions, const QVector<int> &shotCamera);
     void externFaceDetection(const QString &fName);
 
     //////////////////////
@@ -234,6 +252,10 @@ class ProjectModel: public QAbstractItemModel
     void setSegmentsToInsert(QList<Segment *> segmentsToInsert);
     void resetAutoCameraLabels(Segment *segment);
     void resetShotFaces(Segment *segment);
+    Shot * shotFromPosition(Episode *episode, qint64 position);
+    void loadEpisode(Episode *episode);
+    void loadAllEpisodes();
+    void evictEpisodes();
 
     ////////////////////////
     // evaluation metrics //
@@ -286,6 +308,8 @@ class ProjectModel: public QAbstractItemModel
     QList<Scene *> m_scenes;
     
     MovieAnalyzer *m_movieAnalyzer;
+    bool m_interactive;
+    EpisodeStore m_episodeStore;
 
     QList<QPair<qint64, qint64> > m_subBound;
     QMap<QString, QList<QPair<int, qreal> > > m_shotUtterances;
@@ -208,6 +208,11 @@ void Shot::appendFaces(qint64 position, const QList<QRect> &faces)
   m_faces.push_back(QPair<qint64, QList<Face> >(position, newFaces));
 }
 
+void Shot::appendFaces(qint64 position, const QList<Face> &faces)
+{
+  m_faces.push_back(QPair<qint64, QList<Face> >(position, faces));
+}
+
 void Shot::appendMusicRate(QPair<qint64, qreal> musicRate)
 {
   m_musicRates.push_back(musicRate);
@@ -227,6 +232,11 @@ qint64 Shot::getEnd() const
   return m_end;
 }
 
+Shot::TransitionType Shot::getTransitionType() const
+{
+  return m_transitionType;
+}
+
 int Shot::getCamera(Segment::Source source) const
 {
   return m_camera[source];
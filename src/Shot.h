@@ -26,8 +26,10 @@ class Shot: public Segment
   void clearFaces();
   void clearMusicRates();
   void appendFaces(qint64 position, const QList<QRect> &faces);
+  void appendFaces(qint64 position, const QList<Face> &faces);
   void appendMusicRate(QPair<qint64, qreal> musicRate);
   qint64 getEnd() const;
+  TransitionType getTransitionType() const;
   int getCamera(Segment::Source source) const;
   QString getLabel(Segment::Source source) const;
   QMap<QString, int> getSpeakerList(VideoFrame::SpeakerSource source);
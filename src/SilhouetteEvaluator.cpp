@@ -0,0 +1,114 @@
+#include <algorithm>
+
+#include "SilhouetteEvaluator.h"
+
+using namespace arma;
+
+/////////////////
+// constructor //
+/////////////////
+
+SilhouetteEvaluator::SilhouetteEvaluator(const mat &D)
+  : m_n(D.n_rows),
+    m_S(D)
+{
+  // each instance initially forms its own cluster, numbered
+  // after the instance
+  m_S.diag().zeros();
+
+  m_cluster.resize(m_n);
+  m_sizes.fill(1, m_n);
+  m_closest.resize(m_n);
+  m_closestDist.resize(m_n);
+
+  for (int i(0); i < m_n; i++) {
+    m_cluster[i] = i;
+    m_clusters.push_back(i);
+  }
+
+  for (int i(0); i < m_n; i++)
+    updateSecondClosest(i);
+}
+
+////////////////////
+// public methods //
+////////////////////
+
+int SilhouetteEvaluator::merge(int k1, int k2)
+{
+  // merged cluster keeps the number of the first one
+  m_S.col(k1) += m_S.col(k2);
+  m_sizes[k1] += m_sizes[k2];
+  m_sizes[k2] = 0;
+  m_clusters.removeOne(k2);
+
+  for (int j(0); j < m_n; j++)
+    if (m_cluster[j] == k2)
+      m_cluster[j] = k1;
+
+  // average distances to other clusters are left unchanged: second
+  // closest cluster only searched again when pointing to merged ones
+  for (int j(0); j < m_n; j++) {
+
+    if (m_closest[j] == k1 || m_closest[j] == k2)
+      updateSecondClosest(j);
+
+    else if (m_cluster[j] != k1) {
+
+      qreal dist = m_S(j, k1) / m_sizes[k1];
+
+      if (dist < m_closestDist[j]) {
+	m_closest[j] = k1;
+	m_closestDist[j] = dist;
+      }
+    }
+  }
+
+  return k1;
+}
+
+qreal SilhouetteEvaluator::getScore() const
+{
+  qreal Q(0.0);
+
+  for (int j(0); j < m_n; j++) {
+
+    int k = m_cluster[j];
+
+    // s(x_j) equal to 0 for isolated instances
+    if (m_sizes[k] > 1 && m_closest[j] != -1) {
+
+      qreal a = m_S(j, k) / (m_sizes[k] - 1);
+      qreal b = m_closestDist[j];
+
+      Q += (b - a) / std::max(a, b);
+    }
+  }
+
+  return (m_n > 0) ? Q / m_n : 0.0;
+}
+
+/////////////////////
+// private methods //
+/////////////////////
+
+void SilhouetteEvaluator::updateSecondClosest(int j)
+{
+  m_closest[j] = -1;
+  m_closestDist[j] = datum::inf;
+
+  for (int i(0); i < m_clusters.size(); i++) {
+
+    int k = m_clusters[i];
+
+    if (k != m_cluster[j]) {
+
+      qreal dist = m_S(j, k) / m_sizes[k];
+
+      if (m_closest[j] == -1 || dist < m_closestDist[j]) {
+	m_closest[j] = k;
+	m_closestDist[j] = dist;
+      }
+    }
+  }
+}
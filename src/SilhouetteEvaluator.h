@@ -0,0 +1,37 @@
+#ifndef SILHOUETTEEVALUATOR_H
+#define SILHOUETTEEVALUATOR_H
+
+#include <QList>
+#include <QVector>
+
+#include <armadillo>
+
+///////////////////////////////////////////////////////
+// silhouette of a partition evolving by successive  //
+// merges of clusters: sums of distances between     //
+// instances and clusters, as well as the second     //
+// closest cluster of each instance, are updated at  //
+// each merge instead of being computed again        //
+///////////////////////////////////////////////////////
+
+class SilhouetteEvaluator
+{
+ public:
+  SilhouetteEvaluator(const arma::mat &D);
+
+  int merge(int k1, int k2);
+  qreal getScore() const;
+
+ private:
+  void updateSecondClosest(int j);
+
+  int m_n;
+  arma::mat m_S;                // sum of distances between each instance and each cluster
+  QVector<int> m_cluster;       // cluster of each instance
+  QVector<int> m_sizes;         // size of each cluster
+  QList<int> m_clusters;        // current clusters
+  QVector<int> m_closest;       // second closest cluster of each instance
+  QVector<qreal> m_closestDist; // average distance to this cluster
+};
+
+#endif
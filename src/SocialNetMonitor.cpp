@@ -72,6 +72,10 @@ SocialNetMonitor::SocialNetMonitor(QWidget *parent)
   QCheckBox *displayLabels = new QCheckBox(tr("Display node labels"));
   QCheckBox *displayEdges = new QCheckBox(tr("Display edges"));
 
+  // views built on several threads when igraph is thread-safe
+  QCheckBox *parallelViews = new QCheckBox(tr("Build views in parallel"));
+  parallelViews->setEnabled(SocialNetProcessor::parallelViewsSupported());
+
   QFrame *line_1 = new QFrame;
   line_1->setFrameShape(QFrame::HLine);
   line_1->setFrameShadow(QFrame::Sunken);
@@ -89,7 +93,7 @@ SocialNetMonitor::SocialNetMonitor(QWidget *parent)
   m_timer = new QTimer(this);
 
   QGridLayout *layout = new QGridLayout;
-  layout->addWidget(m_socialNetWidget, 0, 0, 10, 10);
+  layout->addWidget(m_socialNetWidget, 0, 0, 11, 10);
   // layout->addWidget(srcBox, 0, 10);
   // layout->addWidget(m_direct, 1, 10);
   // layout->addWidget(m_weight, 2, 10);
@@ -99,11 +103,12 @@ SocialNetMonitor::SocialNetMonitor(QWidget *parent)
   layout->addWidget(layoutBox, 2, 10);
   layout->addWidget(displayLabels, 3, 10);
   layout->addWidget(displayEdges, 4, 10);
-  layout->addWidget(line_3, 5, 10, 1, 2);
-  layout->addWidget(filterBox, 6, 10);
-  layout->addWidget(m_filterWeight, 7, 10, 1, 2);
-  layout->addWidget(line_2, 8, 10, 1, 2);
-  layout->addWidget(exportGraph, 9, 10, 1, 2, Qt::AlignHCenter);
+  layout->addWidget(parallelViews, 5, 10);
+  layout->addWidget(line_3, 6, 10, 1, 2);
+  layout->addWidget(filterBox, 7, 10);
+  layout->addWidget(m_filterWeight, 8, 10, 1, 2);
+  layout->addWidget(line_2, 9, 10, 1, 2);
+  layout->addWidget(exportGraph, 10, 10, 1, 2, Qt::AlignHCenter);
   
   setLayout(layout);
 
@@ -118,6 +123,7 @@ SocialNetMonitor::SocialNetMonitor(QWidget *parent)
   connect(durInteract, SIGNAL(clicked(bool)), this, SLOT(activDurWeight(bool)));
   connect(exportGraph, SIGNAL(clicked()), this, SLOT(exportGraphToFile()));
   connect(displayLabels, SIGNAL(clicked(bool)), this, SLOT(setLabelDisplay(bool)));
+  connect(parallelViews, SIGNAL(clicked(bool)), this, SLOT(setParallelViews(bool)));
 
   connect(m_weight, SIGNAL(clicked(bool)), weightBox, SLOT(setEnabled(bool)));
   connect(interact, SIGNAL(clicked(bool)), m_direct, SLOT(setEnabled(bool)));
@@ -290,6 +296,12 @@ void SocialNetMonitor::activDurWeight(bool checked)
   updateViews();
 }
 
+void SocialNetMonitor::setParallelViews(bool checked)
+{
+  // taken into account next time views are built
+  m_socialNetProcessor->setViewThreads(checked ? -1 : 0);
+}
+
 void SocialNetMonitor::play()
 {
   m_timer->start(m_currRate);
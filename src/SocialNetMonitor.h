@@ -35,6 +35,7 @@ public slots:
   void adjustWeight(bool checked);
   void activNbWeight(bool checked);
   void activDurWeight(bool checked);
+  void setParallelViews(bool checked);
   void play();
   void pause();
   void stop();
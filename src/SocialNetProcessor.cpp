@@ -1,9 +1,12 @@
 #include <QtMath>
 #include <QFile>
 #include <QProgressDialog>
+#include <QThread>
 
 #include <QDebug>
 
+#include <algorithm>
+
 #include "SocialNetProcessor.h"
 #include "Season.h"
 #include "Episode.h"
@@ -12,12 +15,39 @@
 
 using namespace std;
 
+class ViewThread: public QThread
+{
+ public:
+  ViewThread(SocialNetProcessor *processor, int first, int last, const SocialNetProcessor::ViewBlockStart *blockStarts, QList<Vertex> *verticesViews, QList<Edge> *edgesViews, QVector<arma::vec> *comVec, QAtomicInt *nDone, QAtomicInt *abort)
+    : m_processor(processor), m_first(first), m_last(last), m_blockStarts(blockStarts), m_verticesViews(verticesViews), m_edgesViews(edgesViews), m_comVec(comVec), m_nDone(nDone), m_abort(abort) {}
+
+ protected:
+  void run()
+  {
+    m_processor->buildViews(m_first, m_last, m_blockStarts, m_verticesViews, m_edgesViews, m_comVec, m_nDone, m_abort);
+  }
+
+ private:
+  SocialNetProcessor *m_processor;
+  int m_first;
+  int m_last;
+  const SocialNetProcessor::ViewBlockStart *m_blockStarts;
+  QList<Vertex> *m_verticesViews;
+  QList<Edge> *m_edgesViews;
+  QVector<arma::vec> *m_comVec;
+  QAtomicInt *m_nDone;
+  QAtomicInt *m_abort;
+};
+
 SocialNetProcessor::SocialNetProcessor(QWidget *parent)
   : QWidget(parent),
     m_directed(false),
     m_weighted(true),
     m_nbWeight(false),
-    m_iCurrScene(0)
+    m_iCurrScene(0),
+    m_exactOrdering(false),
+    m_nViewThreads(0),
+    m_viewBlockSize(32)
 {
   igraph_i_set_attribute_table(&igraph_cattribute_table);
   m_optimizer = new Optimizer();
@@ -54,9 +84,10 @@ void SocialNetProcessor::setGraph(SocialNetProcessor::GraphSource source, bool l
   initGraph(edges);
   initGraphWidget();
 
-  // possibly initialize layout
+  // possibly initialize layout, same one from one run to another
   int nVertices = igraph_vcount(&m_graph);
   igraph_matrix_init(&m_coord, nVertices, 3);
+  igraph_rng_seed(igraph_rng_default(), 0);
   getLayoutCoord(nVertices, 500, nVertices, false, true);
 
   // build network views
@@ -81,70 +112,218 @@ void SocialNetProcessor::buildNetworkViews(bool layout)
     QProgressDialog progress(tr("Building graph views..."), tr("Cancel"), 0, m_networkViews.size(), this);
     progress.setWindowModality(Qt::WindowModal);
 
-    QVector<arma::vec> prevComVec;
     QVector<QVector<int> > communityMatching(m_networkViews.size() - 1);
 
-    for (int i(0); i < m_networkViews.size(); i++) {
+    // views built one after the other or independently on worker threads
+    bool done = (m_nViewThreads == 0) ? buildViewsSerial(communityMatching, progress) : buildViewsParallel(communityMatching, progress);
 
-      // update agglomerative graph and corresponding widget
-      updateGraph(m_networkViews[i]);
-      updateGraphWidget(layout);
+    if (!done)
+      return;
 
-      // export current view to file
-      // exportViewToFile(i, "BB", "dyn_ns");
-      // exportViewToFile(i, "BB", "dyn_ts10");
-      // exportViewToFile(i, "BB", "dyn_ts40");
-      // exportViewToFile(i, "BB", "cum");
-      
-      // exportViewToFile(i, "GoT", "dyn_ns");
-      // exportViewToFile(i, "GoT", "dyn_ts10");
-      // exportViewToFile(i, "GoT", "dyn_ts40");
-      // exportViewToFile(i, "GoT", "cum");
+    // make consistent the community labels
+    m_dynCommunities = getDynCommunities(communityMatching);
+    adjustComLabels(m_dynCommunities);
 
-      // exportViewToFile(i, "HoC", "dyn_ns");
-      // exportViewToFile(i, "HoC", "dyn_ts10");
-      // exportViewToFile(i, "HoC", "dyn_ts40");
-      // exportViewToFile(i, "HoC", "cum");
+    // normalize weights
+    normalizeWeights();
 
-      // perform community detection on current graph
-      QVector<int> comAssign = communityDetection_ter();
+    // set current view to selected scene
+    m_vertices = m_verticesViews[m_iCurrScene];
+    m_edges = m_edgesViews[m_iCurrScene];
+  }
+}
 
-      // assign each node to his own community
-      for (int j(0); j < comAssign.size(); j++)
-	m_vertices[j].setCom(comAssign[j]);
+bool SocialNetProcessor::buildViewsSerial(QVector<QVector<int> > &communityMatching, QProgressDialog &progress)
+{
+  QVector<arma::vec> prevComVec;
 
-      // update view vertices and edges
-      m_verticesViews[i] = m_vertices;
-      m_edgesViews[i] = m_edges;
+  NetworkSnapshotStore::Cursor cursor(&m_networkViews);
 
-      // vectorize resulting communities
-      QVector<arma::vec> currComVec = vectorizeCommunities(comAssign);
-      
-      // matching with previous communities
-      if( !prevComVec.isEmpty()) {
-	QVector<int> matching = partitionMatching(prevComVec, currComVec);
-	communityMatching[i-1] = matching;
-      }
+  for (int i(0); i < m_networkViews.size(); i++) {
+
+    // update agglomerative graph and corresponding widget
+    cursor.seek(i);
+    updateGraph(cursor.getSnapshot());
+    updateGraphWidget(true);
+
+    // export current view to file
+    // exportViewToFile(i, "BB", "dyn_ns");
+    // exportViewToFile(i, "BB", "dyn_ts10");
+    // exportViewToFile(i, "BB", "dyn_ts40");
+    // exportViewToFile(i, "BB", "cum");
+    
+    // exportViewToFile(i, "GoT", "dyn_ns");
+    // exportViewToFile(i, "GoT", "dyn_ts10");
+    // exportViewToFile(i, "GoT", "dyn_ts40");
+    // exportViewToFile(i, "GoT", "cum");
+
+    // exportViewToFile(i, "HoC", "dyn_ns");
+    // exportViewToFile(i, "HoC", "dyn_ts10");
+    // exportViewToFile(i, "HoC", "dyn_ts40");
+    // exportViewToFile(i, "HoC", "cum");
+
+    // perform community detection on current graph
+    QVector<int> comAssign = communityDetection_ter();
+
+    // assign each node to his own community
+    for (int j(0); j < comAssign.size(); j++)
+      m_vertices[j].setCom(comAssign[j]);
 
-      prevComVec = currComVec;
+    // update view vertices and edges
+    m_verticesViews[i] = m_vertices;
+    m_edgesViews[i] = m_edges;
+
+    // vectorize resulting communities
+    QVector<arma::vec> currComVec = vectorizeCommunities(comAssign);
+    
+    // matching with previous communities
+    if( !prevComVec.isEmpty()) {
+      QVector<int> matching = partitionMatching(prevComVec, currComVec);
+      communityMatching[i-1] = matching;
+    }
+
+    prevComVec = currComVec;
+
+    // update progress bar
+    progress.setValue(i);
+    if (progress.wasCanceled())
+      return false;
+  }
+
+  return true;
+}
+
+bool SocialNetProcessor::buildViewsParallel(QVector<QVector<int> > &communityMatching, QProgressDialog &progress)
+{
+  int n(m_networkViews.size());
+  int nBlocks = (n + m_viewBlockSize - 1) / m_viewBlockSize;
+  int nThreads = (m_nViewThreads < 0) ? QThread::idealThreadCount() : m_nViewThreads;
+  nThreads = qMax(1, qMin(nThreads, nBlocks));
+
+  // views written at distinct indices by the workers
+  QVector<QVector<arma::vec> > comVec(n);
+  QAtomicInt nDone(0);
+  QAtomicInt abort(0);
+  QList<ViewThread *> threads;
+
+  // starting layouts of the blocks, chained serially
+  QVector<ViewBlockStart> blockStarts(nBlocks);
+  initBlockStarts(blockStarts);
+
+  // workers processing whole blocks of views
+  for (int k(0); k < nThreads; k++) {
+    int first = k * nBlocks / nThreads * m_viewBlockSize;
+    int last = qMin(n, (k + 1) * nBlocks / nThreads * m_viewBlockSize);
+    threads.push_back(new ViewThread(this, first, last, blockStarts.data(), m_verticesViews.data(), m_edgesViews.data(), comVec.data(), &nDone, &abort));
+    threads.last()->start();
+  }
+
+  bool canceled(false);
+
+  for (int k(0); k < nThreads; k++)
+    while (!threads[k]->wait(100)) {
 
       // update progress bar
-      progress.setValue(i);
-      if (progress.wasCanceled())
-	return;
+      progress.setValue(nDone.load());
+
+      if (!canceled && progress.wasCanceled()) {
+	canceled = true;
+	abort.store(1);
+      }
     }
 
-    // make consistent the community labels
-    m_dynCommunities = getDynCommunities(communityMatching);
-    adjustComLabels(m_dynCommunities);
+  qDeleteAll(threads);
 
-    // normalize weights
-    normalizeWeights();
+  for (int b(0); b < nBlocks; b++)
+    igraph_matrix_destroy(&blockStarts[b].coord);
 
-    // set current view to selected scene
-    m_vertices = m_verticesViews[m_iCurrScene];
-    m_edges = m_edgesViews[m_iCurrScene];
+  if (canceled)
+    return false;
+
+  // matching with previous communities
+  for (int i(1); i < n; i++)
+    communityMatching[i-1] = partitionMatching(comVec[i-1], comVec[i]);
+
+  return true;
+}
+
+void SocialNetProcessor::initBlockStarts(QVector<ViewBlockStart> &blockStarts)
+{
+  igraph_t graph;
+  igraph_copy(&graph, &m_graph);
+
+  NetworkSnapshotStore::Cursor cursor(&m_networkViews);
+
+  // first block starts from the agglomerative graph layout
+  igraph_matrix_copy(&blockStarts[0].coord, &m_coord);
+  blockStarts[0].vertices = m_vertices;
+  blockStarts[0].edges = m_edges;
+
+  // next ones from the last view of the previous block, laid out from
+  // the start of that block: one layout per block instead of one per view
+  for (int b(1); b < blockStarts.size(); b++) {
+
+    int i = b * m_viewBlockSize - 1;
+
+    igraph_matrix_copy(&blockStarts[b].coord, &blockStarts[b-1].coord);
+    blockStarts[b].vertices = blockStarts[b-1].vertices;
+    blockStarts[b].edges = blockStarts[b-1].edges;
+
+    igraph_rng_seed(igraph_rng_default(), i);
+    cursor.seek(i);
+    updateGraph(&graph, cursor.getSnapshot());
+    updateGraphWidget(&graph, &blockStarts[b].coord, blockStarts[b].vertices, blockStarts[b].edges, true);
+  }
+
+  igraph_destroy(&graph);
+}
+
+void SocialNetProcessor::buildViews(int first, int last, const ViewBlockStart *blockStarts, QList<Vertex> *verticesViews, QList<Edge> *edgesViews, QVector<arma::vec> *comVec, QAtomicInt *nDone, QAtomicInt *abort)
+{
+  // graph and layout of the worker
+  igraph_t graph;
+  igraph_matrix_t coord;
+
+  igraph_copy(&graph, &m_graph);
+  igraph_matrix_copy(&coord, &m_coord);
+
+  NetworkSnapshotStore::Cursor cursor(&m_networkViews);
+  QList<Vertex> vertices;
+  QList<Edge> edges;
+
+  for (int i(first); i < last && abort->load() == 0; i++) {
+
+    // same random numbers whatever the thread processing the view
+    igraph_rng_seed(igraph_rng_default(), i);
+
+    // each block starts from its precomputed layout, next views from
+    // the layout of the previous one
+    if (i % m_viewBlockSize == 0) {
+      const ViewBlockStart &start = blockStarts[i / m_viewBlockSize];
+      vertices = start.vertices;
+      edges = start.edges;
+      igraph_matrix_update(&coord, &start.coord);
+    }
+
+    cursor.seek(i);
+    updateGraph(&graph, cursor.getSnapshot());
+    updateGraphWidget(&graph, &coord, vertices, edges, true);
+
+    // perform community detection on current graph
+    QVector<int> comAssign = communityDetection_ter(&graph);
+
+    for (int j(0); j < comAssign.size(); j++)
+      vertices[j].setCom(comAssign[j]);
+
+    verticesViews[i] = vertices;
+    edgesViews[i] = edges;
+    comVec[i] = vectorizeCommunities(comAssign, vertices);
+
+    nDone->ref();
   }
+
+  igraph_matrix_destroy(&coord);
+  igraph_destroy(&graph);
 }
 
 void SocialNetProcessor::updateSceneRefs(int i)
@@ -697,6 +876,11 @@ QVector<int> SocialNetProcessor::partitionMatching(const QVector<arma::vec> &pre
 }
 
 QVector<arma::vec> SocialNetProcessor::vectorizeCommunities(const QVector<int> &comAssign)
+{
+  return vectorizeCommunities(comAssign, m_vertices);
+}
+
+QVector<arma::vec> SocialNetProcessor::vectorizeCommunities(const QVector<int> &comAssign, const QList<Vertex> &vertices)
 {
   QVector<arma::vec> comVec;
   QVector<QList<int> > partition;
@@ -720,7 +904,7 @@ QVector<arma::vec> SocialNetProcessor::vectorizeCommunities(const QVector<int> &
     comVec[i].zeros(comAssign.size());
 
     for (int j(0); j < partition[i].size(); j++) {
-      comVec[i](partition[i][j]) = m_vertices[partition[i][j]].getWeight();
+      comVec[i](partition[i][j]) = vertices[partition[i][j]].getWeight();
 
       // if (partition.size() > 1 && m_vertices[partition[i][j]].getWeight() > 2)
       // qDebug() << i << partition[i][j] << m_vertices[partition[i][j]].getLabel() << m_vertices[partition[i][j]].getWeight();
@@ -1016,22 +1200,27 @@ QList<Vertex> SocialNetProcessor::setVertices()
 }
 
 QList<qreal> SocialNetProcessor::getNodeStrengths()
+{
+  return getNodeStrengths(&m_graph);
+}
+
+QList<qreal> SocialNetProcessor::getNodeStrengths(const igraph_t *graph)
 {
   QList<qreal> strengths;
 
   // number of vertices and edges
-  int nVertices(igraph_vcount(&m_graph));
-  int nEdges(igraph_ecount(&m_graph));
+  int nVertices(igraph_vcount(graph));
+  int nEdges(igraph_ecount(graph));
   
   // retrieving edge weights
   igraph_vector_t weights;
   igraph_vector_init(&weights, nEdges);
-  EANV(&m_graph, "weight", &weights);
+  EANV(graph, "weight", &weights);
 
   // computing vertex weights
   igraph_vector_t vStrengths;
   igraph_vector_init(&vStrengths, nVertices);
-  igraph_strength(&m_graph, &vStrengths, igraph_vss_all(), IGRAPH_ALL, IGRAPH_NO_LOOPS, &weights);
+  igraph_strength(graph, &vStrengths, igraph_vss_all(), IGRAPH_ALL, IGRAPH_NO_LOOPS, &weights);
 
   // pushing normalized degrees
   for (int i(0); i < nVertices; i++)
@@ -1045,6 +1234,11 @@ QList<qreal> SocialNetProcessor::getNodeStrengths()
 }
 
 QList<QVector3D> SocialNetProcessor::getLayoutCoord(int nVertices, int nIter, qreal maxdelta, bool use_seed, bool twoDim)
+{
+  return getLayoutCoord(&m_graph, &m_coord, nVertices, nIter, maxdelta, use_seed, twoDim);
+}
+
+QList<QVector3D> SocialNetProcessor::getLayoutCoord(const igraph_t *graph, igraph_matrix_t *coord, int nVertices, int nIter, qreal maxdelta, bool use_seed, bool twoDim, qreal minDisp)
 {
   QList<QVector3D> verticesCoord;
   qreal x, y, z;
@@ -1054,8 +1248,8 @@ QList<QVector3D> SocialNetProcessor::getLayoutCoord(int nVertices, int nIter, qr
   qreal coolexp(1.5); 
   qreal repulserad(volume * nVertices);
   igraph_vector_t weights;
-  igraph_vector_init(&weights, m_edges.size());
-  EANV(&m_graph, "weight", &weights);
+  igraph_vector_init(&weights, igraph_ecount(graph));
+  EANV(graph, "weight", &weights);
 
   igraph_vector_t minx;
   igraph_vector_t maxx;
@@ -1068,26 +1262,18 @@ QList<QVector3D> SocialNetProcessor::getLayoutCoord(int nVertices, int nIter, qr
     VECTOR(maxx)[i] = 500.0;
   }
 
-  if (twoDim) {
-    igraph_layout_fruchterman_reingold(&m_graph,
-				       &m_coord,
-				       nIter,
-				       maxdelta,
-				       volume,
-				       coolexp,
-				       repulserad,
-				       use_seed,
-				       &weights,
-				       nullptr,
-				       nullptr,
-				       nullptr,
-				       nullptr);
+  // possibly stop once vertices hardly move
+  if (use_seed && minDisp > 0.0)
+    runAdaptiveLayout(graph, coord, nIter, maxdelta, volume, coolexp, repulserad, &weights, twoDim, minDisp);
+  else
+    runLayout(graph, coord, nIter, maxdelta, volume, coolexp, repulserad, use_seed, &weights, twoDim);
 
+  if (twoDim) {
     // normalizing coordinates
     qreal max(0.0);
     for (int i(0); i < nVertices; i++) {
-      x = qFabs(MATRIX(m_coord, i, 0));
-      y = qFabs(MATRIX(m_coord, i, 1));
+      x = qFabs(MATRIX(*coord, i, 0));
+      y = qFabs(MATRIX(*coord, i, 1));
       
       if (x > max)
 	max = x;
@@ -1098,8 +1284,8 @@ QList<QVector3D> SocialNetProcessor::getLayoutCoord(int nVertices, int nIter, qr
     // pushing coordinates into 3D vector list
     for (int i(0); i < nVertices; i++) {
 
-      x = MATRIX(m_coord, i, 0) / max;
-      y = MATRIX(m_coord, i, 1) / max;
+      x = MATRIX(*coord, i, 0) / max;
+      y = MATRIX(*coord, i, 1) / max;
       z = 0.0;
 
       verticesCoord.push_back(QVector3D(x, y, z));
@@ -1107,28 +1293,12 @@ QList<QVector3D> SocialNetProcessor::getLayoutCoord(int nVertices, int nIter, qr
   }
 
   else {
-    igraph_layout_fruchterman_reingold_3d(&m_graph,
-					  &m_coord,
-					  nIter,
-					  maxdelta,
-					  volume,
-					  coolexp,
-					  repulserad,
-					  use_seed,
-					  &weights,
-					  nullptr,
-					  nullptr,
-					  nullptr,
-					  nullptr,
-					  nullptr,
-					  nullptr);
-
     // normalizing coordinates
     qreal max(0.0);
     for (int i(0); i < nVertices; i++) {
-      x = qFabs(MATRIX(m_coord, i, 0));
-      y = qFabs(MATRIX(m_coord, i, 1));
-      z = qFabs(MATRIX(m_coord, i, 2));
+      x = qFabs(MATRIX(*coord, i, 0));
+      y = qFabs(MATRIX(*coord, i, 1));
+      z = qFabs(MATRIX(*coord, i, 2));
 
       if (x > max)
 	max = x;
@@ -1141,9 +1311,9 @@ QList<QVector3D> SocialNetProcessor::getLayoutCoord(int nVertices, int nIter, qr
     // pushing coordinates into 3D vector list
     for (int i(0); i < nVertices; i++) {
 
-      x = MATRIX(m_coord, i, 0) / max;
-      y = MATRIX(m_coord, i, 1) / max;
-      z = MATRIX(m_coord, i, 2) / max;
+      x = MATRIX(*coord, i, 0) / max;
+      y = MATRIX(*coord, i, 1) / max;
+      z = MATRIX(*coord, i, 2) / max;
 
       verticesCoord.push_back(QVector3D(x, y, z));
     }
@@ -1156,6 +1326,129 @@ QList<QVector3D> SocialNetProcessor::getLayoutCoord(int nVertices, int nIter, qr
   return verticesCoord;
 }
 
+void SocialNetProcessor::runLayout(const igraph_t *graph, igraph_matrix_t *coord, int nIter, qreal maxdelta, qreal volume, qreal coolexp, qreal repulserad, bool use_seed, const igraph_vector_t *weights, bool twoDim)
+{
+  if (twoDim)
+    igraph_layout_fruchterman_reingold(graph,
+				       coord,
+				       nIter,
+				       maxdelta,
+				       volume,
+				       coolexp,
+				       repulserad,
+				       use_seed,
+				       weights,
+				       nullptr,
+				       nullptr,
+				       nullptr,
+				       nullptr);
+
+  else
+    igraph_layout_fruchterman_reingold_3d(graph,
+					  coord,
+					  nIter,
+					  maxdelta,
+					  volume,
+					  coolexp,
+					  repulserad,
+					  use_seed,
+					  weights,
+					  nullptr,
+					  nullptr,
+					  nullptr,
+					  nullptr,
+					  nullptr,
+					  nullptr);
+}
+
+void SocialNetProcessor::runAdaptiveLayout(const igraph_t *graph, igraph_matrix_t *coord, int nIter, qreal maxdelta, qreal volume, qreal coolexp, qreal repulserad, const igraph_vector_t *weights, bool twoDim, qreal minDisp)
+{
+  int nVertices = igraph_matrix_nrow(coord);
+  int nDim = twoDim ? 2 : 3;
+
+  igraph_matrix_t prevCoord;
+  igraph_matrix_init(&prevCoord, 0, 0);
+
+  // one iteration at a time, following the cooling schedule of a full run
+  for (int it(0); it < nIter; it++) {
+
+    igraph_matrix_update(&prevCoord, coord);
+
+    qreal delta = maxdelta * qPow(static_cast<qreal>(nIter - it) / nIter, coolexp);
+    runLayout(graph, coord, 1, delta, volume, coolexp, repulserad, true, weights, twoDim);
+
+    // largest displacement of a vertex
+    qreal disp(0.0);
+
+    for (int i(0); i < nVertices; i++) {
+
+      qreal d(0.0);
+      for (int j(0); j < nDim; j++)
+	d += qPow(MATRIX(*coord, i, j) - MATRIX(prevCoord, i, j), 2);
+
+      if (d > disp)
+	disp = d;
+    }
+
+    if (qSqrt(disp) < minDisp)
+      break;
+  }
+
+  igraph_matrix_destroy(&prevCoord);
+}
+
+void SocialNetProcessor::placeNewVertices(const igraph_t *graph, igraph_matrix_t *coord, const QList<Vertex> &vertices, const QList<qreal> &strengths)
+{
+  int nEdges = igraph_ecount(graph);
+  int nDim = igraph_matrix_ncol(coord);
+
+  // vertices isolated in previous view and connected in current one
+  QVector<bool> isNew(vertices.size());
+
+  for (int i(0); i < vertices.size(); i++)
+    isNew[i] = (vertices[i].getWeight() == 0.0 && strengths[i] > 0.0);
+
+  igraph_vector_t weights;
+  igraph_vector_init(&weights, nEdges);
+  EANV(graph, "weight", &weights);
+
+  // weighted barycenter of already placed neighbors
+  QVector<qreal> sumWeights(vertices.size(), 0.0);
+  QVector<QVector<qreal> > center(vertices.size(), QVector<qreal>(nDim, 0.0));
+
+  for (int i(0); i < nEdges; i++) {
+
+    qreal w = VECTOR(weights)[i];
+
+    if (w <= 0.0)
+      continue;
+
+    int from;
+    int to;
+    igraph_edge(graph, i, &from, &to);
+
+    if (isNew[from] && !isNew[to]) {
+      sumWeights[from] += w;
+      for (int j(0); j < nDim; j++)
+	center[from][j] += w * MATRIX(*coord, to, j);
+    }
+
+    else if (isNew[to] && !isNew[from]) {
+      sumWeights[to] += w;
+      for (int j(0); j < nDim; j++)
+	center[to][j] += w * MATRIX(*coord, from, j);
+    }
+  }
+
+  // slightly moved away from barycenter not to overlap neighbors
+  for (int i(0); i < vertices.size(); i++)
+    if (sumWeights[i] > 0.0)
+      for (int j(0); j < nDim; j++)
+	MATRIX(*coord, i, j) = center[i][j] / sumWeights[i] + igraph_rng_get_unif(igraph_rng_default(), -1.0, 1.0);
+
+  igraph_vector_destroy(&weights);
+}
+
 QList<Edge> SocialNetProcessor::setEdges()
 {
   QList<Edge> edges;
@@ -1188,11 +1481,16 @@ QList<Edge> SocialNetProcessor::setEdges()
 ///////////////////////////////////////////////
 
 void SocialNetProcessor::updateGraph(const QMap<QString, QMap<QString, qreal> > &currView)
+{
+  updateGraph(&m_graph, currView);
+}
+
+void SocialNetProcessor::updateGraph(igraph_t *graph, const QMap<QString, QMap<QString, qreal> > &currView)
 {
   // delete previous edges
   igraph_es_t es;
   igraph_es_all(&es, IGRAPH_EDGEORDER_ID);
-  igraph_delete_edges(&m_graph, es);
+  igraph_delete_edges(graph, es);
   igraph_es_destroy(&es);
 
   // update edge weight
@@ -1216,12 +1514,12 @@ void SocialNetProcessor::updateGraph(const QMap<QString, QMap<QString, qreal> >
 	int pTo = m_verticesLabels.indexOf(sSpk);
       
 	// insert edge
-	igraph_add_edge(&m_graph, pFrom, pTo);
+	igraph_add_edge(graph, pFrom, pTo);
 
 	// set edge weight
 	int eid;
-	igraph_get_eid(&m_graph, &eid, pFrom, pTo, false, false);
-	SETEAN(&m_graph, "weight", eid, weight);
+	igraph_get_eid(graph, &eid, pFrom, pTo, false, false);
+	SETEAN(graph, "weight", eid, weight);
 
 	// qDebug() << fSpk << sSpk << weight << pFrom << pTo;
       }
@@ -1235,53 +1533,63 @@ void SocialNetProcessor::updateGraph(const QMap<QString, QMap<QString, qreal> >
 
 void SocialNetProcessor::updateGraphWidget(bool layout)
 {
-  updateVertices(layout);
-  updateEdges();
+  updateGraphWidget(&m_graph, &m_coord, m_vertices, m_edges, layout);
+}
+
+void SocialNetProcessor::updateGraphWidget(const igraph_t *graph, igraph_matrix_t *coord, QList<Vertex> &vertices, QList<Edge> &edges, bool layout)
+{
+  updateVertices(graph, coord, vertices, layout);
+  updateEdges(graph, vertices, edges);
 }
 
-void SocialNetProcessor::updateVertices(bool layout)
+void SocialNetProcessor::updateVertices(const igraph_t *graph, igraph_matrix_t *coord, QList<Vertex> &vertices, bool layout)
 {
   // updated node strengths
-  QList<qreal> strengths = getNodeStrengths();
+  QList<qreal> strengths = getNodeStrengths(graph);
+
+  // vertices appearing in current view placed close to their neighbors
+  if (layout)
+    placeNewVertices(graph, coord, vertices, strengths);
+
   for (int i(0); i < strengths.size(); i++) {
 
     qreal newStrength = strengths[i];
-    if (m_vertices[i].getWeight() != newStrength)
-      m_vertices[i].setWeight(newStrength);
+    if (vertices[i].getWeight() != newStrength)
+      vertices[i].setWeight(newStrength);
   }
 
   if (layout) {
     // possibly update vertices coordinates
-    // QList<QVector3D> verticesCoord = getLayoutCoord(m_vertices.size(), 10, 5, true, true);
-    // QList<QVector3D> verticesCoord = getLayoutCoord(m_vertices.size(), 10, 20, true, true);
-    QList<QVector3D> verticesCoord = getLayoutCoord(m_vertices.size(), 8, 4, true, true);
+    // QList<QVector3D> verticesCoord = getLayoutCoord(graph, coord, vertices.size(), 10, 5, true, true);
+    // QList<QVector3D> verticesCoord = getLayoutCoord(graph, coord, vertices.size(), 10, 20, true, true);
+    QList<QVector3D> verticesCoord = getLayoutCoord(graph, coord, vertices.size(), 8, 4, true, true, 0.1);
     for (int i(0); i < verticesCoord.size(); i++)
-      m_vertices[i].setV(verticesCoord[i]);
+      vertices[i].setV(verticesCoord[i]);
   }
 }
 
-void SocialNetProcessor::updateEdges()
+void SocialNetProcessor::updateEdges(const igraph_t *graph, const QList<Vertex> &vertices, QList<Edge> &edges)
 {
-  int nEdges = igraph_ecount(&m_graph);
+  int nEdges = igraph_ecount(graph);
 
   // retrieving edge weights
   igraph_vector_t weights;
   igraph_vector_init(&weights, nEdges);
-  EANV(&m_graph, "weight", &weights);
+  EANV(graph, "weight", &weights);
 
   for (int i(0); i < nEdges; i++) {
     
     // retrieve indices of adjacent vertices
     int from;
     int to;
-    igraph_edge(&m_graph, i, &from, &to);
+    igraph_edge(graph, i, &from, &to);
 
     // edge weight
     qreal edgeWeight = VECTOR(weights)[i];
 
     // coordinates of adjacent vertices
-    QVector3D v1 = m_vertices[from].getV();
-    QVector3D v2 = m_vertices[to].getV();
+    QVector3D v1 = vertices[from].getV();
+    QVector3D v2 = vertices[to].getV();
 
     // z axis along which draw edge cylinder
     QVector3D z(0, 0, 1);
@@ -1303,10 +1611,10 @@ void SocialNetProcessor::updateEdges()
     QPair<qreal, QPair<qreal, QVector3D> > v2Data(length, moveToV2);
 
     if (edgeWeight > 0.0) {
-      m_edges[i].setWeight(edgeWeight);
-      m_edges[i].setColorWeight(edgeWeight);
-      m_edges[i].setV1(v1);
-      m_edges[i].setV2(v2Data);
+      edges[i].setWeight(edgeWeight);
+      edges[i].setColorWeight(edgeWeight);
+      edges[i].setV1(v1);
+      edges[i].setV2(v2Data);
     }
   }
 
@@ -1379,7 +1687,7 @@ void SocialNetProcessor::setSceneSpeechSegments(QList<QList<SpeechSegment *> > s
 
   m_sceneSpeechSegments = sceneSpeechSegments;
   m_sceneInteractions.resize(m_sceneSpeechSegments.size());
-  m_networkViews.resize(m_sceneSpeechSegments.size());
+  m_networkViews.clear(m_sceneSpeechSegments.size());
   m_sceneRefs.resize(m_sceneSpeechSegments.size());
 
   m_verticesViews.resize(m_sceneSpeechSegments.size());
@@ -1401,6 +1709,26 @@ void SocialNetProcessor::setNbWeight(bool nbWeight)
   m_nbWeight = nbWeight;
 }
 
+void SocialNetProcessor::setViewThreads(int nThreads)
+{
+  // workers would share igraph random generator and error handling
+  if (nThreads != 0 && !parallelViewsSupported()) {
+    qWarning() << "igraph not built thread-safe: network views built serially";
+    nThreads = 0;
+  }
+
+  m_nViewThreads = nThreads;
+}
+
+bool SocialNetProcessor::parallelViewsSupported()
+{
+#if defined(IGRAPH_THREAD_SAFE) && IGRAPH_THREAD_SAFE
+  return true;
+#else
+  return false;
+#endif
+}
+
 ///////////////
 // accessors //
 ///////////////
@@ -1427,7 +1755,7 @@ QVector<QMap<QString, QMap<QString, qreal> > > SocialNetProcessor::getSceneInter
 
 QVector<QMap<QString, QMap<QString, qreal> > > SocialNetProcessor::getNetworkViews() const
 {
-  return m_networkViews;
+  return m_networkViews.toVector();
 }
 
 ///////////////////////
@@ -1649,19 +1977,24 @@ QVector<int> SocialNetProcessor::communityDetection_bis()
 }
 
 QVector<int> SocialNetProcessor::communityDetection_ter()
+{
+  return communityDetection_ter(&m_graph);
+}
+
+QVector<int> SocialNetProcessor::communityDetection_ter(const igraph_t *graph)
 {
   QVector<int> comAssign;
 
   // number of vertices and edges
-  int nVertices(igraph_vcount(&m_graph));
-  int nEdges(igraph_ecount(&m_graph));
+  int nVertices(igraph_vcount(graph));
+  int nEdges(igraph_ecount(graph));
   
   comAssign.resize(nVertices);
 
   // retrieving edge weights
   igraph_vector_t edgeWeights;
   igraph_vector_init(&edgeWeights, nEdges);
-  EANV(&m_graph, "weight", &edgeWeights);
+  EANV(graph, "weight", &edgeWeights);
 
   igraph_vector_t modularity;
   igraph_vector_t membership;
@@ -1671,7 +2004,7 @@ QVector<int> SocialNetProcessor::communityDetection_ter()
   igraph_vector_init(&membership, 0);
   igraph_matrix_init(&memberships, 0, 0);
 
-  igraph_community_multilevel(&m_graph, &edgeWeights, &membership, &memberships, &modularity);
+  igraph_community_multilevel(graph, &edgeWeights, &membership, &memberships, &modularity);
 
   // assign communities
   for (int i(0); i < nVertices; i++)
@@ -1850,12 +2183,12 @@ void SocialNetProcessor::exportGraphToPajekFile(const QMap<QString, QMap<QString
   }
 }
 
-QVector<QMap<QString, QMap<QString, qreal> > > SocialNetProcessor::buildNetworkSnapshots_bis()
+NetworkSnapshotStore SocialNetProcessor::buildNetworkSnapshots_bis()
 {
-  QVector<QMap<QString, QMap<QString, qreal> > > networkSnapshotsFromPast = buildNetworkSnapshotsFromPast();
-  QVector<QMap<QString, QMap<QString, qreal> > > networkSnapshotsFromFuture = buildNetworkSnapshotsFromFuture();
+  NetworkSnapshotStore networkSnapshotsFromPast = buildNetworkSnapshotsFromPast();
+  NetworkSnapshotStore networkSnapshotsFromFuture = buildNetworkSnapshotsFromFuture();
 
-  QVector<QMap<QString, QMap<QString, qreal> > > networkSnapshots = mergeNetworkSnapshots(networkSnapshotsFromPast, networkSnapshotsFromFuture);
+  NetworkSnapshotStore networkSnapshots = mergeNetworkSnapshots(networkSnapshotsFromPast, networkSnapshotsFromFuture);
 
   /*
   for (int i(0); i < networkSnapshots.size(); i++) {
@@ -1887,16 +2220,24 @@ QVector<QMap<QString, QMap<QString, qreal> > > SocialNetProcessor::buildNetworkS
   return networkSnapshots;
 }
 
-QVector<QMap<QString, QMap<QString, qreal> > > SocialNetProcessor::mergeNetworkSnapshots(const QVector<QMap<QString, QMap<QString, qreal> > > &networkSnapshotsFromPast, const QVector<QMap<QString, QMap<QString, qreal> > > &networkSnapshotsFromFuture)
+NetworkSnapshotStore SocialNetProcessor::mergeNetworkSnapshots(const NetworkSnapshotStore &networkSnapshotsFromPast, const NetworkSnapshotStore &networkSnapshotsFromFuture)
 {
-  QVector<QMap<QString, QMap<QString, qreal> > > networkSnapshots(networkSnapshotsFromPast.size());
+  NetworkSnapshotStore networkSnapshots;
+  int n(networkSnapshotsFromPast.size());
 
-  for (int i(0); i < networkSnapshots.size() - 1; i++) {
+  // snapshots from the future are stored from last scene to first
+  NetworkSnapshotStore::Cursor pastCursor(&networkSnapshotsFromPast);
+  NetworkSnapshotStore::Cursor futureCursor(&networkSnapshotsFromFuture);
+
+  for (int i(0); i < n - 1; i++) {
 
     QMap<QString, QMap<QString, qreal> > snapshot;
 
-    QMap<QString, QMap<QString, qreal> > snapshotFromPast = networkSnapshotsFromPast[i];
-    QMap<QString, QMap<QString, qreal> > snapshotFromFuture = networkSnapshotsFromFuture[i+1];
+    pastCursor.seek(i);
+    futureCursor.seek(n - 2 - i);
+
+    const QMap<QString, QMap<QString, qreal> > &snapshotFromPast = pastCursor.getSnapshot();
+    const QMap<QString, QMap<QString, qreal> > &snapshotFromFuture = futureCursor.getSnapshot();
 
     // loop over interactions built from the past
     QMap<QString, QMap<QString, qreal> >::const_iterator it1 = snapshotFromPast.begin();
@@ -1967,9 +2308,13 @@ QVector<QMap<QString, QMap<QString, qreal> > > SocialNetProcessor::mergeNetworkS
       it1++;
     }
     
-    networkSnapshots[i] = snapshot;
+    networkSnapshots.append(snapshot);
   }
 
+  // no future for last scene
+  if (n > 0)
+    networkSnapshots.append(QMap<QString, QMap<QString, qreal> >());
+
   return networkSnapshots;
 }
 
@@ -1999,20 +2344,20 @@ bool SocialNetProcessor::interactingSpeaker(const QString &spk, const QMap<QStri
   return false;
 }
 
-QVector<QMap<QString, QMap<QString, qreal> > > SocialNetProcessor::buildNetworkSnapshotsFromPast()
+NetworkSnapshotStore SocialNetProcessor::buildNetworkSnapshotsFromPast()
 {
-  QVector<QMap<QString, QMap<QString, qreal> > > networkSnapshotsFromPast(m_sceneInteractions.size());
+  NetworkSnapshotStore networkSnapshotsFromPast;
+
+  // single snapshot updated from one scene to the next
+  QMap<QString, QMap<QString, qreal> > networkSnapshot;
 
   for (int i(0); i < m_sceneInteractions.size(); i++) {
     
-    QMap<QString, QMap<QString, qreal> > networkSnapshot;
     QMap<QString, QMap<QString, qreal> > currSceneInteractions = m_sceneInteractions[i];
 
     // increment interaction weights
     if (i > 0) {
 
-      networkSnapshot = networkSnapshotsFromPast[i-1];
-
       QMap<QString, QMap<QString, qreal> >::const_iterator it1 = currSceneInteractions.begin();
 
       while (it1 != currSceneInteractions.end()) {
@@ -2061,26 +2406,27 @@ QVector<QMap<QString, QMap<QString, qreal> > > SocialNetProcessor::buildNetworkS
       it1++;
     }
 
-    networkSnapshotsFromPast[i] = networkSnapshot;
+    networkSnapshotsFromPast.append(networkSnapshot);
   }
 
   return networkSnapshotsFromPast;
 }
 
-QVector<QMap<QString, QMap<QString, qreal> > > SocialNetProcessor::buildNetworkSnapshotsFromFuture()
+NetworkSnapshotStore SocialNetProcessor::buildNetworkSnapshotsFromFuture()
 {
-  QVector<QMap<QString, QMap<QString, qreal> > > networkSnapshotsFromFuture(m_sceneInteractions.size());
+  NetworkSnapshotStore networkSnapshotsFromFuture;
+
+  // single snapshot updated from one scene to the previous one,
+  // snapshots being stored from last scene to first
+  QMap<QString, QMap<QString, qreal> > networkSnapshot;
 
   for (int i(m_sceneInteractions.size() - 1); i >= 0 ; i--) {
     
-    QMap<QString, QMap<QString, qreal> > networkSnapshot;
     QMap<QString, QMap<QString, qreal> > currSceneInteractions = m_sceneInteractions[i];
 
     // decrement interaction weights
     if (i < m_sceneInteractions.size() - 1) {
 
-      networkSnapshot = networkSnapshotsFromFuture[i+1];
-
       QMap<QString, QMap<QString, qreal> >::const_iterator it1 = currSceneInteractions.begin();
 
       while (it1 != currSceneInteractions.end()) {
@@ -2131,7 +2477,7 @@ QVector<QMap<QString, QMap<QString, qreal> > > SocialNetProcessor::buildNetworkS
       it1++;
     }
     
-    networkSnapshotsFromFuture[i] = networkSnapshot;
+    networkSnapshotsFromFuture.append(networkSnapshot);
   }
 
   return networkSnapshotsFromFuture;
@@ -2163,49 +2509,61 @@ void SocialNetProcessor::updateSnapshot(QMap<QString, QMap<QString, qreal> > &sn
   }
 }
 
-QVector<QMap<QString, QMap<QString, qreal> > > SocialNetProcessor::buildNetworkSnapshots()
+NetworkSnapshotStore SocialNetProcessor::buildNetworkSnapshots()
 {
-  QVector<QMap<QString, QMap<QString, qreal> > > networkSnapshots(m_sceneInteractions.size());
-  
+  int n(m_sceneInteractions.size());
+
+  // scene interactions on integer speaker ids
+  SpeakerDictionary speakers;
+  QVector<InteractionMatrix> sceneInter = InteractionMatrix::fromMaps(m_sceneInteractions, speakers);
+
   // scene occurences of speakers and interactions
-  QMap<QString, QList<QPair<int, qreal> > > speakerOcc;
-  QMap<QString, QMap<QString, QList<QPair<int, qreal> > > > interOcc;
+  QVector<QList<QPair<int, qreal> > > speakerOcc;
+  QVector<QList<QPair<int, qreal> > > interOcc;
+  QVector<QPair<int, int> > interPairs;
 
-  speakerOcc = getSpeakerOcc(m_sceneInteractions);
-  interOcc = getInterOcc(m_sceneInteractions);
+  speakerOcc = getSpeakerOcc(sceneInter, speakers.size());
+  interOcc = getInterOcc(sceneInter, interPairs);
 
-  // loop over interactions for building network views
-  QMap<QString, QMap<QString, QList<QPair<int, qreal> > > >::const_iterator it1 = interOcc.begin();
+  // loop over interactions for building network views: only weight
+  // changes from one scene to the next are kept
+  QVector<QList<QPair<int, qreal> > > sceneUpdates(n);
 
-  while (it1 != interOcc.end()) {
+  for (int p(0); p < interPairs.size(); p++) {
 
-    QString fSpeaker = it1.key();
-    QMap<QString, QList<QPair<int, qreal> > > interLocs = it1.value();
+    int fSpk = interPairs[p].first;
+    int sSpk = interPairs[p].second;
 
-    QMap<QString, QList<QPair<int, qreal> > >::const_iterator it2 = interLocs.begin();
+    // weight interaction in each scene
+    QVector<qreal> snapshotInter = getSceneWeights(interOcc[p], speakerOcc[fSpk], speakerOcc[sSpk], n);
 
-    while (it2 != interLocs.end()) {
+    for (int i(0); i < snapshotInter.size(); i++)
+      if (i == 0 || snapshotInter[i] != snapshotInter[i-1])
+	sceneUpdates[i].push_back(QPair<int, qreal>(p, snapshotInter[i]));
+  }
 
-      QString sSpeaker = it2.key();
-      QList<QPair<int, qreal> > scenesInter = it2.value();
+  // update snapshots
+  NetworkSnapshotStore networkSnapshots(speakers);
+  QVector<qreal> pairWeights(interPairs.size(), 0.0);
 
-      // weight interaction in each scene
-      QVector<qreal> snapshotInter = getSceneWeights(scenesInter, speakerOcc[fSpeaker], speakerOcc[sSpeaker], m_sceneInteractions.size());
+  for (int i(0); i < n; i++) {
 
-      // update snapshots
-      for (int i(0); i < snapshotInter.size(); i++)
-	networkSnapshots[i][fSpeaker][sSpeaker] = snapshotInter[i];
+    for (int j(0); j < sceneUpdates[i].size(); j++)
+      pairWeights[sceneUpdates[i][j].first] = sceneUpdates[i][j].second;
 
-      it2++;
-    }
+    InteractionMatrix snapshot;
 
-    it1++;
+    for (int p(0); p < interPairs.size(); p++)
+      snapshot.add(interPairs[p].first, interPairs[p].second, pairWeights[p]);
+
+    snapshot.compress(speakers.size());
+    networkSnapshots.append(snapshot);
   }
 
   return networkSnapshots;
 }
 
-QVector<QMap<QString, QMap<QString, qreal> > > SocialNetProcessor::buildCumNetworks(int timeSlice)
+NetworkSnapshotStore SocialNetProcessor::buildCumNetworks(int timeSlice)
 {
   QVector<QMap<QString, QMap<QString, qreal> > > cumNetworks;
   cumNetworks.resize(m_sceneInteractions.size() / timeSlice);
@@ -2247,17 +2605,17 @@ QVector<QMap<QString, QMap<QString, qreal> > > SocialNetProcessor::buildCumNetwo
     }
   }
 
-  QVector<QMap<QString, QMap<QString, qreal> > > expandedNet;
-  expandedNet.resize(cumNetworks.size() * timeSlice);
+  NetworkSnapshotStore expandedNet;
 
-  // expand the network to intermediate scenes
+  // expand the network to intermediate scenes: same snapshot,
+  // hence no update, over each time slice
   for (int i(0); i < cumNetworks.size(); i++) {
 
     int first = i * timeSlice;
     int last = timeSlice * (i + 1);
     
     for (int j(first); j < last; j++)
-      expandedNet[j] = cumNetworks[i];
+      expandedNet.append(cumNetworks[i]);
   }
 
   // qDebug() << m_sceneInteractions.size() << expandedNet.size();
@@ -2451,82 +2809,85 @@ QVector<qreal> SocialNetProcessor::weightEdges(const QVector<qreal> &sceneWeight
   return edgeWeights;
 }
 
-QMap<QString, QList<QPair<int, qreal> > > SocialNetProcessor::getSpeakerOcc(const QVector<QMap<QString, QMap<QString, qreal> > > &inter)
+QVector<QList<QPair<int, qreal> > > SocialNetProcessor::getSpeakerOcc(const QVector<InteractionMatrix> &inter, int nSpeakers)
 {
-  QMap<QString, QList<QPair<int, qreal> > > speakerOcc;
+  QVector<QList<QPair<int, qreal> > > speakerOcc(nSpeakers);
+  QVector<qreal> interDuration(nSpeakers, 0.0);
+  QVector<bool> involved(nSpeakers, false);
 
   // get speakers/nodes list
   for (int i(0); i < inter.size(); i++) {
 
-    QMap<QString, QMap<QString, qreal> >::const_iterator it1 = inter[i].begin();
+    const QVector<int> &rowPtr = inter[i].getRowPtr();
+    const QVector<int> &colIdx = inter[i].getColIdx();
+    const QVector<qreal> &values = inter[i].getValues();
+    QList<int> sceneSpeakers;
 
-    QMap<QString, qreal> interDuration;
+    for (int fSpk(0); fSpk < inter[i].getNRows(); fSpk++)
+      for (int k(rowPtr[fSpk]); k < rowPtr[fSpk + 1]; k++) {
 
-    while (it1 != inter[i].end()) {
+	int sSpk = colIdx[k];
+	qreal duration = values[k];
 
-      QString fSpeaker = it1.key();
-      QMap<QString, qreal> interlocs = it1.value();
-
-      QMap<QString, qreal>::const_iterator it2 = interlocs.begin();
+	interDuration[fSpk] += duration;
+	interDuration[sSpk] += duration;
 
-      while (it2 != interlocs.end()) {
-      
-	QString sSpeaker = it2.key();
-	qreal duration = it2.value();
+	if (!involved[fSpk]) {
+	  involved[fSpk] = true;
+	  sceneSpeakers.push_back(fSpk);
+	}
 
-	interDuration[fSpeaker] += duration;
-	interDuration[sSpeaker] += duration;
-	
-	it2++;
+	if (!involved[sSpk]) {
+	  involved[sSpk] = true;
+	  sceneSpeakers.push_back(sSpk);
+	}
       }
 
-      it1++;
-    }
+    // speaker ids sorted as speaker names
+    std::sort(sceneSpeakers.begin(), sceneSpeakers.end());
 
-    QMap<QString, qreal>::const_iterator it3 = interDuration.begin();
+    for (int j(0); j < sceneSpeakers.size(); j++) {
 
-    while (it3 != interDuration.end()) {
-      
-      QString speaker = it3.key();
-      qreal duration = it3.value();
+      int spk = sceneSpeakers[j];
 
-      speakerOcc[speaker].push_back(QPair<int, qreal>(i, duration));
+      speakerOcc[spk].push_back(QPair<int, qreal>(i, interDuration[spk]));
 
-      it3++;
+      interDuration[spk] = 0.0;
+      involved[spk] = false;
     }
   }
 
   return speakerOcc;
 }
 
-QMap<QString, QMap<QString, QList<QPair<int, qreal> > > > SocialNetProcessor::getInterOcc(const QVector<QMap<QString, QMap<QString, qreal> > > &inter)
+QVector<QList<QPair<int, qreal> > > SocialNetProcessor::getInterOcc(const QVector<InteractionMatrix> &inter, QVector<QPair<int, int> > &interPairs)
 {
-  QMap<QString, QMap<QString, QList<QPair<int, qreal> > > > interOcc;
+  QVector<QList<QPair<int, qreal> > > interOcc;
+  QHash<qint64, int> pairIdx;
+
+  interPairs.clear();
 
   // loop over narrative units
   for (int i(0); i < inter.size(); i++) {
 
-    QMap<QString, QMap<QString, qreal> >::const_iterator it1 = inter[i].begin();
+    const QVector<int> &rowPtr = inter[i].getRowPtr();
+    const QVector<int> &colIdx = inter[i].getColIdx();
+    const QVector<qreal> &values = inter[i].getValues();
 
-    while (it1 != inter[i].end()) {
+    for (int fSpk(0); fSpk < inter[i].getNRows(); fSpk++)
+      for (int k(rowPtr[fSpk]); k < rowPtr[fSpk + 1]; k++) {
 
-      QString fSpeaker = it1.key();
-      QMap<QString, qreal> interlocs = it1.value();
+	qint64 key = InteractionMatrix::pairKey(fSpk, colIdx[k]);
+	QHash<qint64, int>::const_iterator it = pairIdx.constFind(key);
 
-      QMap<QString, qreal>::const_iterator it2 = interlocs.begin();
+	if (it == pairIdx.constEnd()) {
+	  it = pairIdx.insert(key, interPairs.size());
+	  interPairs.push_back(QPair<int, int>(fSpk, colIdx[k]));
+	  interOcc.push_back(QList<QPair<int, qreal> >());
+	}
 
-      while (it2 != interlocs.end()) {
-	
-	QString sSpeaker = it2.key();
-	qreal duration = it2.value();
-	
-	interOcc[fSpeaker][sSpeaker].push_back(QPair<int, qreal>(i, duration));
-	
-	it2++;
+	interOcc[it.value()].push_back(QPair<int, qreal>(i, values[k]));
       }
-
-      it1++;
-    }
   }
 
   return interOcc;
@@ -2671,16 +3032,19 @@ void SocialNetProcessor::monitorPlot()
   IS.save("/home/xbost/Outils/tv_series_proc_tool/tools/sna/matlab/data/IS40.dat", arma::raw_ascii);
 }
 
-arma::vec SocialNetProcessor::monitorRelationWeight(const QString &fSpk, const QString &sSpk, const QVector<QMap<QString, QMap<QString, qreal> > > &netViews)
+arma::vec SocialNetProcessor::monitorRelationWeight(const QString &fSpk, const QString &sSpk, const NetworkSnapshotStore &netViews)
 {
   arma::vec W;
   W.zeros(netViews.size());
 
+  NetworkSnapshotStore::Cursor cursor(&netViews);
+
   for (int i(0); i < netViews.size(); i++) {
    
-    QMap<QString, QMap<QString, qreal> >::const_iterator it1 = netViews[i].begin();
+    cursor.seek(i);
+    QMap<QString, QMap<QString, qreal> >::const_iterator it1 = cursor.getSnapshot().begin();
 
-    while (it1 != netViews[i].end()) {
+    while (it1 != cursor.getSnapshot().end()) {
 
       QString fSpeaker = it1.key();
       QMap<QString, qreal> interLocs = it1.value();
@@ -2706,16 +3070,19 @@ arma::vec SocialNetProcessor::monitorRelationWeight(const QString &fSpk, const Q
   return W;
 }
 
-arma::vec SocialNetProcessor::monitorSpkStrength(const QString &spk, const QVector<QMap<QString, QMap<QString, qreal> > > &netViews)
+arma::vec SocialNetProcessor::monitorSpkStrength(const QString &spk, const NetworkSnapshotStore &netViews)
 {
   arma::vec S;
   S.zeros(netViews.size());
 
+  NetworkSnapshotStore::Cursor cursor(&netViews);
+
   for (int i(0); i < netViews.size(); i++) {
    
-    QMap<QString, QMap<QString, qreal> >::const_iterator it1 = netViews[i].begin();
+    cursor.seek(i);
+    QMap<QString, QMap<QString, qreal> >::const_iterator it1 = cursor.getSnapshot().begin();
 
-    while (it1 != netViews[i].end()) {
+    while (it1 != cursor.getSnapshot().end()) {
 
       QString fSpeaker = it1.key();
       QMap<QString, qreal> interLocs = it1.value();
@@ -3012,6 +3379,14 @@ void SocialNetProcessor::setNarrChart()
   setNarrChart_aux_bis(jMin, jMax, selSpeakers);
 }
 
+void SocialNetProcessor::setStorylineOrdering(bool exact, qreal timeLimit)
+{
+  // exact ordering of each snapshot, the model being reused from one
+  // snapshot to the next one
+  m_exactOrdering = exact;
+  m_optimizer->setOrderingTimeLimit(timeLimit);
+}
+
 void SocialNetProcessor::setNarrChart_aux_bis(int inf, int sup, const QStringList &speakers)
 {
   // number of snapshots
@@ -3042,8 +3417,14 @@ void SocialNetProcessor::setNarrChart_aux_bis(int inf, int sup, const QStringLis
 
       // qDebug() << "Scene" << k << j;
 
-      QMap<QString, QMap<QString, qreal> > neighbors = snapshotToNeighbors(j + inf);
-      QVector<int> pos = m_optimizer->barycenterOrdering(speakers, neighbors, initPos, nIter, refSpkWeight);
+      QVector<int> pos;
+
+      if (m_exactOrdering)
+	m_optimizer->orderStorylines(pos, getMatrix(speakers, j + inf), initPos);
+      else {
+	QMap<QString, QMap<QString, qreal> > neighbors = snapshotToNeighbors(j + inf);
+	pos = m_optimizer->barycenterOrdering(speakers, neighbors, initPos, nIter, refSpkWeight);
+      }
 
       for (int i(0); i < pos.size(); i++)
 	m_narrChart[speakers[i]][j] = QPoint(j + inf, pos[i]);
@@ -3056,8 +3437,14 @@ void SocialNetProcessor::setNarrChart_aux_bis(int inf, int sup, const QStringLis
 
       // qDebug() << "Scene" << k << j;
 
-      QMap<QString, QMap<QString, qreal> > neighbors = snapshotToNeighbors(j + inf);
-      QVector<int> pos = m_optimizer->barycenterOrdering(speakers, neighbors, initPos, nIter, refSpkWeight);
+      QVector<int> pos;
+
+      if (m_exactOrdering)
+	m_optimizer->orderStorylines(pos, getMatrix(speakers, j + inf), initPos);
+      else {
+	QMap<QString, QMap<QString, qreal> > neighbors = snapshotToNeighbors(j + inf);
+	pos = m_optimizer->barycenterOrdering(speakers, neighbors, initPos, nIter, refSpkWeight);
+      }
 
       for (int i(0); i < pos.size(); i++)
 	m_narrChart[speakers[i]][j] = QPoint(j + inf, pos[i]);
@@ -3074,9 +3461,10 @@ arma::mat SocialNetProcessor::getMatrix(const QStringList &speakers, int i)
   arma::mat A;
   A.zeros(speakers.size(), speakers.size());
 
-  QMap<QString, QMap<QString, qreal> >::const_iterator it1 = m_networkViews[i].begin();
+  QMap<QString, QMap<QString, qreal> > snapshot = m_networkViews[i];
+  QMap<QString, QMap<QString, qreal> >::const_iterator it1 = snapshot.begin();
 
-  while (it1 != m_networkViews[i].end()) {
+  while (it1 != snapshot.end()) {
 
     QString fSpk = it1.key();
     QMap<QString, qreal> interloc = it1.value();
@@ -3109,9 +3497,10 @@ QMap<QString, QMap<QString, qreal> > SocialNetProcessor::snapshotToNeighbors(int
 {
   QMap<QString, QMap<QString, qreal> > neighbors;
 
-  QMap<QString, QMap<QString, qreal> >::const_iterator it1 = m_networkViews[i].begin();
+  QMap<QString, QMap<QString, qreal> > snapshot = m_networkViews[i];
+  QMap<QString, QMap<QString, qreal> >::const_iterator it1 = snapshot.begin();
 
-  while (it1 != m_networkViews[i].end()) {
+  while (it1 != snapshot.end()) {
 
     QString fSpk = it1.key();
     QMap<QString, qreal> interloc = it1.value();
@@ -3224,11 +3613,14 @@ QStringList SocialNetProcessor::filterSpeakers(int iMin, int iMax, qreal minStre
   QStringList filSpeakers;
   QMap<QString, qreal> spkStrength;
 
+  NetworkSnapshotStore::Cursor cursor(&m_networkViews);
+
   for (int i(iMin); i <= iMax; i++) {
     
-    QMap<QString, QMap<QString, qreal> >::const_iterator it1 = m_networkViews[i].begin();
+    cursor.seek(i);
+    QMap<QString, QMap<QString, qreal> >::const_iterator it1 = cursor.getSnapshot().begin();
 
-    while (it1 != m_networkViews[i].end()) {
+    while (it1 != cursor.getSnapshot().end()) {
 
       QString fSpk = it1.key();
       QMap<QString, qreal> interloc = it1.value();
@@ -3,6 +3,8 @@
 
 #include <QObject>
 #include <QVector3D>
+#include <QProgressDialog>
+#include <QAtomicInt>
 #include <armadillo>
 
 #include <igraph.h>
@@ -12,6 +14,8 @@
 #include "Vertex.h"
 #include "Edge.h"
 #include "Optimizer.h"
+#include "InteractionMatrix.h"
+#include "NetworkSnapshotStore.h"
 
 class SocialNetProcessor: public QWidget
 {
@@ -32,6 +36,8 @@ public:
   void setDirected(bool directed);
   void setWeighted(bool weighted);
   void setNbWeight(bool nbWeight);
+  void setViewThreads(int nThreads);
+  static bool parallelViewsSupported();
   void setInterThresh(int interThresh);
   void setNbDiscard(int nbDiscard);
   
@@ -66,6 +72,7 @@ public:
   /////////////////////
 
   void setNarrChart();
+  void setStorylineOrdering(bool exact, qreal timeLimit = 1.0);
   void setNarrChart_aux(int inf, int sup, int jMin, const arma::mat &S, const QStringList &speakers, QMap<QString, QVector<QPoint> > &m_narrChart);
   QMap<QString, QVector<QPoint> > getNarrChart() const;
   QVector<int> posFromNarrChart(int index, const QStringList &selSpeakers, QMap<QString, QVector<QPoint> > &narrChart);
@@ -92,22 +99,31 @@ private:
   QList<Vertex> setVertices();
   QList<Edge> setEdges();
   QList<qreal> getNodeStrengths();
+  QList<qreal> getNodeStrengths(const igraph_t *graph);
   QList<QVector3D> getLayoutCoord(int nVertices, int nIter, qreal maxdelta, bool use_seed = false, bool twoDim = false);
+  QList<QVector3D> getLayoutCoord(const igraph_t *graph, igraph_matrix_t *coord, int nVertices, int nIter, qreal maxdelta, bool use_seed, bool twoDim, qreal minDisp = 0.0);
+  void runLayout(const igraph_t *graph, igraph_matrix_t *coord, int nIter, qreal maxdelta, qreal volume, qreal coolexp, qreal repulserad, bool use_seed, const igraph_vector_t *weights, bool twoDim);
+  void runAdaptiveLayout(const igraph_t *graph, igraph_matrix_t *coord, int nIter, qreal maxdelta, qreal volume, qreal coolexp, qreal repulserad, const igraph_vector_t *weights, bool twoDim, qreal minDisp);
+  void placeNewVertices(const igraph_t *graph, igraph_matrix_t *coord, const QList<Vertex> &vertices, const QList<qreal> &strengths);
 
   ///////////////////////////////////////////////
   // update network from view (graph + widget) //
   ///////////////////////////////////////////////
 
   void updateGraph(const QMap<QString, QMap<QString, qreal> > &currView);
+  void updateGraph(igraph_t *graph, const QMap<QString, QMap<QString, qreal> > &currView);
   void updateGraphWidget(bool layout);
-  void updateVertices(bool layout);
-  void updateEdges();
+  void updateGraphWidget(const igraph_t *graph, igraph_matrix_t *coord, QList<Vertex> &vertices, QList<Edge> &edges, bool layout);
+  void updateVertices(const igraph_t *graph, igraph_matrix_t *coord, QList<Vertex> &vertices, bool layout);
+  void updateEdges(const igraph_t *graph, const QList<Vertex> &vertices, QList<Edge> &edges);
 
   //////////////////////////////////////
   // community detection and matching //
   //////////////////////////////////////
 
   QVector<arma::vec> vectorizeCommunities(const QVector<int> &comAssign);
+  QVector<arma::vec> vectorizeCommunities(const QVector<int> &comAssign, const QList<Vertex> &vertices);
+  QVector<int> communityDetection_ter(const igraph_t *graph);
   QVector<arma::vec> vectorizeCommunities_bis(const QVector<int> &comAssign);
   void displayCommunities(const QVector<int> &comAssign, int minSize, qreal minStrength = 1.0) const;
   qreal jaccardIndex(const arma::vec &U, const arma::vec &V) const;
@@ -121,32 +137,45 @@ private:
   // handling views //
   ////////////////////
 
+  friend class ViewThread;
+
+  // layout and widget state a block of views starts from
+  struct ViewBlockStart {
+    igraph_matrix_t coord;
+    QList<Vertex> vertices;
+    QList<Edge> edges;
+  };
+
   void buildNetworkViews(bool layout);
+  bool buildViewsSerial(QVector<QVector<int> > &communityMatching, QProgressDialog &progress);
+  bool buildViewsParallel(QVector<QVector<int> > &communityMatching, QProgressDialog &progress);
+  void initBlockStarts(QVector<ViewBlockStart> &blockStarts);
+  void buildViews(int first, int last, const ViewBlockStart *blockStarts, QList<Vertex> *verticesViews, QList<Edge> *edgesViews, QVector<arma::vec> *comVec, QAtomicInt *nDone, QAtomicInt *abort);
   void updateSceneRefs(int i);
 
-  QVector<QMap<QString, QMap<QString, qreal> > > buildNetworkSnapshots();
-  QVector<QMap<QString, QMap<QString, qreal> > > buildNetworkSnapshots_bis();
+  NetworkSnapshotStore buildNetworkSnapshots();
+  NetworkSnapshotStore buildNetworkSnapshots_bis();
 
   bool interactingSpeaker(const QString &spk, const QMap<QString, QMap<QString, qreal> > &network);
 
-  QVector<QMap<QString, QMap<QString, qreal> > > mergeNetworkSnapshots(const QVector<QMap<QString, QMap<QString, qreal> > > &networkSnapshotsFromPast, const QVector<QMap<QString, QMap<QString, qreal> > > &networkSnapshotsFromFuture);
-  QVector<QMap<QString, QMap<QString, qreal> > > buildNetworkSnapshotsFromPast();
-  QVector<QMap<QString, QMap<QString, qreal> > > buildNetworkSnapshotsFromFuture();
+  NetworkSnapshotStore mergeNetworkSnapshots(const NetworkSnapshotStore &networkSnapshotsFromPast, const NetworkSnapshotStore &networkSnapshotsFromFuture);
+  NetworkSnapshotStore buildNetworkSnapshotsFromPast();
+  NetworkSnapshotStore buildNetworkSnapshotsFromFuture();
 
   qreal sigmoid(qreal x, qreal lambda = 0.01);
 
   void updateSnapshot(QMap<QString, QMap<QString, qreal> > &snapshot, const QString &fSpeaker, const QString &sSpeaker, qreal weight);
 
-  QMap<QString, QList<QPair<int, qreal> > > getSpeakerOcc(const QVector<QMap<QString, QMap<QString, qreal> > > &inter);
-  QMap<QString, QMap<QString, QList<QPair<int, qreal> > > > getInterOcc(const QVector<QMap<QString, QMap<QString, qreal> > > &inter);
+  QVector<QList<QPair<int, qreal> > > getSpeakerOcc(const QVector<InteractionMatrix> &inter, int nSpeakers);
+  QVector<QList<QPair<int, qreal> > > getInterOcc(const QVector<InteractionMatrix> &inter, QVector<QPair<int, int> > &interPairs);
   QVector<qreal> getSceneWeights(const QList<QPair<int, qreal> > &interOcc, const QList<QPair<int, qreal> > &fSpeakerOcc, const QList<QPair<int, qreal> > &sSpeakerOcc, int n);
   QVector<qreal> weightEdges(const QVector<qreal> &sceneWeights, qreal lambda) const;
 
-  QVector<QMap<QString, QMap<QString, qreal> > > buildCumNetworks(int timeSlice);
+  NetworkSnapshotStore buildCumNetworks(int timeSlice);
 
   void normalizeWeights();
-  arma::vec monitorRelationWeight(const QString &fSpk, const QString &sSpk, const QVector<QMap<QString, QMap<QString, qreal> > > &netViews);
-  arma::vec monitorSpkStrength(const QString &spk, const QVector<QMap<QString, QMap<QString, qreal> > > &netViews);
+  arma::vec monitorRelationWeight(const QString &fSpk, const QString &sSpk, const NetworkSnapshotStore &netViews);
+  arma::vec monitorSpkStrength(const QString &spk, const NetworkSnapshotStore &netViews);
   void monitorPlot();
 
   /////////////////////////
@@ -168,7 +197,7 @@ private:
   arma::vec simToNeighborsNeighborhood(const QString &speaker, const QMap<QString, QMap<QString, qreal> > &edges);
 
   QVector<QMap<QString, QMap<QString, qreal> > > m_sceneInteractions;
-  QVector<QMap<QString, QMap<QString, qreal> > > m_networkViews;
+  NetworkSnapshotStore m_networkViews;
   QList<QList<SpeechSegment *> > m_sceneSpeechSegments;
 
   QVector<QPair<int, int> > m_sceneRefs;
@@ -191,6 +220,15 @@ private:
   QList<QList<QPair<int, int> > > m_dynCommunities;
 
   QMap<QString, QVector<QPoint> > m_narrChart;
+  bool m_exactOrdering;
+
+  // threads building views (ideal count when negative), serial views
+  // chained when 0, only possible with thread-safe igraph
+  int m_nViewThreads;
+
+  // views chained within blocks when built in parallel, each block
+  // starting from the layout of the last view of the previous one
+  int m_viewBlockSize;
 
   Optimizer *m_optimizer;
 };
@@ -0,0 +1,89 @@
+#include <algorithm>
+
+#include "SpeakerDictionary.h"
+
+// ordering of speaker ids by name
+class NameOrder
+{
+ public:
+  NameOrder(const QVector<QString> &names)
+    : m_names(names) {}
+
+  bool operator()(int i, int j) const { return m_names[i] < m_names[j]; }
+
+ private:
+  const QVector<QString> &m_names;
+};
+
+//////////////////
+// constructors //
+//////////////////
+
+SpeakerDictionary::SpeakerDictionary()
+  : m_sorted(true)
+{
+}
+
+SpeakerDictionary::SpeakerDictionary(QStringList names)
+  : m_sorted(true)
+{
+  names.sort();
+  names.removeDuplicates();
+
+  for (int i(0); i < names.size(); i++)
+    intern(names[i]);
+}
+
+////////////////////
+// public methods //
+////////////////////
+
+int SpeakerDictionary::intern(const QString &name)
+{
+  QHash<QString, int>::const_iterator it = m_ids.find(name);
+
+  if (it != m_ids.end())
+    return it.value();
+
+  if (!m_names.isEmpty() && !(m_names.last() < name))
+    m_sorted = false;
+
+  int id(m_names.size());
+  m_ids.insert(name, id);
+  m_names.push_back(name);
+
+  return id;
+}
+
+int SpeakerDictionary::getId(const QString &name) const
+{
+  return m_ids.value(name, -1);
+}
+
+QString SpeakerDictionary::getName(int id) const
+{
+  return m_names[id];
+}
+
+int SpeakerDictionary::size() const
+{
+  return m_names.size();
+}
+
+bool SpeakerDictionary::isSorted() const
+{
+  return m_sorted;
+}
+
+QVector<int> SpeakerDictionary::getOrder() const
+{
+  QVector<int> order(m_names.size());
+
+  for (int i(0); i < order.size(); i++)
+    order[i] = i;
+
+  if (!m_sorted)
+    std::sort(order.begin(), order.end(), NameOrder(m_names));
+
+  return order;
+}
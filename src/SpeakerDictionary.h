@@ -0,0 +1,35 @@
+#ifndef SPEAKERDICTIONARY_H
+#define SPEAKERDICTIONARY_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+
+///////////////////////////////////////////////////////
+// speaker names mapped to dense integer ids: ids    //
+// given to a list of names at once follow the name  //
+// order, so that sorting ids amounts to sorting     //
+// names as in maps keyed by speaker                 //
+///////////////////////////////////////////////////////
+
+class SpeakerDictionary
+{
+ public:
+  SpeakerDictionary();
+  SpeakerDictionary(QStringList names);
+
+  int intern(const QString &name);
+  int getId(const QString &name) const;
+  QString getName(int id) const;
+  int size() const;
+  bool isSorted() const;
+  QVector<int> getOrder() const;
+
+ private:
+  QHash<QString, int> m_ids;
+  QVector<QString> m_names;
+  bool m_sorted;
+};
+
+#endif
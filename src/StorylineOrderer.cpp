@@ -0,0 +1,268 @@
+#include <QDebug>
+
+#include "StorylineOrderer.h"
+
+using namespace std;
+
+/////////////////////////////////
+// constructor and destructor  //
+/////////////////////////////////
+
+StorylineOrderer::StorylineOrderer()
+  : m_n(0),
+    m_T(0),
+    m_built(false),
+    m_optimal(false),
+    m_timeLimit(1.0),
+    m_uCoef(0.0)
+{
+}
+
+StorylineOrderer::~StorylineOrderer()
+{
+  m_env.end();
+}
+
+////////////////////
+// public methods //
+////////////////////
+
+void StorylineOrderer::setTimeLimit(qreal timeLimit)
+{
+  m_timeLimit = timeLimit;
+}
+
+qreal StorylineOrderer::getTimeLimit() const
+{
+  return m_timeLimit;
+}
+
+qreal StorylineOrderer::order(QVector<QVector<int> > &pos, const arma::mat &W, const QVector<QVector<int> > &fixedPos, const QVector<QVector<int> > &startPos, qreal alpha)
+{
+  // number of speakers and snapshots
+  int n = W.n_rows;
+  int T = (n > 0) ? W.n_cols / n : 0;
+
+  qreal objValue(-1.0);
+  m_optimal = false;
+
+  pos.resize(n);
+  for (int i(0); i < n; i++)
+    pos[i] = QVector<int>(T, -1);
+
+  if (n == 0 || T == 0)
+    return objValue;
+
+  try {
+
+    // model built again only when its dimensions change
+    if (!m_built || n != m_n || T != m_T)
+      build(n, T);
+
+    updateCoefs(W, alpha);
+    updateBounds(fixedPos);
+    setMIPStart(startPos.isEmpty() ? m_lastPos : startPos);
+
+    // best solution found so far returned when time limit is reached
+    m_cplex.setParam(IloCplex::TiLim, (m_timeLimit > 0.0) ? m_timeLimit : 1e75);
+
+    if (!m_cplex.solve())
+      return objValue;
+
+    m_optimal = (m_cplex.getStatus() == IloAlgorithm::Optimal);
+    objValue = m_cplex.getObjValue();
+
+    for (int i(0); i < n; i++)
+      for (int t(0); t < T; t++)
+	pos[i][t] = IloRound(m_cplex.getValue(m_x[i][t]));
+
+    m_lastPos = pos;
+  }
+
+  catch (IloException &e) {
+    cerr << "Concert exception caught: " << e << endl;
+    m_built = false;
+  }
+
+  catch (...) {
+    cerr << "Unknown exception caught: " << endl;
+    m_built = false;
+  }
+
+  return objValue;
+}
+
+bool StorylineOrderer::isOptimal() const
+{
+  return m_optimal;
+}
+
+/////////////////////
+// private methods //
+/////////////////////
+
+void StorylineOrderer::build(int n, int T)
+{
+  clear();
+
+  m_n = n;
+  m_T = T;
+
+  // maximum x coordinate
+  int max(n - 1);
+  int nPairs(n * (n - 1) / 2);
+
+  m_model = IloModel(m_env);
+
+  // var x[i][t]: rank assigned to i-th speaker in snapshot t
+  m_x = IloArray<IloIntVarArray>(m_env, n);
+  for (int i(0); i < n; i++)
+    m_x[i] = IloIntVarArray(m_env, T, 0, max);
+
+  // d[i][j][t] = |x[i][t] - x[j][t]|: additional variables used to
+  // linearize objective, a single one per pair of speakers
+  m_d = IloIntVarArray(m_env, nPairs * T, 0, max);
+
+  // u[i][t] = |x[i][t] - x[i][t+1]|: same for successive snapshots
+  m_u = IloIntVarArray(m_env, n * (T - 1), 0, max);
+
+  // objective function: coefficients set for each call
+  m_obj = IloMinimize(m_env);
+  m_model.add(m_obj);
+
+  // linearization constraints
+  for (int t(0); t < T; t++)
+    for (int i(0); i < n - 1; i++)
+      for (int j(i+1); j < n; j++) {
+	m_model.add(m_d[pairIdx(i, j, t)] >= m_x[i][t] - m_x[j][t]);
+	m_model.add(m_d[pairIdx(i, j, t)] >= m_x[j][t] - m_x[i][t]);
+      }
+
+  for (int i(0); i < n; i++)
+    for (int t(0); t < T - 1; t++) {
+      m_model.add(m_u[i * (T - 1) + t] >= m_x[i][t] - m_x[i][t+1]);
+      m_model.add(m_u[i * (T - 1) + t] >= m_x[i][t+1] - m_x[i][t]);
+    }
+
+  // all different in snapshot t constraints
+  for (int t(0); t < T; t++)
+    for (int i(0); i < n - 1; i++)
+      for (int j(i+1); j < n; j++)
+	m_model.add(m_x[i][t] != m_x[j][t]);
+
+  m_cplex = IloCplex(m_model);
+
+  // no output in terminal
+  m_cplex.setOut(m_env.getNullStream());
+  m_cplex.setWarning(m_env.getNullStream());
+
+  m_dCoefs.zeros(nPairs * T);
+  m_uCoef = 0.0;
+  m_fixed.set_size(n, T);
+  m_fixed.fill(-1);
+
+  m_built = true;
+}
+
+void StorylineOrderer::clear()
+{
+  // all extractables are released along with the environment
+  m_env.end();
+  m_env = IloEnv();
+
+  m_lastPos.clear();
+  m_built = false;
+}
+
+void StorylineOrderer::updateCoefs(const arma::mat &W, qreal alpha)
+{
+  int n(m_n);
+
+  // weights of edges linking speakers i and j in snapshot t
+  for (int t(0); t < m_T; t++)
+    for (int i(0); i < n - 1; i++)
+      for (int j(i+1); j < n; j++) {
+
+	int k = pairIdx(i, j, t);
+	qreal coef = (1.0 - alpha) * (W(i, t * n + j) + W(j, t * n + i));
+
+	if (coef != m_dCoefs(k)) {
+	  m_obj.setLinearCoef(m_d[k], coef);
+	  m_dCoefs(k) = coef;
+	}
+      }
+
+  if (alpha != m_uCoef) {
+
+    for (IloInt k(0); k < m_u.getSize(); k++)
+      m_obj.setLinearCoef(m_u[k], alpha);
+
+    m_uCoef = alpha;
+  }
+}
+
+void StorylineOrderer::updateBounds(const QVector<QVector<int> > &fixedPos)
+{
+  for (int i(0); i < m_n; i++)
+    for (int t(0); t < m_T; t++) {
+
+      int rank = (i < fixedPos.size() && t < fixedPos[i].size()) ? fixedPos[i][t] : -1;
+
+      if (rank != m_fixed(i, t)) {
+
+	if (rank == -1)
+	  m_x[i][t].setBounds(0, m_n - 1);
+	else
+	  m_x[i][t].setBounds(rank, rank);
+
+	m_fixed(i, t) = rank;
+      }
+    }
+}
+
+void StorylineOrderer::setMIPStart(const QVector<QVector<int> > &startPos)
+{
+  if (m_cplex.getNMIPStarts() > 0)
+    m_cplex.deleteMIPStarts(0, m_cplex.getNMIPStarts());
+
+  // start ignored unless complete
+  if (startPos.size() != m_n)
+    return;
+
+  for (int i(0); i < m_n; i++)
+    if (startPos[i].size() != m_T)
+      return;
+
+  IloNumVarArray vars(m_env);
+  IloNumArray vals(m_env);
+
+  for (int i(0); i < m_n; i++)
+    for (int t(0); t < m_T; t++) {
+      vars.add(m_x[i][t]);
+      vals.add(startPos[i][t]);
+    }
+
+  // additional variables deduced from ranks
+  for (int t(0); t < m_T; t++)
+    for (int i(0); i < m_n - 1; i++)
+      for (int j(i+1); j < m_n; j++) {
+	vars.add(m_d[pairIdx(i, j, t)]);
+	vals.add(qAbs(startPos[i][t] - startPos[j][t]));
+      }
+
+  for (int i(0); i < m_n; i++)
+    for (int t(0); t < m_T - 1; t++) {
+      vars.add(m_u[i * (m_T - 1) + t]);
+      vals.add(qAbs(startPos[i][t] - startPos[i][t+1]));
+    }
+
+  m_cplex.addMIPStart(vars, vals);
+
+  vars.end();
+  vals.end();
+}
+
+int StorylineOrderer::pairIdx(int i, int j, int t) const
+{
+  return t * (m_n * (m_n - 1) / 2) + i * m_n - i * (i + 1) / 2 + j - i - 1;
+}
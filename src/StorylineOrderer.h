@@ -0,0 +1,58 @@
+#ifndef STORYLINEORDERER_H
+#define STORYLINEORDERER_H
+
+#include <QVector>
+
+#include <ilcplex/ilocplex.h>
+#include <armadillo>
+
+///////////////////////////////////////////////////////
+// ordering of speaker storylines over network       //
+// snapshots: the CPLEX model is kept alive between  //
+// calls with the same number of speakers and        //
+// snapshots, only changed coefficients and bounds   //
+// are updated and the previous ordering is given    //
+// as a MIP start                                    //
+///////////////////////////////////////////////////////
+
+class StorylineOrderer
+{
+ public:
+  StorylineOrderer();
+  ~StorylineOrderer();
+
+  void setTimeLimit(qreal timeLimit);
+  qreal getTimeLimit() const;
+
+  qreal order(QVector<QVector<int> > &pos, const arma::mat &W, const QVector<QVector<int> > &fixedPos, const QVector<QVector<int> > &startPos, qreal alpha);
+  bool isOptimal() const;
+
+ private:
+  void build(int n, int T);
+  void clear();
+  void updateCoefs(const arma::mat &W, qreal alpha);
+  void updateBounds(const QVector<QVector<int> > &fixedPos);
+  void setMIPStart(const QVector<QVector<int> > &startPos);
+  int pairIdx(int i, int j, int t) const;
+
+  IloEnv m_env;
+  IloModel m_model;
+  IloCplex m_cplex;
+  IloObjective m_obj;
+  IloArray<IloIntVarArray> m_x;  // rank of speaker i in snapshot t
+  IloIntVarArray m_d;            // |x[i][t] - x[j][t]| for i < j
+  IloIntVarArray m_u;            // |x[i][t] - x[i][t+1]|
+
+  int m_n;
+  int m_T;
+  bool m_built;
+  bool m_optimal;
+  qreal m_timeLimit;
+
+  arma::vec m_dCoefs;            // current objective coefficients
+  qreal m_uCoef;
+  arma::imat m_fixed;            // fixed ranks, -1 if free
+  QVector<QVector<int> > m_lastPos;
+};
+
+#endif
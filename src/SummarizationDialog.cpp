@@ -61,6 +61,12 @@ SummarizationDialog::SummarizationDialog(const QString &title, const QStringList
   m_granuSB->setMaximum(200);
   m_granuSB->setValue(100);
 
+  QLabel *selectionLabel = new QLabel(tr("<b>Selection:</b>"));
+  m_selectionCB = new QComboBox;
+  m_selectionCB->addItem(tr("Greedy (MMR)"));
+  m_selectionCB->addItem(tr("Greedy (gain per duration)"));
+  m_selectionCB->addItem(tr("Exact (knapsack)"));
+
   QGridLayout *gridLayout = new QGridLayout;
   gridLayout->addWidget(typeBox, 0, 0);
   gridLayout->addWidget(methodBox, 1, 0);
@@ -72,7 +78,9 @@ SummarizationDialog::SummarizationDialog(const QString &title, const QStringList
   gridLayout->addWidget(m_durSB, 4, 3);
   gridLayout->addWidget(granuLabel, 5, 0);
   gridLayout->addWidget(m_granuSB, 5, 3);
-  gridLayout->addWidget(buttonBox, 6, 0, 1, 4, Qt::AlignHCenter);
+  gridLayout->addWidget(selectionLabel, 6, 0);
+  gridLayout->addWidget(m_selectionCB, 6, 1, 1, 3);
+  gridLayout->addWidget(buttonBox, 7, 0, 1, 4, Qt::AlignHCenter);
 
   setLayout(gridLayout);
 
@@ -164,3 +172,8 @@ SummarizationDialog::Method SummarizationDialog::getMethod() const
 {
   return m_method;
 }
+
+SummarizationDialog::Selection SummarizationDialog::getSelection() const
+{
+  return static_cast<SummarizationDialog::Selection>(m_selectionCB->currentIndex());
+}
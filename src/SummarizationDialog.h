@@ -14,6 +14,11 @@ class SummarizationDialog: public QDialog
     Content, Style, Both, Random
   };
 
+  // selection of LSUs under duration budget
+  enum Selection {
+    Mmr, RatioGreedy, Knapsack
+  };
+
   SummarizationDialog(const QString &title, const QStringList &seasons, const QStringList &allSpeakers, const QList<QStringList> &seasonSpeakers, QWidget *parent = 0);
 
   int getSeasonNb() const;
@@ -21,6 +26,7 @@ class SummarizationDialog: public QDialog
   int getDur() const;
   qreal getGranu() const;
   Method getMethod() const;
+  Selection getSelection() const;
 
   public slots:
     void seasonChanged(int index);
@@ -38,6 +44,7 @@ class SummarizationDialog: public QDialog
     QComboBox *m_charCB;
     QSpinBox *m_durSB;
     QSpinBox *m_granuSB;
+    QComboBox *m_selectionCB;
     SummarizationDialog::Method m_method;
 };
 
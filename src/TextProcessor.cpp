@@ -3,6 +3,8 @@
 #include <QRegularExpression>
 #include <QtCore/qmath.h>
 
+#include <algorithm>
+
 #include "TextProcessor.h"
 
 using namespace arma;
@@ -24,8 +26,7 @@ TextProcessor::TextProcessor(QObject *parent)
     QStringList unigrams = extractNGrams(processedLine);
 
     for (int i(0); i < unigrams.size(); i++)
-      if (!m_stopList.contains(unigrams[i]))
-	m_stopList.push_back(unigrams[i]);
+      m_stopList.insert(unigrams[i]);
   }
 }
 
@@ -33,6 +34,8 @@ void TextProcessor::setIndex(const QList<QString> &subText)
 {
   QString processedText;
   QStringList nGrams;
+  m_vocabulary.clear();
+  m_index.clear();
   m_index.resize(subText.size());
 
   for (int i(0); i < subText.size(); i++) {
@@ -44,21 +47,18 @@ void TextProcessor::setIndex(const QList<QString> &subText)
       nGrams = extractNGrams(processedText);
 
       // number of occurrences of each ngram in current subtitle
-      QMap<QString, int> nOcc;
+      QMap<int, int> nOcc;
 
       for (int j(0); j < nGrams.size(); j++)
-	nOcc[nGrams[j]]++;
+	if (!m_stopList.contains(nGrams[j]))
+	  nOcc[getTermId(nGrams[j])]++;
 
-      // updating inverted index
-      QMap<QString, int>::const_iterator it =  nOcc.begin();
+      // updating index, terms sorted by id
+      QMap<int, int>::const_iterator it =  nOcc.begin();
+      m_index[i].reserve(nOcc.size());
 
       while (it != nOcc.end()) {
-
-	QString nGram = it.key();
-
-	if (!m_stopList.contains(nGram))
-	  m_index[i].push_back(QPair<QString, int>(nGram, it.value()));
-
+	m_index[i].push_back(QPair<int, int>(it.key(), it.value()));
 	it++;
       }
     }
@@ -108,12 +108,25 @@ QStringList TextProcessor::extractNGrams(const QString &processedText)
   return nGrams;
 }
 
+int TextProcessor::getTermId(const QString &nGram)
+{
+  QHash<QString, int>::const_iterator it = m_vocabulary.constFind(nGram);
+
+  if (it != m_vocabulary.constEnd())
+    return it.value();
+
+  int id = m_vocabulary.size();
+  m_vocabulary.insert(nGram, id);
+
+  return id;
+}
+
 mat TextProcessor::computeLSULexSim(const QList<QPair<int, int> > &lsuUtterBound)
 {
   arma::mat S;
   S.zeros(lsuUtterBound.size(), lsuUtterBound.size());
-  QVector<QList<QPair<QString, int> > > lsuIndex;
-  QMap<QString, qreal> lsuIdf;
+  QVector<QVector<QPair<int, int> > > lsuIndex;
+  QVector<qreal> lsuIdf;
   QList<QList<int> > subLSU;
 
   // enumerating all utterances covered by each LSU
@@ -127,64 +140,111 @@ mat TextProcessor::computeLSULexSim(const QList<QPair<int, int> > &lsuUtterBound
     subLSU.push_back(uttIndices);
   }
 
-  // generating inverted index term <-> LSU as a document
+  // generating index term <-> LSU as a document
   lsuIndex = genDocIndex(subLSU);
 
   // compute LSU Inverse Document Frequency
   lsuIdf = computeIdf(lsuIndex);
-  
-  // loop twice over LSUs to compute cosine similarity
-  for (int i(0); i < lsuIndex.size() - 1; i++) {
-    for (int j(i+1); j < lsuIndex.size(); j++)
-      if (lsuUtterBound[i].first != -1 && lsuUtterBound[j].first != -1) {
-      
-	/*
-	qDebug() << lsuUtterBound[i].first << "<->" << lsuUtterBound[i].second;
-	qDebug() << lsuUtterBound[j].first << "<->" << lsuUtterBound[j].second;
-	qDebug();
-	*/
-	S(i, j) = computeSimCos(lsuIndex[i], lsuIndex[j], lsuIdf);
+
+  // TF-IDF vectors and their lengths
+  QVector<qreal> norms;
+  QVector<QVector<QPair<int, qreal> > > lsuVec = computeTfIdf(lsuIndex, lsuIdf, norms);
+
+  // LSUs containing each term
+  QVector<QVector<QPair<int, qreal> > > postings = invertIndex(lsuVec);
+
+  // scalar products with next LSUs, accumulated over shared terms only
+  QVector<qreal> scalProd(lsuVec.size(), 0.0);
+  QVector<int> neighbors;
+
+  for (int i(0); i < lsuVec.size() - 1; i++) {
+
+    if (lsuUtterBound[i].first == -1 || norms[i] == 0.0)
+      continue;
+
+    for (int k(0); k < lsuVec[i].size(); k++) {
+
+      const QVector<QPair<int, qreal> > &termPostings = postings[lsuVec[i][k].first];
+      qreal w = lsuVec[i][k].second;
+
+      // postings sorted by LSU: next LSUs at the end
+      for (int l(termPostings.size() - 1); l >= 0 && termPostings[l].first > i; l--) {
+
+	int j = termPostings[l].first;
+
+	if (scalProd[j] == 0.0)
+	  neighbors.push_back(j);
+
+	scalProd[j] += w * termPostings[l].second;
+      }
     }
+
+    // cosine similarity
+    for (int k(0); k < neighbors.size(); k++) {
+
+      int j = neighbors[k];
+
+      if (lsuUtterBound[j].first != -1)
+	S(i, j) = scalProd[j] / (norms[i] * norms[j]);
+
+      scalProd[j] = 0.0;
+    }
+
+    neighbors.clear();
   }
 
   return S;
 }
 
-QVector<QList<QPair<QString, int> > > TextProcessor::genDocIndex(const QList<QList<int> > &subDoc)
+QVector<QVector<QPair<int, int> > > TextProcessor::genDocIndex(const QList<QList<int> > &subDoc)
 {
-  QVector<QList<QPair<QString, int> > > docIndex;
-  docIndex.resize(subDoc.size());
+  QVector<QVector<QPair<int, int> > > docIndex(subDoc.size());
+
+  // term counts of current document
+  QVector<int> counts(m_vocabulary.size(), 0);
+  QVector<int> terms;
 
   // looping over utterances contained in each document
   for (int i(0); i < subDoc.size(); i++) {
 
-    QList<int> subIndices = subDoc[i];
+    const QList<int> &subIndices = subDoc[i];
+
+    for (int j(0); j < subIndices.size(); j++) {
 
-      for (int j(0); j < subIndices.size(); j++) {
+      // document contains speech: update document/term matrix
+      if (subIndices[j] != -1) {
 
-	// document contains speech: update document/term matrix
-	if (subIndices[j] != -1) {
+	const QVector<QPair<int, int> > &termFreq = m_index[subIndices[j]];
 
-	  QList<QPair<QString, int> > termFreq = m_index[subIndices[j]];
+	for (int k(0); k < termFreq.size(); k++) {
 
-	  for (int k(0); k < termFreq.size(); k++) {
+	  if (counts[termFreq[k].first] == 0)
+	    terms.push_back(termFreq[k].first);
 
-	    if (!containsFirst(docIndex[i], termFreq[k].first))
-	      docIndex[i].push_back(termFreq[k]);
-	    else
-	      updateCount(docIndex[i], termFreq[k].first, termFreq[k].second);
-	  }
+	  counts[termFreq[k].first] += termFreq[k].second;
 	}
       }
+    }
+
+    // terms sorted by id
+    std::sort(terms.begin(), terms.end());
+    docIndex[i].reserve(terms.size());
+
+    for (int k(0); k < terms.size(); k++) {
+      docIndex[i].push_back(QPair<int, int>(terms[k], counts[terms[k]]));
+      counts[terms[k]] = 0;
+    }
+
+    terms.clear();
   }
   
   return docIndex;
 }
 
-QMap<QString, qreal> TextProcessor::computeIdf(const QVector<QList<QPair<QString, int> > > &docIndex)
+QVector<qreal> TextProcessor::computeIdf(const QVector<QVector<QPair<int, int> > > &docIndex)
 {
-  QMap<QString, qreal> idf;
-  QMap<QString, int> df;
+  QVector<qreal> idf(m_vocabulary.size(), 0.0);
+  QVector<int> df(m_vocabulary.size(), 0);
 
   // looping over documents to estimate document frequency
   for (int i(0); i < docIndex.size(); i++)
@@ -192,129 +252,47 @@ QMap<QString, qreal> TextProcessor::computeIdf(const QVector<QList<QPair<QString
       df[docIndex[i][j].first]++;
 
   // looping over terms to estimate inverse document frequency
-  QMap<QString, int>::const_iterator it = df.begin();
-  while (it != df.end()) {
-
-    QString nGram = it.key();
-
-    idf[nGram] = qLn(static_cast<qreal>(docIndex.size()) / df[nGram]);
-
-    it++;
-  }
+  for (int i(0); i < df.size(); i++)
+    if (df[i] > 0)
+      idf[i] = qLn(static_cast<qreal>(docIndex.size()) / df[i]);
 
   return idf;
 }
 
-qreal TextProcessor::computeSimCos(const QList<QPair<QString, int> > &v1, const QList<QPair<QString, int> > &v2, const QMap<QString, qreal> &idf)
+QVector<QVector<QPair<int, qreal> > > TextProcessor::computeTfIdf(const QVector<QVector<QPair<int, int> > > &docIndex, const QVector<qreal> &idf, QVector<qreal> &norms)
 {
-  qreal cos(0.0);
-  qreal l1(0.0);
-  qreal l2(0.0);
-  int n1(v1.size());
-  int n2(v2.size());
-  QMap<qreal, QString> ctb;
-
-  /*
-  // display vector content for debugging purpose
-  qDebug() << "V1 -->";
-  for (int i(0); i < n1; i++)
-    qDebug() << v1[i].first;
-
-  qDebug();
-
-  qDebug() << "V2 -->";
-  for (int i(0); i < n2; i++)
-    qDebug() << v2[i].first;
-
-  qDebug();
-  */
-
-  // compute lengths of each vector
-  for (int i(0); i < n1; i++)
-    l1 += qPow(v1[i].second * idf[v1[i].first], 2);
-
-  for (int i(0); i < n2; i++)
-    l2 += qPow(v2[i].second * idf[v2[i].first], 2);
-
-  l1 = qSqrt(l1);
-  l2 = qSqrt(l2);
-
-  // compute scalar product
-  if (n1 < n2)
-    
-    for (int i(0); i < n1; i++) {
-
-      QString nGram = v1[i].first;
-      int tf = v1[i].second;
-
-      if (containsFirst(v2, nGram)) {
-	qreal prod = prodComponent(v2, nGram, tf) * qPow(idf[nGram], 2);
-	cos += prod;
-	ctb[prod] = nGram;
-      }
-    }
-
-  else
+  QVector<QVector<QPair<int, qreal> > > docVec(docIndex.size());
+  norms.fill(0.0, docIndex.size());
 
-    for (int i(0); i < n2; i++) {
-      
-      QString nGram = v2[i].first;
-      int tf = v2[i].second;
+  for (int i(0); i < docIndex.size(); i++) {
 
-      if (containsFirst(v1, nGram)) {
-	qreal prod = prodComponent(v1, nGram, tf) * qPow(idf[nGram], 2);
-	cos += prod;
-	ctb[prod] = nGram;
-      }
-    }
+    docVec[i].reserve(docIndex[i].size());
 
-  if (l1 != 0 && l2 != 0)
-    cos /= l1 * l2;
-  else
-    cos = 0.0;
+    for (int j(0); j < docIndex[i].size(); j++) {
 
-  // display contributors
-  /*
-  QMap<qreal, QString>::const_iterator it = ctb.begin();
+      qreal w = docIndex[i][j].second * idf[docIndex[i][j].first];
 
-  while (it != ctb.end()) {
-
-    qDebug() << it.value() << "\t" << it.key();
+      // terms occurring in every document do not contribute
+      if (w != 0.0) {
+	docVec[i].push_back(QPair<int, qreal>(docIndex[i][j].first, w));
+	norms[i] += qPow(w, 2);
+      }
+    }
 
-    it++;
+    norms[i] = qSqrt(norms[i]);
   }
 
-  qDebug() << endl << "***" << cos << "***" << endl;
-  */
-
-  return cos;
-}
-
-bool TextProcessor::containsFirst(const QList<QPair<QString, int> > &list, const QString &s)
-{
-   for (int i(0); i < list.size(); i++)
-    if (list[i].first == s)
-      return true;
-
-  return false;
-}
-
-void TextProcessor::updateCount(QList<QPair<QString, int> > &list, const QString &s, int value)
-{
-  for (int i(0); i < list.size(); i++)
-
-     if (list[i].first == s) {
-       list[i].second += value;
-       return;
-     }
+  return docVec;
 }
 
-qreal TextProcessor::prodComponent(const QList<QPair<QString, int> > &list, const QString &s, int value)
+QVector<QVector<QPair<int, qreal> > > TextProcessor::invertIndex(const QVector<QVector<QPair<int, qreal> > > &docVec)
 {
-  for (int i(0); i < list.size(); i++)
+  QVector<QVector<QPair<int, qreal> > > postings(m_vocabulary.size());
 
-     if (list[i].first == s)
-       return list[i].second * value;
+  // documents appended in increasing order
+  for (int i(0); i < docVec.size(); i++)
+    for (int j(0); j < docVec[i].size(); j++)
+      postings[docVec[i][j].first].push_back(QPair<int, qreal>(i, docVec[i][j].second));
 
-  return 0.0;
+  return postings;
 }
@@ -3,6 +3,8 @@
 
 #include <QObject>
 #include <QMap>
+#include <QHash>
+#include <QSet>
 #include <QVector>
 #include <armadillo>
 
@@ -21,15 +23,16 @@ class TextProcessor: public QObject
     
     private:
   QStringList extractNGrams(const QString &processedText);
-  QVector<QList<QPair<QString, int> > > genDocIndex(const QList<QList<int> > &subDoc);
-  QMap<QString, qreal> computeIdf(const QVector<QList<QPair<QString, int> > > &docIndex);
-  qreal computeSimCos(const QList<QPair<QString, int> > &v1, const QList<QPair<QString, int> > &v2, const QMap<QString, qreal> &idf);
-  bool containsFirst(const QList<QPair<QString, int> > &list, const QString &s);
-  void updateCount(QList<QPair<QString, int> > &list, const QString &s, int value);
-  qreal prodComponent(const QList<QPair<QString, int> > &list, const QString &s, int value);
+  int getTermId(const QString &nGram);
+  QVector<QVector<QPair<int, int> > > genDocIndex(const QList<QList<int> > &subDoc);
+  QVector<qreal> computeIdf(const QVector<QVector<QPair<int, int> > > &docIndex);
+  QVector<QVector<QPair<int, qreal> > > computeTfIdf(const QVector<QVector<QPair<int, int> > > &docIndex, const QVector<qreal> &idf, QVector<qreal> &norms);
+  QVector<QVector<QPair<int, qreal> > > invertIndex(const QVector<QVector<QPair<int, qreal> > > &docVec);
 
-  QVector<QList<QPair<QString, int> > > m_index;
-  QList<QString> m_stopList;
+  // term ids, and term counts of each subtitle sorted by term id
+  QHash<QString, int> m_vocabulary;
+  QVector<QVector<QPair<int, int> > > m_index;
+  QSet<QString> m_stopList;
 };
 
 #endif
@@ -1,17 +1,40 @@
 #include <QDebug>
 #include <QList>
+#include <QVector>
+#include <QHash>
 #include <cmath>
 #include <iostream>
+#include <algorithm>
 
 #include "UtteranceTree.h"
+#include "HacEngine.h"
+#include "SilhouetteEvaluator.h"
+#include "DistanceKernel.h"
 
 using namespace arma;
 
+// ordering of merges by height
+static bool lessHeight(const QPair<qreal, UttTreeNode *> &merge1, const QPair<qreal, UttTreeNode *> &merge2)
+{
+  return merge1.first < merge2.first;
+}
+
+template <class Linkage>
+static void runHac(const mat &D, const mat &W, QVector<HacMerge> &merges, QVector<int> &clusters)
+{
+  HacEngine<Linkage> hac;
+
+  hac.run(D, W);
+  merges = hac.getMerges();
+  clusters = hac.getClusters();
+}
+
 UtteranceTree::UtteranceTree()
   : m_root(nullptr),
     m_dist(Mahal),
     m_agr(Ward),
-    m_partMeth(Silhouette)
+    m_partMeth(Silhouette),
+    m_distThreads(-1)
 {
 }
 
@@ -156,23 +179,25 @@ void UtteranceTree::getCoordinates(UttTreeNode *node, QList<QPair<QLineF, QPair<
 ///////////////
 
 void UtteranceTree::setTree(const mat &S, const mat &W, const mat &SigmaInv)
+{
+  // inverse of covariance matrix
+  m_SigmaInv = SigmaInv;
+
+  // computing distance matrix between instances
+  setTree(computeDistMat(S, SigmaInv), W);
+}
+
+void UtteranceTree::setTree(const mat &Dist, const mat &W)
 {
   qreal d(0.0);             // minimum distance in distance matrix
-  mat N;                    // updated distance from new cluster
-  mat M;                    // updated distance from new cluster
-  uword toMerge1, toMerge2; // indices of the closest two instances
-  uword iMin, iMax;         // min and max indices of the instances to merge
 
   // freeing memory used by current tree
   clearTree();
   m_cutValues.clear();
   m_partition.clear();
-    
-  // inverse of covariance matrix
-  m_SigmaInv = SigmaInv;
 
-  // computing distance matrix between instances
-  mat D = computeDistMat(S, SigmaInv);
+  // precomputed distances, with infinite diagonal as in computeDistMat
+  mat D = Dist;
 
   // using DeltaI matrix in case of Ward criterion
   if (m_agr == Ward)
@@ -187,69 +212,38 @@ void UtteranceTree::setTree(const mat &S, const mat &W, const mat &SigmaInv)
 
   if (D.n_rows > 0) {
 
-    // stop condition
-    umat F = find(D != datum::inf);
+    QVector<HacMerge> merges;
+    QVector<int> remaining;
 
-    // initializing list of clusters
-    QList<UttTreeNode *> clusters;
-    for (uword i(0); i < S.n_rows; i++)
-      clusters.push_back(new UttTreeNode(0.0, W(i), i));
-
-    while (!F.is_empty()) {
-
-      // retrieving indices of the closest two instances
-      d = D.min(toMerge1, toMerge2);
-
-      // ordering the indices of instances to merge for deleting purpose
-      if (toMerge1 < toMerge2) {
-	iMin = toMerge1;
-	iMax = toMerge2;
-      }
-      else {
-	iMin = toMerge2;
-	iMax = toMerge1;
-      }
-
-      // creation of the new cluster
-      UttTreeNode *newCluster = new UttTreeNode(d, 0.0, -1, clusters[iMin], clusters[iMax]);
-
-      // re-estimating distances from cluster of agregated instances
-      N = updateDistances(clusters, clusters[iMin], clusters[iMax], iMin, iMax, D);
-
-      // updating list of clusters
-      clusters.removeAt(iMax);
-      clusters.removeAt(iMin);
-      clusters.push_back(newCluster);
-
-      /*
-      qDebug();
-      cout << D;
-      
-      qDebug() << "(" << iMin + 1 << "," << iMax + 1 << ")";
-      displayClusters(clusters);
-      qDebug();
-      */
-
-      // updating distance matrix
-      D.shed_row(iMax);
-      D.shed_col(iMax);
-      D.shed_row(iMin);
-      D.shed_col(iMin);
-      D.insert_cols(D.n_cols, N);
-      mat T;
-      T << datum::inf;
-      N.insert_rows(N.n_rows, T);
-      D.insert_rows(D.n_rows, N.t());
-      
-      /*
-      cout << D;
-      qDebug();
-      */
-
-      // updating flag
-      F = find(D != datum::inf);
+    switch (m_agr) {
+    case Min:
+      runHac<MinLinkage>(D, W, merges, remaining);
+      break;
+    case Max:
+      runHac<MaxLinkage>(D, W, merges, remaining);
+      break;
+    case Mean:
+      runHac<MeanLinkage>(D, W, merges, remaining);
+      break;
+    case Ward:
+      runHac<WardLinkage>(D, W, merges, remaining);
+      break;
+    }
+
+    // building tree from merge table
+    QVector<UttTreeNode *> nodes;
+    for (uword i(0); i < D.n_rows; i++)
+      nodes.push_back(new UttTreeNode(0.0, W(i), i));
+
+    for (int i(0); i < merges.size(); i++) {
+      d = merges[i].dist;
+      nodes.push_back(new UttTreeNode(d, 0.0, -1, nodes[merges[i].left], nodes[merges[i].right]));
     }
 
+    QList<UttTreeNode *> clusters;
+    for (int i(0); i < remaining.size(); i++)
+      clusters.push_back(nodes[remaining[i]]);
+
     // setting optimal partition
     for (int i(0); i < clusters.size(); i++) {
       qreal best = getBestCutValue(clusters[i]);
@@ -337,6 +331,11 @@ void UtteranceTree::setDist(DistType dist)
   m_dist = dist;
 }
 
+void UtteranceTree::setDistThreads(int nThreads)
+{
+  m_distThreads = nThreads;
+}
+
 void UtteranceTree::setAgr(AgrCrit agr)
 {
   m_agr = agr;
@@ -367,7 +366,6 @@ qreal UtteranceTree::getBestCutValue(UttTreeNode *node)
 {
   QList<qreal> ultDists;
   QList<qreal> cutDists;
-  QList<QList<QList<int>>> partitions;
   int bestIdx(-1);
 
   // retrieving nodes ultrametric distances
@@ -381,21 +379,15 @@ qreal UtteranceTree::getBestCutValue(UttTreeNode *node)
   if (ultDists.size() > 0)
     cutDists.push_front(ultDists[0] + 1);
 
-  // initializing list of possible partitions of the data set
-  for (int i(0); i < cutDists.size(); i++) {
-    QList<QList<int>> parti = cutTree(node, cutDists[i]);
-    partitions.push_back(parti);
-  }
-
-  if (partitions.size() > 0)
+  if (cutDists.size() > 0)
 
     // call appropriate method to evaluate partitions
     switch (m_partMeth) {
     case Silhouette:
-      bestIdx = getBestPartIdxSil(partitions);
+      bestIdx = getBestPartIdxSil(node, cutDists);
       break;
     case Bipartition:
-      bestIdx = 1;
+      bestIdx = (cutDists.size() > 1) ? 1 : 0;
       break;
     }
   
@@ -429,17 +421,8 @@ qreal UtteranceTree::computeDistance(const mat &U, const mat &V, const mat &Sigm
 
 mat UtteranceTree::computeDistMat(const mat &S, const mat &SigmaInv)
 {
-  mat D(S.n_rows, S.n_rows, fill::zeros);
-  qreal d;
-
-  for (uword i(0); i < S.n_rows; i++) {
-    D(i, i) = datum::inf;
-    for (uword j(i+1); j < S.n_rows; j++) {
-      d = computeDistance(S.row(i), S.row(j), SigmaInv);
-      D(i, j) = d;
-      D(j, i) = d;
-    }
-  }
+  mat D = DistanceKernel::distMat(S, SigmaInv, m_dist, m_distThreads);
+  D.diag().fill(datum::inf);
   
   if (D.n_rows == m_Diff.n_rows && D.n_cols == m_Diff.n_cols)
     return (D % m_Diff);
@@ -509,66 +492,6 @@ mat UtteranceTree::computeClusterCenter(const mat &S, const umat &Idx)
   return g;
 }
 
-mat UtteranceTree::updateDistances(QList<UttTreeNode *> clusters, UttTreeNode *merged1, UttTreeNode *merged2, uword iMin, uword iMax, const mat &D)
-{
-  // updated distances from new cluster
-  mat N(clusters.size(), 1, fill::zeros);
-
-  // weights of merged clusters and new cluster
-  qreal weight1(computeWeight(merged1));
-  qreal weight2(computeWeight(merged2));
-  qreal totWeight = weight1 + weight2;
-
-  // weight of current cluster
-  qreal currWeight;
-
-  // coefficients of Lance-Wiliams formula
-  qreal alpha1(0.0), alpha2(0.0), beta(0.0), gamma(0.0);
-
-  // initializing coefficients in case of min/max/mean criteria
-  switch (m_agr) {
-  case Min:
-    alpha2 = alpha1 = 1.0 / 2.0;
-    gamma = - 1.0 / 2.0;
-    break;
-  case Max:
-    alpha2 = alpha1 = 1.0 / 2.0;
-    gamma = 1.0 / 2.0;
-    break;
-  case Mean:
-    alpha1 = weight1 / totWeight;
-    alpha2 = weight2 / totWeight;
-    break;
-  case Ward:
-    break;
-  }
-  
-  // looping over clusters
-  for (uword i(0); i < static_cast<uword>(clusters.size()); i++)
-
-    if (i != iMin && i != iMax) {
-
-      // initializing coefficients in case of ward criterion
-      if (m_agr == Ward) {
-	currWeight = computeWeight(clusters[i]);
-	alpha1 = (currWeight + weight1) / (currWeight + totWeight);
-	alpha2 = (currWeight + weight2) / (currWeight + totWeight);
-	beta = - currWeight / (currWeight + totWeight);
-      }
-     
-      N(i, 0) = alpha1 * D(iMin, i) + alpha2 * D(iMax, i) + beta * D(iMin, iMax) + gamma * std::abs(D(iMin, i) - D(iMax, i));
-
-      if (!is_finite(N.row(i)))
-	N(i, 0) = datum::inf;
-    }
-
-  // removing rows corresponding to clustered instances
-  N.shed_row(iMax);
-  N.shed_row(iMin);
-
-  return N;
-}
-
 mat UtteranceTree::retrieveCentroid(const arma::mat &S)
 {
   return sum(S, 0) / S.n_rows;
@@ -605,110 +528,63 @@ void UtteranceTree::retrieveUltDist(UttTreeNode *node, QList<qreal> &ultDists)
   }
 }
 
-int UtteranceTree::getBestPartIdxSil(QList<QList<QList<int>>> partitions)
+int UtteranceTree::getBestPartIdxSil(UttTreeNode *node, const QList<qreal> &cutDists)
 {
-  int n(partitions[0][0].size()); // number of instances
-  QVector<qreal> Q(n);            // quality measure for each partition
-  QVector<int> map(n);
-  QMap<int, int> mapInv;
-  QVector<int> C(n);              // cluster of each instance
-  QVector<QVector<qreal>> D(n);   // distance between each instance and each cluster
-  QVector<qreal> a(n);            // distance between an instance and its cluster
-  QVector<qreal> b(n);            // distance between an instance and the second closest cluster
-  QVector<qreal> s(n);            // measures if instance is correctly classified
+  QList<UttTreeNode *> leaves;
+  QList<QPair<qreal, UttTreeNode *> > merges;
+  QHash<UttTreeNode *, int> clusters;
+  int n(0);                        // number of instances
+  QVector<qreal> Q(cutDists.size()); // quality measure for each partition
   int iBest(0);
   Q[iBest] = -1.0;
-  
-  // saving indices
+
+  // distances between instances of the tree
+  getClusterInstances(node, leaves);
+  n = leaves.size();
+
+  uvec idx(n);
   for (int i(0); i < n; i++) {
-    map[i]  = partitions[0][0][i];
-    mapInv[partitions[0][0][i]] = i;
+    idx(i) = leaves[i]->getSubRef();
+    clusters[leaves[i]] = i;
   }
 
-  // looping over the partitions containing (2, ..., n) elements
-  for (int i(1); i < partitions.size(); i++) {
-    
-    // current partition
-    QList<QList<int>> partition = partitions[i];
-
-    // for each instance, retrieving its cluster
-    for (int j(0); j < n; j++) {
-      int k(0);
-      bool found(false);
-      while (!found && k < partition.size()) {
-	if (partition[k].contains(map[j])) {
-	  C[j] = k;
-	  found = true;
-	}
-	k++;
-      }
-    }
-    // for each instance, computing its average distance from members of each cluster
-    QVector<qreal> d(partition.size());
-
-    // looping over instances
-    for (int j(0); j < n; j++) {
-
-      // looping over clusters
-      for (int k(0); k < partition.size(); k++) {
-
-	// initializing distance between instance j and cluster k
-	d[k] = 0.0;
-	int clusterCard = partition[k].size();
- 
-	// looping over cluster instances
-	for (int l(0); l < clusterCard; l++)
-	  if (map[j] != partition[k][l]) {
-	   
-	    d[k] += m_D(map[j], partition[k][l]);
-	  }
-
-	// normalizing distance between instance j and cluster k
-	int normFac = (k == C[j]) ? clusterCard - 1 : clusterCard;
-	d[k] /= normFac;
-      }
-
-      // distance between current instance and its cluster
-      a[j] = d[C[j]];
-
-      // computing distance between current instance and second closest cluster
-      // initialization
-      int k(0);
-      while (k < partition.size() && k == C[j])
-	k++;
-      b[j] = d[k];
-
-      // retrieving closest cluster
-      for (int k(0); k < partition.size(); k++) {
-	if (k != C[j] && d[k] < b[j])
-	  b[j] = d[k];
-      }
-
-      // computing s(x_i)
-      if (partition[C[j]].size() == 1)
-	s[j] = 0;
-      else
-	s[j] = (b[j] - a[j]) / std::max(a[j], b[j]);
-    }
+  SilhouetteEvaluator evaluator(m_D.submat(idx, idx));
+
+  // merges sorted by height: sons merged before fathers
+  retrieveMerges(node, node->getUltDist(), merges);
+  std::stable_sort(merges.begin(), merges.end(), lessHeight);
 
-    // looping over clusters
-    for (int k(0); k < partition.size(); k++) {
-      qreal mean = 0.0;
-
-      for (int j(0); j < partition[k].size(); j++) {
-	int idx = mapInv[partition[k][j]];
-	mean += s[idx];
-      }
-	
-      mean /= partition[k].size();
-      Q[i] += partition[k].size() * mean;
+  // partitions containing (n, ..., 2) elements: merging clusters
+  // whose height falls below current cut value
+  int next(0);
+
+  for (int i(cutDists.size() - 1); i > 0; i--) {
+
+    while (next < merges.size() && merges[next].first <= cutDists[i]) {
+      UttTreeNode *merged = merges[next].second;
+      clusters[merged] = evaluator.merge(clusters[merged->getLeftSon()], clusters[merged->getRightSon()]);
+      next++;
     }
 
-    Q[i] /= n;
+    Q[i] = evaluator.getScore();
+  }
 
+  for (int i(1); i < cutDists.size(); i++)
     if (Q[i] >= Q[iBest])
       iBest = i;
-  }
 
   return iBest;
 }
+
+void UtteranceTree::retrieveMerges(UttTreeNode *node, qreal height, QList<QPair<qreal, UttTreeNode *> > &merges)
+{
+  if (node == nullptr || node->getSubRef() != -1)
+    return;
+
+  // subtree kept whole as soon as one of its ancestors is
+  height = qMin(height, node->getUltDist());
+
+  retrieveMerges(node->getLeftSon(), height, merges);
+  retrieveMerges(node->getRightSon(), height, merges);
+  merges.push_back(QPair<qreal, UttTreeNode *>(height, node));
+}
@@ -29,10 +29,12 @@ class UtteranceTree
   void clearTree();
   void clearTree(UttTreeNode *node);
   void setTree(const arma::mat &S, const arma::mat &W, const arma::mat &Sigma);
+  void setTree(const arma::mat &D, const arma::mat &W);
   void setDist(DistType dist);
   void setAgr(AgrCrit agr);
   void setPartMeth(PartMeth partMeth);
   void setDiff(const arma::mat &Diff);
+  void setDistThreads(int nThreads);
   void displayTree(const arma::umat &map);
   void displayTree(UttTreeNode *node, const arma::umat &map);
   void displayTree(QVector<QString> characters);
@@ -55,13 +57,13 @@ class UtteranceTree
  private:
   double computeDistance(const arma::mat &U, const arma::mat &V, const arma::mat &SigmaInv);
   arma::mat computeDistMat(const arma::mat &S, const arma::mat &SigmaInv);
-  arma::mat updateDistances(QList<UttTreeNode *> clusters, UttTreeNode *merged1, UttTreeNode *merged2, arma::uword iMin, arma::uword iMax, const arma::mat &D);
   arma::mat updateDistancesWard(const arma::mat &S, QList<UttTreeNode *> clusters, UttTreeNode *newCluster, arma::uword iMin, arma::uword iMax);
   arma::mat retrieveCentroid(const arma::mat &S);
   arma::mat computeDeltaI(const arma::mat &D, const arma::mat &W);
   arma::mat computeClusterCenter(const arma::mat &S, const arma::umat &Idx);
   void retrieveUltDist(UttTreeNode *node, QList<qreal> &ultDists);
-  int getBestPartIdxSil(QList<QList<QList<int>>> partitions);
+  int getBestPartIdxSil(UttTreeNode *node, const QList<qreal> &cutDists);
+  void retrieveMerges(UttTreeNode *node, qreal height, QList<QPair<qreal, UttTreeNode *> > &merges);
   void displayClusters(QList<UttTreeNode *> clusters);
   double getBestCutValue(UttTreeNode *node);
 
@@ -71,6 +73,7 @@ class UtteranceTree
   DistType m_dist;
   AgrCrit m_agr;
   PartMeth m_partMeth;
+  int m_distThreads;
   arma::mat m_D;
   arma::mat m_Diff;
   arma::mat m_SigmaInv;
@@ -1,9 +1,331 @@
 #include <opencv2/imgproc/imgproc.hpp>
 
+#include <qmath.h>
+#include <cstring>
+#include <cfloat>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "VideoFrameProcessor.h"
 
 using namespace cv;
 
+///////////////////////////////////////////
+// fused block histogram kernel helpers  //
+///////////////////////////////////////////
+
+// binning of the three HSV channels for a given histogram type
+struct BinParams {
+  int bins[3];
+  int stride[3];
+  quint16 mul[3];
+  int lut[3][256];
+  bool simd;
+};
+
+static void initBinParams(BinParams &p, int histoType, int hBins, int sBins, int vBins)
+{
+  int bins[3] = { 0, 0, 0 };
+
+  switch (histoType) {
+  case VideoFrameProcessor::Lum:
+    bins[2] = vBins;
+    break;
+  case VideoFrameProcessor::Hs:
+    bins[0] = hBins;
+    bins[1] = sBins;
+    break;
+  case VideoFrameProcessor::Hsv:
+    bins[0] = hBins;
+    bins[1] = sBins;
+    bins[2] = vBins;
+    break;
+  }
+
+  // hue ranges from 0 to 179, saturation and value from 0 to 255
+  int high[3] = { 180, 256, 256 };
+  int stride(1);
+
+  p.simd = true;
+
+  for (int c(2); c >= 0; c--) {
+
+    p.bins[c] = bins[c];
+    p.stride[c] = bins[c] > 0 ? stride : 0;
+
+    if (bins[c] > 0)
+      stride *= bins[c];
+
+    // fixed-point multiplier: bin = (value * mul) >> 16
+    quint32 mul = static_cast<quint32>(qCeil(65536.0 * bins[c] / high[c]));
+    p.mul[c] = mul < 65536 ? mul : 0;
+
+    if (bins[c] > 0 && mul >= 65536)
+      p.simd = false;
+
+    // reference bins, rounded as calcHist does for uniform 8-bit ranges
+    double a = bins[c] / static_cast<double>(high[c]);
+
+    for (int v(0); v < 256; v++) {
+
+      if (bins[c] == 0) {
+	p.lut[c][v] = 0;
+	continue;
+      }
+
+      int idx = qBound(0, cvFloor(v * a), bins[c] - 1);
+      p.lut[c][v] = v < high[c] ? idx * p.stride[c] : -1;
+
+      // vectorized binning is used only if exact for every value
+      if (v < high[c] && idx != static_cast<int>((v * mul) >> 16))
+	p.simd = false;
+    }
+  }
+
+  if (stride >= 0xFFFF)
+    p.simd = false;
+}
+
+#ifdef __SSE2__
+
+// 16 interleaved 3-channel pixels to 3 planes
+static inline void loadDeinterleave(const uchar *ptr, __m128i &a, __m128i &b, __m128i &c)
+{
+  __m128i t00 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+  __m128i t01 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr + 16));
+  __m128i t02 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr + 32));
+
+  __m128i t10 = _mm_unpacklo_epi8(t00, _mm_unpackhi_epi64(t01, t01));
+  __m128i t11 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t00, t00), t02);
+  __m128i t12 = _mm_unpacklo_epi8(t01, _mm_unpackhi_epi64(t02, t02));
+
+  __m128i t20 = _mm_unpacklo_epi8(t10, _mm_unpackhi_epi64(t11, t11));
+  __m128i t21 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t10, t10), t12);
+  __m128i t22 = _mm_unpacklo_epi8(t11, _mm_unpackhi_epi64(t12, t12));
+
+  __m128i t30 = _mm_unpacklo_epi8(t20, _mm_unpackhi_epi64(t21, t21));
+  __m128i t31 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t20, t20), t22);
+  __m128i t32 = _mm_unpacklo_epi8(t21, _mm_unpackhi_epi64(t22, t22));
+
+  a = _mm_unpacklo_epi8(t30, _mm_unpackhi_epi64(t31, t31));
+  b = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t30, t30), t32);
+  c = _mm_unpacklo_epi8(t31, _mm_unpackhi_epi64(t32, t32));
+}
+
+// combined bin index of 8 pixels, 0xFFFF when out of range
+static inline __m128i binIndex(const BinParams &p, __m128i h, __m128i s, __m128i v)
+{
+  __m128i ch[3] = { h, s, v };
+  __m128i idx = _mm_setzero_si128();
+
+  for (int c(0); c < 3; c++)
+    if (p.bins[c] > 0) {
+      __m128i bin = _mm_mulhi_epu16(ch[c], _mm_set1_epi16(static_cast<short>(p.mul[c])));
+      idx = _mm_add_epi16(idx, _mm_mullo_epi16(bin, _mm_set1_epi16(static_cast<short>(p.stride[c]))));
+    }
+
+  // hue above 179 is not counted (non-HSV input)
+  if (p.bins[0] > 0) {
+    __m128i inRange = _mm_cmplt_epi16(h, _mm_set1_epi16(180));
+    idx = _mm_or_si128(_mm_and_si128(inRange, idx), _mm_andnot_si128(inRange, _mm_set1_epi16(-1)));
+  }
+
+  return idx;
+}
+
+#endif
+
+// bin indices of n consecutive pixels
+static void rowBinIndices(const BinParams &p, const uchar *row, int n, quint16 *idx)
+{
+  int x(0);
+
+#ifdef __SSE2__
+  if (p.simd) {
+    __m128i zero = _mm_setzero_si128();
+
+    for (; x + 16 <= n; x += 16) {
+      __m128i h, s, v;
+      loadDeinterleave(row + 3 * x, h, s, v);
+
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(idx + x),
+		       binIndex(p, _mm_unpacklo_epi8(h, zero), _mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(v, zero)));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(idx + x + 8),
+		       binIndex(p, _mm_unpackhi_epi8(h, zero), _mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(v, zero)));
+    }
+  }
+#endif
+
+  // remaining pixels, or all of them when fixed-point binning is not exact
+  for (; x < n; x++) {
+    const uchar *pixel = row + 3 * x;
+    int h = p.lut[0][pixel[0]];
+    int s = p.lut[1][pixel[1]];
+    int v = p.lut[2][pixel[2]];
+    idx[x] = (h < 0 || s < 0 || v < 0) ? 0xFFFF : static_cast<quint16>(h + s + v);
+  }
+}
+
+
+///////////////////////////////////////////
+// batch histogram distance helpers      //
+///////////////////////////////////////////
+
+// bin sums of two histograms needed by the metrics
+struct DistSums {
+  double s1;
+  double s2;
+  double s11;
+  double s22;
+  double s12;
+};
+
+#ifdef __SSE2__
+
+static inline double horizontalSum(__m128d v)
+{
+  double d[2];
+  _mm_storeu_pd(d, v);
+
+  return d[0] + d[1];
+}
+
+// bins converted to double and accumulated in double, as the scalar
+// path and OpenCV do: float sums drift on histograms with many bins
+static inline void accumulateSums(int metrics, __m128d va, __m128d vb, __m128d *s)
+{
+  const __m128d absMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+  const __m128d eps = _mm_set1_pd(DBL_EPSILON);
+  const __m128d one = _mm_set1_pd(1.0);
+
+  __m128d d = _mm_sub_pd(va, vb);
+
+  if (metrics == NORM_L1)
+    s[4] = _mm_add_pd(s[4], _mm_and_pd(d, absMask));
+
+  else if (metrics == NORM_L2)
+    s[4] = _mm_add_pd(s[4], _mm_mul_pd(d, d));
+
+  else if (metrics == CV_COMP_CORREL) {
+    s[0] = _mm_add_pd(s[0], va);
+    s[1] = _mm_add_pd(s[1], vb);
+    s[2] = _mm_add_pd(s[2], _mm_mul_pd(va, va));
+    s[3] = _mm_add_pd(s[3], _mm_mul_pd(vb, vb));
+    s[4] = _mm_add_pd(s[4], _mm_mul_pd(va, vb));
+  }
+
+  else if (metrics == CV_COMP_CHISQR) {
+    // empty bins of first histogram are skipped
+    __m128d mask = _mm_cmpgt_pd(_mm_and_pd(va, absMask), eps);
+    __m128d denom = _mm_or_pd(_mm_and_pd(mask, va), _mm_andnot_pd(mask, one));
+    s[4] = _mm_add_pd(s[4], _mm_and_pd(mask, _mm_div_pd(_mm_mul_pd(d, d), denom)));
+  }
+
+  else if (metrics == CV_COMP_HELLINGER) {
+    s[0] = _mm_add_pd(s[0], va);
+    s[1] = _mm_add_pd(s[1], vb);
+    s[4] = _mm_add_pd(s[4], _mm_sqrt_pd(_mm_mul_pd(va, vb)));
+  }
+}
+
+#endif
+
+static void histoSums(int metrics, const float *a, const float *b, int n, DistSums &sums)
+{
+  int x(0);
+
+  sums.s1 = sums.s2 = sums.s11 = sums.s22 = sums.s12 = 0.0;
+
+#ifdef __SSE2__
+  // s1, s2, s11, s22 and s12
+  __m128d s[5];
+
+  for (int k(0); k < 5; k++)
+    s[k] = _mm_setzero_pd();
+
+  for (; x + 4 <= n; x += 4) {
+
+    __m128 va = _mm_loadu_ps(a + x);
+    __m128 vb = _mm_loadu_ps(b + x);
+
+    accumulateSums(metrics, _mm_cvtps_pd(va), _mm_cvtps_pd(vb), s);
+    accumulateSums(metrics, _mm_cvtps_pd(_mm_movehl_ps(va, va)), _mm_cvtps_pd(_mm_movehl_ps(vb, vb)), s);
+  }
+
+  sums.s1 = horizontalSum(s[0]);
+  sums.s2 = horizontalSum(s[1]);
+  sums.s11 = horizontalSum(s[2]);
+  sums.s22 = horizontalSum(s[3]);
+  sums.s12 = horizontalSum(s[4]);
+#endif
+
+  // remaining bins
+  for (; x < n; x++) {
+
+    double va = a[x];
+    double vb = b[x];
+    double d = va - vb;
+
+    if (metrics == NORM_L1)
+      sums.s12 += qAbs(d);
+
+    else if (metrics == NORM_L2)
+      sums.s12 += d * d;
+
+    else if (metrics == CV_COMP_CORREL) {
+      sums.s1 += va;
+      sums.s2 += vb;
+      sums.s11 += va * va;
+      sums.s22 += vb * vb;
+      sums.s12 += va * vb;
+    }
+
+    else if (metrics == CV_COMP_CHISQR) {
+      if (qAbs(va) > DBL_EPSILON)
+	sums.s12 += d * d / va;
+    }
+
+    else if (metrics == CV_COMP_HELLINGER) {
+      sums.s1 += va;
+      sums.s2 += vb;
+      sums.s12 += qSqrt(va * vb);
+    }
+  }
+}
+
+// same values as distanceFromPrev: CV_COMP_INTERSECT shares its
+// value with NORM_L1 and is therefore computed as an L1 norm
+static double histoDistance(int metrics, const float *a, const float *b, int n)
+{
+  DistSums s;
+  histoSums(metrics, a, b, n, s);
+
+  if (metrics == NORM_L1 || metrics == CV_COMP_CHISQR)
+    return s.s12;
+
+  if (metrics == NORM_L2)
+    return qSqrt(s.s12);
+
+  if (metrics == CV_COMP_CORREL) {
+    double scale = 1.0 / n;
+    double num = s.s12 - s.s1 * s.s2 * scale;
+    double denom2 = (s.s11 - s.s1 * s.s1 * scale) * (s.s22 - s.s2 * s.s2 * scale);
+
+    return 1.0 - (qAbs(denom2) > DBL_EPSILON ? num / qSqrt(denom2) : 1.0);
+  }
+
+  if (metrics == CV_COMP_HELLINGER) {
+    double scale = s.s1 * s.s2;
+    scale = qAbs(scale) > FLT_EPSILON ? 1.0 / qSqrt(scale) : 1.0;
+
+    return qSqrt(qMax(1.0 - s.s12 * scale, 0.0));
+  }
+
+  return 1.0;
+}
+
 VideoFrameProcessor::VideoFrameProcessor(int metrics, QObject *parent)
   : QObject(parent),
     m_metrics(metrics),
@@ -11,6 +333,33 @@ VideoFrameProcessor::VideoFrameProcessor(int metrics, QObject *parent)
 {
 }
 
+void VideoFrameProcessor::downscale(const cv::Mat &frame, cv::Mat &scaled, int height)
+{
+  // full resolution requested or frame already small enough: no copy
+  if (height <= 0 || frame.rows <= height) {
+    scaled = frame;
+    return;
+  }
+
+  int width = qRound(frame.cols * height / static_cast<qreal>(frame.rows));
+
+  resize(frame, scaled, Size(width, height), 0, 0, INTER_AREA);
+}
+
+void VideoFrameProcessor::prepareFrame(const cv::Mat &frame, cv::Mat &hsv, int height)
+{
+  // reduce resolution first: conversion and histograms run on fewer pixels
+  Mat scaled;
+  downscale(frame, scaled, height);
+
+  // never convert in place into the decoded frame
+  if (hsv.data == frame.data)
+    hsv.release();
+
+  // histograms computed on HSV frames, whether cached or not
+  cvtColor(scaled, hsv, CV_BGR2HSV);
+}
+
 QVector<cv::Mat> VideoFrameProcessor::splitImage(const Mat &frame, int nVBlock, int nHBlock)
 {
   QVector<Mat> blocks;
@@ -25,6 +374,123 @@ QVector<cv::Mat> VideoFrameProcessor::splitImage(const Mat &frame, int nVBlock,
   return blocks;
 }
 
+int VideoFrameProcessor::getNBlocks(const cv::Mat &frame, int nVBlock, int nHBlock) const
+{
+  int blockVSize(frame.rows / nVBlock);
+  int blockHSize(frame.cols / nHBlock);
+
+  // same block layout as splitImage
+  if (blockVSize == 0 || blockHSize == 0)
+    return 0;
+
+  return (frame.rows / blockVSize) * (frame.cols / blockHSize);
+}
+
+int VideoFrameProcessor::getNBins(int histoType, int hBins, int sBins, int vBins) const
+{
+  switch (histoType) {
+  case Lum:
+    return vBins;
+  case Hs:
+    return hBins * sBins;
+  case Hsv:
+    return hBins * sBins * vBins;
+  }
+
+  return 0;
+}
+
+void VideoFrameProcessor::genBlockHistos(const cv::Mat &frame, int histoType, int hBins, int sBins, int vBins, int nVBlock, int nHBlock, float *histos)
+{
+  CV_Assert(frame.type() == CV_8UC3);
+
+  BinParams p;
+  initBinParams(p, histoType, hBins, sBins, vBins);
+
+  int nBins(getNBins(histoType, hBins, sBins, vBins));
+  int blockVSize(frame.rows / nVBlock);
+  int blockHSize(frame.cols / nHBlock);
+
+  if (blockVSize == 0 || blockHSize == 0)
+    return;
+
+  int nBlockRows(frame.rows / blockVSize);
+  int nBlockCols(frame.cols / blockHSize);
+
+  // bin indices are computed by chunks of pixels on the stack
+  const int chunkSize(256);
+  quint16 idx[chunkSize];
+
+  memset(histos, 0, sizeof(float) * nBlockRows * nBlockCols * nBins);
+
+  // single pass over the frame rows covered by blocks
+  for (int i(0); i < nBlockRows; i++)
+    for (int r(i * blockVSize); r < (i + 1) * blockVSize; r++) {
+
+      const uchar *row = frame.ptr<uchar>(r);
+
+      for (int j(0); j < nBlockCols; j++) {
+
+	float *hist = histos + (i * nBlockCols + j) * nBins;
+	int last((j + 1) * blockHSize);
+
+	for (int x(j * blockHSize); x < last; x += chunkSize) {
+
+	  int n(qMin(chunkSize, last - x));
+	  rowBinIndices(p, row + 3 * x, n, idx);
+
+	  for (int k(0); k < n; k++)
+	    if (idx[k] != 0xFFFF)
+	      hist[idx[k]] += 1.0f;
+	}
+      }
+    }
+
+  // normalizing each block histogram as normalize(NORM_L1) does
+  for (int i(0); i < nBlockRows * nBlockCols; i++) {
+
+    float *hist = histos + i * nBins;
+    double sum(0.0);
+
+    for (int k(0); k < nBins; k++)
+      sum += hist[k];
+
+    double scale = sum > 0 ? 1.0 / sum : 0.0;
+
+    for (int k(0); k < nBins; k++)
+      hist[k] = static_cast<float>(hist[k] * scale);
+  }
+}
+
+void VideoFrameProcessor::genBlockHistos(const cv::Mat &frame, int histoType, int hBins, int sBins, int vBins, int nVBlock, int nHBlock, cv::Mat &histos)
+{
+  int nBlocks(getNBlocks(frame, nVBlock, nHBlock));
+
+  if (nBlocks == 0) {
+    histos.release();
+    return;
+  }
+
+  // no allocation when histograms keep the same size
+  histos.create(nBlocks, getNBins(histoType, hBins, sBins, vBins), CV_32F);
+
+  genBlockHistos(frame, histoType, hBins, sBins, vBins, nVBlock, nHBlock, histos.ptr<float>());
+}
+
+void VideoFrameProcessor::genBlockHistos(const cv::Mat &frame, int histoType, int hBins, int sBins, int vBins, int nVBlock, int nHBlock, cv::Mat &histos, QVector<cv::Mat> &locHisto)
+{
+  uchar *data = histos.data;
+
+  genBlockHistos(frame, histoType, hBins, sBins, vBins, nVBlock, nHBlock, histos);
+
+  // one histogram header per block row
+  if (locHisto.size() != histos.rows || histos.data != data) {
+    locHisto.resize(histos.rows);
+    for (int i(0); i < histos.rows; i++)
+      locHisto[i] = histos.row(i);
+  }
+}
+
 ///////////
 // slots //
 ///////////
@@ -114,6 +580,48 @@ double VideoFrameProcessor::distanceFromPrev(const Mat &hist, const Mat &prevHis
   return dist;
 }
 
+qreal VideoFrameProcessor::meanDistance(const QVector<qreal> &distance)
+{
+  qreal sum(0.0);
+
+  for (int i(0); i < distance.size(); i++)
+    sum += qAbs(1 - distance[i]);
+
+  return 1 - sum / distance.size();
+}
+
+qreal VideoFrameProcessor::batchDistance(const float *histos, const float *prevHistos, int nBlocks, int nBins, qreal *distance)
+{
+  qreal meanDist;
+
+  batchDistance(histos, prevHistos, 1, nBlocks, nBins, &meanDist, distance);
+
+  return meanDist;
+}
+
+void VideoFrameProcessor::batchDistance(const float *histos, const float *prevHistos, int nPrev, int nBlocks, int nBins, qreal *meanDist, qreal *distance)
+{
+  // previous frames histograms are stored one after the other
+  for (int j(0); j < nPrev; j++) {
+
+    const float *prev = prevHistos + static_cast<qint64>(j) * nBlocks * nBins;
+    qreal sum(0.0);
+
+    for (int i(0); i < nBlocks; i++) {
+
+      qreal dist = histoDistance(m_metrics, histos + i * nBins, prev + i * nBins, nBins);
+
+      if (distance)
+	distance[j * nBlocks + i] = dist;
+
+      // averaged as in meanDistance
+      sum += qAbs(1 - dist);
+    }
+
+    meanDist[j] = 1 - sum / nBlocks;
+  }
+}
+
 void VideoFrameProcessor::activL1()
 {
   m_metrics = NORM_L1;
@@ -15,13 +15,23 @@ class VideoFrameProcessor: public QObject
     Lum, Hs, Hsv
   };
   VideoFrameProcessor(int metrics = 0, QObject *parent = 0);
+  void downscale(const cv::Mat &frame, cv::Mat &scaled, int height);
+  void prepareFrame(const cv::Mat &frame, cv::Mat &hsv, int height);
   QVector<cv::Mat> splitImage(const cv::Mat &frame, int nVBlock, int nHBlock);
+  int getNBlocks(const cv::Mat &frame, int nVBlock, int nHBlock) const;
+  int getNBins(int histoType, int hBins, int sBins, int vBins) const;
+  void genBlockHistos(const cv::Mat &frame, int histoType, int hBins, int sBins, int vBins, int nVBlock, int nHBlock, float *histos);
+  void genBlockHistos(const cv::Mat &frame, int histoType, int hBins, int sBins, int vBins, int nVBlock, int nHBlock, cv::Mat &histos);
+  void genBlockHistos(const cv::Mat &frame, int histoType, int hBins, int sBins, int vBins, int nVBlock, int nHBlock, cv::Mat &histos, QVector<cv::Mat> &locHisto);
+  qreal batchDistance(const float *histos, const float *prevHistos, int nBlocks, int nBins, qreal *distance = 0);
+  void batchDistance(const float *histos, const float *prevHistos, int nPrev, int nBlocks, int nBins, qreal *meanDist, qreal *distance = 0);
 
   public slots:
   cv::Mat genVHisto(const cv::Mat &frame, int vBins);
   cv::Mat genHsHisto(const cv::Mat &frame, int hBins, int sBins);
   cv::Mat genHsvHisto(const cv::Mat &frame, int hBins, int sBins, int vBins);
   double distanceFromPrev(const cv::Mat &hist, const cv::Mat &prevHist);
+  qreal meanDistance(const QVector<qreal> &distance);
   void activL1();
   void activL2();
   void activCorrel();
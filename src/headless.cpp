@@ -0,0 +1,33 @@
+#include <QApplication>
+#include <QStringList>
+#include <QTextStream>
+
+#include "HeadlessDriver.h"
+
+int main(int argc, char *argv[])
+{
+  // processing classes are widgets: no display is needed to create them
+  if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+  QApplication app(argc, argv);
+
+  QStringList args = app.arguments();
+
+  if (args.size() < 3) {
+    QTextStream(stderr) << "Usage: " << args[0] << " <project.json> <config.json> [output.json]" << endl;
+    return 2;
+  }
+
+  // output project overwrites input one by default
+  QString projectFName = args[1];
+  QString configFName = args[2];
+  QString outputFName = (args.size() > 3) ? args[3] : projectFName;
+
+  HeadlessDriver driver;
+
+  if (!driver.loadConfig(configFName))
+    return 1;
+
+  return driver.run(projectFName, outputFName) ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+CONFIG += c++11
+CONFIG += testcase
+
+QT += core
+QT += testlib
+QT -= gui
+
+TARGET = HistoCacheTest
+
+INCLUDEPATH += ../../src
+
+HEADERS += ../../src/HistoCache.h
+HEADERS += ../../src/VideoFrameProcessor.h
+
+SOURCES += tst_HistoCache.cpp
+SOURCES += ../../src/HistoCache.cpp
+SOURCES += ../../src/VideoFrameProcessor.cpp
+
+LIBS += -L/usr/local/lib
+
+LIBS += -lopencv_core
+LIBS += -lopencv_imgproc
@@ -0,0 +1,179 @@
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "HistoCache.h"
+#include "VideoFrameProcessor.h"
+
+using namespace cv;
+
+///////////////////////////////////////////////////////
+// histograms read from the cache must be the ones   //
+// computed on the fly for the same decoded frame    //
+///////////////////////////////////////////////////////
+
+class HistoCacheTest: public QObject
+{
+  Q_OBJECT
+
+ private slots:
+  void initTestCase();
+  void cachedEqualsUncached_data();
+  void cachedEqualsUncached();
+
+ private:
+  Mat genFrame(int rows, int cols) const;
+  Mat refBlockHistos(const Mat &frame, int histoType, int hBins, int sBins, int vBins, int nVBlock, int nHBlock, int analysisHeight) const;
+
+  QTemporaryDir m_dir;
+};
+
+void HistoCacheTest::initTestCase()
+{
+  // cache files are written relatively to working directory
+  QVERIFY(m_dir.isValid());
+  QVERIFY(QDir::setCurrent(m_dir.path()));
+}
+
+void HistoCacheTest::cachedEqualsUncached_data()
+{
+  QTest::addColumn<int>("histoType");
+  QTest::addColumn<int>("analysisHeight");
+
+  QTest::newRow("hsv, full resolution") << 2 << 0;
+  QTest::newRow("hsv, reduced resolution") << 2 << 90;
+  QTest::newRow("hs, reduced resolution") << 1 << 90;
+  QTest::newRow("v, reduced resolution") << 0 << 90;
+}
+
+void HistoCacheTest::cachedEqualsUncached()
+{
+  QFETCH(int, histoType);
+  QFETCH(int, analysisHeight);
+
+  int nVBins(64);
+  int nHBins(24);
+  int nSBins(8);
+  int nVBlock(2);
+  int nHBlock(3);
+
+  // cache entries are keyed on the video file
+  QString fName = m_dir.filePath("episode.mp4");
+  QFile video(fName);
+  QVERIFY(video.open(QIODevice::WriteOnly));
+  video.write("video");
+  video.close();
+
+  VideoFrameProcessor processor;
+  Mat frame = genFrame(180, 320);
+  Mat frameCopy = frame.clone();
+
+  // histograms stored in cache during shot extraction
+  Mat hsv;
+  Mat histos;
+  QVector<Mat> locHisto;
+  processor.prepareFrame(frame, hsv, analysisHeight);
+  processor.genBlockHistos(hsv, histoType, nHBins, nSBins, nVBins, nVBlock, nHBlock, histos, locHisto);
+
+  HistoCache writer;
+  QVERIFY(writer.create(fName, histoType, nVBins, nHBins, nSBins, nVBlock, nHBlock, analysisHeight));
+  QVERIFY(writer.append(0, locHisto));
+  QVERIFY(writer.commit(40));
+
+  HistoCache cache;
+  QVERIFY(cache.open(fName, histoType, nVBins, nHBins, nSBins, nVBlock, nHBlock, analysisHeight));
+  QCOMPARE(cache.getFrameCount(), 1);
+  Mat cachedHistos = cache.getHistos(0);
+
+  // histograms computed without cache from the same decoded frame
+  Mat uncachedFrame;
+  Mat uncachedHistos;
+  processor.prepareFrame(frame, uncachedFrame, analysisHeight);
+  processor.genBlockHistos(uncachedFrame, histoType, nHBins, nSBins, nVBins, nVBlock, nHBlock, uncachedHistos);
+
+  // decoded frame left untouched by the conversion
+  QCOMPARE(norm(frame, frameCopy, NORM_INF), 0.0);
+
+  QCOMPARE(cachedHistos.rows, uncachedHistos.rows);
+  QCOMPARE(cachedHistos.cols, uncachedHistos.cols);
+  QCOMPARE(norm(cachedHistos, uncachedHistos, NORM_INF), 0.0);
+
+  // same histograms as OpenCV ones computed on each block of the HSV frame
+  Mat refHistos = refBlockHistos(frame, histoType, nHBins, nSBins, nVBins, nVBlock, nHBlock, analysisHeight);
+
+  QCOMPARE(cachedHistos.rows, refHistos.rows);
+  QCOMPARE(cachedHistos.cols, refHistos.cols);
+  QVERIFY(norm(cachedHistos, refHistos, NORM_INF) < 1e-6);
+}
+
+Mat HistoCacheTest::refBlockHistos(const Mat &frame, int histoType, int hBins, int sBins, int vBins, int nVBlock, int nHBlock, int analysisHeight) const
+{
+  Mat scaled;
+  Mat hsv;
+
+  if (analysisHeight > 0 && frame.rows > analysisHeight)
+    resize(frame, scaled, Size(qRound(frame.cols * analysisHeight / static_cast<qreal>(frame.rows)), analysisHeight), 0, 0, INTER_AREA);
+  else
+    scaled = frame;
+
+  cvtColor(scaled, hsv, CV_BGR2HSV);
+
+  // value only, hue and saturation, or all three channels
+  int channels[3];
+  int histSize[3];
+  const float *ranges[3];
+  float hRange[] = { 0, 180 };
+  float svRange[] = { 0, 256 };
+  int dims(0);
+
+  if (histoType != 0) {
+    channels[dims] = 0;
+    histSize[dims] = hBins;
+    ranges[dims++] = hRange;
+    channels[dims] = 1;
+    histSize[dims] = sBins;
+    ranges[dims++] = svRange;
+  }
+
+  if (histoType != 1) {
+    channels[dims] = 2;
+    histSize[dims] = vBins;
+    ranges[dims++] = svRange;
+  }
+
+  int blockVSize(hsv.rows / nVBlock);
+  int blockHSize(hsv.cols / nHBlock);
+  Mat histos;
+
+  // blocks in row-major order, one normalized histogram per row
+  for (int i(0); i + blockVSize <= hsv.rows; i += blockVSize)
+    for (int j(0); j + blockHSize <= hsv.cols; j += blockHSize) {
+
+      Mat block = hsv(Rect(j, i, blockHSize, blockVSize));
+      Mat hist;
+
+      calcHist(&block, 1, channels, Mat(), hist, dims, histSize, ranges, true, false);
+      normalize(hist, hist, 1, 0, NORM_L1);
+      histos.push_back(Mat(1, static_cast<int>(hist.total()), CV_32F, hist.data).clone());
+    }
+
+  return histos;
+}
+
+Mat HistoCacheTest::genFrame(int rows, int cols) const
+{
+  // color gradients: distinct histograms in BGR and HSV
+  Mat frame(rows, cols, CV_8UC3);
+
+  for (int i(0); i < rows; i++)
+    for (int j(0); j < cols; j++)
+      frame.at<Vec3b>(i, j) = Vec3b((i * 7) % 256, (j * 3) % 256, ((i + j) * 5) % 256);
+
+  return frame;
+}
+
+QTEST_APPLESS_MAIN(HistoCacheTest)
+
+#include "tst_HistoCache.moc"